@@ -64,6 +64,56 @@ public:
         return new_weight;
     }
 
+    /**
+     * @brief Adds to the weight of a vertex.
+     * If the vertex does not exist, it is created with the given weight.
+     *
+     * @param vertex The name of the vertex
+     * @param weight The weight to add
+     * @return The new weight of the vertex
+     */
+    int add_vertex_weight(const std::string &vertex, int weight) {
+        return vertices_[vertex] += weight;
+    }
+
+    /**
+     * @brief Adds to the weight of an undirected edge.
+     * If the edge does not exist, it is created with the given weight. Both
+     * directions are updated, as in increment_edge_weight.
+     *
+     * @param source One endpoint of the edge
+     * @param destination The other endpoint of the edge
+     * @param weight The weight to add
+     * @return The new weight of the edge
+     */
+    int add_edge_weight(const std::string &source,
+                        const std::string &destination, int weight) {
+        int new_weight = edges_[source][destination] += weight;
+        if (source != destination) {
+            edges_[destination][source] = new_weight;
+        }
+        return new_weight;
+    }
+
+    /**
+     * @brief Adds the vertex and edge weights of another graph to this one.
+     *
+     * @param other The graph to merge in
+     */
+    void merge(const Graph &other) {
+        for (const auto &[vertex, weight] : other.vertices_) {
+            vertices_[vertex] += weight;
+        }
+        // other is symmetric, so adding every stored direction keeps this
+        // graph symmetric too
+        for (const auto &[source, destinations] : other.edges_) {
+            auto &adjacency = edges_[source];
+            for (const auto &[destination, weight] : destinations) {
+                adjacency[destination] += weight;
+            }
+        }
+    }
+
     /**
      * @brief Increments the weight of a vertex by 1 if it already exists.
      * Does not create the vertex if it is missing.
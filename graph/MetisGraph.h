@@ -52,13 +52,16 @@ private:
     // Partition result array
     std::vector<idx_t> part_;
 
+    // Edge-cut of the last partitioning (METIS objective value)
+    idx_t edge_cut_;
+
 public:
     /**
      * @brief Default constructor
      */
     MetisGraph() :
-        nvtxs_(0), ncon_(1), prepared_(false), use_recursive_bisection_(false) {
-    }
+        nvtxs_(0), ncon_(1), prepared_(false), use_recursive_bisection_(false),
+        edge_cut_(0) {}
 
     /**
      * @brief Prepares the METIS graph data structures from a Graph instance.
@@ -221,6 +224,40 @@ public:
                 "METIS partitioning failed with error code: " +
                 std::to_string(ret));
         }
+        edge_cut_ = objval;
+    }
+
+    /**
+     * @brief Gets the edge-cut of the last partitioning.
+     *
+     * @return Total weight of the edges whose endpoints are in different
+     * partitions
+     */
+    idx_t get_edge_cut() const { return edge_cut_; }
+
+    /**
+     * @brief Gets the load imbalance of the last partitioning.
+     *
+     * @param num_partitions Number of partitions the graph was split into
+     * @return Vertex weight of the heaviest partition over the mean partition
+     * weight (1.0 is a perfect balance), or 0 if nothing was partitioned
+     */
+    double get_imbalance(int num_partitions) const {
+        if (num_partitions <= 0 || part_.empty()) {
+            return 0.0;
+        }
+        std::vector<idx_t> weights(num_partitions, 0);
+        idx_t total = 0;
+        for (size_t i = 0; i < part_.size() && i < vwgt_.size(); ++i) {
+            weights[part_[i]] += vwgt_[i];
+            total += vwgt_[i];
+        }
+        if (total == 0) {
+            return 0.0;
+        }
+        idx_t heaviest = *std::max_element(weights.begin(), weights.end());
+        return static_cast<double>(heaviest) * num_partitions /
+               static_cast<double>(total);
     }
 
     /**
@@ -142,6 +142,29 @@ void testConditionalIncrements() {
     END_TEST("conditional_increments")
 }
 
+void testMergeOperation() {
+    TEST("merge_operation")
+    Graph graph;
+    graph.increment_vertex_weight("A");
+    graph.increment_edge_weight("A", "B");
+
+    Graph other;
+    ASSERT_EQ(3, other.add_vertex_weight("A", 3));
+    other.add_vertex_weight("C", 2);
+    ASSERT_EQ(4, other.add_edge_weight("A", "B", 4));
+    ASSERT_EQ(4, other.get_edge_weight("B", "A"));
+    other.add_edge_weight("C", "C", 5);
+
+    graph.merge(other);
+    ASSERT_EQ(4, graph.get_vertex_weight("A"));
+    ASSERT_EQ(2, graph.get_vertex_weight("C"));
+    ASSERT_EQ(5, graph.get_edge_weight("A", "B"));
+    ASSERT_EQ(5, graph.get_edge_weight("B", "A"));
+    ASSERT_EQ(5, graph.get_edge_weight("C", "C"));
+
+    END_TEST("merge_operation")
+}
+
 void testPerformance() {
     TEST("performance")
     Graph graph;
@@ -178,6 +201,7 @@ int main() {
         {"combined_operations", testCombinedOperations},
         {"clear_operation", testClearOperation},
         {"conditional_increments", testConditionalIncrements},
+        {"merge_operation", testMergeOperation},
         {"performance", testPerformance}};
 
     run_test_suite("Graph Implementation", tests);
@@ -155,6 +155,48 @@ void test_partition_with_weights() {
     END_TEST("partition_with_weights")
 }
 
+void test_edge_cut_and_imbalance() {
+    TEST("edge_cut_and_imbalance")
+
+    Graph graph;
+    MetisGraph metis_graph;
+    ASSERT_EQ(0, metis_graph.get_edge_cut());
+    ASSERT_TRUE(metis_graph.get_imbalance(2) == 0.0);
+
+    // Two pairs joined by heavy edges, linked by a single light edge
+    for (const std::string vertex : {"A", "B", "C", "D"}) {
+        graph.increment_vertex_weight(vertex);
+    }
+    const std::vector<std::pair<std::string, std::string>> edges = {
+        {"A", "B"}, {"C", "D"}, {"B", "C"}};
+    for (int i = 0; i < 5; ++i) {
+        graph.increment_edge_weight("A", "B");
+        graph.increment_edge_weight("C", "D");
+    }
+    graph.increment_edge_weight("B", "C");
+
+    metis_graph.prepare_from_graph(graph);
+    metis_graph.partition(2);
+    auto partitions = metis_graph.get_partition_result();
+    const auto &vertex_to_idx = metis_graph.get_vertex_to_idx();
+
+    // The reported edge-cut is the weight of the edges crossing partitions
+    idx_t cut = 0;
+    for (const auto &[u, v] : edges) {
+        if (partitions[vertex_to_idx.at(u)] !=
+            partitions[vertex_to_idx.at(v)]) {
+            cut += graph.get_edge_weight(u, v);
+        }
+    }
+    ASSERT_EQ(cut, metis_graph.get_edge_cut());
+    ASSERT_GE(metis_graph.get_imbalance(2), 1.0);
+    ASSERT_LE(metis_graph.get_imbalance(2), 2.0);
+
+    std::cout << "  ✓ Edge-cut " << metis_graph.get_edge_cut()
+              << ", imbalance " << metis_graph.get_imbalance(2) << std::endl;
+    END_TEST("edge_cut_and_imbalance")
+}
+
 void test_multiple_partitions() {
     TEST("multiple_partitions")
 
@@ -268,6 +310,7 @@ int main() {
         {"empty_graph", test_empty_graph},
         {"partition_simple", test_partition_simple},
         {"partition_with_weights", test_partition_with_weights},
+        {"edge_cut_and_imbalance", test_edge_cut_and_imbalance},
         {"multiple_partitions", test_multiple_partitions},
         {"invalid_partition_parameters", test_invalid_partition_parameters},
         {"partition_before_prepare", test_partition_before_prepare}};
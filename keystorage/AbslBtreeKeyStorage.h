@@ -57,6 +57,23 @@ public:
         storage_[key] = value;
     }
 
+    /**
+     * @brief Implementation: Put many key-value pairs
+     *
+     * Each pair is inserted next to the previous one, so a batch sorted by
+     * key skips the search from the root.
+     *
+     * @param pairs The pairs to store
+     */
+    void put_batch_impl(
+        const std::vector<std::pair<std::string, ValueType>> &pairs) {
+        auto hint = storage_.end();
+        for (const auto &[key, value] : pairs) {
+            hint = storage_.insert_or_assign(hint, key, value);
+            ++hint;
+        }
+    }
+
     /**
      * @brief Implementation: Get a value by key, or insert it if it doesn't
      * exist
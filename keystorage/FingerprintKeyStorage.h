@@ -0,0 +1,287 @@
+#pragma once
+
+#include "KeyStorageConcepts.h"
+#include <ankerl/unordered_dense.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Compact key map that stores a fingerprint of each key, not the key
+ * @tparam ValueType The type of values stored (integral types or pointers)
+ *
+ * Meant for key->partition maps whose keys are already stored by the
+ * partitions' storage engines. Each entry is a 32-bit tag (a hash of the key)
+ * and its value, kept in a cuckoo-filter-like table: buckets of
+ * SLOTS_PER_BUCKET slots, each tag having two candidate buckets derived from
+ * the tag itself, and displacement (cuckoo kicks) on insertion. Since the
+ * buckets only depend on the tag, the table doubles without the keys.
+ *
+ * Integral values wider than 16 bits are stored in 16 bits (partition
+ * indices); insert() throws std::out_of_range for larger values. An entry
+ * then costs 6 bytes, against the full key plus tree-node overhead in the
+ * ordered key storages.
+ *
+ * This is NOT a KeyStorage: different keys may share a tag, so a lookup
+ * returns the values of every entry with the key's tag (candidates()), and
+ * the caller resolves false positives by asking the storage engines which
+ * candidate actually holds the key. Keys cannot be enumerated either; ordered
+ * iteration has to merge the storage engines' own scans.
+ *
+ * Not thread-safe; callers serialize access like for the other key maps.
+ */
+template <KeyStorageValueType ValueType> class FingerprintKeyStorage {
+public:
+    static constexpr size_t SLOTS_PER_BUCKET = 4;
+    // Entries sharing a tag that one lookup can return
+    static constexpr size_t MAX_CANDIDATES = 2 * SLOTS_PER_BUCKET;
+
+private:
+    using SlotValue =
+        std::conditional_t<std::is_integral_v<ValueType> &&
+                               (sizeof(ValueType) > sizeof(uint16_t)),
+                           uint16_t, ValueType>;
+
+    static constexpr uint32_t EMPTY = 0;          // Tag of a free slot
+    static constexpr size_t MAX_KICKS = 500;      // Displacements per insert
+    static constexpr size_t INITIAL_BUCKETS = 16; // Buckets of a new table
+
+    std::vector<uint32_t> tags_;    // SLOTS_PER_BUCKET tags per bucket
+    std::vector<SlotValue> values_; // Value of each slot
+    size_t bucket_mask_;            // Bucket count - 1 (a power of two)
+    size_t size_;                   // Stored entries
+    uint64_t kick_state_;           // xorshift state choosing kick victims
+
+    static uint32_t tag_of(const std::string &key) {
+        uint64_t hash = ankerl::unordered_dense::hash<std::string>{}(key);
+        uint32_t tag = static_cast<uint32_t>(hash >> 32);
+        return tag == EMPTY ? 1 : tag;
+    }
+
+    size_t first_bucket(uint32_t tag) const {
+        return static_cast<size_t>((tag * 0x9E3779B97F4A7C15ULL) >> 32) &
+               bucket_mask_;
+    }
+
+    size_t second_bucket(uint32_t tag) const {
+        return static_cast<size_t>(((tag ^ 0x5BD1E995U) *
+                                    0xC2B2AE3D27D4EB4FULL) >>
+                                   32) &
+               bucket_mask_;
+    }
+
+    /**
+     * @brief Put an entry in a free slot of one of its buckets
+     * @return true if a slot was free
+     */
+    bool place(uint32_t tag, SlotValue value) {
+        for (size_t bucket : {first_bucket(tag), second_bucket(tag)}) {
+            for (size_t slot = bucket * SLOTS_PER_BUCKET;
+                 slot < (bucket + 1) * SLOTS_PER_BUCKET; ++slot) {
+                if (tags_[slot] == EMPTY) {
+                    tags_[slot] = tag;
+                    values_[slot] = value;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Insert an entry, displacing others if both buckets are full
+     * @return false if displacement gave up (the entry left homeless is
+     * returned through tag and value)
+     */
+    bool insert_entry(uint32_t &tag, SlotValue &value) {
+        if (place(tag, value)) {
+            return true;
+        }
+        size_t bucket = first_bucket(tag);
+        for (size_t kick = 0; kick < MAX_KICKS; ++kick) {
+            kick_state_ ^= kick_state_ << 13;
+            kick_state_ ^= kick_state_ >> 7;
+            kick_state_ ^= kick_state_ << 17;
+            size_t slot = bucket * SLOTS_PER_BUCKET +
+                          static_cast<size_t>(kick_state_ % SLOTS_PER_BUCKET);
+            std::swap(tag, tags_[slot]);
+            std::swap(value, values_[slot]);
+            bucket = bucket == first_bucket(tag) ? second_bucket(tag)
+                                                 : first_bucket(tag);
+            for (size_t other = bucket * SLOTS_PER_BUCKET;
+                 other < (bucket + 1) * SLOTS_PER_BUCKET; ++other) {
+                if (tags_[other] == EMPTY) {
+                    tags_[other] = tag;
+                    values_[other] = value;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Double the bucket count and re-place every entry
+     * @param tag Tag of an entry not in the table yet (EMPTY for none)
+     * @param value Its value
+     */
+    void grow(uint32_t tag, SlotValue value) {
+        std::vector<uint32_t> old_tags = std::move(tags_);
+        std::vector<SlotValue> old_values = std::move(values_);
+        size_t bucket_count = (bucket_mask_ + 1) * 2;
+        for (;;) {
+            tags_.assign(bucket_count * SLOTS_PER_BUCKET, EMPTY);
+            values_.assign(bucket_count * SLOTS_PER_BUCKET, SlotValue());
+            bucket_mask_ = bucket_count - 1;
+            bool placed = true;
+            for (size_t slot = 0; placed && slot <= old_tags.size(); ++slot) {
+                uint32_t entry_tag = slot < old_tags.size() ? old_tags[slot]
+                                                            : tag;
+                SlotValue entry_value = slot < old_tags.size()
+                                            ? old_values[slot]
+                                            : value;
+                if (entry_tag != EMPTY) {
+                    placed = insert_entry(entry_tag, entry_value);
+                }
+            }
+            if (placed) {
+                return;
+            }
+            bucket_count *= 2; // Pathological clustering: try larger
+        }
+    }
+
+    static SlotValue to_slot(const ValueType &value) {
+        if constexpr (!std::is_same_v<SlotValue, ValueType>) {
+            // Negative values wrap around and are rejected too
+            if (static_cast<std::make_unsigned_t<ValueType>>(value) >
+                std::numeric_limits<SlotValue>::max()) {
+                throw std::out_of_range(
+                    "FingerprintKeyStorage value does not fit in 16 bits");
+            }
+        }
+        return static_cast<SlotValue>(value);
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param path Base directory for on-disk backends; ignored (in memory)
+     */
+    explicit FingerprintKeyStorage(const std::string &path) :
+        tags_(INITIAL_BUCKETS * SLOTS_PER_BUCKET, EMPTY),
+        values_(INITIAL_BUCKETS * SLOTS_PER_BUCKET),
+        bucket_mask_(INITIAL_BUCKETS - 1), size_(0),
+        kick_state_(0x2545F4914F6CDD1DULL) {
+        (void)path;
+    }
+
+    /**
+     * @brief Get the values of every entry whose tag matches the key's
+     * @param key The key to look up
+     * @param values Output array for the candidate values (duplicates are
+     * reported once)
+     * @return Number of candidates (0 if the key was certainly never inserted)
+     */
+    size_t candidates(const std::string &key,
+                      std::array<ValueType, MAX_CANDIDATES> &values) const {
+        uint32_t tag = tag_of(key);
+        size_t count = 0;
+        const size_t buckets[2] = {first_bucket(tag), second_bucket(tag)};
+        for (size_t b = 0; b < (buckets[0] == buckets[1] ? 1 : 2); ++b) {
+            size_t bucket = buckets[b];
+            for (size_t slot = bucket * SLOTS_PER_BUCKET;
+                 slot < (bucket + 1) * SLOTS_PER_BUCKET; ++slot) {
+                if (tags_[slot] != tag) {
+                    continue;
+                }
+                ValueType value = static_cast<ValueType>(values_[slot]);
+                bool seen = false;
+                for (size_t i = 0; i < count; ++i) {
+                    seen = seen || values[i] == value;
+                }
+                if (!seen) {
+                    values[count++] = value;
+                }
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Add an entry for a key known not to have one yet
+     *
+     * Always adds a new entry, even if other keys share the tag.
+     *
+     * @param key The key
+     * @param value Its value
+     * @throws std::out_of_range if an integral value does not fit in 16 bits
+     */
+    void insert(const std::string &key, const ValueType &value) {
+        uint32_t tag = tag_of(key);
+        SlotValue slot_value = to_slot(value);
+        // Keep the load factor below 15/16 so displacement stays short
+        if ((size_ + 1) * 16 > tags_.size() * 15 ||
+            !insert_entry(tag, slot_value)) {
+            grow(tag, slot_value);
+        }
+        ++size_;
+    }
+
+    /**
+     * @brief Change the value of one of a key's entries
+     * @param key The key
+     * @param old_value The value the key's entry holds now
+     * @param new_value The value to store instead
+     * @return true if an entry with the key's tag and old_value was found
+     */
+    bool replace(const std::string &key, const ValueType &old_value,
+                 const ValueType &new_value) {
+        uint32_t tag = tag_of(key);
+        SlotValue old_slot = to_slot(old_value);
+        for (size_t bucket : {first_bucket(tag), second_bucket(tag)}) {
+            for (size_t slot = bucket * SLOTS_PER_BUCKET;
+                 slot < (bucket + 1) * SLOTS_PER_BUCKET; ++slot) {
+                if (tags_[slot] == tag && values_[slot] == old_slot) {
+                    values_[slot] = to_slot(new_value);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Get the number of entries
+     * @return Entry count
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Get the memory held by the table
+     * @return Bytes allocated for tags and values
+     */
+    size_t memory_usage() const {
+        return tags_.capacity() * sizeof(uint32_t) +
+               values_.capacity() * sizeof(SlotValue);
+    }
+};
+
+/**
+ * @brief Whether a key map type is a FingerprintKeyStorage
+ */
+template <typename T> struct is_fingerprint_key_storage : std::false_type {};
+
+template <KeyStorageValueType ValueType>
+struct is_fingerprint_key_storage<FingerprintKeyStorage<ValueType>>
+    : std::true_type {};
+
+template <typename T>
+inline constexpr bool is_fingerprint_key_storage_v =
+    is_fingerprint_key_storage<T>::value;
@@ -38,6 +38,27 @@ public:
         static_cast<Derived *>(this)->put_impl(key, value);
     }
 
+    /**
+     * @brief Put many key-value pairs at once
+     *
+     * Storages with a bulk path (put_batch_impl) insert the whole batch in
+     * one step, e.g. one transaction; the others put the pairs one by one.
+     * Batches sorted by key insert fastest.
+     *
+     * @param pairs The pairs to store
+     */
+    void put_batch(const std::vector<std::pair<std::string, ValueType>> &pairs) {
+        if constexpr (requires(Derived &derived) {
+                          derived.put_batch_impl(pairs);
+                      }) {
+            static_cast<Derived *>(this)->put_batch_impl(pairs);
+        } else {
+            for (const auto &[key, value] : pairs) {
+                put(key, value);
+            }
+        }
+    }
+
     /**
      * @brief Scan for key-value pairs from a starting point
      * @param key_start The starting key
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <concepts>
+#include <string>
 #include <type_traits>
 
+struct EngineProfile; // storage/EngineTuning.h
+
 /**
  * @brief Concept for valid KeyStorage value types.
  *
@@ -15,3 +19,37 @@
 template <typename T>
 concept KeyStorageValueType =
     std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>;
+
+/**
+ * @brief Concept for key storages with tuning
+ *
+ * A tunable key storage names its tuning struct TuningType, picks it out of
+ * an EngineProfile with T::profile_tuning(profile), and takes it after the
+ * path in its constructor.
+ */
+template <typename T>
+concept TunableKeyStorage =
+    requires(const EngineProfile &profile) {
+        typename T::TuningType;
+        {
+            T::profile_tuning(profile)
+        } -> std::convertible_to<typename T::TuningType>;
+    } &&
+    std::constructible_from<T, const std::string &,
+                            const typename T::TuningType &>;
+
+/**
+ * @brief Create a key storage tuned by a profile
+ * @param path Base directory for on-disk backends
+ * @param profile Tuning of every backend; tunable key storages take theirs
+ * @return The new key storage
+ */
+template <typename T>
+T make_key_storage(const std::string &path, const EngineProfile &profile) {
+    if constexpr (TunableKeyStorage<T>) {
+        return T(path, T::profile_tuning(profile));
+    } else {
+        (void)profile;
+        return T(path);
+    }
+}
@@ -3,6 +3,8 @@
 #include "KeyStorage.h"
 #include "KeyStorageIterator.h"
 #include "KeyStorageValueBinary.h"
+#include "../storage/EngineTuning.h"
+#include "../storage/LmdbTransactions.h"
 #include <lmdb.h>
 #include <string>
 #include <string_view>
@@ -10,6 +12,7 @@
 #include <filesystem>
 #include <atomic>
 #include <chrono>
+#include <memory>
 
 // Forward declaration
 template <KeyStorageValueType ValueType> class LmdbKeyStorageIterator;
@@ -39,6 +42,10 @@ template <KeyStorageValueType ValueType> class LmdbKeyStorageIterator;
  * - ValueType must be trivially copyable (stored as sizeof(ValueType) raw
  * bytes)
  *
+ * Opened with the LmdbTuning settings and growing map of LmdbStorageEngine;
+ * lookups reuse one read transaction per thread, and get_or_insert() runs a
+ * single write transaction.
+ *
  * Note: This class is NOT thread-safe by default. Users must manually
  * call lock()/unlock() or lock_shared()/unlock_shared() when needed.
  */
@@ -50,19 +57,53 @@ private:
     MDB_dbi dbi_;
     bool is_open_;
     std::string db_path_;
+    std::unique_ptr<LmdbTransactions> transactions_;
 
     static std::atomic_int db_counter_;
     static std::string id_;
 
+    /**
+     * @brief Close the environment, aborting its cached read transactions
+     */
+    void close_env() {
+        if (transactions_) {
+            transactions_->close();
+            transactions_.reset();
+        }
+        mdb_dbi_close(env_, dbi_);
+        mdb_env_close(env_);
+    }
+
 public:
+    using TuningType = LmdbOptions;
+
+    /**
+     * @brief Get this key storage's settings in a profile
+     * @param profile The profile
+     * @return The profile's LMDB settings
+     */
+    static LmdbOptions profile_tuning(const EngineProfile &profile) {
+        return profile.lmdb;
+    }
+
     /**
      * @brief Constructor
      * @param base_path Directory under which a unique \c repart_kv_keystorage
      *        subdirectory is created for this LMDB environment.
-     * @param map_size Maximum size of the memory map in bytes (default: 50GB)
+     * @param map_size Initial size of the memory map in bytes (default: 0,
+     *        the LmdbTuning setting); the map grows when full
      */
     explicit LmdbKeyStorage(const std::string &base_path,
-                            size_t map_size = 50ULL * 1024 * 1024 * 1024) :
+                            size_t map_size = 0) :
+        LmdbKeyStorage(base_path, with_map_size(map_size)) {}
+
+    /**
+     * @brief Constructor
+     * @param base_path Directory under which a unique \c repart_kv_keystorage
+     *        subdirectory is created for this LMDB environment.
+     * @param options Environment settings
+     */
+    LmdbKeyStorage(const std::string &base_path, const LmdbOptions &options) :
         env_(nullptr), dbi_(MDB_dbi{}), is_open_(false) {
         db_path_ =
             (std::filesystem::path(base_path) / "repart_kv_keystorage" / id_ /
@@ -70,7 +111,7 @@ public:
                  db_counter_.fetch_add(1, std::memory_order_relaxed)))
                 .string();
         std::filesystem::create_directories(db_path_);
-        init_with_path(db_path_, map_size);
+        init_with_path(db_path_, options);
     }
 
     /**
@@ -78,8 +119,7 @@ public:
      */
     ~LmdbKeyStorage() {
         if (is_open_ && env_) {
-            mdb_dbi_close(env_, dbi_);
-            mdb_env_close(env_);
+            close_env();
             is_open_ = false;
             if (!db_path_.empty()) {
                 std::error_code ec;
@@ -95,7 +135,8 @@ public:
     // Enable move
     LmdbKeyStorage(LmdbKeyStorage &&other) noexcept :
         env_(other.env_), dbi_(other.dbi_), is_open_(other.is_open_),
-        db_path_(std::move(other.db_path_)) {
+        db_path_(std::move(other.db_path_)),
+        transactions_(std::move(other.transactions_)) {
         other.env_ = nullptr;
         other.is_open_ = false;
     }
@@ -103,13 +144,13 @@ public:
     LmdbKeyStorage &operator=(LmdbKeyStorage &&other) noexcept {
         if (this != &other) {
             if (is_open_ && env_) {
-                mdb_dbi_close(env_, dbi_);
-                mdb_env_close(env_);
+                close_env();
             }
             env_ = other.env_;
             dbi_ = other.dbi_;
             is_open_ = other.is_open_;
             db_path_ = std::move(other.db_path_);
+            transactions_ = std::move(other.transactions_);
             other.env_ = nullptr;
             other.is_open_ = false;
         }
@@ -127,34 +168,24 @@ public:
             return false;
         }
 
-        MDB_txn *txn;
-        MDB_val mdb_key;
-        MDB_val mdb_value;
-
-        int rc = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
-        if (rc != 0) {
+        LmdbTransactions::Reader reader = transactions_->read();
+        if (reader.txn() == nullptr) {
             return false;
         }
 
+        MDB_val mdb_key;
+        MDB_val mdb_value;
         mdb_key.mv_size = key.size();
         mdb_key.mv_data =
             const_cast<void *>(static_cast<const void *>(key.c_str()));
 
-        rc = mdb_get(txn, dbi_, &mdb_key, &mdb_value);
-        if (rc == MDB_SUCCESS) {
-            const std::string_view stored(
-                static_cast<const char *>(mdb_value.mv_data),
-                mdb_value.mv_size);
-            if (!key_storage_value_from_bytes(stored, value)) {
-                mdb_txn_abort(txn);
-                return false;
-            }
-            mdb_txn_abort(txn);
-            return true;
-        } else {
-            mdb_txn_abort(txn);
+        int rc = mdb_get(reader.txn(), dbi_, &mdb_key, &mdb_value);
+        if (rc != MDB_SUCCESS) {
             return false;
         }
+        const std::string_view stored(
+            static_cast<const char *>(mdb_value.mv_data), mdb_value.mv_size);
+        return key_storage_value_from_bytes(stored, value);
     }
 
     /**
@@ -167,15 +198,8 @@ public:
             return;
         }
 
-        MDB_txn *txn;
         MDB_val mdb_key;
         MDB_val mdb_value;
-
-        int rc = mdb_txn_begin(env_, nullptr, 0, &txn);
-        if (rc != 0) {
-            return;
-        }
-
         const std::string_view value_bytes = key_storage_value_as_bytes(value);
 
         mdb_key.mv_size = key.size();
@@ -185,16 +209,41 @@ public:
         mdb_value.mv_data =
             const_cast<void *>(static_cast<const void *>(value_bytes.data()));
 
-        rc = mdb_put(txn, dbi_, &mdb_key, &mdb_value, 0);
-        if (rc != 0) {
-            mdb_txn_abort(txn);
-            return;
-        }
+        transactions_->write([&](MDB_txn *txn) {
+            return mdb_put(txn, dbi_, &mdb_key, &mdb_value, 0);
+        });
+    }
 
-        rc = mdb_txn_commit(txn);
-        if (rc != 0) {
+    /**
+     * @brief Implementation: Put many key-value pairs in one write transaction
+     * @param pairs The pairs to store
+     */
+    void put_batch_impl(
+        const std::vector<std::pair<std::string, ValueType>> &pairs) {
+        if (!is_open_ || !env_ || pairs.empty()) {
             return;
         }
+
+        transactions_->write([&](MDB_txn *txn) {
+            int rc = MDB_SUCCESS;
+            for (const auto &[key, value] : pairs) {
+                const std::string_view value_bytes =
+                    key_storage_value_as_bytes(value);
+                MDB_val mdb_key;
+                MDB_val mdb_value;
+                mdb_key.mv_size = key.size();
+                mdb_key.mv_data =
+                    const_cast<void *>(static_cast<const void *>(key.c_str()));
+                mdb_value.mv_size = value_bytes.size();
+                mdb_value.mv_data = const_cast<void *>(
+                    static_cast<const void *>(value_bytes.data()));
+                rc = mdb_put(txn, dbi_, &mdb_key, &mdb_value, 0);
+                if (rc != MDB_SUCCESS) {
+                    break;
+                }
+            }
+            return rc;
+        });
     }
 
     /**
@@ -213,76 +262,35 @@ public:
             return false;
         }
 
-        MDB_txn *txn;
-        MDB_val mdb_key;
-        MDB_val mdb_value;
-
-        // Try to get first
-        int rc = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
-        if (rc == 0) {
-            mdb_key.mv_size = key.size();
-            mdb_key.mv_data =
-                const_cast<void *>(static_cast<const void *>(key.c_str()));
-            rc = mdb_get(txn, dbi_, &mdb_key, &mdb_value);
-            if (rc == MDB_SUCCESS) {
-                const std::string_view stored(
-                    static_cast<const char *>(mdb_value.mv_data),
-                    mdb_value.mv_size);
-                if (!key_storage_value_from_bytes(stored, found_value)) {
-                    mdb_txn_abort(txn);
-                    found_value = value_to_insert;
-                    return false;
-                }
-                mdb_txn_abort(txn);
-                return true;
-            }
-            mdb_txn_abort(txn);
-        }
-
-        // Not found, try to insert
-        rc = mdb_txn_begin(env_, nullptr, 0, &txn);
-        if (rc != 0) {
-            found_value = value_to_insert;
-            return false;
-        }
-
         const std::string_view value_bytes =
             key_storage_value_as_bytes(value_to_insert);
+        MDB_val mdb_key;
         mdb_key.mv_size = key.size();
         mdb_key.mv_data =
             const_cast<void *>(static_cast<const void *>(key.c_str()));
-        mdb_value.mv_size = value_bytes.size();
-        mdb_value.mv_data =
-            const_cast<void *>(static_cast<const void *>(value_bytes.data()));
 
-        rc = mdb_put(txn, dbi_, &mdb_key, &mdb_value, MDB_NOOVERWRITE);
-        if (rc == 0) {
-            mdb_txn_commit(txn);
-            found_value = value_to_insert;
-            return false;
-        } else if (rc == MDB_KEYEXIST) {
-            // Someone else inserted it in the meantime!
-            rc = mdb_get(txn, dbi_, &mdb_key, &mdb_value);
-            if (rc == MDB_SUCCESS) {
-                const std::string_view stored(
-                    static_cast<const char *>(mdb_value.mv_data),
-                    mdb_value.mv_size);
-                if (!key_storage_value_from_bytes(stored, found_value)) {
-                    mdb_txn_abort(txn);
-                    found_value = value_to_insert;
-                    return false;
-                }
-                mdb_txn_abort(txn);
-                return true;
-            }
-            mdb_txn_abort(txn);
-            found_value = value_to_insert;
-            return false;
-        } else {
-            mdb_txn_abort(txn);
+        // One write transaction: MDB_NOOVERWRITE returns the stored value
+        // when the key exists, so no separate lookup is needed
+        bool existed = false;
+        transactions_->write([&](MDB_txn *txn) {
+            MDB_val mdb_value;
+            mdb_value.mv_size = value_bytes.size();
+            mdb_value.mv_data = const_cast<void *>(
+                static_cast<const void *>(value_bytes.data()));
+            int rc = mdb_put(txn, dbi_, &mdb_key, &mdb_value, MDB_NOOVERWRITE);
+            existed =
+                rc == MDB_KEYEXIST &&
+                key_storage_value_from_bytes(
+                    std::string_view(
+                        static_cast<const char *>(mdb_value.mv_data),
+                        mdb_value.mv_size),
+                    found_value);
+            return rc;
+        });
+        if (!existed) {
             found_value = value_to_insert;
-            return false;
         }
+        return existed;
     }
 
     /**
@@ -326,17 +334,13 @@ public:
             return 0;
         }
 
-        MDB_txn *txn;
-        MDB_stat stat;
-
-        int rc = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
-        if (rc != 0) {
+        LmdbTransactions::Reader reader = transactions_->read();
+        if (reader.txn() == nullptr) {
             return 0;
         }
 
-        rc = mdb_stat(txn, dbi_, &stat);
-        mdb_txn_abort(txn);
-
+        MDB_stat stat;
+        int rc = mdb_stat(reader.txn(), dbi_, &stat);
         if (rc != 0) {
             return 0;
         }
@@ -365,19 +369,10 @@ public:
             return;
         }
 
-        MDB_txn *txn;
-        int rc = mdb_txn_begin(env_, nullptr, 0, &txn);
-        if (rc != 0) {
-            return;
-        }
-
-        rc = mdb_drop(txn, dbi_,
-                      0); // 0 = don't delete the database, just clear it
-        if (rc == 0) {
-            mdb_txn_commit(txn);
-        } else {
-            mdb_txn_abort(txn);
-        }
+        transactions_->write([&](MDB_txn *txn) {
+            // 0 = don't delete the database, just clear it
+            return mdb_drop(txn, dbi_, 0);
+        });
     }
 
     /**
@@ -390,26 +385,15 @@ public:
             return false;
         }
 
-        MDB_txn *txn;
         MDB_val mdb_key;
-
-        int rc = mdb_txn_begin(env_, nullptr, 0, &txn);
-        if (rc != 0) {
-            return false;
-        }
-
         mdb_key.mv_size = key.size();
         mdb_key.mv_data =
             const_cast<void *>(static_cast<const void *>(key.c_str()));
 
-        rc = mdb_del(txn, dbi_, &mdb_key, nullptr);
-        if (rc == 0) {
-            mdb_txn_commit(txn);
-            return true;
-        } else {
-            mdb_txn_abort(txn);
-            return false;
-        }
+        int rc = transactions_->write([&](MDB_txn *txn) {
+            return mdb_del(txn, dbi_, &mdb_key, nullptr);
+        });
+        return rc == 0;
     }
 
     /**
@@ -418,27 +402,37 @@ public:
      */
     const std::string &get_path() const { return db_path_; }
 
+    /**
+     * @brief Get the current size of the memory map
+     * @return Bytes (0 if the database is not open)
+     */
+    size_t map_size() const {
+        return transactions_ ? transactions_->map_size() : 0;
+    }
+
 private:
     /**
-     * @brief Initialize the database with a specific path
-     * @param path The database path
-     * @param map_size The map size
+     * @brief Get the LmdbTuning options with another initial map size
+     * @param map_size Initial map size (0: the LmdbTuning setting)
+     * @return The options
      */
-    void init_with_path(const std::string &path, size_t map_size) {
-        int rc = mdb_env_create(&env_);
-        if (rc != 0) {
-            is_open_ = false;
-            return;
+    static LmdbOptions with_map_size(size_t map_size) {
+        LmdbOptions options = LmdbTuning::options();
+        if (map_size != 0) {
+            options.map_size = map_size;
         }
+        return options;
+    }
 
-        mdb_env_set_maxdbs(env_, 1);
-        mdb_env_set_mapsize(env_, map_size);
-
-        rc =
-            mdb_env_open(env_, path.c_str(), MDB_NOSYNC | MDB_NOMETASYNC, 0664);
+    /**
+     * @brief Initialize the database with a specific path
+     * @param path The database path
+     * @param options Environment settings
+     */
+    void init_with_path(const std::string &path, const LmdbOptions &options) {
+        int rc =
+            LmdbTransactions::open_env(env_, path.c_str(), options, false);
         if (rc != 0) {
-            mdb_env_close(env_);
-            env_ = nullptr;
             is_open_ = false;
             return;
         }
@@ -462,6 +456,7 @@ private:
         }
 
         mdb_txn_commit(txn);
+        transactions_ = std::make_unique<LmdbTransactions>(env_, options);
         is_open_ = true;
     }
 };
@@ -475,6 +470,7 @@ private:
 template <KeyStorageValueType ValueType> class LmdbKeyStorageIterator
     : public KeyStorageIterator<LmdbKeyStorageIterator<ValueType>, ValueType> {
 private:
+    LmdbTransactions::Pin pin_; // Keeps the map in place
     MDB_env *env_;
     MDB_dbi dbi_;
     MDB_txn *txn_;
@@ -489,10 +485,12 @@ public:
      * @brief Constructor for begin iterator
      * @param env LMDB environment
      * @param dbi LMDB database handle
+     * @param pin Pin keeping the map from growing while the cursor is open
      */
-    LmdbKeyStorageIterator(MDB_env *env, MDB_dbi dbi) :
-        env_(env), dbi_(dbi), txn_(nullptr), cursor_(nullptr), is_valid_(false),
-        is_at_end_(false) {
+    LmdbKeyStorageIterator(MDB_env *env, MDB_dbi dbi,
+                           LmdbTransactions::Pin pin = {}) :
+        pin_(std::move(pin)), env_(env), dbi_(dbi), txn_(nullptr),
+        cursor_(nullptr), is_valid_(false), is_at_end_(false) {
 
         if (!env_ || !dbi_) {
             is_at_end_ = true;
@@ -527,10 +525,12 @@ public:
      * @param env LMDB environment
      * @param dbi LMDB database handle
      * @param key The key to search for
+     * @param pin Pin keeping the map from growing while the cursor is open
      */
-    LmdbKeyStorageIterator(MDB_env *env, MDB_dbi dbi, const std::string &key) :
-        env_(env), dbi_(dbi), txn_(nullptr), cursor_(nullptr), is_valid_(false),
-        is_at_end_(false) {
+    LmdbKeyStorageIterator(MDB_env *env, MDB_dbi dbi, const std::string &key,
+                           LmdbTransactions::Pin pin = {}) :
+        pin_(std::move(pin)), env_(env), dbi_(dbi), txn_(nullptr),
+        cursor_(nullptr), is_valid_(false), is_at_end_(false) {
 
         if (!env_ || !dbi_) {
             is_at_end_ = true;
@@ -594,8 +594,9 @@ public:
 
     // Enable move
     LmdbKeyStorageIterator(LmdbKeyStorageIterator &&other) noexcept :
-        env_(other.env_), dbi_(other.dbi_), txn_(other.txn_),
-        cursor_(other.cursor_), current_key_(other.current_key_),
+        pin_(std::move(other.pin_)), env_(other.env_), dbi_(other.dbi_),
+        txn_(other.txn_), cursor_(other.cursor_),
+        current_key_(other.current_key_),
         current_value_(other.current_value_), is_valid_(other.is_valid_),
         is_at_end_(other.is_at_end_) {
         other.txn_ = nullptr;
@@ -612,6 +613,7 @@ public:
             if (txn_) {
                 mdb_txn_abort(txn_);
             }
+            pin_ = std::move(other.pin_);
             env_ = other.env_;
             dbi_ = other.dbi_;
             txn_ = other.txn_;
@@ -687,7 +689,11 @@ public:
 // Implementation of lower_bound_impl
 template <KeyStorageValueType ValueType> LmdbKeyStorageIterator<ValueType>
 LmdbKeyStorage<ValueType>::lower_bound_impl(const std::string &key) {
-    return LmdbKeyStorageIterator<ValueType>(env_, dbi_, key);
+    if (!transactions_) {
+        return LmdbKeyStorageIterator<ValueType>(env_, dbi_, key);
+    }
+    return LmdbKeyStorageIterator<ValueType>(env_, dbi_, key,
+                                             transactions_->pin());
 }
 
 // Static member definitions
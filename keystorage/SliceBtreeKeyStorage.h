@@ -0,0 +1,700 @@
+#pragma once
+
+#include "KeyStorage.h"
+#include "KeyStorageIterator.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+namespace slice_btree {
+
+/** Key bytes held by a slice. */
+constexpr size_t SLICE_BYTES = sizeof(uint64_t);
+
+/** Slice length of keys longer than a slice. */
+constexpr uint8_t LONGER = SLICE_BYTES + 1;
+
+/** Keys per node, inner and leaf. */
+constexpr size_t FANOUT = 16;
+
+/**
+ * @brief Get the first SLICE_BYTES bytes of a key as a big-endian integer
+ *
+ * Shorter keys are padded with zero bytes, so comparing slices as integers
+ * orders keys by their first SLICE_BYTES bytes.
+ *
+ * @param key The key
+ * @return The slice
+ */
+inline uint64_t key_slice(std::string_view key) {
+    unsigned char bytes[SLICE_BYTES] = {};
+    std::memcpy(bytes, key.data(), std::min(key.size(), SLICE_BYTES));
+    uint64_t slice = 0;
+    for (unsigned char byte : bytes) {
+        slice = slice << 8 | byte;
+    }
+    return slice;
+}
+
+/**
+ * @brief Get the slice length of a key: its size up to SLICE_BYTES, or
+ * LONGER
+ *
+ * Keys with the same slice are ordered by slice length: the shorter one is
+ * a prefix of the longer one.
+ *
+ * @param key The key
+ * @return The slice length
+ */
+inline uint8_t slice_length(std::string_view key) {
+    return key.size() > SLICE_BYTES ? LONGER
+                                    : static_cast<uint8_t>(key.size());
+}
+
+/**
+ * @brief Append the bytes of a slice to a key
+ * @param key The key to append to
+ * @param slice The slice
+ * @param length Slice length (LONGER appends all SLICE_BYTES bytes)
+ */
+inline void append_slice(std::string &key, uint64_t slice, uint8_t length) {
+    size_t bytes = std::min<size_t>(length, SLICE_BYTES);
+    for (size_t i = 0; i < bytes; ++i) {
+        key.push_back(static_cast<char>(slice >> (8 * (SLICE_BYTES - 1 - i))));
+    }
+}
+
+/**
+ * @brief Count the slices of a node lower than a slice
+ *
+ * Compares all FANOUT slots at once (AVX2 or SSE4.2 when enabled at
+ * compile time, see the REPART_KV_NATIVE_ARCH CMake option); unused slots
+ * hold UINT64_MAX and never count.
+ *
+ * @param slices The node's slices (aligned to 32 bytes)
+ * @param slice The slice to compare with
+ * @return Number of slices lower than slice
+ */
+inline size_t count_lower(const uint64_t *slices, uint64_t slice) {
+    size_t lower = 0;
+#if defined(__AVX2__)
+    // No unsigned 64-bit compare: flip the sign bits and compare signed
+    const __m256i flip = _mm256_set1_epi64x(LLONG_MIN);
+    const __m256i needle =
+        _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(slice)),
+                         flip);
+    for (size_t i = 0; i < FANOUT; i += 4) {
+        __m256i keys = _mm256_xor_si256(
+            _mm256_load_si256(reinterpret_cast<const __m256i *>(slices + i)),
+            flip);
+        lower += std::popcount(static_cast<unsigned>(_mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpgt_epi64(needle, keys)))));
+    }
+#elif defined(__SSE4_2__)
+    const __m128i flip = _mm_set1_epi64x(LLONG_MIN);
+    const __m128i needle = _mm_xor_si128(
+        _mm_set1_epi64x(static_cast<long long>(slice)), flip);
+    for (size_t i = 0; i < FANOUT; i += 2) {
+        __m128i keys = _mm_xor_si128(
+            _mm_load_si128(reinterpret_cast<const __m128i *>(slices + i)),
+            flip);
+        lower += std::popcount(static_cast<unsigned>(
+            _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(needle, keys)))));
+    }
+#else
+    // Branch-free, so compilers vectorize it with the instructions at hand
+    for (size_t i = 0; i < FANOUT; ++i) {
+        lower += slices[i] < slice;
+    }
+#endif
+    return lower;
+}
+
+/**
+ * @brief Keys of a node: slices and slice lengths, sorted
+ *
+ * Within a layer, a (slice, slice length) pair identifies one entry, so
+ * nodes are searched with integer compares only.
+ */
+struct NodeKeys {
+    alignas(32) std::array<uint64_t, FANOUT> slices; // UINT64_MAX past count
+    std::array<uint8_t, FANOUT> lengths;             // Slice lengths
+    uint8_t count = 0;                               // Keys in use
+
+    NodeKeys() {
+        slices.fill(UINT64_MAX);
+        lengths.fill(0);
+    }
+
+    /**
+     * @brief Find the first key not lower than (slice, length)
+     * @return Its position, count if there is none
+     */
+    size_t lower_bound(uint64_t slice, uint8_t length) const {
+        size_t position = count_lower(slices.data(), slice);
+        while (position < count && slices[position] == slice &&
+               lengths[position] < length) {
+            ++position;
+        }
+        return position;
+    }
+
+    /**
+     * @brief Check whether the key at a position is (slice, length)
+     */
+    bool matches(size_t position, uint64_t slice, uint8_t length) const {
+        return position < count && slices[position] == slice &&
+               lengths[position] == length;
+    }
+
+    bool full() const { return count == FANOUT; }
+};
+
+template <typename ValueType> class Layer;
+
+/**
+ * @brief Leaf node: a value per key, and for keys longer than a slice
+ * either the rest of the key (suffix) or the layer indexing the rests of
+ * all keys that share the slice
+ */
+template <typename ValueType> struct Leaf : NodeKeys {
+    std::array<ValueType, FANOUT> values{};
+    std::array<std::unique_ptr<std::string>, FANOUT> suffixes;
+    std::array<std::unique_ptr<Layer<ValueType>>, FANOUT> layers;
+    Leaf *next = nullptr; // Next leaf in key order
+
+    /**
+     * @brief Move entries [from, count) to another leaf, starting at
+     * to_position
+     */
+    void move_entries(size_t from, Leaf &to, size_t to_position) {
+        for (size_t i = from; i < count; ++i) {
+            size_t j = to_position + (i - from);
+            to.slices[j] = slices[i];
+            to.lengths[j] = lengths[i];
+            to.values[j] = values[i];
+            to.suffixes[j] = std::move(suffixes[i]);
+            to.layers[j] = std::move(layers[i]);
+        }
+    }
+};
+
+/**
+ * @brief Inner node: child i holds the keys in [key i-1, key i)
+ */
+struct Inner : NodeKeys {
+    std::array<NodeKeys *, FANOUT + 1> children{};
+
+    /**
+     * @brief Find the child that holds (slice, length)
+     */
+    size_t child(uint64_t slice, uint8_t length) const {
+        size_t position = lower_bound(slice, length);
+        return matches(position, slice, length) ? position + 1 : position;
+    }
+};
+
+/**
+ * @brief B+ tree over the slices found at one depth of the keys
+ *
+ * The top layer indexes the first SLICE_BYTES bytes of every key. Keys
+ * longer than a slice that share their slice with no other key keep the
+ * rest of the key as a suffix; as soon as two do, their rests move to a
+ * layer of their own, one slice deeper (Masstree's trie of B+ trees).
+ * There is no removal: entries only get added or updated.
+ */
+template <typename ValueType> class Layer {
+private:
+    using LeafType = Leaf<ValueType>;
+
+    NodeKeys *root_;  // Root node
+    size_t height_;   // Inner levels above the leaves
+    LeafType *first_; // Leftmost leaf, which never changes
+
+public:
+    Layer() : root_(new LeafType()), height_(0), first_(nullptr) {
+        first_ = static_cast<LeafType *>(root_);
+    }
+
+    Layer(const Layer &) = delete;
+    Layer &operator=(const Layer &) = delete;
+
+    Layer(Layer &&other) noexcept :
+        root_(std::exchange(other.root_, nullptr)),
+        height_(std::exchange(other.height_, 0)),
+        first_(std::exchange(other.first_, nullptr)) {}
+
+    Layer &operator=(Layer &&other) noexcept {
+        if (this != &other) {
+            destroy(root_, height_);
+            root_ = std::exchange(other.root_, nullptr);
+            height_ = std::exchange(other.height_, 0);
+            first_ = std::exchange(other.first_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Layer() { destroy(root_, height_); }
+
+    /**
+     * @brief Find the leaf position of the first key not lower than
+     * (slice, length)
+     * @return The leaf and the position (which may be the leaf's count)
+     */
+    std::pair<LeafType *, size_t> find(uint64_t slice, uint8_t length) const {
+        NodeKeys *node = root_;
+        for (size_t level = height_; level > 0; --level) {
+            const Inner *inner = static_cast<const Inner *>(node);
+            node = inner->children[inner->child(slice, length)];
+        }
+        LeafType *leaf = static_cast<LeafType *>(node);
+        return {leaf, leaf->lower_bound(slice, length)};
+    }
+
+    /**
+     * @brief Add a key that is not in the layer yet
+     *
+     * Full nodes met on the way down are split first, so the leaf has room.
+     *
+     * @return The leaf and position of the new entry, whose value, suffix
+     * and layer are empty
+     */
+    std::pair<LeafType *, size_t> insert(uint64_t slice, uint8_t length) {
+        if (root_->full()) {
+            Inner *root = new Inner();
+            root->children[0] = root_;
+            split_child(*root, 0, height_);
+            root_ = root;
+            ++height_;
+        }
+
+        NodeKeys *node = root_;
+        for (size_t level = height_; level > 0; --level) {
+            Inner *inner = static_cast<Inner *>(node);
+            size_t child = inner->child(slice, length);
+            if (inner->children[child]->full()) {
+                split_child(*inner, child, level - 1);
+                child = inner->child(slice, length);
+            }
+            node = inner->children[child];
+        }
+
+        LeafType *leaf = static_cast<LeafType *>(node);
+        size_t position = leaf->lower_bound(slice, length);
+        for (size_t i = leaf->count; i > position; --i) {
+            leaf->slices[i] = leaf->slices[i - 1];
+            leaf->lengths[i] = leaf->lengths[i - 1];
+            leaf->values[i] = leaf->values[i - 1];
+            leaf->suffixes[i] = std::move(leaf->suffixes[i - 1]);
+            leaf->layers[i] = std::move(leaf->layers[i - 1]);
+        }
+        leaf->slices[position] = slice;
+        leaf->lengths[position] = length;
+        leaf->values[position] = ValueType();
+        ++leaf->count;
+        return {leaf, position};
+    }
+
+    /**
+     * @brief Get the leftmost leaf, where iteration starts
+     */
+    LeafType *first() const { return first_; }
+
+private:
+    /**
+     * @brief Split a full child in two halves and add the separating key to
+     * its (non-full) parent
+     * @param parent The parent
+     * @param index Position of the child in the parent
+     * @param child_height Inner levels below the child (0 for a leaf)
+     */
+    static void split_child(Inner &parent, size_t index, size_t child_height) {
+        constexpr size_t half = FANOUT / 2;
+        NodeKeys *left = parent.children[index];
+        NodeKeys *right;
+        uint64_t separator_slice;
+        uint8_t separator_length;
+
+        if (child_height == 0) {
+            // The right leaf's first key separates the leaves
+            LeafType *left_leaf = static_cast<LeafType *>(left);
+            LeafType *right_leaf = new LeafType();
+            left_leaf->move_entries(half, *right_leaf, 0);
+            right_leaf->count = FANOUT - half;
+            right_leaf->next = left_leaf->next;
+            left_leaf->next = right_leaf;
+            separator_slice = right_leaf->slices[0];
+            separator_length = right_leaf->lengths[0];
+            right = right_leaf;
+        } else {
+            // The middle key moves up to the parent
+            Inner *left_inner = static_cast<Inner *>(left);
+            Inner *right_inner = new Inner();
+            separator_slice = left_inner->slices[half];
+            separator_length = left_inner->lengths[half];
+            for (size_t i = half + 1; i < FANOUT; ++i) {
+                right_inner->slices[i - half - 1] = left_inner->slices[i];
+                right_inner->lengths[i - half - 1] = left_inner->lengths[i];
+            }
+            for (size_t i = half + 1; i <= FANOUT; ++i) {
+                right_inner->children[i - half - 1] = left_inner->children[i];
+                left_inner->children[i] = nullptr;
+            }
+            right_inner->count = FANOUT - half - 1;
+            right = right_inner;
+        }
+        std::fill(left->slices.begin() + half, left->slices.end(), UINT64_MAX);
+        left->count = half;
+
+        for (size_t i = parent.count; i > index; --i) {
+            parent.slices[i] = parent.slices[i - 1];
+            parent.lengths[i] = parent.lengths[i - 1];
+            parent.children[i + 1] = parent.children[i];
+        }
+        parent.slices[index] = separator_slice;
+        parent.lengths[index] = separator_length;
+        parent.children[index + 1] = right;
+        ++parent.count;
+    }
+
+    static void destroy(NodeKeys *node, size_t height) {
+        if (node == nullptr) {
+            return;
+        }
+        if (height == 0) {
+            delete static_cast<LeafType *>(node);
+            return;
+        }
+        Inner *inner = static_cast<Inner *>(node);
+        for (size_t i = 0; i <= inner->count; ++i) {
+            destroy(inner->children[i], height - 1);
+        }
+        delete inner;
+    }
+};
+
+} // namespace slice_btree
+
+// Forward declaration
+template <KeyStorageValueType ValueType> class SliceBtreeKeyStorageIterator;
+
+/**
+ * @brief B+ tree implementation of KeyStorage whose nodes hold fixed-width
+ * key slices
+ * @tparam ValueType The type of values stored (integral types or pointers)
+ *
+ * Nodes store the first 8 bytes of each key as a big-endian integer next to
+ * the child pointers or values, so a node step compares integers in place
+ * (with SIMD when enabled) instead of following a pointer to a heap string.
+ * The rest of a key longer than 8 bytes is stored only when needed: as a
+ * suffix while no other key shares its first 8 bytes, and otherwise in a
+ * deeper layer indexed by the next 8 bytes (see slice_btree::Layer).
+ *
+ * Like absl::btree_map, inserting invalidates iterators.
+ *
+ * Requires C++20 for concepts and CRTP pattern.
+ */
+template <KeyStorageValueType ValueType> class SliceBtreeKeyStorage
+    : public KeyStorage<SliceBtreeKeyStorage<ValueType>,
+                        SliceBtreeKeyStorageIterator<ValueType>, ValueType> {
+private:
+    using Layer = slice_btree::Layer<ValueType>;
+
+    Layer root_; // Layer of the first slice of every key
+
+public:
+    /**
+     * @brief Constructor
+     * @param path Base directory for on-disk backends; ignored for this
+     *        in-memory tree.
+     */
+    explicit SliceBtreeKeyStorage(const std::string &path) { (void)path; }
+
+    /**
+     * @brief Destructor
+     */
+    ~SliceBtreeKeyStorage() = default;
+
+    /**
+     * @brief Implementation: Get a value by key
+     * @param key The key to look up
+     * @param value Output parameter for the retrieved value
+     * @return true if the key exists, false otherwise
+     */
+    bool get_impl(const std::string &key, ValueType &value) const {
+        const Layer *layer = &root_;
+        std::string_view rest = key;
+        while (true) {
+            uint64_t slice = slice_btree::key_slice(rest);
+            uint8_t length = slice_btree::slice_length(rest);
+            auto [leaf, position] = layer->find(slice, length);
+            if (!leaf->matches(position, slice, length)) {
+                return false;
+            }
+            if (length == slice_btree::LONGER) {
+                rest.remove_prefix(slice_btree::SLICE_BYTES);
+                if (leaf->layers[position]) {
+                    layer = leaf->layers[position].get();
+                    continue;
+                }
+                if (*leaf->suffixes[position] != rest) {
+                    return false;
+                }
+            }
+            value = leaf->values[position];
+            return true;
+        }
+    }
+
+    /**
+     * @brief Implementation: Put a key-value pair into storage
+     * @param key The key to store
+     * @param value The value to associate with the key
+     */
+    void put_impl(const std::string &key, const ValueType &value) {
+        bool inserted;
+        *emplace(root_, key, value, inserted) = value;
+    }
+
+    /**
+     * @brief Implementation: Get a value by key, or insert it if it doesn't
+     * exist
+     * @param key The key to look up
+     * @param value_to_insert The value to insert if the key doesn't exist
+     * @param found_value Output parameter for the retrieved (or inserted) value
+     * @return true if the key already existed, false if it was newly inserted
+     */
+    bool get_or_insert_impl(const std::string &key,
+                            const ValueType &value_to_insert,
+                            ValueType &found_value) {
+        bool inserted;
+        found_value = *emplace(root_, key, value_to_insert, inserted);
+        return !inserted;
+    }
+
+    /**
+     * @brief Implementation: Scan for key-value pairs from a starting key
+     * @param key_start The starting key (first key >= key_start)
+     * @param limit Maximum number of pairs to return
+     * @param results Output vector of (key, value) pairs
+     */
+    void scan_impl(const std::string &key_start, size_t limit,
+                   std::vector<std::pair<std::string, ValueType>> &results) {
+        results.clear();
+        if (limit == 0)
+            return;
+        auto it = lower_bound_impl(key_start);
+        for (; !it.is_end() && results.size() < limit; ++it) {
+            results.emplace_back(it.get_key(), it.get_value());
+        }
+    }
+
+    /**
+     * @brief Implementation: Find the first element with key not less than the
+     * given key
+     * @param key The key to search for
+     * @return Iterator pointing to the found element or end
+     */
+    SliceBtreeKeyStorageIterator<ValueType>
+    lower_bound_impl(const std::string &key) {
+        return SliceBtreeKeyStorageIterator<ValueType>(root_, key);
+    }
+
+private:
+    /**
+     * @brief Find a key, adding it with a value if it is missing
+     * @param root Layer to search
+     * @param key The key, without the slices of the layers above
+     * @param value Value of the key if it is added
+     * @param inserted Set to whether the key was added
+     * @return The key's value
+     */
+    static ValueType *emplace(Layer &root, std::string_view key,
+                              const ValueType &value, bool &inserted) {
+        Layer *layer = &root;
+        while (true) {
+            uint64_t slice = slice_btree::key_slice(key);
+            uint8_t length = slice_btree::slice_length(key);
+            auto [leaf, position] = layer->find(slice, length);
+            if (!leaf->matches(position, slice, length)) {
+                std::tie(leaf, position) = layer->insert(slice, length);
+                leaf->values[position] = value;
+                if (length == slice_btree::LONGER) {
+                    leaf->suffixes[position] = std::make_unique<std::string>(
+                        key.substr(slice_btree::SLICE_BYTES));
+                }
+                inserted = true;
+                return &leaf->values[position];
+            }
+            if (length != slice_btree::LONGER) {
+                inserted = false;
+                return &leaf->values[position];
+            }
+
+            key.remove_prefix(slice_btree::SLICE_BYTES);
+            if (!leaf->layers[position]) {
+                std::unique_ptr<std::string> &suffix =
+                    leaf->suffixes[position];
+                if (*suffix == key) {
+                    inserted = false;
+                    return &leaf->values[position];
+                }
+                // A second key with this slice: both rests go one layer down
+                auto next = std::make_unique<Layer>();
+                bool moved;
+                emplace(*next, *suffix, leaf->values[position], moved);
+                suffix.reset();
+                leaf->layers[position] = std::move(next);
+            }
+            layer = leaf->layers[position].get();
+        }
+    }
+};
+
+/**
+ * @brief Iterator implementation for SliceBtreeKeyStorage
+ * @tparam ValueType The type of values stored
+ *
+ * Keeps one leaf position per layer it went down through, and the slices
+ * of those layers as the key prefix.
+ *
+ * Requires C++20 for concepts and CRTP pattern.
+ */
+template <KeyStorageValueType ValueType> class SliceBtreeKeyStorageIterator
+    : public KeyStorageIterator<SliceBtreeKeyStorageIterator<ValueType>,
+                                ValueType> {
+private:
+    using Layer = slice_btree::Layer<ValueType>;
+    using LeafType = slice_btree::Leaf<ValueType>;
+
+    struct Position {
+        const LeafType *leaf;
+        size_t index;
+    };
+
+    std::vector<Position> positions_; // One per layer, empty at the end
+    std::string prefix_;              // Slices of the layers above the last
+
+public:
+    /**
+     * @brief Constructor
+     * @param root The storage's top layer
+     * @param key Position the iterator on the first key not less than this
+     */
+    SliceBtreeKeyStorageIterator(const Layer &root, std::string_view key) {
+        const Layer *layer = &root;
+        while (true) {
+            uint64_t slice = slice_btree::key_slice(key);
+            uint8_t length = slice_btree::slice_length(key);
+            auto [leaf, index] = layer->find(slice, length);
+            positions_.push_back({leaf, index});
+            if (length != slice_btree::LONGER ||
+                !leaf->matches(index, slice, length)) {
+                break;
+            }
+            key.remove_prefix(slice_btree::SLICE_BYTES);
+            if (leaf->layers[index]) {
+                slice_btree::append_slice(prefix_, slice, length);
+                layer = leaf->layers[index].get();
+                continue;
+            }
+            if (*leaf->suffixes[index] < key) {
+                ++positions_.back().index;
+            }
+            break;
+        }
+        settle();
+    }
+
+    /**
+     * @brief Implementation: Get the key at the current iterator position
+     * @return The key as a string
+     */
+    std::string get_key_impl() const {
+        if (positions_.empty()) {
+            return "";
+        }
+        const Position &position = positions_.back();
+        const LeafType &leaf = *position.leaf;
+        std::string key = prefix_;
+        slice_btree::append_slice(key, leaf.slices[position.index],
+                                  leaf.lengths[position.index]);
+        if (leaf.suffixes[position.index]) {
+            key += *leaf.suffixes[position.index];
+        }
+        return key;
+    }
+
+    /**
+     * @brief Implementation: Get the value at the current iterator position
+     * @return The value
+     */
+    ValueType get_value_impl() const {
+        if (positions_.empty()) {
+            return ValueType();
+        }
+        const Position &position = positions_.back();
+        return position.leaf->values[position.index];
+    }
+
+    /**
+     * @brief Implementation: Increment the iterator to the next element
+     */
+    void increment_impl() {
+        if (!positions_.empty()) {
+            ++positions_.back().index;
+            settle();
+        }
+    }
+
+    /**
+     * @brief Implementation: Check if this iterator is at the end
+     * @return true if at end, false otherwise
+     */
+    bool is_end_impl() const { return positions_.empty(); }
+
+private:
+    /**
+     * @brief Move the last position to the next entry holding a value: to
+     * the next leaf past the end of one, back up a layer past the end of
+     * one, and down into the layer of an entry that has one
+     */
+    void settle() {
+        while (!positions_.empty()) {
+            Position &position = positions_.back();
+            if (position.index >= position.leaf->count) {
+                if (position.leaf->next != nullptr) {
+                    position = {position.leaf->next, 0};
+                    continue;
+                }
+                positions_.pop_back();
+                if (!positions_.empty()) {
+                    prefix_.resize(prefix_.size() - slice_btree::SLICE_BYTES);
+                    ++positions_.back().index;
+                }
+                continue;
+            }
+            const Layer *layer = position.leaf->layers[position.index].get();
+            if (layer == nullptr) {
+                return;
+            }
+            slice_btree::append_slice(prefix_,
+                                      position.leaf->slices[position.index],
+                                      slice_btree::LONGER);
+            positions_.push_back({layer->first(), 0});
+        }
+    }
+};
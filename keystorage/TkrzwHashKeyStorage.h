@@ -3,6 +3,7 @@
 #include "KeyStorage.h"
 #include "KeyStorageIterator.h"
 #include "KeyStorageValueBinary.h"
+#include "../storage/TkrzwTuning.h"
 #include <tkrzw_dbm_hash.h>
 #include <string>
 #include <memory>
@@ -45,12 +46,26 @@ public:
         return out;
     }
 
+    using TuningType = TkrzwHashTuning;
+
+    /**
+     * @brief Get this key storage's tuning in a profile
+     * @param profile The profile
+     * @return The profile's HashDBM tuning of key storages
+     */
+    static TkrzwHashTuning profile_tuning(const EngineProfile &profile) {
+        return profile.tkrzw_hash_keys;
+    }
+
     /**
      * @brief Constructor
      * @param base_path Directory under which \c repart_kv_keystorage files are
      *        created for this database.
+     * @param tuning HashDBM tuning (default: the EngineTuning profile's)
      */
-    explicit TkrzwHashKeyStorage(const std::string &base_path) :
+    explicit TkrzwHashKeyStorage(const std::string &base_path,
+                                 const TkrzwHashTuning &tuning =
+                                     EngineTuning::profile().tkrzw_hash_keys) :
         db_(std::make_unique<tkrzw::HashDBM>()), is_open_(false) {
         const std::filesystem::path root =
             std::filesystem::path(base_path) / "repart_kv_keystorage" / id_;
@@ -61,8 +76,8 @@ public:
                                  ".tkh"))
                             .string();
 
-        tkrzw::HashDBM::TuningParameters tuning_params;
-        tuning_params.num_buckets = 100000;
+        tkrzw::HashDBM::TuningParameters tuning_params =
+            tkrzw_tuning_parameters(tuning);
 
         tkrzw::Status status = db_->OpenAdvanced(
             db_file_path_, true, tkrzw::File::OPEN_TRUNCATE, tuning_params);
@@ -3,6 +3,7 @@
 #include "KeyStorage.h"
 #include "KeyStorageIterator.h"
 #include "KeyStorageValueBinary.h"
+#include "../storage/TkrzwTuning.h"
 #include <tkrzw_dbm_tree.h>
 #include <string>
 #include <memory>
@@ -46,12 +47,26 @@ public:
         return out;
     }
 
+    using TuningType = TkrzwTreeTuning;
+
+    /**
+     * @brief Get this key storage's tuning in a profile
+     * @param profile The profile
+     * @return The profile's TreeDBM tuning of key storages
+     */
+    static TkrzwTreeTuning profile_tuning(const EngineProfile &profile) {
+        return profile.tkrzw_tree_keys;
+    }
+
     /**
      * @brief Constructor
      * @param base_path Directory under which \c repart_kv_keystorage files are
      *        created for this database.
+     * @param tuning TreeDBM tuning (default: the EngineTuning profile's)
      */
-    explicit TkrzwTreeKeyStorage(const std::string &base_path) :
+    explicit TkrzwTreeKeyStorage(const std::string &base_path,
+                                 const TkrzwTreeTuning &tuning =
+                                     EngineTuning::profile().tkrzw_tree_keys) :
         db_(std::make_unique<tkrzw::TreeDBM>()), is_open_(false) {
         const std::filesystem::path root =
             std::filesystem::path(base_path) / "repart_kv_keystorage" / id_;
@@ -62,9 +77,8 @@ public:
                                  ".tkt"))
                             .string();
 
-        tkrzw::TreeDBM::TuningParameters tuning_params;
-        tuning_params.max_page_size = 8192;
-        tuning_params.max_branches = 256;
+        tkrzw::TreeDBM::TuningParameters tuning_params =
+            tkrzw_tuning_parameters(tuning);
 
         tkrzw::Status status = db_->OpenAdvanced(
             db_file_path_, true, tkrzw::File::OPEN_TRUNCATE, tuning_params);
@@ -5,13 +5,18 @@
 #include "../LmdbKeyStorage.h"
 #include "../LevelDBKeyStorage.h"
 #include "../UnorderedDenseKeyStorage.h"
+#include "../FingerprintKeyStorage.h"
+#include "../SliceBtreeKeyStorage.h"
 #include "../../utils/test_assertions.h"
 #include "../../utils/test_resources.h"
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <concepts>
 #include <functional>
 #include <iostream>
+#include <map>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -595,6 +600,34 @@ template <typename StorageType, typename ValueType> void test_get_or_insert() {
     END_TEST("get_or_insert")
 }
 
+template <typename StorageType, typename ValueType> void test_put_batch() {
+    TEST("put_batch")
+    StorageType storage(key_storage_test_root());
+    storage.put("key:0005", static_cast<ValueType>(1));
+
+    // Sorted batch, overwriting one existing key
+    std::vector<std::pair<std::string, ValueType>> batch;
+    for (int i = 0; i < 100; ++i) {
+        std::string number = std::to_string(i);
+        batch.emplace_back("key:" + std::string(4 - number.size(), '0') +
+                               number,
+                           static_cast<ValueType>(i + 10));
+    }
+    storage.put_batch(batch);
+    storage.put_batch({});
+
+    ValueType value{};
+    ASSERT_TRUE(storage.get("key:0005", value));
+    ASSERT_EQ(static_cast<ValueType>(15), value);
+    ASSERT_TRUE(storage.get("key:0099", value));
+    ASSERT_EQ(static_cast<ValueType>(109), value);
+
+    auto results = scan_storage<StorageType, ValueType>(storage, "", 1000);
+    ASSERT_EQ(100, results.size());
+    ASSERT_STR_EQ("key:0000", results.front().first);
+    END_TEST("put_batch")
+}
+
 // Helper function to run all tests for a given storage type and value type
 template <typename StorageType, typename ValueType>
 void run_storage_test_suite(const std::string &storage_name,
@@ -650,12 +683,193 @@ void run_storage_test_suite(const std::string &storage_name,
         {"numeric_value_ranges",
          []() { test_numeric_value_ranges<StorageType, ValueType>(); }},
         {"get_or_insert",
-         []() { test_get_or_insert<StorageType, ValueType>(); }}};
+         []() { test_get_or_insert<StorageType, ValueType>(); }},
+        {"put_batch", []() { test_put_batch<StorageType, ValueType>(); }}};
 
     std::string suite_name = storage_name + "<" + value_type_name + ">";
     run_test_suite(suite_name, tests);
 }
 
+// FingerprintKeyStorage is not a KeyStorage and has its own tests
+
+namespace {
+using Fingerprints = FingerprintKeyStorage<size_t>;
+using Candidates = std::array<size_t, Fingerprints::MAX_CANDIDATES>;
+
+// Whether value is one of the key's candidates
+bool has_candidate(const Fingerprints &storage, const std::string &key,
+                   size_t value) {
+    Candidates candidates;
+    size_t count = storage.candidates(key, candidates);
+    for (size_t i = 0; i < count; ++i) {
+        if (candidates[i] == value) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+void test_fingerprint_candidates() {
+    TEST("fingerprint_candidates")
+    Fingerprints storage(key_storage_test_root());
+    Candidates candidates;
+    ASSERT_EQ(0u, storage.candidates("missing", candidates));
+
+    storage.insert("key1", 3);
+    storage.insert("key2", 7);
+    ASSERT_EQ(2u, storage.size());
+    ASSERT_TRUE(has_candidate(storage, "key1", 3));
+    ASSERT_TRUE(has_candidate(storage, "key2", 7));
+    size_t count = storage.candidates("key1", candidates);
+    ASSERT_GE(count, 1u);
+    ASSERT_LE(count, Fingerprints::MAX_CANDIDATES);
+    END_TEST("fingerprint_candidates")
+}
+
+void test_fingerprint_replace() {
+    TEST("fingerprint_replace")
+    Fingerprints storage(key_storage_test_root());
+    storage.insert("key", 1);
+    ASSERT_FALSE(storage.replace("key", 2, 5));
+    ASSERT_TRUE(storage.replace("key", 1, 5));
+    ASSERT_TRUE(has_candidate(storage, "key", 5));
+    ASSERT_FALSE(has_candidate(storage, "key", 1));
+    ASSERT_EQ(1u, storage.size());
+    END_TEST("fingerprint_replace")
+}
+
+void test_fingerprint_growth() {
+    TEST("fingerprint_growth")
+    Fingerprints storage(key_storage_test_root());
+    const size_t count = 200000;
+    for (size_t i = 0; i < count; ++i) {
+        storage.insert("key:" + std::to_string(i), i % 32);
+    }
+    ASSERT_EQ(count, storage.size());
+
+    // Every key keeps its value through the table doublings, and most keys
+    // missing from the table have no candidate at all
+    size_t false_positives = 0;
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_TRUE(has_candidate(storage, "key:" + std::to_string(i), i % 32));
+        Candidates candidates;
+        if (storage.candidates("other:" + std::to_string(i), candidates) > 0) {
+            ++false_positives;
+        }
+    }
+    ASSERT_LT(false_positives, count / 1000);
+    END_TEST("fingerprint_growth")
+}
+
+void test_fingerprint_memory() {
+    TEST("fingerprint_memory")
+    Fingerprints storage(key_storage_test_root());
+    const size_t count = 1 << 17;
+    for (size_t i = 0; i < count; ++i) {
+        storage.insert("user" + std::to_string(i * 7919), i % 16);
+    }
+    // 6 bytes per slot, at least half of the slots used
+    ASSERT_LE(storage.memory_usage() / count, 12u);
+    END_TEST("fingerprint_memory")
+}
+
+void test_fingerprint_value_range() {
+    TEST("fingerprint_value_range")
+    Fingerprints storage(key_storage_test_root());
+    storage.insert("largest", 65535);
+    ASSERT_TRUE(has_candidate(storage, "largest", 65535));
+    bool thrown = false;
+    try {
+        storage.insert("too_large", 65536);
+    } catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+    ASSERT_EQ(1u, storage.size());
+    END_TEST("fingerprint_value_range")
+}
+
+void test_lmdb_key_storage_growth() {
+    TEST("lmdb_key_storage_growth")
+    LmdbOptions options;
+    options.map_size = 1 << 16;
+    LmdbTuning::set_options(options);
+    LmdbKeyStorage<size_t> storage(key_storage_test_root());
+    LmdbTuning::set_options(LmdbOptions());
+    ASSERT_EQ(size_t(1) << 16, storage.map_size());
+
+    // get_or_insert grows the map like put does
+    const size_t count = 5000;
+    size_t found_value = 0;
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_FALSE(storage.get_or_insert("key:" + std::to_string(i), i,
+                                           found_value));
+        ASSERT_EQ(i, found_value);
+    }
+    ASSERT_GT(storage.map_size(), size_t(1) << 16);
+
+    // Existing keys keep their value
+    for (size_t i = 0; i < count; i += 97) {
+        ASSERT_TRUE(storage.get_or_insert("key:" + std::to_string(i), count,
+                                          found_value));
+        ASSERT_EQ(i, found_value);
+    }
+    END_TEST("lmdb_key_storage_growth")
+}
+
+void test_slice_btree_layers() {
+    TEST("slice_btree_layers")
+    SliceBtreeKeyStorage<size_t> storage(key_storage_test_root());
+    std::map<std::string, size_t> expected;
+
+    // Keys sharing 8-byte slices at several depths (suffixes, then deeper
+    // layers), prefixes of each other, and embedded zero bytes
+    std::vector<std::string> keys = {"", "a", std::string("a\0", 2),
+                                     "abcdefgh", "abcdefghi", "abcdefgh\xff"};
+    for (size_t i = 0; i < 3000; ++i) {
+        keys.push_back("user" + std::to_string(i * 7919 % 3000));
+        keys.push_back("shared_prefix_of_24_byte" + std::to_string(i % 300));
+        keys.push_back(std::string(i % 20, '\0') + std::to_string(i % 50));
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+        size_t found_value = 0;
+        bool existed = storage.get_or_insert(keys[i], i, found_value);
+        auto [it, inserted] = expected.try_emplace(keys[i], i);
+        ASSERT_EQ(!inserted, existed);
+        ASSERT_EQ(it->second, found_value);
+        if (i % 3 == 0) {
+            storage.put(keys[i], i + 1);
+            it->second = i + 1;
+        }
+    }
+
+    for (const auto &[key, value] : expected) {
+        size_t found_value = 0;
+        ASSERT_TRUE(storage.get(key, found_value));
+        ASSERT_EQ(value, found_value);
+    }
+    size_t found_value = 0;
+    ASSERT_FALSE(storage.get("abcdefghij", found_value));
+    ASSERT_FALSE(storage.get("shared_prefix_of_24_byte", found_value));
+
+    // Iteration matches std::map from every kind of starting point
+    for (const std::string &start :
+         {std::string(""), std::string("abcdefgh"), std::string("shared"),
+          std::string("shared_prefix_of_24_byte15"), std::string("user1"),
+          std::string("user2999~"), std::string("\xff")}) {
+        auto it = storage.lower_bound(start);
+        for (auto expected_it = expected.lower_bound(start);
+             expected_it != expected.end(); ++expected_it, ++it) {
+            ASSERT_FALSE(it.is_end());
+            ASSERT_STR_EQ(expected_it->first, it.get_key());
+            ASSERT_EQ(expected_it->second, it.get_value());
+        }
+        ASSERT_TRUE(it.is_end());
+    }
+    END_TEST("slice_btree_layers")
+}
+
 int main() {
     std::cout << "========================================" << std::endl;
     std::cout << "  Generic KeyStorage Test Suite" << std::endl;
@@ -675,6 +889,8 @@ int main() {
                                                         "int");
     run_storage_test_suite<UnorderedDenseKeyStorage<int>, int>(
         "UnorderedDenseKeyStorage", "int");
+    run_storage_test_suite<SliceBtreeKeyStorage<int>, int>(
+        "SliceBtreeKeyStorage", "int");
 
     // Test all storage implementations with long
     std::cout << "\n=== Testing with long ===" << std::endl;
@@ -691,6 +907,8 @@ int main() {
                                                           "long");
     run_storage_test_suite<UnorderedDenseKeyStorage<long>, long>(
         "UnorderedDenseKeyStorage", "long");
+    run_storage_test_suite<SliceBtreeKeyStorage<long>, long>(
+        "SliceBtreeKeyStorage", "long");
 
     // Test all storage implementations with uint64_t
     std::cout << "\n=== Testing with uint64_t ===" << std::endl;
@@ -708,6 +926,8 @@ int main() {
         "LevelDBKeyStorage", "uint64_t");
     run_storage_test_suite<UnorderedDenseKeyStorage<uint64_t>, uint64_t>(
         "UnorderedDenseKeyStorage", "uint64_t");
+    run_storage_test_suite<SliceBtreeKeyStorage<uint64_t>, uint64_t>(
+        "SliceBtreeKeyStorage", "uint64_t");
 
     // Test all storage implementations with IndexType (trivial struct value)
     std::cout << "\n=== Testing with IndexType ===" << std::endl;
@@ -725,6 +945,22 @@ int main() {
         "LevelDBKeyStorage", "IndexType");
     run_storage_test_suite<UnorderedDenseKeyStorage<IndexType>, IndexType>(
         "UnorderedDenseKeyStorage", "IndexType");
+    run_storage_test_suite<SliceBtreeKeyStorage<IndexType>, IndexType>(
+        "SliceBtreeKeyStorage", "IndexType");
+
+    run_test_suite(
+        "FingerprintKeyStorage<size_t>",
+        {{"fingerprint_candidates", test_fingerprint_candidates},
+         {"fingerprint_replace", test_fingerprint_replace},
+         {"fingerprint_growth", test_fingerprint_growth},
+         {"fingerprint_memory", test_fingerprint_memory},
+         {"fingerprint_value_range", test_fingerprint_value_range}});
+
+    run_test_suite("LmdbKeyStorage<size_t> (map growth)",
+                   {{"lmdb_key_storage_growth", test_lmdb_key_storage_growth}});
+
+    run_test_suite("SliceBtreeKeyStorage<size_t> (layers)",
+                   {{"slice_btree_layers", test_slice_btree_layers}});
 
     std::cout << "\n========================================" << std::endl;
     std::cout << "  Overall Test Results" << std::endl;
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "PartitionPlan.h"
+#include "../storage/Status.h"
+#include "../storage/TokenBucket.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Checkpoint settings
+ */
+struct CheckpointOptions {
+    uint64_t bytes_per_second = 0; // Image bytes written per second, across
+                                   // all partitions (0: unlimited)
+    uint64_t burst_bytes = 0;      // Budget burst (0: one second worth)
+};
+
+/**
+ * @brief Outcome of a checkpoint
+ */
+struct CheckpointStats {
+    size_t bytes = 0;                     // Bytes in the checkpoint directory
+    std::chrono::nanoseconds pause{0};    // Time writers were held off
+    std::chrono::nanoseconds duration{0}; // Wall time of the checkpoint
+};
+
+/**
+ * @brief Writes the engine images and the plan of one checkpoint
+ *
+ * The storage holds its writers off, calls hold(), start()s one engine image
+ * per partition, copies its key map into a PartitionPlan and waits with
+ * wait_captured() for every image to be fixed before letting writers in
+ * again. The images are then written concurrently, one thread each, all
+ * taking their bytes from one TokenBucket. finish() saves the plan and
+ * waits for them.
+ *
+ * Everything is written into <directory>.partial, synced, and renamed to
+ * <directory> only if every part succeeded, so a checkpoint directory is
+ * always complete.
+ */
+class CheckpointWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    std::string directory_;  // Final checkpoint directory
+    std::string staging_;    // Directory written until finish()
+    TokenBucket throttle_;   // Budget shared by the images
+    Status status_;          // ERROR if the checkpoint cannot be written
+    bool staged_ = false;    // staging_ was created by this writer
+    std::mutex mutex_;       // Guards pending_
+    std::condition_variable captured_cv_; // Signalled when pending_ drops
+    size_t pending_ = 0;                  // Images not fixed yet
+    std::deque<Status> results_;          // Result of each image
+    std::vector<std::thread> threads_;    // One per image
+    Clock::time_point start_;             // Construction time
+    Clock::time_point held_;              // When writers were held off
+    std::chrono::nanoseconds pause_{0};   // Time writers were held off
+
+    void join() {
+        for (std::thread &thread : threads_) {
+            thread.join();
+        }
+        threads_.clear();
+    }
+
+public:
+    /**
+     * @brief Constructor - creates the staging directory
+     * @param directory Checkpoint directory (must not exist)
+     * @param options Throttling settings
+     */
+    CheckpointWriter(const std::string &directory,
+                     const CheckpointOptions &options) :
+        directory_(directory), staging_(directory + ".partial"),
+        throttle_(options.bytes_per_second, options.burst_bytes),
+        status_(Status::SUCCESS), start_(Clock::now()), held_(start_) {
+        std::error_code error;
+        if (directory_.empty() ||
+            std::filesystem::exists(directory_, error)) {
+            status_ = Status::ERROR;
+            return;
+        }
+        std::filesystem::remove_all(staging_, error); // Left by a crash
+        staged_ = std::filesystem::create_directories(staging_, error);
+        if (!staged_) {
+            status_ = Status::ERROR;
+        }
+    }
+
+    ~CheckpointWriter() {
+        join();
+        if (staged_) {
+            std::error_code error;
+            std::filesystem::remove_all(staging_, error); // Gone if published
+        }
+    }
+
+    // Copy constructor and assignment operator are deleted
+    CheckpointWriter(const CheckpointWriter &) = delete;
+    CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+    /**
+     * @brief Check whether the checkpoint can be written
+     * @return Status::ERROR if the directory exists or the staging directory
+     * could not be created
+     */
+    Status status() const { return status_; }
+
+    /**
+     * @brief Note that writers are held off from now on
+     */
+    void hold() { held_ = Clock::now(); }
+
+    /**
+     * @brief Start writing the image of a partition's engine
+     * @param engine The engine; must outlive finish()
+     * @param partition Partition index
+     */
+    template <typename Engine> void start(Engine &engine, size_t partition) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++pending_;
+        }
+        Status &result = results_.emplace_back(Status::ERROR);
+        threads_.emplace_back([this, &engine, partition, &result]() {
+            bool captured = false;
+            auto on_captured = [this, &captured]() {
+                captured = true;
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--pending_ == 0) {
+                    captured_cv_.notify_all();
+                }
+            };
+            result = engine.checkpoint(staging_, partition, throttle_,
+                                       on_captured);
+            if (!captured) {
+                on_captured();
+            }
+        });
+    }
+
+    /**
+     * @brief Wait until every started image is fixed; writers may be let in
+     * when this returns
+     */
+    void wait_captured() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        captured_cv_.wait(lock, [this]() { return pending_ == 0; });
+        pause_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - held_);
+    }
+
+    /**
+     * @brief Save the plan, wait for the images and publish the checkpoint
+     * @param plan Key map, placement and access graph; saved as "plan"
+     * @param stats Output: size, pause and duration of the checkpoint
+     * @return Status::SUCCESS, or Status::ERROR if any part failed (nothing
+     * is left behind)
+     */
+    Status finish(const PartitionPlan &plan, CheckpointStats &stats) {
+        if (status_ == Status::SUCCESS) {
+            status_ = plan.save(staging_ + "/plan");
+        }
+        join();
+        for (Status result : results_) {
+            if (result != Status::SUCCESS) {
+                status_ = Status::ERROR;
+            }
+        }
+        if (status_ != Status::SUCCESS) {
+            return status_;
+        }
+
+        stats.bytes = 0;
+        for (const auto &entry :
+             std::filesystem::recursive_directory_iterator(staging_)) {
+            if (entry.is_regular_file()) {
+                stats.bytes += entry.file_size();
+            }
+        }
+
+        // Everything reaches the disk before the directory gets its name
+        int fd = ::open(staging_.c_str(), O_RDONLY | O_DIRECTORY);
+        bool synced = fd >= 0 && ::syncfs(fd) == 0;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        std::error_code error;
+        if (synced) {
+            std::filesystem::rename(staging_, directory_, error);
+        }
+        if (!synced || error) {
+            status_ = Status::ERROR;
+            return status_;
+        }
+        const std::filesystem::path parent =
+            std::filesystem::absolute(directory_).parent_path();
+        fd = ::open(parent.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+
+        stats.pause = pause_;
+        stats.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - start_);
+        return Status::SUCCESS;
+    }
+};
@@ -2,12 +2,21 @@
 
 #include "RepartitioningKeyValueStorage.h"
 #include "../keystorage/KeyStorage.h"
+#include "../keystorage/FingerprintKeyStorage.h"
 #include "../storage/StorageEngine.h"
+#include "../storage/EngineTuning.h"
+#include "../storage/TieredStorageEngine.h"
+#include "../storage/CachedStorageEngine.h"
 #include "../graph/Graph.h"
 #include "../graph/MetisGraph.h"
+#include "MergeScan.h"
 #include "Tracker.h"
+#include "PartitionPlan.h"
+#include "RecoveryStats.h"
+#include "RepartitionStats.h"
+#include "Checkpoint.h"
 #include "storage/StorageEngineIterator.h"
-#include <bitset>
+#include <array>
 #include <map>
 #include <string>
 #include <vector>
@@ -22,6 +31,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <numeric>
 
 /**
  * @brief Hard repartitioning key-value storage implementation
@@ -33,6 +43,25 @@
  * This implementation creates separate storage engines for each partition and
  * migrates data by creating new storage engines during repartitioning.
  *
+ * With FingerprintKeyStorage as StorageMapType, the key map keeps a 32-bit
+ * fingerprint per key instead of the key itself (the engines already store
+ * the keys). A fingerprint may match several partitions, so reads, writes and
+ * migrations ask the candidate partitions' engines which one holds the key,
+ * and scans merge the engines' own ordered scans (see MergeScan). Meant for
+ * large keyspaces served mostly by point lookups.
+ *
+ * With a TieredStorageEngine, each repartitioning also re-tiers the
+ * partitions: the hot_partition_count() partitions with the largest tracked
+ * access weight move to the hot engine and the others to the cold one, on
+ * the repartitioning thread while requests are served.
+ *
+ * With a CachedStorageEngine, each repartitioning also keeps the
+ * PREFETCH_NEIGHBOURS strongest access-graph neighbours of every tracked
+ * key. Reading a key then prefetches its neighbours into the caches of the
+ * partitions that own them, so the reads that usually follow it hit memory.
+ * Prefetching needs the key map to locate the neighbours, so it is off with
+ * FingerprintKeyStorage.
+ *
  * @tparam StorageEngineTemplate Storage engine class template (e.g.
  *        \c MapStorageEngine)
  * @tparam STORAGE_SYNC Engine sync flag (\c
@@ -72,6 +101,15 @@ private:
         partition_locks_; // Vector of partition locks
     HashFunc hash_func_;  // Hash function for key hashing
     Tracker<> tracker_;   // Tracker for tracking key access patterns
+    PartitionPlan plan_;  // Planned keys not placed yet (load_plan())
+    std::atomic<size_t>
+        hot_partition_count_; // Partitions kept hot (TieredStorageEngine)
+    ankerl::unordered_dense::map<std::string, std::vector<std::string>>
+        neighbours_; // Keys to prefetch after each key (CachedStorageEngine)
+    RepartitionStats repartition_stats_; // Last applied repartitioning
+    mutable std::mutex
+        repartition_stats_mutex_; // Guards repartition_stats_
+    ScanFanout scan_fanout_;      // Partitions touched per scan
 
     // Threading attributes for automatic repartitioning
     std::thread repartitioning_thread_; // Background thread for automatic
@@ -85,11 +123,27 @@ private:
     std::mutex cv_mutex_;        // Mutex for condition variable
     std::vector<std::string>
         paths_; // Paths for embedded database files (default: {/tmp})
+    std::unique_ptr<typename MergeScan<StorageEngineType>::SeekPool>
+        seek_pool_; // Threads seeking the partitions of fingerprint scans
 
     using IteratorType = typename StorageEngineType::IteratorType;
 
-    static constexpr size_t MAX_PARTITION_COUNT =
-        32; // Maximum number of partitions
+    static constexpr size_t PLAN_SCAN_BATCH =
+        1024; // Pairs per engine scan when saving a fingerprint plan
+
+    static constexpr size_t RECOVERY_BATCH =
+        4096; // Pairs per engine scan and key map insert in recover()
+
+    // Key map stores fingerprints only (see FingerprintKeyStorage)
+    static constexpr bool FINGERPRINT_KEYS =
+        is_fingerprint_key_storage_v<StorageMapType<size_t>>;
+
+    // Reads prefetch co-accessed keys (see CachedStorageEngine)
+    static constexpr bool PREFETCH =
+        is_cached_storage_engine_v<StorageEngineType> && !FINGERPRINT_KEYS;
+
+    static constexpr size_t PREFETCH_NEIGHBOURS =
+        4; // Neighbours prefetched after each read
 
 public:
     /**
@@ -104,6 +158,8 @@ public:
      * @param paths Optional vector of paths for embedded database files
      * (default: {/tmp}) Each partition uses paths[i % paths.size()] to
      * distribute across paths
+     * @param profile Tuning of the storage engines and key maps (default: the
+     * EngineTuning profile)
      */
     HardRepartitioningKeyValueStorage(
         size_t partition_count, const HashFunc &hash_func = HashFunc(),
@@ -111,20 +167,23 @@ public:
             std::nullopt,
         std::optional<std::chrono::milliseconds> repartition_interval =
             std::nullopt,
-        const std::vector<std::string> &paths = {"/tmp"}) :
-        storage_map_(StorageMapType<size_t>(paths.empty() ? std::string("/tmp")
-                                                          : paths[0])),
+        const std::vector<std::string> &paths = {"/tmp"},
+        const EngineProfile &profile = EngineTuning::profile()) :
+        storage_map_(make_key_storage<StorageMapType<size_t>>(
+            paths.empty() ? std::string("/tmp") : paths[0], profile)),
         enable_tracking_(false), is_repartitioning_(false),
         partition_count_(partition_count), level_(0), hash_func_(hash_func),
+        hot_partition_count_(std::max<size_t>(1, partition_count / 4)),
         tracking_duration_(tracking_duration),
         repartition_interval_(repartition_interval), running_(true),
-        paths_(paths.empty() ? std::vector<std::string>{"/tmp"} : paths) {
+        paths_(paths.empty() ? std::vector<std::string>{"/tmp"} : paths),
+        seek_pool_(MergeScan<StorageEngineType>::make_pool(partition_count)) {
         // Create partition_count storage engine instances
         storages_.reserve(partition_count_);
         for (size_t i = 0; i < partition_count_; ++i) {
-            storages_.push_back(new StorageEngineType(
-                level_,
-                paths_[i % paths_.size()])); // Child storages at level + 1
+            storages_.push_back(new_engine<StorageEngineType>(
+                level_, paths_[i % paths_.size()], i,
+                profile)); // Child storages at level + 1
         }
 
         // Create partition locks
@@ -172,36 +231,43 @@ public:
      * @return Status code indicating the result of the operation
      */
     Status read_impl(const std::string &key, std::string &value) {
+        if constexpr (FINGERPRINT_KEYS) {
+            return fingerprint_read(key, value);
+        } else {
+            // Look up which storage owns this key
+            size_t partition_idx;
+            key_map_lock_.lock_shared();
+            bool found = storage_map_.get(key, partition_idx);
+            if (!found) {
+                // Key not found in any storage
+                key_map_lock_.unlock_shared();
+                return Status::NOT_FOUND;
+            }
 
-        // Look up which storage owns this key
-        size_t partition_idx;
-        key_map_lock_.lock_shared();
-        bool found = storage_map_.get(key, partition_idx);
-        if (!found) {
-            // Key not found in any storage
-            key_map_lock_.unlock_shared();
-            return Status::NOT_FOUND;
-        }
+            if constexpr (PREFETCH) {
+                prefetch_neighbours(key);
+            }
 
-        // Lock the partition for reading
-        partition_locks_[partition_idx]->lock_shared();
+            // Lock the partition for reading
+            partition_locks_[partition_idx]->lock_shared();
 
-        // Unlock key map (we have the storage lock now)
-        key_map_lock_.unlock_shared();
+            // Unlock key map (we have the storage lock now)
+            key_map_lock_.unlock_shared();
 
-        // Read value from storage
-        Status status = storages_[partition_idx]->read(key, value);
+            // Read value from storage
+            Status status = storages_[partition_idx]->read(key, value);
 
-        // Unlock storage
-        partition_locks_[partition_idx]->unlock_shared();
+            // Unlock storage
+            partition_locks_[partition_idx]->unlock_shared();
 
-        // Track key access if enabled
-        if (enable_tracking_) {
-            if (tracker_.update(key)) {
-                enable_tracking_ = false;
+            // Track key access if enabled
+            if (enable_tracking_) {
+                if (tracker_.update(key)) {
+                    enable_tracking_ = false;
+                }
             }
+            return status;
         }
-        return status;
     }
 
     /**
@@ -217,15 +283,27 @@ public:
 
         key_map_lock_.lock();
 
-        bool found_storage = storage_map_.get(key, partition_idx);
+        if constexpr (FINGERPRINT_KEYS) {
+            // Locks the owner's partition for writing
+            std::string current;
+            if (!find_owner(key, current, partition_idx)) {
+                partition_idx = initial_partition(key);
+                storage_map_.insert(key, partition_idx);
+                plan_.erase(key);
+                partition_locks_[partition_idx]->lock();
+            }
+        } else {
+            bool found_storage = storage_map_.get(key, partition_idx);
 
-        if (!found_storage) {
-            partition_idx = hash_func_(key) % partition_count_;
-            storage_map_.put(key, partition_idx);
-        }
+            if (!found_storage) {
+                partition_idx = initial_partition(key);
+                storage_map_.put(key, partition_idx);
+                plan_.erase(key);
+            }
 
-        // Lock the partition for writing
-        partition_locks_[partition_idx]->lock();
+            // Lock the partition for writing
+            partition_locks_[partition_idx]->lock();
+        }
 
         // Unlock key map (we have the storage lock now)
         key_map_lock_.unlock();
@@ -255,99 +333,124 @@ public:
     Status
     scan_impl(const std::string &initial_key_prefix, size_t limit,
               std::vector<std::pair<std::string, std::string>> &results) {
-        std::bitset<MAX_PARTITION_COUNT> partition_bitset;
+        if constexpr (FINGERPRINT_KEYS) {
+            return fingerprint_scan(initial_key_prefix, limit, results);
+        } else {
 
-        // Get iterator starting from initial_key
-        std::vector<std::pair<std::string, size_t>> key_index_pairs;
-        key_map_lock_.lock_shared();
-        storage_map_.scan(initial_key_prefix, limit, key_index_pairs);
+            // Get iterator starting from initial_key
+            std::vector<std::pair<std::string, size_t>> key_index_pairs;
+            key_map_lock_.lock_shared();
+            storage_map_.scan(initial_key_prefix, limit, key_index_pairs);
 
-        for (const auto &[key, partition_idx] : key_index_pairs) {
-            partition_bitset.set(partition_idx);
-        }
+            // Partitions touched, sorted so their locks are taken in the
+            // same order by every scan
+            std::vector<size_t> scanned_partitions;
+            scanned_partitions.reserve(key_index_pairs.size());
+            for (const auto &[key, partition_idx] : key_index_pairs) {
+                scanned_partitions.push_back(partition_idx);
+            }
+            std::sort(scanned_partitions.begin(), scanned_partitions.end());
+            scanned_partitions.erase(std::unique(scanned_partitions.begin(),
+                                                 scanned_partitions.end()),
+                                     scanned_partitions.end());
 
-        for (size_t i = 0; i < partition_count_; ++i) {
-            if (partition_bitset.test(i)) {
-                partition_locks_[i]->lock_shared();
+            for (size_t partition_idx : scanned_partitions) {
+                partition_locks_[partition_idx]->lock_shared();
             }
-        }
 
-        key_map_lock_.unlock_shared();
+            key_map_lock_.unlock_shared();
+            scan_fanout_.record(scanned_partitions.size());
 
-        std::map<size_t, IteratorType> iterators;
-        for (const auto &[key, partition_idx] : key_index_pairs) {
-            iterators.try_emplace(partition_idx,
-                                  storages_[partition_idx]->iterator());
-        }
+            std::map<size_t, IteratorType> iterators;
+            for (const auto &[key, partition_idx] : key_index_pairs) {
+                iterators.try_emplace(partition_idx,
+                                      storages_[partition_idx]->iterator());
+            }
 
-        // Read values from storages
-        results.reserve(key_index_pairs.size());
-        Status status = Status::NOT_FOUND;
-        for (const auto &[key, partition_idx] : key_index_pairs) {
-            std::string value;
-            IteratorType &iterator = iterators.at(partition_idx);
-            status = iterator.find(key, value);
-            if (status != Status::SUCCESS) {
-                break;
+            // Read values from storages
+            results.reserve(key_index_pairs.size());
+            Status status = Status::NOT_FOUND;
+            for (const auto &[key, partition_idx] : key_index_pairs) {
+                std::string value;
+                IteratorType &iterator = iterators.at(partition_idx);
+                status = iterator.find(key, value);
+                if (status != Status::SUCCESS) {
+                    break;
+                }
+                results.push_back({key, value});
             }
-            results.push_back({key, value});
-        }
 
-        iterators.clear();
+            iterators.clear();
 
-        for (size_t i = 0; i < partition_count_; ++i) {
-            if (partition_bitset.test(i)) {
-                partition_locks_[i]->unlock_shared();
+            for (size_t partition_idx : scanned_partitions) {
+                partition_locks_[partition_idx]->unlock_shared();
             }
-        }
 
-        // Track key access patterns if enabled
-        if (enable_tracking_) {
-            std::vector<std::string> keys;
-            for (auto it = std::make_move_iterator(key_index_pairs.begin()),
-                      end = std::make_move_iterator(key_index_pairs.end());
-                 it != end; ++it) {
-                keys.push_back(std::move(it->first));
-            }
-            if (tracker_.multi_update(keys)) {
-                enable_tracking_ = false;
+            // Track key access patterns if enabled
+            if (enable_tracking_) {
+                std::vector<std::string> keys;
+                for (auto it = std::make_move_iterator(key_index_pairs.begin()),
+                          end = std::make_move_iterator(key_index_pairs.end());
+                     it != end; ++it) {
+                    keys.push_back(std::move(it->first));
+                }
+                if (tracker_.multi_update(keys)) {
+                    enable_tracking_ = false;
+                }
             }
-        }
 
-        return status;
+            return status;
+        }
     }
 
-    void update_storage_map() {
+    /**
+     * @brief Move the tracked keys to their METIS partitions
+     * @param stats Receives the number of keys moved and their bytes
+     */
+    void update_storage_map(RepartitionStats &stats) {
         std::vector<idx_t> metis_partitions = tracker_.get_metis_partitions();
         const auto &idx_to_vertex = tracker_.get_idx_to_vertex();
         for (size_t i = 0; i < metis_partitions.size(); ++i) {
             size_t next_partition_idx =
                 static_cast<size_t>(metis_partitions[i]);
-            size_t partition_idx;
             key_map_lock_.lock();
-            bool found = storage_map_.get(idx_to_vertex[i], partition_idx);
-            if (found && next_partition_idx != partition_idx) {
-                size_t curr_partition_idx = partition_idx;
-                if (partition_idx <= next_partition_idx) {
-                    partition_locks_[curr_partition_idx]->lock();
-                    partition_locks_[next_partition_idx]->lock();
-                } else {
-                    partition_locks_[next_partition_idx]->lock();
-                    partition_locks_[curr_partition_idx]->lock();
+            if constexpr (FINGERPRINT_KEYS) {
+                size_t bytes =
+                    fingerprint_migrate(idx_to_vertex[i], next_partition_idx);
+                if (bytes > 0) {
+                    ++stats.keys_reassigned;
+                    stats.bytes_migrated += bytes;
                 }
+            } else {
+                size_t partition_idx;
+                bool found = storage_map_.get(idx_to_vertex[i], partition_idx);
+                if (found && next_partition_idx != partition_idx) {
+                    size_t curr_partition_idx = partition_idx;
+                    if (partition_idx <= next_partition_idx) {
+                        partition_locks_[curr_partition_idx]->lock();
+                        partition_locks_[next_partition_idx]->lock();
+                    } else {
+                        partition_locks_[next_partition_idx]->lock();
+                        partition_locks_[curr_partition_idx]->lock();
+                    }
 
-                storage_map_.put(idx_to_vertex[i], next_partition_idx);
-                key_map_lock_.unlock();
+                    storage_map_.put(idx_to_vertex[i], next_partition_idx);
+                    key_map_lock_.unlock();
 
-                std::string value;
-                storages_[partition_idx]->read(idx_to_vertex[i], value);
-                storages_[next_partition_idx]->write(idx_to_vertex[i], value);
-                storages_[partition_idx]->remove(idx_to_vertex[i], value);
+                    std::string value;
+                    storages_[partition_idx]->read(idx_to_vertex[i], value);
+                    storages_[next_partition_idx]->write(idx_to_vertex[i],
+                                                         value);
+                    storages_[partition_idx]->remove(idx_to_vertex[i], value);
+                    ++stats.keys_reassigned;
+                    stats.bytes_migrated += idx_to_vertex[i].size() +
+                                            value.size();
 
-                partition_locks_[curr_partition_idx]->unlock();
-                partition_locks_[next_partition_idx]->unlock();
-            } else {
-                key_map_lock_.unlock();
+                    partition_locks_[curr_partition_idx]->unlock();
+                    partition_locks_[next_partition_idx]->unlock();
+                } else {
+                    key_map_lock_.unlock();
+                }
             }
         }
         // Lock the graph to clear it
@@ -379,24 +482,253 @@ public:
         // Set repartitioning flag and disable tracking temporarily
         is_repartitioning_ = true;
 
+        RepartitionStats stats;
         bool success =
-            tracker_.prepare_for_partition_map_update(partition_count_);
+            tracker_.prepare_for_partition_map_update(partition_count_, stats);
 
         if (success) {
+            if constexpr (PREFETCH) {
+                // The graph is cleared by update_storage_map()
+                auto neighbours =
+                    tracker_.co_accessed_keys(PREFETCH_NEIGHBOURS);
+                key_map_lock_.lock();
+                neighbours_ = std::move(neighbours);
+                key_map_lock_.unlock();
+            }
+
             // Step 3: Lock and update partition assignments
             // Save old storages
 
             // Update partition_map with new assignments
-            this->update_storage_map();
+            const auto update_start = std::chrono::steady_clock::now();
+            this->update_storage_map(stats);
+            stats.update_time =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - update_start);
+
+            if constexpr (is_tiered_storage_engine_v<StorageEngineType>) {
+                retier();
+            }
 
             // Create new storage engines
             // Increment level for new storage e
+
+            stats.scan_fanout = scan_fanout_.roll();
+            std::lock_guard<std::mutex> lock(repartition_stats_mutex_);
+            stats.cycle = repartition_stats_.cycle + 1;
+            repartition_stats_ = stats;
         }
 
         // Clear repartitioning flag
         is_repartitioning_ = false;
     }
 
+    Status save_plan_impl(const std::string &path) {
+        PartitionPlan plan(partition_count_);
+        key_map_lock_.lock_shared();
+        if constexpr (FINGERPRINT_KEYS) {
+            // The keys are only known to the engines
+            for (size_t i = 0; i < partition_count_; ++i) {
+                partition_locks_[i]->lock_shared();
+            }
+            key_map_lock_.unlock_shared();
+            std::vector<std::pair<std::string, std::string>> batch;
+            for (size_t i = 0; i < partition_count_; ++i) {
+                std::string next_key;
+                do {
+                    batch.clear();
+                    storages_[i]->scan(next_key, PLAN_SCAN_BATCH, batch);
+                    for (const auto &[key, value] : batch) {
+                        plan.assign(key, i);
+                    }
+                    if (!batch.empty()) {
+                        next_key = batch.back().first + '\0';
+                    }
+                } while (batch.size() == PLAN_SCAN_BATCH);
+            }
+            for (size_t i = 0; i < partition_count_; ++i) {
+                partition_locks_[i]->unlock_shared();
+            }
+        } else {
+            for (auto it = storage_map_.lower_bound(""); !it.is_end(); ++it) {
+                plan.assign(it.get_key(), it.get_value());
+            }
+            key_map_lock_.unlock_shared();
+        }
+        plan.graph() = tracker_.snapshot_graph();
+        return plan.save(path);
+    }
+
+    Status load_plan_impl(const std::string &path) {
+        PartitionPlan plan;
+        Status status = plan.load(path);
+        if (status != Status::SUCCESS) {
+            return status;
+        }
+        if (plan.partition_count() != partition_count_) {
+            return Status::ERROR;
+        }
+        tracker_.merge_graph(plan.graph());
+        plan.graph().clear();
+
+        key_map_lock_.lock();
+        // Keys already placed keep their partition
+        plan.erase_placed([this](const std::string &key) {
+            size_t partition_idx;
+            if constexpr (FINGERPRINT_KEYS) {
+                std::string value;
+                if (!find_owner(key, value, partition_idx)) {
+                    return false;
+                }
+                partition_locks_[partition_idx]->unlock();
+                return true;
+            } else {
+                return storage_map_.get(key, partition_idx);
+            }
+        });
+        plan_ = std::move(plan);
+        key_map_lock_.unlock();
+        return Status::SUCCESS;
+    }
+
+    /**
+     * @brief Rebuild the key map from the data already in the engines
+     *
+     * With an EnginePersistence store set, the partition engines reopen the
+     * data of a previous run, but the key map starts empty. Every partition
+     * is scanned by its own thread, in batches of RECOVERY_BATCH pairs, and
+     * each batch enters the key map with one put_batch() under the key map
+     * lock. A key found in two partitions (a crash in the middle of a move)
+     * maps to the one inserted last; both hold the same value. Keys already
+     * in the key map are not added twice, so recovering again is harmless.
+     *
+     * Call before the storage serves requests.
+     *
+     * @return Keys and bytes recovered, and the time it took
+     */
+    RecoveryStats recover() {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<RecoveryStats> partials(partition_count_);
+        std::vector<std::thread> scanners;
+        scanners.reserve(partition_count_);
+        for (size_t i = 0; i < partition_count_; ++i) {
+            scanners.emplace_back([this, i, &partials]() {
+                std::vector<std::pair<std::string, std::string>> batch;
+                std::vector<std::pair<std::string, size_t>> entries;
+                std::string next_key;
+                do {
+                    batch.clear();
+                    partition_locks_[i]->lock_shared();
+                    storages_[i]->scan(next_key, RECOVERY_BATCH, batch);
+                    partition_locks_[i]->unlock_shared();
+
+                    entries.clear();
+                    for (const auto &[key, value] : batch) {
+                        partials[i].bytes += key.size() + value.size();
+                        entries.emplace_back(key, i);
+                    }
+                    partials[i].keys += batch.size();
+
+                    key_map_lock_.lock();
+                    if constexpr (FINGERPRINT_KEYS) {
+                        for (const auto &[key, partition_idx] : entries) {
+                            if (!has_candidate(key, partition_idx)) {
+                                storage_map_.insert(key, partition_idx);
+                            }
+                        }
+                    } else {
+                        storage_map_.put_batch(entries);
+                    }
+                    key_map_lock_.unlock();
+
+                    if (!batch.empty()) {
+                        next_key = batch.back().first + '\0';
+                    }
+                } while (batch.size() == RECOVERY_BATCH);
+            });
+        }
+        for (auto &scanner : scanners) {
+            scanner.join();
+        }
+
+        RecoveryStats stats;
+        for (const RecoveryStats &partial : partials) {
+            stats.keys += partial.keys;
+            stats.bytes += partial.bytes;
+        }
+        stats.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start);
+        return stats;
+    }
+
+    /**
+     * @brief Write a consistent checkpoint while serving requests
+     *
+     * Writers are held off (the key map and every partition locked shared)
+     * only until each partition's engine has fixed its image (see
+     * StorageEngine::checkpoint()) and the key map is copied into the plan;
+     * reads go on meanwhile. The images are then written by one thread per
+     * partition, together at most options.bytes_per_second. Tkrzw engines
+     * fix their image only once their file is copied, so writers are held
+     * off for the whole copy, which runs unthrottled.
+     *
+     * The directory holds the images under their EnginePersistence names
+     * and the key map, placement and access graph as a PartitionPlan file,
+     * "plan". Copied into <path>/repart_kv_storage/<name>, it opens as store
+     * <name>: recover() and load_plan() then restore the storage. With a
+     * fingerprint key map the plan holds no keys; recover() finds them in
+     * the images.
+     *
+     * @param directory Checkpoint directory (must not exist)
+     * @param options Throttling settings
+     * @param stats Output: size, pause and duration of the checkpoint
+     * @return Status::SUCCESS, or Status::ERROR if it could not be written
+     * (no directory is left behind)
+     */
+    Status checkpoint(const std::string &directory,
+                      const CheckpointOptions &options,
+                      CheckpointStats &stats) {
+        CheckpointWriter writer(directory, options);
+        if (writer.status() != Status::SUCCESS) {
+            return Status::ERROR;
+        }
+
+        PartitionPlan plan(partition_count_);
+        key_map_lock_.lock_shared();
+        for (size_t i = 0; i < partition_count_; ++i) {
+            partition_locks_[i]->lock_shared();
+        }
+        writer.hold();
+        for (size_t i = 0; i < partition_count_; ++i) {
+            writer.start(*storages_[i], i);
+        }
+        if constexpr (!FINGERPRINT_KEYS) {
+            for (auto it = storage_map_.lower_bound(""); !it.is_end(); ++it) {
+                plan.assign(it.get_key(), it.get_value());
+            }
+        }
+        writer.wait_captured();
+        for (size_t i = 0; i < partition_count_; ++i) {
+            partition_locks_[i]->unlock_shared();
+        }
+        key_map_lock_.unlock_shared();
+
+        plan.graph() = tracker_.snapshot_graph();
+        return writer.finish(plan, stats);
+    }
+
+    /**
+     * @brief Write a consistent checkpoint while serving requests
+     * @param directory Checkpoint directory (must not exist)
+     * @param options Throttling settings
+     * @return Status::SUCCESS, or Status::ERROR if it could not be written
+     */
+    Status checkpoint(const std::string &directory,
+                      const CheckpointOptions &options = {}) {
+        CheckpointStats stats;
+        return checkpoint(directory, options, stats);
+    }
+
     // Interface methods required by the abstract base class
     void enable_tracking_impl(bool enable) {
         enable_tracking_ = enable;
@@ -408,10 +740,85 @@ public:
 
     bool enable_tracking_impl() const { return enable_tracking_; }
 
+    /**
+     * @brief Set how many partitions run on the hot engine
+     *
+     * Only used with a TieredStorageEngine (default: a quarter of the
+     * partitions, at least one). Applied at the next repartitioning.
+     *
+     * @param count Number of hot partitions
+     */
+    void hot_partition_count(size_t count) { hot_partition_count_ = count; }
+
+    /**
+     * @brief Get how many partitions run on the hot engine
+     * @return Number of hot partitions
+     */
+    size_t hot_partition_count() const { return hot_partition_count_; }
+
+    /**
+     * @brief Get the tier of a partition (TieredStorageEngine only)
+     * @param partition_idx The partition
+     * @return The tier serving the partition
+     */
+    Tier partition_tier(size_t partition_idx) const {
+        static_assert(is_tiered_storage_engine_v<StorageEngineType>,
+                      "partition_tier() requires a TieredStorageEngine");
+        return storages_[partition_idx]->tier();
+    }
+
+    /**
+     * @brief Get the read cache counters of all partitions
+     * (CachedStorageEngine only)
+     * @return Hits, misses, prefetched and wasted entries, summed
+     */
+    CacheStats cache_stats() const
+        requires is_cached_storage_engine_v<StorageEngineType>
+    {
+        CacheStats stats;
+        for (auto *storage : storages_) {
+            stats += storage->cache_stats();
+        }
+        return stats;
+    }
+
     bool is_repartitioning_impl() const { return is_repartitioning_.load(); }
 
+    RepartitionStats repartition_stats_impl() const {
+        std::lock_guard<std::mutex> lock(repartition_stats_mutex_);
+        return repartition_stats_;
+    }
+
+    double scan_fanout_impl() const { return scan_fanout_.mean(); }
+
     const Graph &graph_impl() const { return tracker_.graph(); }
 
+    /**
+     * @brief Sync every partition engine to disk (implementation for CRTP)
+     *
+     * Holds the key map and every partition shared, like checkpoint(), so
+     * that no key is halfway through a move while the engines sync.
+     *
+     * @return true if every engine synced
+     */
+    bool sync_impl()
+        requires requires(StorageEngineType &engine) { engine.sync(); }
+    {
+        key_map_lock_.lock_shared();
+        for (size_t i = 0; i < partition_count_; ++i) {
+            partition_locks_[i]->lock_shared();
+        }
+        bool ok = true;
+        for (auto *storage : storages_) {
+            ok = storage->sync() && ok;
+        }
+        for (size_t i = 0; i < partition_count_; ++i) {
+            partition_locks_[i]->unlock_shared();
+        }
+        key_map_lock_.unlock_shared();
+        return ok;
+    }
+
     size_t operation_count_impl() const {
         size_t operation_count = 0;
         for (auto *storage : storages_) {
@@ -421,6 +828,236 @@ public:
     }
 
 private:
+    /**
+     * @brief Check whether a partition is among a key's candidates
+     * (fingerprint mode); the key map must be locked by the caller
+     */
+    bool has_candidate(const std::string &key, size_t partition_idx) const {
+        std::array<size_t, FingerprintKeyStorage<size_t>::MAX_CANDIDATES>
+            candidates;
+        size_t count = storage_map_.candidates(key, candidates);
+        return std::find(candidates.begin(), candidates.begin() + count,
+                         partition_idx) != candidates.begin() + count;
+    }
+
+    /**
+     * @brief Find the partition whose engine holds a key (fingerprint mode)
+     *
+     * Asks the engine of every partition the key's fingerprint points to,
+     * locking each one exclusively; the owner is left locked. The key map
+     * must be locked exclusively by the caller.
+     *
+     * @param key The key
+     * @param value Output parameter for the key's current value
+     * @param partition_idx Output parameter for the owner
+     * @return true if a partition holds the key
+     */
+    bool find_owner(const std::string &key, std::string &value,
+                    size_t &partition_idx) {
+        std::array<size_t, FingerprintKeyStorage<size_t>::MAX_CANDIDATES>
+            candidates;
+        size_t count = storage_map_.candidates(key, candidates);
+        for (size_t i = 0; i < count; ++i) {
+            partition_locks_[candidates[i]]->lock();
+            if (storages_[candidates[i]]->read(key, value) ==
+                Status::SUCCESS) {
+                partition_idx = candidates[i];
+                return true;
+            }
+            partition_locks_[candidates[i]]->unlock();
+        }
+        return false;
+    }
+
+    /**
+     * @brief Read a value in fingerprint mode
+     *
+     * Tries the candidate partitions in turn; the key map is released once
+     * the last candidate is locked, like in the regular read.
+     */
+    Status fingerprint_read(const std::string &key, std::string &value) {
+        std::array<size_t, FingerprintKeyStorage<size_t>::MAX_CANDIDATES>
+            candidates;
+        key_map_lock_.lock_shared();
+        size_t count = storage_map_.candidates(key, candidates);
+        bool key_map_locked = true;
+        Status status = Status::NOT_FOUND;
+        for (size_t i = 0; i < count && status == Status::NOT_FOUND; ++i) {
+            partition_locks_[candidates[i]]->lock_shared();
+            if (i + 1 == count) {
+                key_map_lock_.unlock_shared();
+                key_map_locked = false;
+            }
+            status = storages_[candidates[i]]->read(key, value);
+            partition_locks_[candidates[i]]->unlock_shared();
+        }
+        if (key_map_locked) {
+            key_map_lock_.unlock_shared();
+        }
+
+        // Track key access if enabled
+        if (enable_tracking_ && count > 0) {
+            if (tracker_.update(key)) {
+                enable_tracking_ = false;
+            }
+        }
+        return status;
+    }
+
+    /**
+     * @brief Scan in fingerprint mode by merging every engine's scan
+     */
+    Status fingerprint_scan(
+        const std::string &initial_key_prefix, size_t limit,
+        std::vector<std::pair<std::string, std::string>> &results) {
+        key_map_lock_.lock_shared();
+        for (size_t i = 0; i < partition_count_; ++i) {
+            partition_locks_[i]->lock_shared();
+        }
+        key_map_lock_.unlock_shared();
+
+        results.clear();
+        if (limit > 0) {
+            MergeScan<StorageEngineType>::merge(storages_, initial_key_prefix,
+                                                limit, results,
+                                                seek_pool_.get());
+        }
+        scan_fanout_.record(partition_count_);
+
+        for (size_t i = 0; i < partition_count_; ++i) {
+            partition_locks_[i]->unlock_shared();
+        }
+
+        // Track key access patterns if enabled
+        if (enable_tracking_ && !results.empty()) {
+            std::vector<std::string> keys;
+            keys.reserve(results.size());
+            for (const auto &[key, value] : results) {
+                keys.push_back(key);
+            }
+            if (tracker_.multi_update(keys)) {
+                enable_tracking_ = false;
+            }
+        }
+
+        return results.empty() ? Status::NOT_FOUND : Status::SUCCESS;
+    }
+
+    /**
+     * @brief Move a key to another partition in fingerprint mode
+     *
+     * Called with the key map locked exclusively; releases it.
+     *
+     * @param key The key
+     * @param next_partition_idx The partition to move the key to
+     * @return Bytes of the key and value moved, 0 if the key did not move
+     */
+    size_t fingerprint_migrate(const std::string &key,
+                               size_t next_partition_idx) {
+        std::string value;
+        size_t partition_idx;
+        if (!find_owner(key, value, partition_idx)) {
+            key_map_lock_.unlock();
+            return 0;
+        }
+        if (partition_idx == next_partition_idx) {
+            partition_locks_[partition_idx]->unlock();
+            key_map_lock_.unlock();
+            return 0;
+        }
+
+        // Partitions are locked in index order; the key map keeps the key
+        // from changing while the owner is briefly unlocked
+        if (next_partition_idx < partition_idx) {
+            partition_locks_[partition_idx]->unlock();
+            partition_locks_[next_partition_idx]->lock();
+            partition_locks_[partition_idx]->lock();
+        } else {
+            partition_locks_[next_partition_idx]->lock();
+        }
+
+        storage_map_.replace(key, partition_idx, next_partition_idx);
+        key_map_lock_.unlock();
+
+        storages_[next_partition_idx]->write(key, value);
+        storages_[partition_idx]->remove(key, value);
+
+        partition_locks_[partition_idx]->unlock();
+        partition_locks_[next_partition_idx]->unlock();
+        return key.size() + value.size();
+    }
+
+    /**
+     * @brief Prefetch the strongest neighbours of a key into the caches of
+     * their partitions; the key map must be locked by the caller
+     */
+    void prefetch_neighbours(const std::string &key) {
+        auto it = neighbours_.find(key);
+        if (it == neighbours_.end()) {
+            return;
+        }
+        for (const std::string &neighbour : it->second) {
+            size_t partition_idx;
+            if (storage_map_.get(neighbour, partition_idx)) {
+                storages_[partition_idx]->prefetch(neighbour);
+            }
+        }
+    }
+
+    /**
+     * @brief Choose the partition of a key written for the first time
+     * @param key The key
+     * @return The partition planned by load_plan(), or the key's hash
+     * partition
+     */
+    size_t initial_partition(const std::string &key) const {
+        size_t partition_idx;
+        if (plan_.partition_of(key, partition_idx)) {
+            return partition_idx;
+        }
+        return hash_func_(key) % partition_count_;
+    }
+
+    /**
+     * @brief Move the most accessed partitions to the hot engine and the
+     * others to the cold one (TieredStorageEngine only)
+     *
+     * A partition's weight is the tracked access weight of the keys METIS
+     * just placed in it. Demotions run first so memory is freed before hot
+     * engines fill up.
+     */
+    void retier() {
+        const std::vector<idx_t> &vertex_weights =
+            tracker_.get_metis_vertex_weights();
+        std::vector<idx_t> metis_partitions = tracker_.get_metis_partitions();
+        std::vector<uint64_t> weights(partition_count_, 0);
+        for (size_t i = 0;
+             i < metis_partitions.size() && i < vertex_weights.size(); ++i) {
+            weights[static_cast<size_t>(metis_partitions[i])] +=
+                static_cast<uint64_t>(vertex_weights[i]);
+        }
+
+        std::vector<size_t> order(partition_count_);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&weights](size_t a, size_t b) {
+                             return weights[a] > weights[b];
+                         });
+        size_t hot_count = std::min<size_t>(hot_partition_count_,
+                                            partition_count_);
+
+        for (size_t rank = hot_count; rank < partition_count_; ++rank) {
+            storages_[order[rank]]->demote();
+        }
+        for (size_t rank = 0; rank < hot_count; ++rank) {
+            if (weights[order[rank]] > 0) {
+                storages_[order[rank]]->promote();
+            } else {
+                storages_[order[rank]]->demote();
+            }
+        }
+    }
+
     /**
      * @brief Background thread loop for automatic repartitioning
      *
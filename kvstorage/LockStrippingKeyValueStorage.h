@@ -3,8 +3,10 @@
 #include "RepartitioningKeyValueStorage.h"
 #include "../keystorage/KeyStorage.h"
 #include "../storage/StorageEngine.h"
+#include "../storage/EngineTuning.h"
 #include "../graph/Graph.h"
 #include "../graph/MetisGraph.h"
+#include "MergeScan.h"
 #include "Tracker.h"
 #include "storage/StorageEngineIterator.h"
 #include <map>
@@ -27,8 +29,8 @@
  *
  * This class manages partitioned storage with static partitioning
  * capabilities. Uses a single storage engine for each partition.
- * Range scans require locking all partitions and scanning all of
- * them with the requested limit.
+ * Range scans read lock all partitions and merge per-partition cursors,
+ * stopping as soon as the requested limit is reached.
  *
  * @tparam StorageEngineTemplate Storage engine class template
  * @tparam STORAGE_SYNC Engine sync flag
@@ -53,6 +55,8 @@ private:
     HashFunc hash_func_;  // Hash function for key hashing
     std::vector<std::string>
         paths_; // Paths for embedded database files (default: {/tmp})
+    std::unique_ptr<typename MergeScan<StorageEngineType>::SeekPool>
+        seek_pool_; // Threads seeking the partitions of large scans
 
     using IteratorType = typename StorageEngineType::IteratorType;
 
@@ -69,19 +73,23 @@ public:
      * @param paths Optional vector of paths for embedded database files
      * (default: {/tmp}) Each partition uses paths[i % paths.size()] to
      * distribute across paths
+     * @param profile Tuning of the storage engines (default: the EngineTuning
+     * profile)
      */
     LockStrippingKeyValueStorage(
         size_t partition_count, const HashFunc &hash_func = HashFunc(),
-        const std::vector<std::string> &paths = {"/tmp"}) :
+        const std::vector<std::string> &paths = {"/tmp"},
+        const EngineProfile &profile = EngineTuning::profile()) :
         partition_count_(partition_count), hash_func_(hash_func),
-        paths_(paths.empty() ? std::vector<std::string>{"/tmp"} : paths) {
+        paths_(paths.empty() ? std::vector<std::string>{"/tmp"} : paths),
+        seek_pool_(MergeScan<StorageEngineType>::make_pool(partition_count)) {
 
         // Create partition_count storage engine instances
         storages_.reserve(partition_count_);
         for (size_t i = 0; i < partition_count_; ++i) {
-            storages_.push_back(new StorageEngineType(
-                1,
-                paths_[i % paths_.size()])); // Child storages at level + 1
+            storages_.push_back(new_engine<StorageEngineType>(
+                1, paths_[i % paths_.size()], i,
+                profile)); // Child storages at level + 1
         }
 
         // Create partition locks
@@ -136,42 +144,50 @@ public:
      * @param limit Maximum number of key-value pairs to return
      * @param results Reference to store the results
      * @return Status code indicating the result of the operation
+     *
+     * Merges the partitions with a k-way heap over one cursor per partition
+     * (see MergeScan).
      */
     Status
     scan_impl(const std::string &initial_key_prefix, size_t limit,
               std::vector<std::pair<std::string, std::string>> &results) {
 
-        Status status = Status::SUCCESS;
         // Read lock all storages
         for (size_t i = 0; i < partition_count_; ++i) {
             partition_locks_[i]->lock_shared();
         }
 
         results.clear();
-        results.reserve(limit * partition_count_);
+        results.reserve(limit);
 
-        for (size_t i = 0; i < partition_count_; ++i) {
-            std::vector<std::pair<std::string, std::string>> partition_results;
-            partition_results.reserve(limit);
-            storages_[i]->scan(initial_key_prefix, limit, partition_results);
-            results.insert(results.end(), partition_results.begin(),
-                           partition_results.end());
+        if (limit > 0) {
+            MergeScan<StorageEngineType>::merge(storages_, initial_key_prefix,
+                                                limit, results,
+                                                seek_pool_.get());
         }
 
-        if (results.empty()) {
-            status = Status::NOT_FOUND;
+        // Unlock all storages
+        for (size_t i = 0; i < partition_count_; ++i) {
+            partition_locks_[i]->unlock_shared();
         }
 
-        std::sort(results.begin(), results.end());
-
-        results.resize(std::min(results.size(), limit));
+        return results.empty() ? Status::NOT_FOUND : Status::SUCCESS;
+    }
 
-        // Unlock all storages
+    /**
+     * @brief Sync every partition engine to disk (implementation for CRTP)
+     * @return true if every engine synced
+     */
+    bool sync_impl()
+        requires requires(StorageEngineType &engine) { engine.sync(); }
+    {
+        bool ok = true;
         for (size_t i = 0; i < partition_count_; ++i) {
+            partition_locks_[i]->lock_shared();
+            ok = storages_[i]->sync() && ok;
             partition_locks_[i]->unlock_shared();
         }
-
-        return status;
+        return ok;
     }
 
     size_t operation_count_impl() const {
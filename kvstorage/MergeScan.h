@@ -0,0 +1,220 @@
+#pragma once
+
+#include "../storage/Status.h"
+#include "threaded/StrandPool.h"
+#include "threaded/operation/Rendezvous.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Ordered scan over several storage engines holding disjoint keys
+ *
+ * Performs a k-way merge over one cursor per engine: a min-heap holds the
+ * engine whose next key is the smallest, and the merge stops as soon as limit
+ * pairs have been emitted, in O(limit log P) comparisons. Cursors fetch small
+ * batches that grow on demand, so an engine whose keys are not reached never
+ * returns more than its first batch. For large limits, the first batches of
+ * all engines are fetched in parallel on a SeekPool owned by the caller (its
+ * threads are started once, so a seek only pays for a hand-off); this hides
+ * the seek latency of disk engines.
+ *
+ * The caller must keep the engines from being written during the merge
+ * (e.g. by read locking all partitions).
+ *
+ * @tparam StorageEngineType Storage engine type
+ */
+template <typename StorageEngineType> class MergeScan {
+public:
+    // Smallest first batch fetched by a scan cursor
+    static constexpr size_t MIN_SCAN_BATCH = 16;
+    // Limit from which the first batches are fetched in parallel
+    static constexpr size_t PARALLEL_SEEK_MIN_LIMIT = 256;
+
+private:
+    /**
+     * @brief Position of a scan inside one engine
+     */
+    struct ScanCursor {
+        std::vector<std::pair<std::string, std::string>>
+            batch;              // Pairs fetched from the engine
+        size_t position = 0;    // Next pair of batch to merge
+        std::string next_key;   // First key of the next batch
+        size_t batch_size = 0;  // Number of pairs requested by the last fetch
+        bool exhausted = false; // No keys left after batch
+    };
+
+    /**
+     * @brief Fetch the next batch of a cursor
+     * @param storage Engine the cursor scans
+     * @param cursor The cursor to refill
+     * @param count Number of pairs to fetch
+     * @return true if at least one pair was fetched
+     */
+    static bool fetch(StorageEngineType *storage, ScanCursor &cursor,
+                      size_t count) {
+        cursor.batch.clear();
+        cursor.position = 0;
+        cursor.batch_size = count;
+        Status status = storage->scan(cursor.next_key, count, cursor.batch);
+        if (status != Status::SUCCESS) {
+            cursor.batch.clear();
+        }
+        cursor.exhausted = cursor.batch.size() < count;
+        if (cursor.batch.empty()) {
+            return false;
+        }
+        // Smallest key greater than the last one fetched
+        cursor.next_key = cursor.batch.back().first + '\0';
+        return true;
+    }
+
+public:
+    /**
+     * @brief First batch fetch of one cursor, run as a strand on a SeekPool
+     */
+    class Seek {
+    private:
+        friend class MergeScan;
+
+        Strand strand_;                        // Scheduling state on the pool
+        StorageEngineType *storage_ = nullptr; // Engine to seek
+        ScanCursor *cursor_ = nullptr;         // Cursor to fill
+        size_t count_ = 0;                     // Pairs to fetch
+        char *has_pairs_ = nullptr;            // Set if a pair was fetched
+        Rendezvous *done_ = nullptr;           // Joined once fetched
+
+    public:
+        /**
+         * @brief Get the seek's scheduling state (for the pool)
+         * @return The strand
+         */
+        Strand &strand() { return strand_; }
+
+        /**
+         * @brief Fetch the first batch (pool threads only)
+         * @return false: a seek is a single turn
+         */
+        bool run(size_t) {
+            *has_pairs_ = fetch(storage_, *cursor_, count_);
+            done_->arrive();
+            return false;
+        }
+    };
+
+    using SeekPool = StrandPool<Seek>;
+
+    /**
+     * @brief Make the pool a storage seeks its engines on
+     * @param engine_count Number of engines merged by the storage
+     * @return A pool of up to one thread per engine beyond the first (the
+     * calling thread seeks one engine itself), or nullptr for a single engine
+     */
+    static std::unique_ptr<SeekPool> make_pool(size_t engine_count) {
+        if (engine_count < 2) {
+            return nullptr;
+        }
+        size_t threads = std::max<size_t>(std::thread::hardware_concurrency(),
+                                          1);
+        return std::make_unique<SeekPool>(
+            std::min(engine_count - 1, threads));
+    }
+
+    /**
+     * @brief Merge the engines' keys from a start key up to a limit
+     * @param storages The engines to merge
+     * @param start_key First key (inclusive) of the scan
+     * @param limit Maximum number of pairs to merge (greater than 0)
+     * @param results Vector the merged pairs are appended to
+     * @param pool Pool the first batches are fetched on when the limit
+     * reaches PARALLEL_SEEK_MIN_LIMIT (default: none, every engine is seeked
+     * on the calling thread)
+     */
+    static void
+    merge(const std::vector<StorageEngineType *> &storages,
+          const std::string &start_key, size_t limit,
+          std::vector<std::pair<std::string, std::string>> &results,
+          SeekPool *pool = nullptr) {
+        const size_t count = storages.size();
+        std::vector<ScanCursor> cursors(count);
+        size_t first_batch = std::min(
+            limit, std::max(MIN_SCAN_BATCH, (limit + count - 1) / count));
+
+        // Seek every engine to the start key
+        std::vector<char> has_pairs(count, 0);
+        for (size_t i = 0; i < count; ++i) {
+            cursors[i].next_key = start_key;
+        }
+        if (pool != nullptr && count > 1 && limit >= PARALLEL_SEEK_MIN_LIMIT) {
+            // The calling thread seeks the first engine while the pool
+            // seeks the others
+            Rendezvous done(count);
+            std::vector<Seek> seeks(count - 1);
+            for (size_t i = 1; i < count; ++i) {
+                Seek &seek = seeks[i - 1];
+                seek.storage_ = storages[i];
+                seek.cursor_ = &cursors[i];
+                seek.count_ = first_batch;
+                seek.has_pairs_ = &has_pairs[i];
+                seek.done_ = &done;
+                if (seek.strand_.notify()) {
+                    pool->submit(&seek);
+                }
+            }
+            has_pairs[0] = fetch(storages[0], cursors[0], first_batch);
+            done.wait();
+            // A pool thread may still be ending a seek's run
+            for (Seek &seek : seeks) {
+                while (!seek.strand_.idle()) {
+                    std::this_thread::yield();
+                }
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                has_pairs[i] = fetch(storages[i], cursors[i], first_batch);
+            }
+        }
+
+        // Min-heap of engines ordered by their cursor's next key
+        auto greater = [&cursors](size_t a, size_t b) {
+            return cursors[a].batch[cursors[a].position].first >
+                   cursors[b].batch[cursors[b].position].first;
+        };
+        std::vector<size_t> heap;
+        heap.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            if (has_pairs[i]) {
+                heap.push_back(i);
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), greater);
+
+        while (!heap.empty() && results.size() < limit) {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            size_t idx = heap.back();
+            heap.pop_back();
+
+            ScanCursor &cursor = cursors[idx];
+            results.push_back(std::move(cursor.batch[cursor.position]));
+            ++cursor.position;
+
+            if (cursor.position == cursor.batch.size()) {
+                // No engine is ever asked for more pairs than are still
+                // missing from the results
+                size_t missing = limit - results.size();
+                if (cursor.exhausted || missing == 0 ||
+                    !fetch(storages[idx], cursor,
+                           std::min(missing, cursor.batch_size * 2))) {
+                    continue;
+                }
+            }
+
+            heap.push_back(idx);
+            std::push_heap(heap.begin(), heap.end(), greater);
+        }
+    }
+};
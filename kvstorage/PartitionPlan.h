@@ -0,0 +1,322 @@
+#pragma once
+
+#include "../graph/Graph.h"
+#include "../storage/Status.h"
+#include <ankerl/unordered_dense.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Checkpoint of a repartitioning storage's placement state
+ *
+ * Holds the access graph tracked so far and the key-to-partition plan, so a
+ * restarted storage can place keys where the previous run left them instead
+ * of hash-placing them until the first repartitioning, and can feed the old
+ * co-access history to its first METIS run.
+ *
+ * The file is a compact binary encoding (all integers are LEB128 varints,
+ * strings are a length followed by the raw bytes):
+ * - the 8-byte magic "RPKVPLN1" and the partition count;
+ * - the vertex count, then each vertex and its weight;
+ * - the edge count, then each undirected edge once (source <= destination)
+ *   and its weight;
+ * - the assignment count, then each key and its partition.
+ *
+ * save() writes a temporary file next to the target, syncs it and renames it
+ * over the target, then syncs the directory, so a crash while saving leaves
+ * either the previous checkpoint or the new one.
+ *
+ * A storage drops a key's assignment once it has placed the key (see
+ * erase()), so the plan shrinks as the restored keys are written again.
+ */
+class PartitionPlan {
+private:
+    static constexpr char MAGIC[8] = {'R', 'P', 'K', 'V', 'P', 'L', 'N', '1'};
+
+    size_t partition_count_; // Partition count the plan was made for
+    Graph graph_;            // Access graph at checkpoint time
+    ankerl::unordered_dense::map<std::string, size_t>
+        assignments_; // Key to partition
+
+    static void write_varint(std::ostream &out, uint64_t value) {
+        while (value >= 0x80) {
+            out.put(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.put(static_cast<char>(value));
+    }
+
+    static bool read_varint(std::istream &in, uint64_t &value) {
+        value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            int byte = in.get();
+            if (byte == std::char_traits<char>::eof()) {
+                return false;
+            }
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false; // Longer than any 64-bit value
+    }
+
+    static void write_string(std::ostream &out, const std::string &value) {
+        write_varint(out, value.size());
+        out.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    static bool read_string(std::istream &in, std::string &value) {
+        uint64_t size;
+        if (!read_varint(in, size)) {
+            return false;
+        }
+        value.resize(size);
+        in.read(value.data(), static_cast<std::streamsize>(size));
+        return static_cast<uint64_t>(in.gcount()) == size;
+    }
+
+    // Flush a file or directory to the disk
+    static bool sync_path(const std::string &path, int flags) {
+        int fd = ::open(path.c_str(), flags);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = ::fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+    }
+
+    // Directory holding a file
+    static std::string directory_of(const std::string &path) {
+        std::filesystem::path parent =
+            std::filesystem::path(path).parent_path();
+        return parent.empty() ? std::string(".") : parent.string();
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param partition_count Partition count the plan is made for
+     */
+    explicit PartitionPlan(size_t partition_count = 0) :
+        partition_count_(partition_count) {}
+
+    /**
+     * @brief Get the partition count the plan was made for
+     * @return Partition count
+     */
+    size_t partition_count() const { return partition_count_; }
+
+    /**
+     * @brief Get the access graph
+     * @return Reference to the graph
+     */
+    Graph &graph() { return graph_; }
+
+    /**
+     * @brief Get the access graph
+     * @return Const reference to the graph
+     */
+    const Graph &graph() const { return graph_; }
+
+    /**
+     * @brief Assign a key to a partition
+     * @param key The key
+     * @param partition The partition index
+     */
+    void assign(const std::string &key, size_t partition) {
+        assignments_[key] = partition;
+    }
+
+    /**
+     * @brief Look up the partition planned for a key
+     * @param key The key
+     * @param partition Output parameter to store the partition index
+     * @return true if the plan assigns the key
+     */
+    bool partition_of(const std::string &key, size_t &partition) const {
+        if (assignments_.empty()) {
+            return false;
+        }
+        auto it = assignments_.find(key);
+        if (it == assignments_.end()) {
+            return false;
+        }
+        partition = it->second;
+        return true;
+    }
+
+    /**
+     * @brief Drop a key's assignment once the storage has placed the key
+     * @param key The key
+     *
+     * The assignments are freed once the last one is dropped.
+     */
+    void erase(const std::string &key) {
+        if (assignments_.empty()) {
+            return;
+        }
+        assignments_.erase(key);
+        if (assignments_.empty()) {
+            decltype(assignments_)().swap(assignments_);
+        }
+    }
+
+    /**
+     * @brief Drop the assignments of the keys a storage has already placed
+     * @param placed Predicate telling whether a key is placed
+     */
+    template <typename Predicate> void erase_placed(Predicate placed) {
+        std::vector<std::string> keys;
+        for (const auto &[key, partition] : assignments_) {
+            if (placed(key)) {
+                keys.push_back(key);
+            }
+        }
+        for (const std::string &key : keys) {
+            erase(key);
+        }
+    }
+
+    /**
+     * @brief Get the number of assigned keys
+     * @return Assignment count
+     */
+    size_t size() const { return assignments_.size(); }
+
+    /**
+     * @brief Write the plan to a file
+     * @param path The file path
+     * @return Status::SUCCESS, or Status::ERROR if the file could not be
+     * written
+     */
+    Status save(const std::string &path) const {
+        const std::string temp_path = path + ".tmp";
+        {
+            std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                return Status::ERROR;
+            }
+            out.write(MAGIC, sizeof(MAGIC));
+            write_varint(out, partition_count_);
+
+            write_varint(out, graph_.get_vertex_count());
+            for (const auto &[vertex, weight] : graph_.get_vertices()) {
+                write_string(out, vertex);
+                write_varint(out, static_cast<uint64_t>(weight));
+            }
+
+            uint64_t edge_count = 0;
+            for (const auto &[source, destinations] : graph_.get_edges()) {
+                for (const auto &[destination, weight] : destinations) {
+                    edge_count += source <= destination ? 1 : 0;
+                }
+            }
+            write_varint(out, edge_count);
+            for (const auto &[source, destinations] : graph_.get_edges()) {
+                for (const auto &[destination, weight] : destinations) {
+                    if (source <= destination) {
+                        write_string(out, source);
+                        write_string(out, destination);
+                        write_varint(out, static_cast<uint64_t>(weight));
+                    }
+                }
+            }
+
+            write_varint(out, assignments_.size());
+            for (const auto &[key, partition] : assignments_) {
+                write_string(out, key);
+                write_varint(out, partition);
+            }
+
+            out.flush();
+            if (!out) {
+                std::remove(temp_path.c_str());
+                return Status::ERROR;
+            }
+        }
+        // The contents reach the disk before the file gets the target's
+        // name, and the rename before save() returns
+        const std::string directory = directory_of(path);
+        if (!sync_path(temp_path, O_RDONLY) ||
+            !sync_path(directory, O_RDONLY | O_DIRECTORY) ||
+            std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            std::remove(temp_path.c_str());
+            return Status::ERROR;
+        }
+        if (!sync_path(directory, O_RDONLY | O_DIRECTORY)) {
+            return Status::ERROR;
+        }
+        return Status::SUCCESS;
+    }
+
+    /**
+     * @brief Replace the plan with the contents of a file
+     * @param path The file path
+     * @return Status::SUCCESS, Status::NOT_FOUND if the file does not exist,
+     * or Status::ERROR if it is not a valid plan (the plan is left empty)
+     */
+    Status load(const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return Status::NOT_FOUND;
+        }
+        graph_.clear();
+        assignments_.clear();
+        partition_count_ = 0;
+
+        char magic[sizeof(MAGIC)];
+        in.read(magic, sizeof(magic));
+        if (in.gcount() != sizeof(magic) ||
+            !std::equal(magic, magic + sizeof(magic), MAGIC)) {
+            return Status::ERROR;
+        }
+
+        uint64_t partition_count;
+        uint64_t count;
+        uint64_t value;
+        std::string key;
+        std::string other;
+        bool valid = read_varint(in, partition_count) &&
+                     partition_count > 0 && read_varint(in, count);
+        for (uint64_t i = 0; valid && i < count; ++i) {
+            valid = read_string(in, key) && read_varint(in, value);
+            if (valid) {
+                graph_.add_vertex_weight(key, static_cast<int>(value));
+            }
+        }
+        valid = valid && read_varint(in, count);
+        for (uint64_t i = 0; valid && i < count; ++i) {
+            valid = read_string(in, key) && read_string(in, other) &&
+                    read_varint(in, value);
+            if (valid) {
+                graph_.add_edge_weight(key, other, static_cast<int>(value));
+            }
+        }
+        valid = valid && read_varint(in, count);
+        for (uint64_t i = 0; valid && i < count; ++i) {
+            valid = read_string(in, key) && read_varint(in, value) &&
+                    value < partition_count;
+            if (valid) {
+                assignments_[std::move(key)] = static_cast<size_t>(value);
+            }
+        }
+
+        if (!valid) {
+            graph_.clear();
+            assignments_.clear();
+            return Status::ERROR;
+        }
+        partition_count_ = static_cast<size_t>(partition_count);
+        return Status::SUCCESS;
+    }
+};
@@ -1,7 +1,15 @@
 #pragma once
 
+#include "../storage/EnginePersistence.h"
 #include "../storage/StorageEngine.h"
 #include "../storage/Status.h"
+#include "WriteAheadLog.h"
+#include <array>
+#include <concepts>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -23,10 +31,34 @@
  * - void write_impl(const std::string& key, const std::string& value)
  * - std::vector<std::pair<std::string, std::string>> scan_impl(const
  * std::string& initial_key_prefix, size_t limit)
+ *
+ * With enable_write_ahead_log(), writes are logged to a shared group-commit
+ * WriteAheadLog before they are applied, and acknowledged once the log is
+ * on disk. Derived classes whose partition engines survive a restart may
+ * implement bool sync_impl(), which syncs every engine to disk, to let
+ * checkpoint_write_ahead_log() truncate the log.
  */
 template <typename Derived, template <bool> class StorageEngineTemplate,
           bool STORAGE_SYNC = false>
 class PartitionedKeyValueStorage {
+private:
+    static constexpr size_t WAL_STRIPES = 64;
+
+    /**
+     * @brief Write-ahead log state, allocated when the log is enabled
+     *
+     * Writes of one key append and apply under the key's stripe, so that the
+     * log and the engines see them in the same order.
+     */
+    struct WalState {
+        std::unique_ptr<WriteAheadLog> log;          // Group-commit log
+        std::array<std::mutex, WAL_STRIPES> stripes; // Per-key order
+        std::mutex checkpoint_mutex;                 // One checkpoint at a time
+        bool checkpoints = false; // The engines persist, checkpoints allowed
+    };
+
+    std::unique_ptr<WalState> wal_; // Write-ahead log, if enabled
+
 public:
     using StorageEngineType = StorageEngineTemplate<STORAGE_SYNC>;
     static constexpr bool storage_sync_enabled = STORAGE_SYNC;
@@ -48,12 +80,101 @@ public:
 
     /**
      * @brief Write a key-value pair
+     *
+     * With the write-ahead log enabled, the write is applied to the engines
+     * as soon as it is appended to the log, before it is durable: readers
+     * may see it while write() still waits for the log flush. If the flush
+     * fails, write() returns Status::ERROR but the value stays applied (and
+     * is lost on a restart). Writes acknowledged with success are durable.
+     *
+     * The write that finds the closed log segments past checkpoint_bytes
+     * runs checkpoint_write_ahead_log() before it returns.
+     *
      * @param key The key to write
      * @param value The value to associate with the key
      * @return Status code indicating the result of the operation
      */
     Status write(const std::string &key, const std::string &value) {
-        return static_cast<Derived *>(this)->write_impl(key, value);
+        if (!wal_) {
+            return static_cast<Derived *>(this)->write_impl(key, value);
+        }
+        uint64_t lsn;
+        Status status;
+        {
+            std::lock_guard<std::mutex> lock(
+                wal_->stripes[std::hash<std::string>{}(key) % WAL_STRIPES]);
+            lsn = wal_->log->append(key, value);
+            status = static_cast<Derived *>(this)->write_impl(key, value);
+        }
+        if (!wal_->log->wait_durable(lsn)) {
+            return Status::ERROR;
+        }
+        if (wal_->checkpoints && wal_->log->checkpoint_due()) {
+            std::unique_lock<std::mutex> checkpoint(wal_->checkpoint_mutex,
+                                                    std::try_to_lock);
+            if (checkpoint.owns_lock()) {
+                checkpoint_locked();
+            }
+        }
+        return status;
+    }
+
+    /**
+     * @brief Log writes to a group-commit write-ahead log
+     *
+     * Replays the log already in the directory into the partitions first, so
+     * a storage re-created on the same directory recovers the acknowledged
+     * writes. Must be called before the storage is shared between threads.
+     *
+     * @param directory Log directory
+     * @param options Log settings
+     * @return Status::SUCCESS, or Status::ERROR if the log cannot be opened
+     */
+    Status enable_write_ahead_log(const std::string &directory,
+                                  const WalOptions &options = WalOptions()) {
+        try {
+            WriteAheadLog::replay(
+                directory, [this](const std::string &key,
+                                  const std::string &value) {
+                    static_cast<Derived *>(this)->write_impl(key, value);
+                });
+            auto state = std::make_unique<WalState>();
+            state->log = std::make_unique<WriteAheadLog>(directory, options);
+            state->checkpoints =
+                syncs_engines() && EnginePersistence::enabled();
+            wal_ = std::move(state);
+        } catch (const std::exception &) {
+            return Status::ERROR;
+        }
+        return Status::SUCCESS;
+    }
+
+    /**
+     * @brief Checkpoint the engines and truncate the write-ahead log
+     *
+     * Waits until every write appended to the log so far is applied (all
+     * key stripes locked at once), syncs the engines to disk, then deletes
+     * the closed log segments holding only those writes. Needs engines that
+     * reopen their data after a restart: a Derived::sync_impl() and an
+     * EnginePersistence store set before enable_write_ahead_log().
+     *
+     * @return Status::SUCCESS, or Status::ERROR on I/O error or if the
+     * engines do not persist (the log is then kept whole)
+     */
+    Status checkpoint_write_ahead_log() {
+        if (!wal_ || !wal_->checkpoints) {
+            return Status::ERROR;
+        }
+        std::lock_guard<std::mutex> checkpoint(wal_->checkpoint_mutex);
+        return checkpoint_locked();
+    }
+
+    /**
+     * @brief Get the write-ahead log
+     * @return The log, or nullptr if not enabled
+     */
+    WriteAheadLog *write_ahead_log() {
+        return wal_ ? wal_->log.get() : nullptr;
     }
 
     /**
@@ -73,6 +194,32 @@ public:
         return static_cast<const Derived *>(this)->operation_count_impl();
     }
 
+private:
+    // Whether Derived implements sync_impl()
+    static constexpr bool syncs_engines() {
+        return requires(Derived &derived) {
+            { derived.sync_impl() } -> std::same_as<bool>;
+        };
+    }
+
+    // Checkpoint body; wal_->checkpoint_mutex held, checkpoints allowed
+    Status checkpoint_locked() {
+        uint64_t lsn;
+        {
+            std::array<std::unique_lock<std::mutex>, WAL_STRIPES> locks;
+            for (size_t i = 0; i < WAL_STRIPES; ++i) {
+                locks[i] = std::unique_lock<std::mutex>(wal_->stripes[i]);
+            }
+            lsn = wal_->log->last_lsn();
+        }
+        if constexpr (syncs_engines()) {
+            if (!static_cast<Derived *>(this)->sync_impl()) {
+                return Status::ERROR;
+            }
+        }
+        return wal_->log->truncate(lsn) ? Status::SUCCESS : Status::ERROR;
+    }
+
 protected:
     /**
      * @brief Protected destructor (CRTP pattern)
@@ -0,0 +1,629 @@
+#pragma once
+
+#include "PartitionedKeyValueStorage.h"
+#include "../storage/StorageEngine.h"
+#include "../storage/EngineTuning.h"
+#include "../storage/EngineThreading.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Split and merge thresholds of RangePartitionedKeyValueStorage
+ *
+ * Loads are the number of operations that touched a range during the last
+ * rebalancing interval, compared to the average over all ranges.
+ */
+struct RangeBalancePolicy {
+    double split_load_factor = 2.0; // Split ranges at this many times average
+    double merge_load_factor =
+        0.25; // Merge neighbours both this much below average
+    size_t min_split_load = 64; // Never split ranges with fewer operations
+    size_t max_range_keys =
+        1 << 20; // Split ranges holding more keys than this
+    size_t min_ranges = 0; // Never merge below this count (0: partitions)
+    size_t max_ranges = 0; // Never split above this count (0: 4 x partitions)
+};
+
+/**
+ * @brief Range-partitioned key-value storage implementation
+ *
+ * Sibling of LockStrippingKeyValueStorage that assigns contiguous key ranges
+ * to partitions instead of hashing keys, so a scan only touches the
+ * partitions covering its range. Each range owns one storage engine and one
+ * lock. It is a repartitioning baseline that needs no access graph: a
+ * background thread splits hot or oversized ranges at their median key and
+ * merges cold neighbours, moving the data online. A range is counted and
+ * searched for its median without its lock, and its moving keys are copied
+ * in chunks under short exclusive locks, while writes to them in between go
+ * to both engines (as in TieredStorageEngine::migrate()). The ranges are
+ * only locked for the whole step when the new bounds are published.
+ *
+ * Ranges form a linked list ordered by key, in the style of a B-link tree:
+ * each range knows its exclusive upper bound and its right neighbour, both
+ * protected by the range lock, and a sorted range table is only a search
+ * accelerator. A lookup that reaches a range through a stale table entry
+ * follows the right links (or the range it was merged into) until it reaches
+ * the range covering the key. Locks are always taken from left to right.
+ *
+ * The initial partition_count ranges split the printable ASCII space evenly
+ * by first byte; under skew the rebalancing adapts them to the workload.
+ *
+ * @tparam StorageEngineTemplate Storage engine class template
+ * @tparam STORAGE_SYNC Engine sync flag
+ */
+template <template <bool> class StorageEngineTemplate, bool STORAGE_SYNC>
+class RangePartitionedKeyValueStorage
+    : public PartitionedKeyValueStorage<
+          RangePartitionedKeyValueStorage<StorageEngineTemplate, STORAGE_SYNC>,
+          StorageEngineTemplate, STORAGE_SYNC> {
+private:
+    using StorageEngineType = StorageEngineTemplate<STORAGE_SYNC>;
+
+    // Pairs read per engine scan while moving or counting a range's keys
+    static constexpr size_t MOVE_CHUNK = 1024;
+
+    /**
+     * @brief Contiguous key range owned by one storage engine
+     */
+    struct Range {
+        const std::string lower; // Inclusive lower bound (never changes)
+        const size_t partition;  // Initial range this one was split from
+        std::optional<std::string>
+            upper; // Exclusive upper bound (none: unbounded)
+        std::shared_ptr<Range> right; // Right neighbour (nullptr: last)
+        std::shared_ptr<Range>
+            merged_into; // Left neighbour that absorbed this range
+        StorageEngineType *engine; // Storage engine holding the range's keys
+        StorageEngineType
+            *copy_target;        // Engine the moving keys are copied to
+        std::string copy_lower;  // First moving key (with copy_target)
+        std::shared_mutex lock;  // Protects upper, right and the copy fields
+        std::atomic_size_t load; // Operations since the last rebalance
+        std::atomic_size_t key_estimate; // Upper bound on the key count
+
+        Range(const std::string &lower_bound, size_t partition_idx,
+              StorageEngineType *storage) :
+            lower(lower_bound), partition(partition_idx), engine(storage),
+            copy_target(nullptr), load(0), key_estimate(0) {}
+
+        ~Range() { delete engine; }
+    };
+
+    size_t partition_count_;    // Initial number of ranges
+    RangeBalancePolicy policy_; // Split and merge thresholds
+    std::vector<std::shared_ptr<Range>>
+        table_; // Live ranges sorted by lower bound
+    std::shared_mutex table_lock_; // Protects table_
+    ShardedCounter operation_count_; // Reads, writes and scans served
+    std::atomic_size_t next_path_;   // Round robin index into paths_
+    std::vector<std::string>
+        paths_; // Paths for embedded database files (default: {/tmp})
+    EngineProfile profile_; // Tuning of the storage engines
+
+    // Threading attributes for automatic rebalancing
+    std::thread rebalancing_thread_; // Background thread splitting and
+                                     // merging ranges
+    std::optional<std::chrono::milliseconds>
+        rebalance_interval_;     // Interval between rebalancing cycles
+    std::atomic<bool> running_;  // Flag to control the rebalancing loop
+    std::condition_variable cv_; // Condition variable to wake the thread
+    std::mutex cv_mutex_;        // Mutex for condition variable
+    std::atomic_size_t split_count_; // Ranges split so far
+    std::atomic_size_t merge_count_; // Range pairs merged so far
+    std::mutex rebalance_mutex_;     // One rebalancing cycle at a time
+
+public:
+    /**
+     * @brief Constructor
+     * @param partition_count Number of initial ranges
+     * @param rebalance_interval Optional interval between rebalancing
+     * cycles (no automatic rebalancing if not set)
+     * @param paths Optional vector of paths for embedded database files
+     * (default: {/tmp}). Engines are created on the paths in round robin.
+     * @param policy Split and merge thresholds
+     * @param profile Tuning of the storage engines (default: the EngineTuning
+     * profile)
+     */
+    RangePartitionedKeyValueStorage(
+        size_t partition_count,
+        std::optional<std::chrono::milliseconds> rebalance_interval =
+            std::nullopt,
+        const std::vector<std::string> &paths = {"/tmp"},
+        const RangeBalancePolicy &policy = RangeBalancePolicy(),
+        const EngineProfile &profile = EngineTuning::profile()) :
+        partition_count_(std::max<size_t>(partition_count, 1)),
+        policy_(policy), next_path_(0),
+        paths_(paths.empty() ? std::vector<std::string>{"/tmp"} : paths),
+        profile_(profile), rebalance_interval_(rebalance_interval),
+        running_(true),
+        split_count_(0), merge_count_(0) {
+        if (policy_.min_ranges == 0) {
+            policy_.min_ranges = partition_count_;
+        }
+        if (policy_.max_ranges == 0) {
+            policy_.max_ranges = 4 * partition_count_;
+        }
+
+        // Spread the initial bounds over the printable characters
+        constexpr size_t first = '!';
+        constexpr size_t span = '~' - first + 1;
+        table_.reserve(partition_count_);
+        for (size_t i = 0; i < partition_count_; ++i) {
+            std::string lower;
+            if (i > 0) {
+                size_t bound = first + i * span / partition_count_;
+                lower = std::string(1, static_cast<char>(bound));
+            }
+            auto range = std::make_shared<Range>(lower, i, create_engine(i));
+            if (!table_.empty()) {
+                table_.back()->upper = lower;
+                table_.back()->right = range;
+            }
+            table_.push_back(range);
+        }
+
+        if (rebalance_interval_.has_value() &&
+            rebalance_interval_.value().count() > 0) {
+            rebalancing_thread_ = std::thread(
+                &RangePartitionedKeyValueStorage::rebalance_loop, this);
+        }
+    }
+
+    /**
+     * @brief Destructor - stops the rebalancing thread
+     */
+    ~RangePartitionedKeyValueStorage() {
+        running_ = false;
+        cv_.notify_all();
+        if (rebalancing_thread_.joinable()) {
+            rebalancing_thread_.join();
+        }
+        // Break the right links so the ranges are released
+        for (auto &range : table_) {
+            range->right.reset();
+        }
+    }
+
+    /**
+     * @brief Read a value by key (implementation for CRTP)
+     * @param key The key to read
+     * @param value Reference to store the value associated with the key
+     * @return Status code indicating the result of the operation
+     */
+    Status read_impl(const std::string &key, std::string &value) {
+        operation_count_.add();
+        std::shared_ptr<Range> range = locate(key, false);
+        range->load.fetch_add(1, std::memory_order_relaxed);
+        Status status = range->engine->read(key, value);
+        range->lock.unlock_shared();
+        return status;
+    }
+
+    /**
+     * @brief Write a key-value pair (implementation for CRTP)
+     * @param key The key to write
+     * @param value The value to associate with the key
+     * @return Status code indicating the result of the operation
+     */
+    Status write_impl(const std::string &key, const std::string &value) {
+        operation_count_.add();
+        std::shared_ptr<Range> range = locate(key, true);
+        range->load.fetch_add(1, std::memory_order_relaxed);
+        range->key_estimate.fetch_add(1, std::memory_order_relaxed);
+        Status status = range->engine->write(key, value);
+        if (range->copy_target != nullptr && key >= range->copy_lower) {
+            // The key is moving: its copy must not miss the write
+            range->copy_target->write(key, value);
+        }
+        range->lock.unlock();
+        return status;
+    }
+
+    /**
+     * @brief Scan for key-value pairs starting with a given prefix
+     * @param initial_key_prefix The initial key prefix to search for
+     * @param limit Maximum number of key-value pairs to return
+     * @param results Reference to store the results
+     * @return Status code indicating the result of the operation
+     *
+     * Reads the range covering the start key and then its right neighbours
+     * until the limit is reached. Ranges are locked hand over hand, so each
+     * boundary is crossed while both neighbours are locked.
+     */
+    Status
+    scan_impl(const std::string &initial_key_prefix, size_t limit,
+              std::vector<std::pair<std::string, std::string>> &results) {
+        operation_count_.add();
+        results.clear();
+        if (limit == 0) {
+            return Status::NOT_FOUND;
+        }
+
+        std::shared_ptr<Range> range = locate(initial_key_prefix, false);
+        const std::string *start = &initial_key_prefix;
+        while (true) {
+            range->load.fetch_add(1, std::memory_order_relaxed);
+            std::vector<std::pair<std::string, std::string>> range_results;
+            range->engine->scan(*start, limit - results.size(), range_results);
+            for (auto &pair : range_results) {
+                // Moved keys may still be in the engine past the bound
+                if (range->upper.has_value() && pair.first >= *range->upper) {
+                    break;
+                }
+                results.push_back(std::move(pair));
+            }
+
+            if (results.size() >= limit || range->right == nullptr) {
+                break;
+            }
+            std::shared_ptr<Range> next = range->right;
+            next->lock.lock_shared();
+            range->lock.unlock_shared();
+            range = std::move(next);
+            start = &range->lower;
+        }
+        range->lock.unlock_shared();
+
+        return results.empty() ? Status::NOT_FOUND : Status::SUCCESS;
+    }
+
+    size_t operation_count_impl() const {
+        return operation_count_.load();
+    }
+
+    /**
+     * @brief Split hot or oversized ranges and merge cold neighbours
+     *
+     * Loads are measured since the previous call and reset. Called
+     * periodically by the rebalancing thread when an interval is set.
+     */
+    void rebalance() {
+        std::lock_guard<std::mutex> rebalancing(rebalance_mutex_);
+        std::vector<std::shared_ptr<Range>> ranges;
+        {
+            std::shared_lock<std::shared_mutex> lock(table_lock_);
+            ranges = table_;
+        }
+
+        std::vector<size_t> loads(ranges.size());
+        size_t total_load = 0;
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            loads[i] = ranges[i]->load.exchange(0, std::memory_order_relaxed);
+            total_load += loads[i];
+        }
+        double average = static_cast<double>(total_load) / ranges.size();
+
+        // Split first, so a range is never merged and split in one cycle
+        size_t range_count = ranges.size();
+        std::vector<bool> split(ranges.size(), false);
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (range_count >= policy_.max_ranges) {
+                break;
+            }
+            bool hot = loads[i] >= policy_.min_split_load &&
+                       loads[i] >= policy_.split_load_factor * average;
+            bool oversized = ranges[i]->key_estimate.load(
+                                 std::memory_order_relaxed) >
+                             policy_.max_range_keys;
+            if ((hot || oversized) && split_range(ranges[i], hot)) {
+                split[i] = true;
+                ++range_count;
+            }
+        }
+
+        for (size_t i = 0; i + 1 < ranges.size(); ++i) {
+            if (range_count <= policy_.min_ranges) {
+                break;
+            }
+            double cold = policy_.merge_load_factor * average;
+            if (split[i] || split[i + 1] || loads[i] > cold ||
+                loads[i + 1] > cold ||
+                ranges[i]->key_estimate.load(std::memory_order_relaxed) +
+                        ranges[i + 1]->key_estimate.load(
+                            std::memory_order_relaxed) >
+                    policy_.max_range_keys / 2) {
+                continue;
+            }
+            if (merge_ranges(ranges[i], ranges[i + 1])) {
+                --range_count;
+                // The survivor is not merged again in this cycle
+                ++i;
+            }
+        }
+    }
+
+    /**
+     * @brief Get the current number of ranges
+     * @return Range count
+     */
+    size_t range_count() {
+        std::shared_lock<std::shared_mutex> lock(table_lock_);
+        return table_.size();
+    }
+
+    /**
+     * @brief Get the number of ranges split so far
+     * @return Split count
+     */
+    size_t split_count() const {
+        return split_count_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of range pairs merged so far
+     * @return Merge count
+     */
+    size_t merge_count() const {
+        return merge_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * @brief Create a storage engine on the next path
+     * @param partition Initial range the engine's range descends from,
+     * selecting per-partition engine options (e.g. LevelDB's)
+     * @return The new storage engine
+     */
+    StorageEngineType *create_engine(size_t partition) {
+        size_t path_idx = next_path_.fetch_add(1, std::memory_order_relaxed);
+        const std::string &path = paths_[path_idx % paths_.size()];
+        return new_engine<StorageEngineType>(1, path, partition, profile_);
+    }
+
+    /**
+     * @brief Find and lock the range covering a key
+     * @param key The key
+     * @param exclusive Take the range lock exclusively instead of shared
+     * @return The range covering the key, locked
+     */
+    std::shared_ptr<Range> locate(const std::string &key, bool exclusive) {
+        std::shared_ptr<Range> range;
+        {
+            std::shared_lock<std::shared_mutex> lock(table_lock_);
+            auto it = std::upper_bound(
+                table_.begin(), table_.end(), key,
+                [](const std::string &k, const std::shared_ptr<Range> &r) {
+                    return k < r->lower;
+                });
+            range = *(it - 1);
+        }
+
+        while (true) {
+            if (exclusive) {
+                range->lock.lock();
+            } else {
+                range->lock.lock_shared();
+            }
+
+            // The table may lag behind a split or merge
+            std::shared_ptr<Range> next;
+            if (range->merged_into != nullptr) {
+                next = range->merged_into;
+            } else if (range->upper.has_value() && key >= *range->upper) {
+                next = range->right;
+            } else {
+                return range;
+            }
+
+            if (exclusive) {
+                range->lock.unlock();
+            } else {
+                range->lock.unlock_shared();
+            }
+            range = std::move(next);
+        }
+    }
+
+    /**
+     * @brief Count the keys stored in a range
+     * @param range The range, not locked: writes may change the count while
+     * it is taken
+     * @return Key count
+     */
+    size_t count_keys(Range &range) {
+        size_t count = 0;
+        std::string next_key = range.lower;
+        std::vector<std::pair<std::string, std::string>> chunk;
+        while (true) {
+            chunk.clear();
+            range.engine->scan(next_key, MOVE_CHUNK, chunk);
+            count += chunk.size();
+            if (chunk.size() < MOVE_CHUNK) {
+                return count;
+            }
+            next_key = chunk.back().first + '\0';
+        }
+    }
+
+    /**
+     * @brief Find the key at a position of a range
+     * @param range The range, not locked
+     * @param position Number of keys before the wanted one
+     * @return The key, or std::nullopt if the range has no longer as many
+     * keys
+     */
+    std::optional<std::string> key_at(Range &range, size_t position) {
+        std::string next_key = range.lower;
+        std::vector<std::pair<std::string, std::string>> chunk;
+        while (true) {
+            chunk.clear();
+            range.engine->scan(next_key, MOVE_CHUNK, chunk);
+            if (position < chunk.size()) {
+                return chunk[position].first;
+            }
+            if (chunk.size() < MOVE_CHUNK) {
+                return std::nullopt;
+            }
+            position -= chunk.size();
+            next_key = chunk.back().first + '\0';
+        }
+    }
+
+    /**
+     * @brief Copy the keys of a range from a bound on to another engine
+     *
+     * Each chunk is copied under a short exclusive lock of the range, and
+     * writes to the copied keys in between also go to the target. The
+     * target keeps receiving them until the caller clears copy_target while
+     * publishing the move.
+     *
+     * @param range The range whose keys are copied
+     * @param from First key to copy
+     * @param target Engine the keys are copied to
+     */
+    void copy_keys(Range &range, const std::string &from,
+                   StorageEngineType *target) {
+        {
+            std::unique_lock<std::shared_mutex> lock(range.lock);
+            range.copy_target = target;
+            range.copy_lower = from;
+        }
+
+        std::string next_key = from;
+        std::vector<std::pair<std::string, std::string>> chunk;
+        while (true) {
+            chunk.clear();
+            std::unique_lock<std::shared_mutex> lock(range.lock);
+            range.engine->scan(next_key, MOVE_CHUNK, chunk);
+            for (const auto &[key, value] : chunk) {
+                target->write(key, value);
+            }
+            if (chunk.size() < MOVE_CHUNK) {
+                return;
+            }
+            next_key = chunk.back().first + '\0';
+        }
+    }
+
+    /**
+     * @brief Split a range at its median key
+     * @param range The range to split
+     * @param hot Whether the range is split for its load; otherwise it is
+     * only split if it really holds more than max_range_keys keys
+     * @return true if the range was split
+     */
+    bool split_range(const std::shared_ptr<Range> &range, bool hot) {
+        // Only the rebalancing cycle merges, so this cannot change
+        if (range->merged_into != nullptr) {
+            return false;
+        }
+        size_t key_count = count_keys(*range);
+        range->key_estimate.store(key_count, std::memory_order_relaxed);
+        if (key_count < 2 || (!hot && key_count <= policy_.max_range_keys)) {
+            return false;
+        }
+        // Keys before the median keep it above the lower bound
+        std::optional<std::string> median = key_at(*range, key_count / 2);
+        if (!median.has_value()) {
+            return false;
+        }
+
+        // Copy the upper half to a new range
+        auto sibling = std::make_shared<Range>(
+            *median, range->partition, create_engine(range->partition));
+        copy_keys(*range, *median, sibling->engine);
+        sibling->key_estimate.store(key_count - key_count / 2,
+                                    std::memory_order_relaxed);
+        range->key_estimate.store(key_count / 2, std::memory_order_relaxed);
+
+        // Publish the sibling through the right link, then in the table
+        range->lock.lock();
+        sibling->upper = range->upper;
+        sibling->right = range->right;
+        range->upper = *median;
+        range->right = sibling;
+        range->copy_target = nullptr;
+        range->lock.unlock();
+
+        {
+            std::unique_lock<std::shared_mutex> lock(table_lock_);
+            auto it = std::upper_bound(
+                table_.begin(), table_.end(), *median,
+                [](const std::string &k, const std::shared_ptr<Range> &r) {
+                    return k < r->lower;
+                });
+            table_.insert(it, sibling);
+        }
+
+        // The moved keys are past the new bound, so no request reads them
+        // from the old engine any more
+        std::vector<std::pair<std::string, std::string>> chunk;
+        do {
+            chunk.clear();
+            range->engine->scan(*median, MOVE_CHUNK, chunk);
+            for (const auto &pair : chunk) {
+                std::string removed;
+                range->engine->remove(pair.first, removed);
+            }
+        } while (chunk.size() == MOVE_CHUNK);
+
+        split_count_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Merge a range into its left neighbour
+     * @param left The surviving range
+     * @param right The right neighbour of left, absorbed into it
+     * @return true if the ranges were merged
+     */
+    bool merge_ranges(const std::shared_ptr<Range> &left,
+                      const std::shared_ptr<Range> &right) {
+        {
+            std::shared_lock<std::shared_mutex> lock(left->lock);
+            if (left->merged_into != nullptr || left->right != right) {
+                // Changed since the table was read
+                return false;
+            }
+        }
+
+        // The copied keys are past the left bound until the merge is
+        // published, so the left range is not locked meanwhile
+        copy_keys(*right, right->lower, left->engine);
+        left->key_estimate.fetch_add(
+            right->key_estimate.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+
+        left->lock.lock();
+        right->lock.lock();
+        left->upper = right->upper;
+        left->right = right->right;
+        right->right.reset();
+        right->merged_into = left;
+        right->copy_target = nullptr;
+        right->lock.unlock();
+        left->lock.unlock();
+
+        {
+            std::unique_lock<std::shared_mutex> lock(table_lock_);
+            table_.erase(std::find(table_.begin(), table_.end(), right));
+        }
+        merge_count_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Rebalancing loop run by the background thread
+     */
+    void rebalance_loop() {
+        while (running_) {
+            std::unique_lock<std::mutex> lock(cv_mutex_);
+            if (cv_.wait_for(lock, rebalance_interval_.value(),
+                             [this]() { return !running_; })) {
+                break;
+            }
+            lock.unlock();
+            rebalance();
+        }
+    }
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+/**
+ * @brief Outcome of rebuilding a storage from the engines of a previous run
+ */
+struct RecoveryStats {
+    size_t keys = 0;                      // Keys found in the engines
+    size_t bytes = 0;                     // Bytes of their keys and values
+    std::chrono::nanoseconds duration{0}; // Wall time of the recovery
+
+    /**
+     * @brief Get the recovered data size in GB
+     * @return Gigabytes (10^9 bytes)
+     */
+    double gigabytes() const { return static_cast<double>(bytes) / 1e9; }
+
+    /**
+     * @brief Get the recovery time per GB of data
+     * @return Seconds per GB, 0 when nothing was recovered
+     */
+    double seconds_per_gb() const {
+        if (bytes == 0) {
+            return 0.0;
+        }
+        return std::chrono::duration<double>(duration).count() / gigabytes();
+    }
+};
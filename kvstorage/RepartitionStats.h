@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Quality and cost of the last repartitioning of a storage
+ *
+ * Filled by the repartitioning storages each time METIS produces a new
+ * placement; cycles where the graph could not be partitioned leave it as
+ * it was.
+ */
+struct RepartitionStats {
+    size_t cycle = 0;           // Placements applied so far
+    uint64_t edge_cut = 0;      // METIS objective: weight of cut edges
+    double imbalance = 0.0;     // Heaviest partition over the mean weight
+    size_t keys_reassigned = 0; // Tracked keys that changed partition
+    size_t bytes_migrated = 0;  // Key and value bytes copied between engines
+    double scan_fanout = 0.0;   // Partitions per scan since the last cycle
+
+    std::chrono::nanoseconds prepare_time{0};   // Building the METIS graph
+    std::chrono::nanoseconds partition_time{0}; // Running METIS
+    std::chrono::nanoseconds update_time{0};    // Applying the placement
+};
+
+/**
+ * @brief Mean number of partitions touched per scan over a window
+ *
+ * Scans record how many partitions they touched; roll() closes the window
+ * (the storages roll it at every repartitioning). Relaxed counters: the
+ * mean is approximate while scans run.
+ */
+class ScanFanout {
+private:
+    std::atomic<uint64_t> scans_{0};      // Scans in the window
+    std::atomic<uint64_t> partitions_{0}; // Partitions they touched
+
+public:
+    /**
+     * @brief Record one scan
+     * @param partitions Partitions the scan touched
+     */
+    void record(size_t partitions) {
+        scans_.fetch_add(1, std::memory_order_relaxed);
+        partitions_.fetch_add(partitions, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the mean fan-out of the current window
+     * @return Partitions per scan, 0 before the first scan
+     */
+    double mean() const {
+        uint64_t scans = scans_.load(std::memory_order_relaxed);
+        if (scans == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(
+                   partitions_.load(std::memory_order_relaxed)) /
+               static_cast<double>(scans);
+    }
+
+    /**
+     * @brief Close the current window and start a new one
+     * @return Mean fan-out of the closed window
+     */
+    double roll() {
+        uint64_t scans = scans_.exchange(0, std::memory_order_relaxed);
+        uint64_t partitions =
+            partitions_.exchange(0, std::memory_order_relaxed);
+        if (scans == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(partitions) / static_cast<double>(scans);
+    }
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "PartitionedKeyValueStorage.h"
+#include "RepartitionStats.h"
 #include "../graph/Graph.h"
 #include "../graph/MetisGraph.h"
 #include <string>
@@ -38,6 +39,10 @@
  * - void single_key_graph_update_impl(const std::string& key)
  * - void multi_key_graph_update_impl(const std::vector<std::string>& keys)
  * - void repartition_loop_impl()
+ * - Status save_plan_impl(const std::string& path)
+ * - Status load_plan_impl(const std::string& path)
+ * - RepartitionStats repartition_stats_impl() const
+ * - double scan_fanout_impl() const
  */
 template <typename Derived, template <bool> class StorageEngineTemplate,
           bool STORAGE_SYNC = false>
@@ -99,6 +104,52 @@ public:
         return static_cast<const Derived *>(this)->graph_impl();
     }
 
+    /**
+     * @brief Get the quality and cost of the last repartitioning
+     * @return Edge-cut, imbalance, keys and bytes moved, phase times and
+     * scan fan-out of the last cycle that applied a placement (all zero
+     * before the first one)
+     */
+    RepartitionStats repartition_stats() const {
+        return static_cast<const Derived *>(this)->repartition_stats_impl();
+    }
+
+    /**
+     * @brief Get the mean number of partitions touched per scan since the
+     * last repartitioning
+     * @return Partitions per scan, 0 if there was no scan
+     */
+    double scan_fanout() const {
+        return static_cast<const Derived *>(this)->scan_fanout_impl();
+    }
+
+    /**
+     * @brief Checkpoint the access graph and the key-to-partition plan
+     * @param path File to write (replaced atomically)
+     * @return Status::SUCCESS, or Status::ERROR if the file could not be
+     * written
+     */
+    Status save_plan(const std::string &path) {
+        return static_cast<Derived *>(this)->save_plan_impl(path);
+    }
+
+    /**
+     * @brief Load a checkpoint written by save_plan()
+     * @param path File to read
+     * @return Status::SUCCESS, Status::NOT_FOUND if the file does not exist,
+     * or Status::ERROR if it is invalid or was made for another partition
+     * count
+     *
+     * The saved graph is merged into the tracking graph, so the next
+     * repartitioning also weighs the previous run's co-accesses. Keys written
+     * for the first time are placed on their planned partition instead of
+     * being hash-placed. Meant to be called right after construction, before
+     * the storage is shared between threads.
+     */
+    Status load_plan(const std::string &path) {
+        return static_cast<Derived *>(this)->load_plan_impl(path);
+    }
+
 protected:
     /**
      * @brief Protected destructor (CRTP pattern)
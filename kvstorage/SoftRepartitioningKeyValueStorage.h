@@ -3,9 +3,13 @@
 #include "RepartitioningKeyValueStorage.h"
 #include "../keystorage/KeyStorage.h"
 #include "../storage/StorageEngine.h"
+#include "../storage/EngineTuning.h"
 #include "../graph/Graph.h"
 #include "../graph/MetisGraph.h"
 #include "Tracker.h"
+#include "PartitionPlan.h"
+#include "RepartitionStats.h"
+#include "Checkpoint.h"
 #include <string>
 #include <vector>
 #include <cstddef>
@@ -72,6 +76,11 @@ private:
     HashFunc hash_func_;     // Hash function for key hashing
     MetisGraph metis_graph_; // METIS graph for partitioning
     Tracker<> tracker_;      // Tracker for tracking key access patterns
+    PartitionPlan plan_;     // Planned keys not placed yet (load_plan())
+    RepartitionStats repartition_stats_; // Last applied repartitioning
+    mutable std::mutex
+        repartition_stats_mutex_; // Guards repartition_stats_
+    ScanFanout scan_fanout_;      // Partitions touched per scan
 
     // Threading attributes for automatic repartitioning
     std::thread repartitioning_thread_; // Background thread for automatic
@@ -99,6 +108,8 @@ public:
      * @param paths Optional vector of paths for embedded database files
      * (default: {/tmp}) Uses the first path since this storage has only one
      * storage engine
+     * @param profile Tuning of the storage engines and key maps (default: the
+     * EngineTuning profile)
      */
     SoftRepartitioningKeyValueStorage(
         size_t partition_count, const HashFunc &hash_func = HashFunc(),
@@ -106,12 +117,14 @@ public:
             std::nullopt,
         std::optional<std::chrono::milliseconds> repartition_interval =
             std::nullopt,
-        const std::vector<std::string> &paths = {"/tmp"}) :
-        partition_map_(PartitionMapType<size_t>(
-            paths.empty() ? std::string("/tmp") : paths[0])),
+        const std::vector<std::string> &paths = {"/tmp"},
+        const EngineProfile &profile = EngineTuning::profile()) :
+        partition_map_(make_key_storage<PartitionMapType<size_t>>(
+            paths.empty() ? std::string("/tmp") : paths[0], profile)),
         enable_tracking_(false), is_repartitioning_(false),
         partition_count_(partition_count),
-        storage_(StorageEngineType(0, paths.empty() ? "/tmp" : paths[0])),
+        storage_(make_engine<StorageEngineType>(
+            0, paths.empty() ? "/tmp" : paths[0], profile)),
         hash_func_(hash_func), tracking_duration_(tracking_duration),
         repartition_interval_(repartition_interval), running_(true),
         paths_(paths.empty() ? std::vector<std::string>{"/tmp"} : paths) {
@@ -198,8 +211,11 @@ public:
         // Look up or assign partition for this key
         size_t partition_idx;
 
-        size_t next_partition_idx = hash_func_(key) % partition_count_;
-        partition_map_.get_or_insert(key, next_partition_idx, partition_idx);
+        if (!partition_map_.get(key, partition_idx)) {
+            partition_idx = initial_partition(key);
+            partition_map_.put(key, partition_idx);
+            plan_.erase(key);
+        }
 
         // Lock the partition for writing
         partition_locks_[partition_idx]->lock();
@@ -265,6 +281,7 @@ public:
 
         // Unlock key map
         key_map_lock_.unlock_shared();
+        scan_fanout_.record(sorted_partitions.size());
 
         // Track key access if enabled
         if (enable_tracking_) {
@@ -304,11 +321,13 @@ public:
         is_repartitioning_ = true;
         enable_tracking_ = false;
 
+        RepartitionStats stats;
         bool success =
-            tracker_.prepare_for_partition_map_update(partition_count_);
+            tracker_.prepare_for_partition_map_update(partition_count_, stats);
 
         if (success) {
             // Step 3: Lock and update partition assignments
+            const auto update_start = std::chrono::steady_clock::now();
             key_map_lock_.lock();
 
             for (size_t partition_idx = 0; partition_idx < partition_count_;
@@ -316,8 +335,10 @@ public:
                 partition_locks_[partition_idx]->lock();
             }
 
-            // Update partition_map with new assignments
-            tracker_.update_partition_map(partition_map_);
+            // Update partition_map with new assignments; the data stays in
+            // the shared engine, so nothing is migrated
+            stats.keys_reassigned =
+                tracker_.update_partition_map(partition_map_);
 
             // Unlock all partitions
             for (size_t partition_idx = 0; partition_idx < partition_count_;
@@ -327,12 +348,112 @@ public:
 
             // Unlock key map
             key_map_lock_.unlock();
+            stats.update_time =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - update_start);
+
+            stats.scan_fanout = scan_fanout_.roll();
+            std::lock_guard<std::mutex> lock(repartition_stats_mutex_);
+            stats.cycle = repartition_stats_.cycle + 1;
+            repartition_stats_ = stats;
         }
 
         // Clear repartitioning flag
         is_repartitioning_ = false;
     }
 
+    Status save_plan_impl(const std::string &path) {
+        PartitionPlan plan(partition_count_);
+        key_map_lock_.lock_shared();
+        for (auto it = partition_map_.lower_bound(""); !it.is_end(); ++it) {
+            plan.assign(it.get_key(), it.get_value());
+        }
+        key_map_lock_.unlock_shared();
+        plan.graph() = tracker_.snapshot_graph();
+        return plan.save(path);
+    }
+
+    Status load_plan_impl(const std::string &path) {
+        PartitionPlan plan;
+        Status status = plan.load(path);
+        if (status != Status::SUCCESS) {
+            return status;
+        }
+        if (plan.partition_count() != partition_count_) {
+            return Status::ERROR;
+        }
+        tracker_.merge_graph(plan.graph());
+        plan.graph().clear();
+
+        key_map_lock_.lock();
+        // Keys already placed keep their partition
+        plan.erase_placed([this](const std::string &key) {
+            size_t partition_idx;
+            return partition_map_.get(key, partition_idx);
+        });
+        plan_ = std::move(plan);
+        key_map_lock_.unlock();
+        return Status::SUCCESS;
+    }
+
+    /**
+     * @brief Write a consistent checkpoint while serving requests
+     *
+     * Writers are held off until the engine has fixed its image (see
+     * StorageEngine::checkpoint()) and the partition map is copied into the
+     * plan; the image is written afterwards, at most
+     * options.bytes_per_second. A Tkrzw engine fixes its image only once
+     * its file is copied, so writers are held off for the whole copy, which
+     * runs unthrottled. The directory holds the engine's image as
+     * partition 0 and the partition map, placement and access graph as a
+     * PartitionPlan file, "plan".
+     *
+     * @param directory Checkpoint directory (must not exist)
+     * @param options Throttling settings
+     * @param stats Output: size, pause and duration of the checkpoint
+     * @return Status::SUCCESS, or Status::ERROR if it could not be written
+     * (no directory is left behind)
+     */
+    Status checkpoint(const std::string &directory,
+                      const CheckpointOptions &options,
+                      CheckpointStats &stats) {
+        CheckpointWriter writer(directory, options);
+        if (writer.status() != Status::SUCCESS) {
+            return Status::ERROR;
+        }
+
+        PartitionPlan plan(partition_count_);
+        key_map_lock_.lock_shared();
+        for (size_t i = 0; i < partition_count_; ++i) {
+            partition_locks_[i]->lock_shared();
+        }
+        writer.hold();
+        writer.start(storage_, 0);
+        for (auto it = partition_map_.lower_bound(""); !it.is_end(); ++it) {
+            plan.assign(it.get_key(), it.get_value());
+        }
+        writer.wait_captured();
+        for (size_t i = 0; i < partition_count_; ++i) {
+            partition_locks_[i]->unlock_shared();
+        }
+        key_map_lock_.unlock_shared();
+
+        plan.graph() = tracker_.snapshot_graph();
+        return writer.finish(plan, stats);
+    }
+
+    /**
+     * @brief Write a consistent checkpoint while serving requests
+     * @param directory Checkpoint directory (must not exist)
+     * @param options Throttling settings
+     * @return Status::SUCCESS, or Status::ERROR if it could not be written
+     */
+    Status checkpoint(const std::string &directory,
+                      const CheckpointOptions &options = {}) {
+        CheckpointStats stats;
+        return checkpoint(directory, options, stats);
+    }
+
     // Interface methods required by the abstract base class
     void enable_tracking_impl(bool enable) { enable_tracking_ = enable; }
 
@@ -340,11 +461,32 @@ public:
 
     bool is_repartitioning_impl() const { return is_repartitioning_.load(); }
 
+    RepartitionStats repartition_stats_impl() const {
+        std::lock_guard<std::mutex> lock(repartition_stats_mutex_);
+        return repartition_stats_;
+    }
+
+    double scan_fanout_impl() const { return scan_fanout_.mean(); }
+
     const Graph &graph_impl() const { return tracker_.graph(); }
 
     size_t operation_count_impl() const { return storage_.operation_count(); }
 
 private:
+    /**
+     * @brief Choose the partition of a key written for the first time
+     * @param key The key
+     * @return The partition planned by load_plan(), or the key's hash
+     * partition
+     */
+    size_t initial_partition(const std::string &key) const {
+        size_t partition_idx;
+        if (plan_.partition_of(key, partition_idx)) {
+            return partition_idx;
+        }
+        return hash_func_(key) % partition_count_;
+    }
+
     /**
      * @brief Background thread loop for automatic repartitioning
      *
@@ -2,6 +2,8 @@
 
 #include "../graph/Graph.h"
 #include "../graph/MetisGraph.h"
+#include "RepartitionStats.h"
+#include <ankerl/unordered_dense.h>
 #include <tbb/concurrent_queue.h>
 #include <cstddef>
 #include <string>
@@ -9,6 +11,8 @@
 #include <thread>
 #include <mutex>
 #include <utility>
+#include <algorithm>
+#include <chrono>
 
 /**
  * @brief Tracker class for tracking key access patterns
@@ -183,7 +187,99 @@ public:
      */
     Graph &graph() { return graph_; }
 
+    /**
+     * @brief Copy the graph tracked so far
+     * @return Snapshot of the tracking graph
+     */
+    Graph snapshot_graph() {
+        std::lock_guard<std::mutex> lock(graph_lock_);
+        return graph_;
+    }
+
+    /**
+     * @brief Add the weights of a previously tracked graph (e.g. restored
+     * from a checkpoint) to the tracking graph
+     * @param graph The graph to merge in
+     */
+    void merge_graph(const Graph &graph) {
+        std::lock_guard<std::mutex> lock(graph_lock_);
+        graph_.merge(graph);
+    }
+
+    /**
+     * @brief Get the most accessed keys tracked so far
+     * @param count Maximum number of keys to return
+     * @return Up to count keys, by decreasing access count
+     */
+    std::vector<std::string> hot_keys(size_t count) {
+        std::vector<std::pair<int, std::string>> ranked;
+        {
+            std::lock_guard<std::mutex> lock(graph_lock_);
+            ranked.reserve(graph_.get_vertex_count());
+            for (const auto &[key, weight] : graph_.get_vertices()) {
+                ranked.emplace_back(weight, key);
+            }
+        }
+        count = std::min(count, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                          [](const auto &a, const auto &b) {
+                              return a.first > b.first;
+                          });
+        std::vector<std::string> keys;
+        keys.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            keys.push_back(std::move(ranked[i].second));
+        }
+        return keys;
+    }
+
+    /**
+     * @brief Get the keys most often accessed together with each key
+     * @param count Maximum number of neighbours per key
+     * @return For every key with co-accesses, its neighbours by decreasing
+     * edge weight
+     */
+    ankerl::unordered_dense::map<std::string, std::vector<std::string>>
+    co_accessed_keys(size_t count) {
+        ankerl::unordered_dense::map<std::string, std::vector<std::string>>
+            neighbours;
+        std::vector<std::pair<int, const std::string *>> ranked;
+        std::lock_guard<std::mutex> lock(graph_lock_);
+        for (const auto &[key, edges] : graph_.get_edges()) {
+            ranked.clear();
+            for (const auto &[neighbour, weight] : edges) {
+                if (neighbour != key) {
+                    ranked.emplace_back(weight, &neighbour);
+                }
+            }
+            size_t kept = std::min(count, ranked.size());
+            std::partial_sort(ranked.begin(), ranked.begin() + kept,
+                              ranked.end(), [](const auto &a, const auto &b) {
+                                  return a.first > b.first;
+                              });
+            std::vector<std::string> &strongest = neighbours[key];
+            strongest.reserve(kept);
+            for (size_t i = 0; i < kept; ++i) {
+                strongest.push_back(*ranked[i].second);
+            }
+        }
+        return neighbours;
+    }
+
     bool prepare_for_partition_map_update(size_t partition_count) {
+        RepartitionStats stats;
+        return prepare_for_partition_map_update(partition_count, stats);
+    }
+
+    /**
+     * @brief Partition the tracked graph with METIS
+     * @param partition_count Number of partitions
+     * @param stats On success, receives the edge-cut, the imbalance and the
+     * time spent preparing and partitioning the graph
+     * @return true if METIS produced a placement
+     */
+    bool prepare_for_partition_map_update(size_t partition_count,
+                                          RepartitionStats &stats) {
         // Wait for the queue to be empty
         // This allows already submitted keys not to be considered for the
         // current repartioning
@@ -202,8 +298,21 @@ public:
         bool success = false;
         if (ready()) {
             try {
+                const auto start = std::chrono::steady_clock::now();
                 metis_graph_.prepare_from_graph(graph_);
+                const auto prepared = std::chrono::steady_clock::now();
                 metis_graph_.partition(partition_count);
+                const auto partitioned = std::chrono::steady_clock::now();
+                stats.prepare_time =
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        prepared - start);
+                stats.partition_time =
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        partitioned - prepared);
+                stats.edge_cut =
+                    static_cast<uint64_t>(metis_graph_.get_edge_cut());
+                stats.imbalance = metis_graph_.get_imbalance(
+                    static_cast<int>(partition_count));
                 success = true;
             } catch (const std::exception &e) {
                 // If METIS fails, keep the old partition map
@@ -213,14 +322,26 @@ public:
         return success;
     }
 
+    /**
+     * @brief Apply the METIS placement to a key-to-partition map
+     * @param partition_map The map
+     * @return Number of keys already in the map that changed partition
+     */
     template <typename PartitionMapType>
-    void update_partition_map(PartitionMapType &partition_map) {
+    size_t update_partition_map(PartitionMapType &partition_map) {
         std::vector<idx_t> metis_partitions =
             metis_graph_.get_partition_result();
         const auto &idx_to_vertex = metis_graph_.get_idx_to_vertex();
+        size_t reassigned = 0;
         for (size_t i = 0; i < metis_partitions.size(); ++i) {
-            partition_map.put(idx_to_vertex[i],
-                              static_cast<size_t>(metis_partitions[i]));
+            size_t next_partition_idx =
+                static_cast<size_t>(metis_partitions[i]);
+            size_t partition_idx;
+            if (partition_map.get(idx_to_vertex[i], partition_idx) &&
+                partition_idx != next_partition_idx) {
+                ++reassigned;
+            }
+            partition_map.put(idx_to_vertex[i], next_partition_idx);
         }
         // Lock the graph to clear it
         std::lock_guard<std::mutex> lock(graph_lock_);
@@ -228,6 +349,7 @@ public:
 
         // Note that the queue was not cleared, thus, next repartitioning might
         // consider some realy old tracked keys
+        return reassigned;
     }
 
     std::vector<idx_t> get_metis_partitions() const {
@@ -238,6 +360,10 @@ public:
         return metis_graph_.get_idx_to_vertex();
     }
 
+    const std::vector<idx_t> &get_metis_vertex_weights() const {
+        return metis_graph_.get_vertex_weights();
+    }
+
     void lock_and_clear_graph() {
         std::lock_guard<std::mutex> lock(graph_lock_);
         graph_.clear();
@@ -0,0 +1,542 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Write-ahead log settings
+ */
+struct WalOptions {
+    size_t segment_bytes = 64ULL << 20;     // Rotate the active segment here
+    size_t checkpoint_bytes = 256ULL << 20; // Checkpoint once the closed
+                                            // segments pass this total (0:
+                                            // only on demand)
+    std::chrono::microseconds group_window{0}; // Extra wait of a flush leader
+                                               // for more writers to join
+};
+
+namespace wal_detail {
+
+inline constexpr std::string_view MAGIC("RPKVWAL1", 8);
+inline constexpr uint8_t PUT = 1; // Record type of a write
+
+inline uint32_t crc32(std::string_view data) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (char byte : data) {
+        crc = table[(crc ^ static_cast<uint8_t>(byte)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+inline void append_varint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline bool consume_varint(std::string_view &in, uint64_t &value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && !in.empty(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(in.front());
+        in.remove_prefix(1);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+inline bool sync_directory(const std::string &directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+/**
+ * @brief Sequential reader of one log file
+ *
+ * Stops at the end of the file or at the first incomplete or corrupt record
+ * (the torn tail of a crash).
+ */
+class FileReader {
+private:
+    std::ifstream in_;
+    std::string record_;     // Raw bytes of the last record
+    std::string_view body_;  // Payload of the last record
+
+public:
+    explicit FileReader(const std::string &path) :
+        in_(path, std::ios::binary) {
+        char magic[MAGIC.size()];
+        if (!in_.read(magic, sizeof(magic)) ||
+            std::string_view(magic, sizeof(magic)) != MAGIC) {
+            in_.setstate(std::ios::failbit);
+        }
+    }
+
+    /**
+     * @brief Read the next record
+     * @param key Output key
+     * @param value Output value
+     * @return false at the end of the valid records
+     */
+    bool next(std::string &key, std::string &value) {
+        if (!in_) {
+            return false;
+        }
+        // Header: 4-byte CRC of the payload, then its length as a varint
+        char header[4 + 10];
+        if (!in_.read(header, 4)) {
+            return false;
+        }
+        size_t length_bytes = 0;
+        uint64_t length = 0;
+        for (unsigned shift = 0; length_bytes < 10; shift += 7) {
+            char byte;
+            if (!in_.get(byte)) {
+                return false;
+            }
+            header[4 + length_bytes++] = byte;
+            length |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+        if (length > (1ULL << 32)) {
+            return false;
+        }
+        record_.assign(header, 4 + length_bytes);
+        record_.resize(4 + length_bytes + length);
+        if (!in_.read(record_.data() + 4 + length_bytes,
+                      static_cast<std::streamsize>(length))) {
+            return false;
+        }
+        uint32_t crc = 0;
+        for (int i = 3; i >= 0; --i) {
+            crc = (crc << 8) | static_cast<uint8_t>(record_[i]);
+        }
+        body_ = std::string_view(record_).substr(4 + length_bytes);
+        if (crc32(body_) != crc || body_.empty() ||
+            static_cast<uint8_t>(body_[0]) != PUT) {
+            in_.setstate(std::ios::failbit);
+            return false;
+        }
+        std::string_view in = body_.substr(1);
+        uint64_t size;
+        if (!consume_varint(in, size) || size > in.size()) {
+            in_.setstate(std::ios::failbit);
+            return false;
+        }
+        key.assign(in.data(), size);
+        in.remove_prefix(size);
+        value.assign(in.data(), in.size());
+        return true;
+    }
+};
+
+} // namespace wal_detail
+
+/**
+ * @brief Group-commit write-ahead log shared by all partitions of a storage
+ *
+ * Writers append() a record, which only copies it into a buffer and assigns
+ * it a log sequence number, then wait_durable() for it. The first waiter
+ * becomes the flush leader: it writes the whole buffer and calls fdatasync()
+ * once, for every record appended so far, while the writers arriving during
+ * the flush queue up for the next one. One fsync is thus paid per group of
+ * concurrent writes instead of per write.
+ *
+ * The log is a directory of segments (wal-<seq>.log). The active segment is
+ * closed once it exceeds segment_bytes. The log is not compacted: once the
+ * engines hold every write up to a sequence number on disk (a checkpoint,
+ * see PartitionedKeyValueStorage::checkpoint_write_ahead_log()),
+ * truncate() deletes the closed segments whose records all precede it.
+ * checkpoint_due() tells when the closed segments exceed checkpoint_bytes.
+ * replay() reads the segments left, in order.
+ *
+ * File format: the 8-byte magic "RPKVWAL1", then records. A record is the
+ * CRC-32 of its payload (4 bytes, little endian), the payload length as a
+ * LEB128 varint, and the payload: the record type (1: write), the key as a
+ * varint length and its bytes, and the value bytes.
+ */
+class WriteAheadLog {
+public:
+    using Apply =
+        std::function<void(const std::string &key, const std::string &value)>;
+
+private:
+    struct Segment {
+        uint64_t seq;      // Sequence number in the file name
+        size_t bytes;      // File size
+        uint64_t last_lsn; // Last record in the segment (0: previous run)
+    };
+
+    std::string directory_;           // Log directory
+    WalOptions options_;              // Settings
+    mutable std::mutex mutex_;        // Guards the fields below
+    std::condition_variable flushed_; // Signals the end of a flush
+    std::string buffer_;              // Records not yet written
+    uint64_t next_lsn_;               // Sequence number of the next record
+    uint64_t durable_lsn_;            // Last record known to be on disk
+    bool flushing_;                   // A leader is writing and syncing
+    bool failed_;                     // An I/O error occurred (sticky)
+    int fd_;                          // Active segment
+    uint64_t active_seq_;             // Active segment's sequence number
+    size_t active_bytes_;             // Active segment's size
+    std::vector<Segment> closed_;     // Closed segments, oldest first
+    size_t closed_bytes_;             // Their total size
+    size_t flushes_;                  // Flushes (fdatasync calls) done
+    size_t truncations_;              // Segments deleted by truncate()
+
+    static std::string file_name(const char *prefix, uint64_t seq) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "%s-%020llu.log", prefix,
+                      static_cast<unsigned long long>(seq));
+        return name;
+    }
+
+    std::string path_of(const char *prefix, uint64_t seq) const {
+        return (std::filesystem::path(directory_) / file_name(prefix, seq))
+            .string();
+    }
+
+    // Sequence number of a log file name, or false if it is not one
+    static bool parse_name(const std::string &name, const std::string &prefix,
+                           uint64_t &seq) {
+        if (name.size() != prefix.size() + 1 + 20 + 4 ||
+            name.compare(0, prefix.size() + 1, prefix + "-") != 0 ||
+            name.compare(name.size() - 4, 4, ".log") != 0) {
+            return false;
+        }
+        seq = 0;
+        for (size_t i = prefix.size() + 1; i < name.size() - 4; ++i) {
+            if (name[i] < '0' || name[i] > '9') {
+                return false;
+            }
+            seq = seq * 10 + static_cast<uint64_t>(name[i] - '0');
+        }
+        return true;
+    }
+
+    /**
+     * @brief List the segments of a directory
+     * @return Segments, oldest first
+     */
+    static std::vector<Segment> list(const std::string &directory) {
+        std::vector<Segment> segments;
+        std::error_code ec;
+        for (const auto &entry :
+             std::filesystem::directory_iterator(directory, ec)) {
+            uint64_t seq;
+            if (parse_name(entry.path().filename().string(), "wal", seq)) {
+                segments.push_back(
+                    {seq, static_cast<size_t>(entry.file_size(ec)), 0});
+            }
+        }
+        std::sort(segments.begin(), segments.end(),
+                  [](const Segment &a, const Segment &b) {
+                      return a.seq < b.seq;
+                  });
+        return segments;
+    }
+
+    // Create a log file holding only the magic, synced
+    int create(const std::string &path) {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return -1;
+        }
+        if (!wal_detail::write_all(fd, wal_detail::MAGIC) ||
+            ::fdatasync(fd) != 0 || !wal_detail::sync_directory(directory_)) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Close the active segment and open the next one; mutex_ held, no flush
+    // in progress, every record written so far durable
+    void rotate() {
+        int fd = create(path_of("wal", active_seq_ + 1));
+        if (fd < 0) {
+            failed_ = true;
+            return;
+        }
+        ::close(fd_);
+        closed_.push_back({active_seq_, active_bytes_, durable_lsn_});
+        closed_bytes_ += active_bytes_;
+        fd_ = fd;
+        ++active_seq_;
+        active_bytes_ = wal_detail::MAGIC.size();
+    }
+
+public:
+    /**
+     * @brief Open a log in a directory, after the files already there
+     *
+     * Existing segments are kept for replay(). They are taken as already
+     * replayed into the engines, so the next truncate() deletes them.
+     *
+     * @param directory Log directory (created if missing)
+     * @param options Settings
+     * @throws std::runtime_error if the directory or segment cannot be
+     *         created
+     */
+    explicit WriteAheadLog(const std::string &directory,
+                           const WalOptions &options = WalOptions()) :
+        directory_(directory), options_(options), next_lsn_(1),
+        durable_lsn_(0), flushing_(false), failed_(false), fd_(-1),
+        active_seq_(0), active_bytes_(wal_detail::MAGIC.size()),
+        closed_bytes_(0), flushes_(0), truncations_(0) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory_, ec);
+        closed_ = list(directory_);
+        for (const Segment &segment : closed_) {
+            closed_bytes_ += segment.bytes;
+            active_seq_ = std::max(active_seq_, segment.seq);
+        }
+        ++active_seq_;
+        fd_ = create(path_of("wal", active_seq_));
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to create write-ahead log in " +
+                                     directory_);
+        }
+    }
+
+    /**
+     * @brief Destructor - flushes the buffered records and closes the log
+     */
+    ~WriteAheadLog() {
+        uint64_t last;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            last = next_lsn_ - 1;
+        }
+        wait_durable(last);
+        ::close(fd_);
+    }
+
+    // Copy constructor and assignment operator are deleted
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    /**
+     * @brief Append a write to the log buffer
+     * @param key The key
+     * @param value The value
+     * @return Sequence number of the record, for wait_durable()
+     */
+    uint64_t append(const std::string &key, const std::string &value) {
+        std::string body;
+        body.reserve(1 + 5 + key.size() + value.size());
+        body.push_back(static_cast<char>(wal_detail::PUT));
+        wal_detail::append_varint(body, key.size());
+        body += key;
+        body += value;
+        const uint32_t crc = wal_detail::crc32(body);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < 4; ++i) {
+            buffer_.push_back(static_cast<char>((crc >> (8 * i)) & 0xFF));
+        }
+        wal_detail::append_varint(buffer_, body.size());
+        buffer_ += body;
+        return next_lsn_++;
+    }
+
+    /**
+     * @brief Wait until a record is on disk, flushing it if no one else is
+     * @param lsn Sequence number returned by append()
+     * @return true once durable, false if the log failed to write or sync
+     */
+    bool wait_durable(uint64_t lsn) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (durable_lsn_ < lsn) {
+            if (failed_) {
+                return false;
+            }
+            if (flushing_) {
+                flushed_.wait(lock);
+                continue;
+            }
+            flushing_ = true;
+            if (options_.group_window.count() > 0) {
+                lock.unlock();
+                std::this_thread::sleep_for(options_.group_window);
+                lock.lock();
+            }
+            std::string batch;
+            batch.swap(buffer_);
+            const uint64_t last = next_lsn_ - 1;
+            const int fd = fd_;
+            lock.unlock();
+            const bool ok =
+                wal_detail::write_all(fd, batch) && ::fdatasync(fd) == 0;
+            lock.lock();
+            flushing_ = false;
+            ++flushes_;
+            if (ok) {
+                durable_lsn_ = last;
+                active_bytes_ += batch.size();
+                if (active_bytes_ >= options_.segment_bytes) {
+                    rotate();
+                }
+            } else {
+                failed_ = true;
+            }
+            flushed_.notify_all();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Get the sequence number of the last record appended
+     * @return Sequence number (0: none yet)
+     */
+    uint64_t last_lsn() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return next_lsn_ - 1;
+    }
+
+    /**
+     * @brief Check whether the closed segments call for a checkpoint
+     * @return true once they exceed checkpoint_bytes (never if it is 0)
+     */
+    bool checkpoint_due() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return options_.checkpoint_bytes > 0 &&
+               closed_bytes_ >= options_.checkpoint_bytes;
+    }
+
+    /**
+     * @brief Delete the closed segments no longer needed for recovery
+     *
+     * The caller guarantees that every write up to lsn is on disk elsewhere
+     * (in the engines). Segments holding a later record are kept, and so is
+     * the active segment.
+     *
+     * @param lsn Sequence number of the last write not to replay any more
+     * @return true on success, false if a segment could not be deleted
+     */
+    bool truncate(uint64_t lsn) {
+        std::vector<Segment> doomed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto end = closed_.begin();
+            while (end != closed_.end() && end->last_lsn <= lsn) {
+                closed_bytes_ -= end->bytes;
+                ++end;
+            }
+            doomed.assign(closed_.begin(), end);
+            closed_.erase(closed_.begin(), end);
+            truncations_ += doomed.size();
+        }
+        if (doomed.empty()) {
+            return true;
+        }
+        // Oldest first, so a crash midway leaves a suffix of the log
+        bool ok = true;
+        for (const Segment &segment : doomed) {
+            ok = std::remove(path_of("wal", segment.seq).c_str()) == 0 && ok;
+        }
+        return wal_detail::sync_directory(directory_) && ok;
+    }
+
+    /**
+     * @brief Replay the log of a directory in write order
+     * @param directory Log directory (a missing directory has no records)
+     * @param apply Called for every logged write
+     * @return Number of records replayed
+     */
+    static size_t replay(const std::string &directory, const Apply &apply) {
+        size_t count = 0;
+        std::string key;
+        std::string value;
+        for (const Segment &segment : list(directory)) {
+            wal_detail::FileReader reader((std::filesystem::path(directory) /
+                                           file_name("wal", segment.seq))
+                                              .string());
+            while (reader.next(key, value)) {
+                apply(key, value);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Get the number of flushes done so far
+     * @return fdatasync() calls on the active segments
+     */
+    size_t flush_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return flushes_;
+    }
+
+    /**
+     * @brief Get the number of segments deleted by truncate() so far
+     * @return Segments
+     */
+    size_t truncated_segment_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return truncations_;
+    }
+
+    /**
+     * @brief Get the number of closed segments kept for recovery
+     * @return Segments
+     */
+    size_t closed_segment_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_.size();
+    }
+};
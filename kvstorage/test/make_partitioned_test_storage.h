@@ -10,6 +10,7 @@
 #include "../../utils/test_resources.h"
 #include "../HardRepartitioningKeyValueStorage.h"
 #include "../LockStrippingKeyValueStorage.h"
+#include "../RangePartitionedKeyValueStorage.h"
 #include "../SoftRepartitioningKeyValueStorage.h"
 #include "../threaded/HardThreadedRepartitioningKeyValueStorage.h"
 #include "../threaded/SoftThreadedRepartitioningKeyValueStorage.h"
@@ -58,14 +59,13 @@ struct PartitionedStorageMaker<
 };
 
 template <template <bool> class Eng, bool S, template <typename> class KM,
-          template <typename> class KP, typename HashFunc, size_t Q>
+          typename HashFunc, size_t Q>
 struct PartitionedStorageMaker<
-    HardThreadedRepartitioningKeyValueStorage<Eng, S, KM, KP, HashFunc, Q>> {
-    static HardThreadedRepartitioningKeyValueStorage<Eng, S, KM, KP, HashFunc,
-                                                     Q>
+    HardThreadedRepartitioningKeyValueStorage<Eng, S, KM, HashFunc, Q>> {
+    static HardThreadedRepartitioningKeyValueStorage<Eng, S, KM, HashFunc, Q>
     make(size_t partition_count) {
-        return HardThreadedRepartitioningKeyValueStorage<Eng, S, KM, KP,
-                                                         HashFunc, Q>(
+        return HardThreadedRepartitioningKeyValueStorage<Eng, S, KM, HashFunc,
+                                                         Q>(
             partition_count, std::hash<std::string>{}, std::nullopt,
             std::nullopt, partitioned_kv_test_paths());
     }
@@ -81,6 +81,15 @@ template <bool S> struct PartitionedStorageMaker<
     }
 };
 
+template <bool S> struct PartitionedStorageMaker<
+    RangePartitionedKeyValueStorage<MapStorageEngine, S>> {
+    static RangePartitionedKeyValueStorage<MapStorageEngine, S>
+    make(size_t partition_count) {
+        return RangePartitionedKeyValueStorage<MapStorageEngine, S>(
+            partition_count, std::nullopt, partitioned_kv_test_paths());
+    }
+};
+
 } // namespace detail
 
 template <typename StorageType>
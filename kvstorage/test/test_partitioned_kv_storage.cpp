@@ -3,13 +3,24 @@
 #include "../threaded/SoftThreadedRepartitioningKeyValueStorage.h"
 #include "../threaded/HardThreadedRepartitioningKeyValueStorage.h"
 #include "../../storage/MapStorageEngine.h"
+#include "../../storage/LmdbStorageEngine.h"
+#include "../../storage/EnginePersistence.h"
 #include "../../keystorage/MapKeyStorage.h"
 #include "../../keystorage/LmdbKeyStorage.h"
 #include "../../keystorage/TkrzwTreeKeyStorage.h"
+#include "../../keystorage/FingerprintKeyStorage.h"
+#include "../../keystorage/SliceBtreeKeyStorage.h"
 #include "../../utils/test_assertions.h"
 #include "../LockStrippingKeyValueStorage.h"
+#include "../RangePartitionedKeyValueStorage.h"
+#include "../WriteAheadLog.h"
 #include "make_partitioned_test_storage.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <vector>
 #include <string>
 #include <thread>
@@ -157,6 +168,73 @@ template <typename StorageType> void test_many_partitions() {
     END_TEST("many_partitions")
 }
 
+template <typename StorageType> void test_scan_across_partitions() {
+    TEST("scan_across_partitions")
+    StorageType storage =
+        repart_kv_test::make_partitioned_kv_test_storage<StorageType>(8);
+
+    // Zero-padded keys so that lexicographic and numeric order match
+    auto make_key = [](size_t i) {
+        std::string number = std::to_string(i);
+        return "merge:" + std::string(4 - number.size(), '0') + number;
+    };
+    const size_t num_keys = 600;
+    for (size_t i = 0; i < num_keys; ++i) {
+        Status status =
+            storage.write(make_key(i), "value:" + std::to_string(i));
+        ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    }
+
+    // Scan from the middle, long enough to span several batches per
+    // partition
+    std::vector<std::pair<std::string, std::string>> results;
+    Status status = storage.scan(make_key(100), 300, results);
+    ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    ASSERT_EQ(300, results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        ASSERT_STR_EQ(make_key(100 + i), results[i].first);
+        ASSERT_STR_EQ("value:" + std::to_string(100 + i), results[i].second);
+    }
+
+    // A limit past the last key returns only the remaining keys
+    std::vector<std::pair<std::string, std::string>> tail_results;
+    status = storage.scan(make_key(550), 300, tail_results);
+    ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    ASSERT_EQ(50, tail_results.size());
+    ASSERT_STR_EQ(make_key(550), tail_results.front().first);
+    ASSERT_STR_EQ(make_key(num_keys - 1), tail_results.back().first);
+    END_TEST("scan_across_partitions")
+}
+
+template <typename StorageType> void test_scan_many_partitions() {
+    TEST("scan_many_partitions")
+    // More partitions than a 32-bit partition set could hold
+    const size_t partition_count = 64;
+    StorageType storage =
+        repart_kv_test::make_partitioned_kv_test_storage<StorageType>(
+            partition_count);
+
+    auto make_key = [](size_t i) {
+        std::string number = std::to_string(i);
+        return "wide:" + std::string(4 - number.size(), '0') + number;
+    };
+    const size_t num_keys = 20 * partition_count;
+    for (size_t i = 0; i < num_keys; ++i) {
+        Status status = storage.write(make_key(i), std::to_string(i));
+        ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    }
+
+    std::vector<std::pair<std::string, std::string>> results;
+    Status status = storage.scan(make_key(0), num_keys, results);
+    ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    ASSERT_EQ(num_keys, results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        ASSERT_STR_EQ(make_key(i), results[i].first);
+        ASSERT_STR_EQ(std::to_string(i), results[i].second);
+    }
+    END_TEST("scan_many_partitions")
+}
+
 template <typename StorageType> void test_large_dataset() {
     TEST("large_dataset")
     StorageType storage =
@@ -416,6 +494,597 @@ template <typename StorageType> void test_operation_count() {
     END_TEST("operation_count")
 }
 
+template <bool STORAGE_SYNC> void test_range_split_and_merge() {
+    TEST("range_split_and_merge")
+    RangeBalancePolicy policy;
+    policy.min_split_load = 1;
+    policy.max_ranges = 8;
+    RangePartitionedKeyValueStorage<MapStorageEngine, STORAGE_SYNC> storage(
+        2, std::nullopt, repart_kv_test::partitioned_kv_test_paths(), policy);
+    ASSERT_EQ(2, storage.range_count());
+
+    // All keys start with 'k', so they land in a single range
+    const size_t num_keys = 200;
+    for (size_t i = 0; i < num_keys; ++i) {
+        std::string number = std::to_string(i);
+        std::string key = "key:" + std::string(3 - number.size(), '0') + number;
+        Status status = storage.write(key, "value:" + number);
+        ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    }
+
+    // The loaded range splits at its median key
+    storage.rebalance();
+    ASSERT_TRUE(storage.range_count() > 2);
+    ASSERT_TRUE(storage.split_count() > 0);
+
+    std::string value;
+    Status status = storage.read("key:042", value);
+    ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    ASSERT_STR_EQ("value:42", value);
+    status = storage.read("key:199", value);
+    ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    ASSERT_STR_EQ("value:199", value);
+
+    std::vector<std::pair<std::string, std::string>> results;
+    status = storage.scan("key:090", 20, results);
+    ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    ASSERT_EQ(20, results.size());
+    ASSERT_STR_EQ("key:090", results.front().first);
+    ASSERT_STR_EQ("key:109", results.back().first);
+
+    // Without load, neighbours merge back down to the initial range count
+    storage.rebalance();
+    storage.rebalance();
+    storage.rebalance();
+    ASSERT_EQ(2, storage.range_count());
+    ASSERT_TRUE(storage.merge_count() > 0);
+
+    status = storage.scan("", num_keys + 1, results);
+    ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    ASSERT_EQ(num_keys, results.size());
+    status = storage.read("key:150", value);
+    ASSERT_STATUS_EQ(Status::SUCCESS, status);
+    ASSERT_STR_EQ("value:150", value);
+    END_TEST("range_split_and_merge")
+}
+
+void test_range_online_moves() {
+    TEST("range_online_moves")
+    RangeBalancePolicy policy;
+    policy.min_split_load = 1;
+    policy.max_ranges = 8;
+    RangePartitionedKeyValueStorage<MapStorageEngine, false> storage(
+        2, std::nullopt, repart_kv_test::partitioned_kv_test_paths(), policy);
+
+    // Several move chunks, so writes land between the copied chunks
+    const size_t num_keys = 3000;
+    const size_t focus_keys = 100;
+    auto key_of = [](size_t i) {
+        std::string number = std::to_string(i);
+        return "key:" + std::string(4 - number.size(), '0') + number;
+    };
+    for (size_t i = 0; i < num_keys; ++i) {
+        storage.write(key_of(i), "0");
+    }
+
+    // Rounds overwrite every key, then only the first ones, so ranges split
+    // and then merge while they are written
+    std::atomic<bool> focus(false);
+    std::atomic<bool> done(false);
+    size_t last_round = 0;
+    size_t last_full_round = 0;
+    std::thread writer([&]() {
+        for (size_t round = 1; !done; ++round) {
+            size_t count = focus ? focus_keys : num_keys;
+            for (size_t i = 0; i < count; ++i) {
+                storage.write(key_of(i), std::to_string(round));
+            }
+            last_round = round;
+            if (count == num_keys) {
+                last_full_round = round;
+            }
+        }
+    });
+
+    size_t bad_scans = 0;
+    for (size_t cycle = 0; cycle < 10; ++cycle) {
+        if (cycle == 3) {
+            focus = true;
+        }
+        std::this_thread::sleep_for(sleep_time);
+        storage.rebalance();
+
+        std::vector<std::pair<std::string, std::string>> results;
+        storage.scan("key:", num_keys + 1, results);
+        // Each key once, in order
+        bool ordered =
+            std::adjacent_find(results.begin(), results.end(),
+                               [](const auto &a, const auto &b) {
+                                   return a.first >= b.first;
+                               }) == results.end();
+        if (results.size() != num_keys || !ordered) {
+            ++bad_scans;
+        }
+    }
+    done = true;
+    writer.join();
+
+    ASSERT_EQ(0, bad_scans);
+    ASSERT_TRUE(storage.split_count() > 0);
+    ASSERT_TRUE(storage.merge_count() > 0);
+    size_t stale = 0;
+    for (size_t i = 0; i < num_keys; ++i) {
+        size_t round = i < focus_keys ? last_round : last_full_round;
+        std::string value;
+        if (storage.read(key_of(i), value) != Status::SUCCESS ||
+            value != std::to_string(round)) {
+            ++stale;
+        }
+    }
+    ASSERT_EQ(0, stale);
+    END_TEST("range_online_moves")
+}
+
+// Fresh write-ahead log directory under the test resources
+std::string wal_test_dir(const std::string &name) {
+    std::string dir = repart_kv_test::test_resources_dir() + "/" + name;
+    std::filesystem::remove_all(dir);
+    return dir;
+}
+
+void test_wal_group_commit() {
+    TEST("wal_group_commit")
+    const std::string dir = wal_test_dir("wal_group_commit");
+    const size_t threads = 8;
+    const size_t writes_per_thread = 200;
+    size_t flushes = 0;
+    {
+        WalOptions options;
+        options.group_window = std::chrono::microseconds(200);
+        WriteAheadLog log(dir, options);
+        std::vector<std::thread> writers;
+        std::atomic<size_t> failures{0};
+        for (size_t t = 0; t < threads; ++t) {
+            writers.emplace_back([&, t]() {
+                for (size_t i = 0; i < writes_per_thread; ++i) {
+                    std::string key =
+                        "t" + std::to_string(t) + ":" + std::to_string(i);
+                    if (!log.wait_durable(log.append(key, "v" + key))) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto &writer : writers) {
+            writer.join();
+        }
+        ASSERT_EQ(0, failures.load());
+        flushes = log.flush_count();
+    }
+
+    // Writers waiting on the same flush share its fdatasync
+    ASSERT_TRUE(flushes > 0);
+    ASSERT_TRUE(flushes < threads * writes_per_thread);
+
+    std::map<std::string, std::string> replayed;
+    size_t count = WriteAheadLog::replay(
+        dir, [&](const std::string &key, const std::string &value) {
+            replayed[key] = value;
+        });
+    ASSERT_EQ(threads * writes_per_thread, count);
+    ASSERT_EQ(threads * writes_per_thread, replayed.size());
+    ASSERT_STR_EQ("vt3:17", replayed["t3:17"]);
+    END_TEST("wal_group_commit")
+}
+
+void test_wal_truncate_and_torn_tail() {
+    TEST("wal_truncate_and_torn_tail")
+    const std::string dir = wal_test_dir("wal_truncate");
+    WalOptions options;
+    options.segment_bytes = 4096;
+    options.checkpoint_bytes = 8192;
+    {
+        WriteAheadLog log(dir, options);
+        // 100 keys, overwritten 10 times, over many segments
+        uint64_t half = 0;
+        for (size_t round = 0; round < 10; ++round) {
+            for (size_t i = 0; i < 100; ++i) {
+                std::string value = std::string(32, 'x') + std::to_string(round);
+                uint64_t lsn = log.append("key:" + std::to_string(i), value);
+                ASSERT_TRUE(log.wait_durable(lsn));
+                if (round == 4) {
+                    half = lsn;
+                }
+            }
+        }
+        const size_t closed = log.closed_segment_count();
+        ASSERT_TRUE(closed > 1);
+        ASSERT_TRUE(log.checkpoint_due());
+
+        // Segments with a record after the truncation point are kept
+        ASSERT_TRUE(log.truncate(half));
+        ASSERT_TRUE(log.truncated_segment_count() > 0);
+        ASSERT_TRUE(log.closed_segment_count() > 0);
+        ASSERT_TRUE(log.closed_segment_count() < closed);
+        std::map<std::string, std::string> replayed;
+        size_t count = WriteAheadLog::replay(
+            dir, [&](const std::string &key, const std::string &value) {
+                replayed[key] = value;
+            });
+        ASSERT_TRUE(count >= 5 * 100);
+        ASSERT_TRUE(count < 10 * 100);
+        ASSERT_EQ(100, replayed.size());
+        ASSERT_STR_EQ(std::string(32, 'x') + "9", replayed["key:99"]);
+
+        ASSERT_TRUE(log.truncate(log.last_lsn()));
+        ASSERT_EQ(0, log.closed_segment_count());
+        ASSERT_FALSE(log.checkpoint_due());
+        ASSERT_TRUE(log.wait_durable(log.append("key:0", "latest")));
+    }
+
+    // A crash in the middle of a record leaves a torn tail
+    std::string last_segment;
+    for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("wal-", 0) == 0 && entry.path().string() > last_segment) {
+            last_segment = entry.path().string();
+        }
+    }
+    ASSERT_FALSE(last_segment.empty());
+    {
+        std::ofstream out(last_segment, std::ios::binary | std::ios::app);
+        out.write("\x12\x34\x56\x78\x40key", 8);
+    }
+
+    // Only the active segment is left, and the torn record is dropped
+    std::map<std::string, std::string> replayed;
+    size_t count = WriteAheadLog::replay(
+        dir, [&](const std::string &key, const std::string &value) {
+            replayed[key] = value;
+        });
+    ASSERT_TRUE(count < 100);
+    ASSERT_STR_EQ("latest", replayed["key:0"]);
+    END_TEST("wal_truncate_and_torn_tail")
+}
+
+template <typename StorageType> void test_wal_recovery() {
+    TEST("wal_recovery")
+    const std::string dir = wal_test_dir("wal_recovery");
+    {
+        StorageType storage =
+            repart_kv_test::make_partitioned_kv_test_storage<StorageType>(4);
+        ASSERT_STATUS_EQ(Status::SUCCESS, storage.enable_write_ahead_log(dir));
+        std::vector<std::thread> writers;
+        for (size_t t = 0; t < 4; ++t) {
+            writers.emplace_back([&storage, t]() {
+                for (size_t i = t; i < 400; i += 4) {
+                    storage.write("key:" + std::to_string(i),
+                                  "value:" + std::to_string(i));
+                }
+            });
+        }
+        for (auto &writer : writers) {
+            writer.join();
+        }
+        storage.write("key:7", "rewritten");
+        ASSERT_TRUE(storage.write_ahead_log()->flush_count() > 0);
+
+        // Temporary engines lose their data on a restart: the log stays whole
+        ASSERT_STATUS_EQ(Status::ERROR, storage.checkpoint_write_ahead_log());
+    }
+
+    // A new storage on the same log gets every acknowledged write back
+    StorageType storage =
+        repart_kv_test::make_partitioned_kv_test_storage<StorageType>(4);
+    std::string value;
+    ASSERT_STATUS_EQ(Status::NOT_FOUND, storage.read("key:42", value));
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.enable_write_ahead_log(dir));
+    for (size_t i = 0; i < 400; i += 37) {
+        Status status = storage.read("key:" + std::to_string(i), value);
+        ASSERT_STATUS_EQ(Status::SUCCESS, status);
+        ASSERT_STR_EQ(i == 7 ? "rewritten" : "value:" + std::to_string(i),
+                      value);
+    }
+    std::vector<std::pair<std::string, std::string>> results;
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.scan("", 1000, results));
+    ASSERT_EQ(400, results.size());
+    END_TEST("wal_recovery")
+}
+
+void test_wal_checkpoint() {
+    TEST("wal_checkpoint")
+    using StorageType = LockStrippingKeyValueStorage<LmdbStorageEngine, false>;
+    const std::vector<std::string> paths =
+        repart_kv_test::partitioned_kv_test_paths();
+    const std::string dir = wal_test_dir("wal_checkpoint");
+    EnginePersistence::set_name("wal_checkpoint_test");
+    std::filesystem::remove_all(paths[0] +
+                                "/repart_kv_storage/wal_checkpoint_test");
+    WalOptions options;
+    options.segment_bytes = 4096;
+    options.checkpoint_bytes = 16384;
+    {
+        StorageType storage(4, std::hash<std::string>{}, paths);
+        ASSERT_STATUS_EQ(Status::SUCCESS,
+                         storage.enable_write_ahead_log(dir, options));
+        for (size_t i = 0; i < 2000; ++i) {
+            ASSERT_STATUS_EQ(Status::SUCCESS,
+                             storage.write("key:" + std::to_string(i),
+                                           "value:" + std::to_string(i)));
+        }
+        // Writes past checkpoint_bytes checkpoint on their own
+        WriteAheadLog *log = storage.write_ahead_log();
+        ASSERT_TRUE(log->truncated_segment_count() > 0);
+        ASSERT_FALSE(log->checkpoint_due());
+
+        ASSERT_STATUS_EQ(Status::SUCCESS, storage.checkpoint_write_ahead_log());
+        ASSERT_EQ(0, log->closed_segment_count());
+        ASSERT_STATUS_EQ(Status::SUCCESS, storage.write("key:7", "rewritten"));
+    }
+
+    // The engines hold the truncated writes, the log the later ones
+    StorageType storage(4, std::hash<std::string>{}, paths);
+    ASSERT_STATUS_EQ(Status::SUCCESS,
+                     storage.enable_write_ahead_log(dir, options));
+    EnginePersistence::set_name("");
+    std::string value;
+    for (size_t i = 0; i < 2000; i += 37) {
+        Status status = storage.read("key:" + std::to_string(i), value);
+        ASSERT_STATUS_EQ(Status::SUCCESS, status);
+        ASSERT_STR_EQ(i == 7 ? "rewritten" : "value:" + std::to_string(i),
+                      value);
+    }
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.read("key:7", value));
+    ASSERT_STR_EQ("rewritten", value);
+    END_TEST("wal_checkpoint")
+}
+
+template <template <typename> class KeyMap> void test_recover_key_map() {
+    TEST("recover_key_map")
+    using StorageType =
+        HardRepartitioningKeyValueStorage<LmdbStorageEngine, false, KeyMap>;
+    const std::vector<std::string> paths =
+        repart_kv_test::partitioned_kv_test_paths();
+    EnginePersistence::set_name("recovery_test");
+    std::filesystem::remove_all(paths[0] + "/repart_kv_storage/recovery_test");
+
+    const size_t num_keys = 10000;
+    size_t bytes = 0;
+    {
+        StorageType storage(4, std::hash<std::string>{}, std::nullopt,
+                            std::nullopt, paths);
+        for (size_t i = 0; i < num_keys; ++i) {
+            std::string key = "key:" + std::to_string(i);
+            std::string value = "value:" + std::to_string(i);
+            ASSERT_STATUS_EQ(Status::SUCCESS, storage.write(key, value));
+            bytes += key.size() + value.size();
+        }
+    }
+
+    // The engines reopen their data; the key map is empty until recover()
+    StorageType storage(4, std::hash<std::string>{}, std::nullopt,
+                        std::nullopt, paths);
+    EnginePersistence::set_name("");
+    std::string value;
+    ASSERT_STATUS_EQ(Status::NOT_FOUND, storage.read("key:42", value));
+
+    RecoveryStats stats = storage.recover();
+    ASSERT_EQ(num_keys, stats.keys);
+    ASSERT_EQ(bytes, stats.bytes);
+    ASSERT_TRUE(stats.seconds_per_gb() > 0.0);
+
+    for (size_t i = 0; i < num_keys; i += 97) {
+        Status status = storage.read("key:" + std::to_string(i), value);
+        ASSERT_STATUS_EQ(Status::SUCCESS, status);
+        ASSERT_STR_EQ("value:" + std::to_string(i), value);
+    }
+    std::vector<std::pair<std::string, std::string>> results;
+    ASSERT_STATUS_EQ(Status::SUCCESS,
+                     storage.scan("key:1", num_keys, results));
+    ASSERT_STR_EQ("key:1", results.front().first);
+
+    // Recovered keys stay on their partition when rewritten
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.write("key:42", "rewritten"));
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.read("key:42", value));
+    ASSERT_STR_EQ("rewritten", value);
+    ASSERT_EQ(num_keys, storage.recover().keys);
+    END_TEST("recover_key_map")
+}
+
+template <typename StorageType> void test_checkpoint_under_writes() {
+    TEST("checkpoint_under_writes")
+    StorageType storage =
+        repart_kv_test::make_partitioned_kv_test_storage<StorageType>(4);
+    const std::string directory =
+        repart_kv_test::test_resources_dir() + "/checkpoint_under_writes";
+    std::filesystem::remove_all(directory);
+    for (size_t i = 0; i < 2000; ++i) {
+        storage.write("key:" + std::to_string(i), std::string(32, 'x'));
+    }
+
+    // Each writer bumps pairs of keys, a:<j> before b:<j>: in any
+    // consistent cut, a:<j> is b:<j> or one version ahead
+    const size_t pairs = 64;
+    for (size_t j = 0; j < pairs; ++j) {
+        storage.write("a:" + std::to_string(j), "0");
+        storage.write("b:" + std::to_string(j), "0");
+    }
+    std::atomic<bool> running(true);
+    std::atomic<size_t> writes(0);
+    std::vector<std::thread> writers;
+    for (size_t t = 0; t < 4; ++t) {
+        writers.emplace_back([&, t]() {
+            for (size_t version = 1; running; ++version) {
+                for (size_t j = t; j < pairs; j += 4) {
+                    const std::string v = std::to_string(version);
+                    storage.write("a:" + std::to_string(j), v);
+                    storage.write("b:" + std::to_string(j), v);
+                    writes += 2;
+                }
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // Slow enough that the images take a while to write
+    CheckpointOptions options;
+    options.bytes_per_second = 128 << 10;
+    options.burst_bytes = 1;
+    CheckpointStats stats;
+    const size_t writes_before = writes;
+    ASSERT_STATUS_EQ(Status::SUCCESS,
+                     storage.checkpoint(directory, options, stats));
+    const size_t writes_during = writes - writes_before;
+    running = false;
+    for (auto &writer : writers) {
+        writer.join();
+    }
+
+    ASSERT_GT(stats.duration.count(), 200'000'000);
+    ASSERT_LT(stats.pause.count(), stats.duration.count());
+    ASSERT_GT(writes_during, size_t(0)); // Writes went on meanwhile
+    ASSERT_FALSE(std::filesystem::exists(directory + ".partial"));
+    ASSERT_STATUS_EQ(Status::ERROR, storage.checkpoint(directory));
+
+    std::map<std::string, std::string> image;
+    std::map<std::string, size_t> image_partition;
+    for (size_t i = 0; i < 4; ++i) {
+        const std::string file = EngineCheckpoint::record_file(directory, i);
+        if (std::filesystem::exists(file)) {
+            Status status = EngineCheckpoint::read_records(
+                file, [&](const std::string &key, const std::string &value) {
+                    image[key] = value;
+                    image_partition[key] = i;
+                });
+            ASSERT_STATUS_EQ(Status::SUCCESS, status);
+        }
+    }
+    ASSERT_EQ(2000 + 2 * pairs, image.size());
+    for (size_t j = 0; j < pairs; ++j) {
+        const size_t a = std::stoul(image["a:" + std::to_string(j)]);
+        const size_t b = std::stoul(image["b:" + std::to_string(j)]);
+        ASSERT_TRUE(a == b || a == b + 1);
+    }
+
+    // The plan holds the key map of the same cut
+    PartitionPlan plan;
+    ASSERT_STATUS_EQ(Status::SUCCESS, plan.load(directory + "/plan"));
+    ASSERT_EQ(size_t(4), plan.partition_count());
+    ASSERT_EQ(image.size(), plan.size());
+    const bool one_engine = // Soft storage
+        !std::filesystem::exists(EngineCheckpoint::record_file(directory, 1));
+    for (const auto &[key, partition] : image_partition) {
+        size_t planned;
+        ASSERT_TRUE(plan.partition_of(key, planned));
+        ASSERT_TRUE(one_engine || partition == planned);
+    }
+    END_TEST("checkpoint_under_writes")
+}
+
+// Restore a checkpoint as an EnginePersistence store
+template <template <typename> class KeyMap> void test_checkpoint_clone() {
+    TEST("checkpoint_clone")
+    using StorageType =
+        HardRepartitioningKeyValueStorage<LmdbStorageEngine, false, KeyMap>;
+    const std::vector<std::string> paths =
+        repart_kv_test::partitioned_kv_test_paths();
+    const std::string directory =
+        paths[0] + "/repart_kv_storage/checkpoint_clone";
+    std::filesystem::remove_all(directory);
+
+    const size_t num_keys = 5000;
+    StorageType storage(4, std::hash<std::string>{}, std::nullopt, std::nullopt,
+                        paths);
+    for (size_t i = 0; i < num_keys; ++i) {
+        storage.write("key:" + std::to_string(i), "value:" + std::to_string(i));
+    }
+    CheckpointStats stats;
+    ASSERT_STATUS_EQ(Status::SUCCESS,
+                     storage.checkpoint(directory, CheckpointOptions(), stats));
+    ASSERT_GT(stats.bytes, size_t(0));
+    storage.write("key:42", "after checkpoint");
+
+    EnginePersistence::set_name("checkpoint_clone");
+    StorageType clone(4, std::hash<std::string>{}, std::nullopt, std::nullopt,
+                      paths);
+    EnginePersistence::set_name("");
+    ASSERT_EQ(num_keys, clone.recover().keys);
+    ASSERT_STATUS_EQ(Status::SUCCESS, clone.load_plan(directory + "/plan"));
+    std::string value;
+    for (size_t i = 0; i < num_keys; i += 97) {
+        Status status = clone.read("key:" + std::to_string(i), value);
+        ASSERT_STATUS_EQ(Status::SUCCESS, status);
+        ASSERT_STR_EQ("value:" + std::to_string(i), value);
+    }
+    ASSERT_STATUS_EQ(Status::SUCCESS, clone.read("key:42", value));
+    ASSERT_STR_EQ("value:42", value);
+    END_TEST("checkpoint_clone")
+}
+
+/**
+ * Runs many partition workers on a two-thread pool: scans and point
+ * operations over every partition must complete, each partition keeping
+ * its operations in order.
+ */
+template <typename StorageType> void test_partitions_on_few_threads() {
+    TEST("partitions_on_few_threads")
+    const size_t partition_count = 96;
+    const size_t thread_count = 2;
+    StorageType storage = [&]() {
+        if constexpr (requires {
+                          StorageType(partition_count,
+                                      std::hash<std::string>{}, std::nullopt,
+                                      std::nullopt,
+                                      repart_kv_test::partitioned_kv_test_paths(),
+                                      AdmissionPolicy(), ReplicationPolicy(),
+                                      thread_count);
+                      }) {
+            return StorageType(partition_count, std::hash<std::string>{},
+                               std::nullopt, std::nullopt,
+                               repart_kv_test::partitioned_kv_test_paths(),
+                               AdmissionPolicy(), ReplicationPolicy(),
+                               thread_count);
+        } else {
+            return StorageType(partition_count, std::hash<std::string>{},
+                               std::nullopt, std::nullopt,
+                               repart_kv_test::partitioned_kv_test_paths(),
+                               AdmissionPolicy(), thread_count);
+        }
+    }();
+    ASSERT_EQ(thread_count, storage.thread_count());
+
+    const size_t num_keys = 10 * partition_count;
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < 4; ++c) {
+        clients.emplace_back([&storage, c, num_keys]() {
+            for (size_t i = c; i < num_keys; i += 4) {
+                std::string key = "few:" + std::to_string(1000 + i);
+                for (int version = 0; version < 3; ++version) {
+                    storage.write(key, key + "/" + std::to_string(version));
+                }
+            }
+        });
+    }
+    for (std::thread &client : clients) {
+        client.join();
+    }
+
+    for (size_t i = 0; i < num_keys; ++i) {
+        std::string key = "few:" + std::to_string(1000 + i);
+        std::string value;
+        ASSERT_STATUS_EQ(Status::SUCCESS, storage.read(key, value));
+        ASSERT_STR_EQ(key + "/2", value);
+    }
+    std::vector<std::pair<std::string, std::string>> results;
+    ASSERT_STATUS_EQ(Status::SUCCESS,
+                     storage.scan("few:", num_keys, results));
+    ASSERT_EQ(num_keys, results.size());
+    for (const auto &[key, value] : results) {
+        ASSERT_STR_EQ(key + "/2", value);
+    }
+    END_TEST("partitions_on_few_threads")
+}
+
 // Helper function to run all tests for a given storage type
 template <typename StorageType>
 void run_partitioned_kv_test_suite(const std::string &storage_name) {
@@ -432,6 +1101,10 @@ void run_partitioned_kv_test_suite(const std::string &storage_name) {
         {"scan_with_limit", []() { test_scan_with_limit<StorageType>(); }},
         {"scan_no_matches", []() { test_scan_no_matches<StorageType>(); }},
         {"scan_empty_prefix", []() { test_scan_empty_prefix<StorageType>(); }},
+        {"scan_across_partitions",
+         []() { test_scan_across_partitions<StorageType>(); }},
+        {"scan_many_partitions",
+         []() { test_scan_many_partitions<StorageType>(); }},
         {"large_dataset", []() { test_large_dataset<StorageType>(); }},
         {"special_characters",
          []() { test_special_characters<StorageType>(); }},
@@ -468,7 +1141,7 @@ void run_partitioned_kv_suites_for_key_storage_impl(
         MapStorageEngine, STORAGE_SYNC, KeyMap>>(
         "SoftThreadedRepartitioningKeyValueStorage" + tag);
     run_partitioned_kv_test_suite<HardThreadedRepartitioningKeyValueStorage<
-        MapStorageEngine, STORAGE_SYNC, KeyMap, KeyMap>>(
+        MapStorageEngine, STORAGE_SYNC, KeyMap>>(
         "HardThreadedRepartitioningKeyValueStorage" + tag);
 }
 
@@ -491,6 +1164,17 @@ int main() {
     run_partitioned_kv_suites_for_key_storage<LmdbKeyStorage>("LmdbKeyStorage");
     run_partitioned_kv_suites_for_key_storage<TkrzwTreeKeyStorage>(
         "TkrzwTreeKeyStorage");
+    run_partitioned_kv_suites_for_key_storage<SliceBtreeKeyStorage>(
+        "SliceBtreeKeyStorage");
+
+    // Fingerprint key maps only serve the hard storage
+    run_partitioned_kv_test_suite<HardRepartitioningKeyValueStorage<
+        MapStorageEngine, false, FingerprintKeyStorage>>(
+        "HardRepartitioningKeyValueStorage (FingerprintKeyStorage)");
+    run_partitioned_kv_test_suite<HardRepartitioningKeyValueStorage<
+        MapStorageEngine, true, FingerprintKeyStorage>>(
+        "HardRepartitioningKeyValueStorage (FingerprintKeyStorage) "
+        "[STORAGE_SYNC=true]");
 
     run_partitioned_kv_test_suite<
         LockStrippingKeyValueStorage<MapStorageEngine, false>>(
@@ -499,6 +1183,80 @@ int main() {
         LockStrippingKeyValueStorage<MapStorageEngine, true>>(
         "LockStrippingKeyValueStorage [STORAGE_SYNC=true]");
 
+    run_partitioned_kv_test_suite<
+        RangePartitionedKeyValueStorage<MapStorageEngine, false>>(
+        "RangePartitionedKeyValueStorage");
+    run_partitioned_kv_test_suite<
+        RangePartitionedKeyValueStorage<MapStorageEngine, true>>(
+        "RangePartitionedKeyValueStorage [STORAGE_SYNC=true]");
+    run_test_suite(
+        "RangePartitionedKeyValueStorage (split and merge)",
+        {{"range_split_and_merge",
+          []() { test_range_split_and_merge<false>(); }},
+         {"range_split_and_merge [STORAGE_SYNC=true]",
+          []() { test_range_split_and_merge<true>(); }},
+         {"range_online_moves", test_range_online_moves}});
+
+    run_test_suite(
+        "Threaded storages (shared worker pool)",
+        {{"partitions_on_few_threads (soft)",
+          []() {
+              test_partitions_on_few_threads<
+                  SoftThreadedRepartitioningKeyValueStorage<
+                      MapStorageEngine, false, MapKeyStorage>>();
+          }},
+         {"partitions_on_few_threads (hard)",
+          []() {
+              test_partitions_on_few_threads<
+                  HardThreadedRepartitioningKeyValueStorage<
+                      MapStorageEngine, false, MapKeyStorage>>();
+          }}});
+
+    run_test_suite(
+        "HardRepartitioningKeyValueStorage (recovery)",
+        {{"recover_key_map (MapKeyStorage)",
+          []() { test_recover_key_map<MapKeyStorage>(); }},
+         {"recover_key_map (FingerprintKeyStorage)",
+          []() { test_recover_key_map<FingerprintKeyStorage>(); }}});
+
+    run_test_suite(
+        "Checkpoints",
+        {{"checkpoint_under_writes (hard)",
+          []() {
+              test_checkpoint_under_writes<HardRepartitioningKeyValueStorage<
+                  MapStorageEngine, false, MapKeyStorage>>();
+          }},
+         {"checkpoint_under_writes (soft)",
+          []() {
+              test_checkpoint_under_writes<SoftRepartitioningKeyValueStorage<
+                  MapStorageEngine, false, MapKeyStorage, MapKeyStorage>>();
+          }},
+         {"checkpoint_clone (MapKeyStorage)",
+          []() { test_checkpoint_clone<MapKeyStorage>(); }},
+         {"checkpoint_clone (FingerprintKeyStorage)",
+          []() { test_checkpoint_clone<FingerprintKeyStorage>(); }}});
+
+    run_test_suite(
+        "WriteAheadLog",
+        {{"wal_group_commit", test_wal_group_commit},
+         {"wal_truncate_and_torn_tail", test_wal_truncate_and_torn_tail},
+         {"wal_recovery (hard)",
+          []() {
+              test_wal_recovery<HardRepartitioningKeyValueStorage<
+                  MapStorageEngine, false, MapKeyStorage>>();
+          }},
+         {"wal_recovery (soft)",
+          []() {
+              test_wal_recovery<SoftRepartitioningKeyValueStorage<
+                  MapStorageEngine, false, MapKeyStorage, MapKeyStorage>>();
+          }},
+         {"wal_recovery (lock stripping)",
+          []() {
+              test_wal_recovery<
+                  LockStrippingKeyValueStorage<MapStorageEngine, false>>();
+          }},
+         {"wal_checkpoint", test_wal_checkpoint}});
+
     std::cout << "\n========================================" << std::endl;
     std::cout << "  Overall Test Results" << std::endl;
     std::cout << "========================================" << std::endl;
@@ -512,11 +1270,14 @@ int main() {
                      "types (STORAGE_SYNC false and true per backend suite)"
                   << std::endl;
         std::cout << "✓ Key map backends: MapKeyStorage, LmdbKeyStorage, "
-                     "TkrzwTreeKeyStorage"
+                     "TkrzwTreeKeyStorage, FingerprintKeyStorage (hard only)"
                   << std::endl;
         std::cout << "✓ LockStrippingKeyValueStorage: PASSED (STORAGE_SYNC "
                      "false and true)"
                   << std::endl;
+        std::cout << "✓ RangePartitionedKeyValueStorage: PASSED (STORAGE_SYNC "
+                     "false and true)"
+                  << std::endl;
         return 0;
     } else {
         std::cout << "✗ Some tests failed!" << std::endl;
@@ -4,17 +4,24 @@
 #include "../../keystorage/MapKeyStorage.h"
 #include "../../keystorage/LmdbKeyStorage.h"
 #include "../../keystorage/TkrzwTreeKeyStorage.h"
+#include "../../keystorage/FingerprintKeyStorage.h"
 #include "../../storage/MapStorageEngine.h"
 #include "../../utils/test_assertions.h"
 #include "../threaded/SoftThreadedRepartitioningKeyValueStorage.h"
 #include "../threaded/HardThreadedRepartitioningKeyValueStorage.h"
 #include "../../storage/LmdbStorageEngine.h"
+#include "../../storage/TieredStorageEngine.h"
+#include "../../storage/CachedStorageEngine.h"
 #include "make_partitioned_test_storage.h"
+#include "../PartitionPlan.h"
+#include <cstdio>
 #include <iostream>
+#include <functional>
 #include <vector>
 #include <string>
 #include <thread>
 #include <chrono>
+#include <atomic>
 
 // Test result tracking
 int tests_passed = 0;
@@ -621,6 +628,452 @@ template <typename StorageType> void test_operation_count() {
     END_TEST("operation_count")
 }
 
+template <typename StorageType> void test_plan_checkpoint() {
+    TEST("plan_checkpoint")
+    const std::string plan_path = "/tmp/repart_kv_test_plan.bin";
+    const std::string saved_path = "/tmp/repart_kv_test_plan_saved.bin";
+    const size_t key_count = 32;
+    std::hash<std::string> hasher;
+
+    // Plan every key one partition away from its hash partition, with a
+    // co-access edge between neighbouring keys
+    PartitionPlan plan(4);
+    for (size_t i = 0; i < key_count; ++i) {
+        std::string key = "plan_key:" + std::to_string(i);
+        plan.assign(key, (hasher(key) + 1) % 4);
+        plan.graph().add_vertex_weight(key, 2);
+        if (i > 0) {
+            plan.graph().add_edge_weight(
+                key, "plan_key:" + std::to_string(i - 1), 3);
+        }
+    }
+    ASSERT_STATUS_EQ(Status::SUCCESS, plan.save(plan_path));
+
+    // Partition count mismatch and missing files are reported
+    StorageType other =
+        repart_kv_test::make_partitioned_kv_test_storage<StorageType>(2);
+    ASSERT_STATUS_EQ(Status::ERROR, other.load_plan(plan_path));
+    ASSERT_STATUS_EQ(Status::NOT_FOUND,
+                     other.load_plan("/tmp/repart_kv_test_no_plan.bin"));
+
+    StorageType storage =
+        repart_kv_test::make_partitioned_kv_test_storage<StorageType>(4);
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.load_plan(plan_path));
+    ASSERT_EQ(key_count, storage.graph().get_vertex_count());
+    ASSERT_EQ(key_count - 1, storage.graph().get_edge_count());
+    ASSERT_EQ(3, storage.graph().get_edge_weight("plan_key:1", "plan_key:0"));
+
+    // Keys written after loading land on their planned partition
+    for (size_t i = 0; i < key_count; ++i) {
+        std::string key = "plan_key:" + std::to_string(i);
+        ASSERT_STATUS_EQ(Status::SUCCESS, storage.write(key, "v" + key));
+    }
+    std::string value;
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.read("plan_key:7", value));
+    ASSERT_STR_EQ("vplan_key:7", value);
+
+    // Saving again reproduces the plan and the graph
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.save_plan(saved_path));
+    PartitionPlan saved;
+    ASSERT_STATUS_EQ(Status::SUCCESS, saved.load(saved_path));
+    ASSERT_EQ(4, saved.partition_count());
+    ASSERT_EQ(key_count, saved.size());
+    for (size_t i = 0; i < key_count; ++i) {
+        std::string key = "plan_key:" + std::to_string(i);
+        size_t partition = 0;
+        ASSERT_TRUE(saved.partition_of(key, partition));
+        ASSERT_EQ((hasher(key) + 1) % 4, partition);
+    }
+    ASSERT_EQ(2, saved.graph().get_vertex_weight("plan_key:5"));
+    ASSERT_EQ(3, saved.graph().get_edge_weight("plan_key:5", "plan_key:6"));
+
+    // Assignments are dropped as their keys are placed
+    size_t partition = 0;
+    saved.erase("plan_key:0");
+    ASSERT_EQ(key_count - 1, saved.size());
+    ASSERT_FALSE(saved.partition_of("plan_key:0", partition));
+    saved.erase_placed(
+        [](const std::string &key) { return key != "plan_key:1"; });
+    ASSERT_EQ(1, saved.size());
+    ASSERT_TRUE(saved.partition_of("plan_key:1", partition));
+
+    std::remove(plan_path.c_str());
+    std::remove(saved_path.c_str());
+    END_TEST("plan_checkpoint")
+}
+
+template <typename StorageType> void test_repartition_stats() {
+    TEST("repartition_stats")
+    StorageType storage =
+        repart_kv_test::make_partitioned_kv_test_storage<StorageType>(4);
+    ASSERT_EQ(0, storage.repartition_stats().cycle);
+    ASSERT_TRUE(storage.scan_fanout() == 0.0);
+
+    // Eight groups of four keys, each group always scanned together
+    for (size_t group = 0; group < 8; ++group) {
+        for (size_t i = 0; i < 4; ++i) {
+            std::string key = "group" + std::to_string(group) + "_key" +
+                              std::to_string(i);
+            ASSERT_STATUS_EQ(Status::SUCCESS, storage.write(key, "v" + key));
+        }
+    }
+    storage.enable_tracking(true);
+    std::vector<std::pair<std::string, std::string>> results;
+    for (int round = 0; round < 5; ++round) {
+        for (size_t group = 0; group < 8; ++group) {
+            results.clear();
+            ASSERT_STATUS_EQ(
+                Status::SUCCESS,
+                storage.scan("group" + std::to_string(group) + "_", 4,
+                             results));
+        }
+    }
+    std::this_thread::sleep_for(sleep_time);
+    ASSERT_GE(storage.scan_fanout(), 1.0);
+    ASSERT_LE(storage.scan_fanout(), 4.0);
+
+    storage.repartition();
+
+    // The cycle reports the window's fan-out and starts a new one
+    RepartitionStats stats = storage.repartition_stats();
+    ASSERT_EQ(1, stats.cycle);
+    ASSERT_GE(stats.imbalance, 1.0);
+    ASSERT_GE(stats.scan_fanout, 1.0);
+    ASSERT_LE(stats.keys_reassigned, 32);
+    ASSERT_TRUE(storage.scan_fanout() == 0.0);
+    std::cout << "    Edge cut " << stats.edge_cut << ", imbalance "
+              << stats.imbalance << ", " << stats.keys_reassigned
+              << " keys reassigned" << std::endl;
+
+    // An empty graph leaves the last stats untouched
+    storage.repartition();
+    ASSERT_EQ(1, storage.repartition_stats().cycle);
+    END_TEST("repartition_stats")
+}
+
+void test_hot_key_replication() {
+    TEST("hot_key_replication")
+    ReplicationPolicy replication;
+    replication.hot_keys = 2;
+    replication.replicas = 2;
+    HardThreadedRepartitioningKeyValueStorage<MapStorageEngine, false,
+                                              MapKeyStorage>
+        storage(4, std::hash<std::string>{}, std::nullopt, std::nullopt,
+                repart_kv_test::partitioned_kv_test_paths(), AdmissionPolicy(),
+                replication);
+
+    for (size_t i = 0; i < 100; ++i) {
+        storage.write("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    storage.enable_tracking(true);
+    std::string value;
+    for (int round = 0; round < 200; ++round) {
+        storage.read("key7", value);
+        if (round % 2 == 0) {
+            storage.read("key8", value);
+        }
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        storage.read("key" + std::to_string(i), value);
+    }
+    std::this_thread::sleep_for(sleep_time);
+    storage.repartition();
+
+    // The two hottest keys got two replicas each, on distinct partitions
+    ASSERT_EQ(2, storage.replicated_key_count());
+    for (const std::string key : {"key7", "key8"}) {
+        std::vector<size_t> replicas = storage.replica_partitions(key);
+        ASSERT_EQ(2, replicas.size());
+        ASSERT_TRUE(replicas[0] != replicas[1]);
+        ASSERT_STATUS_EQ(Status::SUCCESS, storage.read(key, value));
+        ASSERT_STR_EQ("value" + key.substr(3), value);
+    }
+    ASSERT_TRUE(storage.replica_partitions("key9").empty());
+
+    // Readers spread over the copies while a writer updates the key and
+    // always reads its own writes back
+    std::atomic<bool> writing(true);
+    std::atomic<size_t> bad_reads(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&]() {
+            std::string read_value;
+            while (writing) {
+                if (storage.read("key7", read_value) != Status::SUCCESS ||
+                    read_value.compare(0, 6, "value7") != 0) {
+                    ++bad_reads;
+                }
+            }
+        });
+    }
+    size_t stale_reads = 0;
+    for (int n = 0; n < 500; ++n) {
+        const std::string written = "value7:" + std::to_string(n);
+        storage.write("key7", written);
+        for (int r = 0; r < 3; ++r) {
+            storage.read("key7", value);
+            stale_reads += value == written ? 0 : 1;
+        }
+    }
+    writing = false;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQ(0, bad_reads.load());
+    ASSERT_EQ(0, stale_reads);
+
+    // Replacing the replicated set sends the dropped keys back to their
+    // owners, with their latest value
+    storage.replicate_hot_keys({"key9"});
+    ASSERT_EQ(1, storage.replicated_key_count());
+    ASSERT_TRUE(storage.replica_partitions("key7").empty());
+    ASSERT_EQ(2, storage.replica_partitions("key9").size());
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.read("key7", value));
+    ASSERT_STR_EQ("value7:499", value);
+    storage.write("key9", "updated");
+    for (int r = 0; r < 6; ++r) {
+        ASSERT_STATUS_EQ(Status::SUCCESS, storage.read("key9", value));
+        ASSERT_STR_EQ("updated", value);
+    }
+
+    // Cycling the replicated set removes the dropped copies, and never the
+    // value a key is read from
+    const std::vector<std::pair<std::string, std::string>> expected = {
+        {"key7", "value7:499"}, {"key8", "value8"}, {"key9", "updated"}};
+    for (int cycle = 0; cycle < 4; ++cycle) {
+        storage.replicate_hot_keys(
+            {cycle % 2 == 0 ? "key7" : "key8", "key9"});
+        ASSERT_EQ(2, storage.replicated_key_count());
+        for (const auto &[key, expected_value] : expected) {
+            for (int r = 0; r < 6; ++r) {
+                ASSERT_STATUS_EQ(Status::SUCCESS, storage.read(key, value));
+                ASSERT_STR_EQ(expected_value, value);
+            }
+        }
+    }
+    END_TEST("hot_key_replication")
+}
+
+// Keys moved by repartitionings keep serving the latest value to the thread
+// that wrote it, although their old worker may still have buffered it
+void test_moved_keys_read_latest() {
+    TEST("moved_keys_read_latest")
+    HardThreadedRepartitioningKeyValueStorage<MapStorageEngine, false,
+                                              MapKeyStorage>
+        storage(4, std::hash<std::string>{}, std::nullopt, std::nullopt,
+                repart_kv_test::partitioned_kv_test_paths());
+
+    std::atomic<bool> running(true);
+    std::atomic<size_t> stale_reads(0);
+    std::vector<std::thread> clients;
+    for (int c = 0; c < 4; ++c) {
+        clients.emplace_back([&, c]() {
+            std::string value;
+            for (size_t n = 0; running; ++n) {
+                // Pairs of keys accessed together, so repartitioning moves
+                // them
+                for (size_t i = 0; i < 16; i += 2) {
+                    const std::string prefix =
+                        "c" + std::to_string(c) + ":" + std::to_string(n % 8);
+                    const std::string first = prefix + ":" + std::to_string(i);
+                    const std::string second =
+                        prefix + ":" + std::to_string(i + 1);
+                    const std::string written = std::to_string(n);
+                    storage.write(first, written);
+                    storage.write(second, written);
+                    if (storage.read(first, value) != Status::SUCCESS ||
+                        value != written ||
+                        storage.read(second, value) != Status::SUCCESS ||
+                        value != written) {
+                        ++stale_reads;
+                    }
+                }
+            }
+        });
+    }
+    for (int cycle = 0; cycle < 20; ++cycle) {
+        storage.enable_tracking(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        storage.repartition();
+    }
+    running = false;
+    for (auto &client : clients) {
+        client.join();
+    }
+    ASSERT_EQ(0, stale_reads.load());
+    END_TEST("moved_keys_read_latest")
+}
+
+// Reads served through the per-thread routing cache stay correct while
+// repartitionings move keys between workers
+void test_routing_cache() {
+    TEST("routing_cache")
+    SoftThreadedRepartitioningKeyValueStorage<MapStorageEngine, false,
+                                              MapKeyStorage>
+        storage(4, std::hash<std::string>{}, std::nullopt, std::nullopt,
+                repart_kv_test::partitioned_kv_test_paths());
+
+    for (size_t i = 0; i < 64; ++i) {
+        storage.write("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    ASSERT_EQ(0, storage.epoch());
+
+    std::atomic<bool> reading(true);
+    std::atomic<size_t> bad_reads(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&, r]() {
+            std::string value;
+            for (size_t n = r; reading; n = (n + 1) % 8) {
+                // A few hot keys per thread, so their routes stay cached
+                const std::string key = "key" + std::to_string(n);
+                if (storage.read(key, value) != Status::SUCCESS ||
+                    value.compare(0, 5, "value") != 0) {
+                    ++bad_reads;
+                }
+            }
+        });
+    }
+
+    for (int cycle = 1; cycle <= 5; ++cycle) {
+        storage.enable_tracking(true);
+        std::string value;
+        for (size_t i = 0; i < 64; ++i) {
+            storage.read("key" + std::to_string(i), value);
+            storage.read("key" + std::to_string((i + cycle) % 64), value);
+        }
+        std::this_thread::sleep_for(sleep_time);
+        storage.repartition();
+        ASSERT_EQ(cycle, storage.epoch());
+        storage.write("key3", "value3:" + std::to_string(cycle));
+    }
+    reading = false;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQ(0, bad_reads.load());
+
+    // A cached route is refreshed by the thread's own write
+    std::string value;
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.read("key3", value));
+    ASSERT_STR_EQ("value3:5", value);
+    storage.write("key3", "latest");
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.read("key3", value));
+    ASSERT_STR_EQ("latest", value);
+    END_TEST("routing_cache")
+}
+
+// Hot partitions in memory, cold ones in LMDB
+template <bool SYNC>
+using MapLmdbTieredEngine =
+    TieredStorageEngine<MapStorageEngine, LmdbStorageEngine, SYNC>;
+
+void test_hot_cold_tiering() {
+    TEST("hot_cold_tiering")
+    HardRepartitioningKeyValueStorage<MapLmdbTieredEngine, false,
+                                      MapKeyStorage>
+        storage(4, std::hash<std::string>{}, std::nullopt, std::nullopt,
+                repart_kv_test::partitioned_kv_test_paths());
+    storage.hot_partition_count(1);
+    for (size_t p = 0; p < 4; ++p) {
+        ASSERT_TRUE(storage.partition_tier(p) == Tier::COLD);
+    }
+
+    const size_t key_count = 200;
+    for (size_t i = 0; i < key_count; ++i) {
+        storage.write("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    storage.enable_tracking(true);
+    std::string value;
+    for (int round = 0; round < 20; ++round) {
+        for (size_t i = 0; i < 10; ++i) {
+            storage.read("key" + std::to_string(i), value);
+        }
+    }
+    storage.read("key100", value);
+    std::this_thread::sleep_for(sleep_time);
+    storage.repartition();
+
+    // Exactly one partition was promoted, and no key was lost on the way
+    size_t hot = 0;
+    for (size_t p = 0; p < 4; ++p) {
+        hot += storage.partition_tier(p) == Tier::HOT ? 1 : 0;
+    }
+    ASSERT_EQ(1, hot);
+    for (size_t i = 0; i < key_count; ++i) {
+        ASSERT_STATUS_EQ(Status::SUCCESS,
+                         storage.read("key" + std::to_string(i), value));
+        ASSERT_STR_EQ("value" + std::to_string(i), value);
+    }
+
+    // Without hot partitions, the next repartitioning demotes it again
+    storage.hot_partition_count(0);
+    storage.enable_tracking(true);
+    for (size_t i = 0; i < 10; ++i) {
+        storage.read("key" + std::to_string(i), value);
+    }
+    std::this_thread::sleep_for(sleep_time);
+    storage.repartition();
+    for (size_t p = 0; p < 4; ++p) {
+        ASSERT_TRUE(storage.partition_tier(p) == Tier::COLD);
+    }
+    END_TEST("hot_cold_tiering")
+}
+
+// Read caches in front of LMDB
+template <bool SYNC>
+using CachedLmdbEngine = CachedStorageEngine<LmdbStorageEngine, SYNC>;
+
+void test_co_access_prefetching() {
+    TEST("co_access_prefetching")
+    HardRepartitioningKeyValueStorage<CachedLmdbEngine, false, MapKeyStorage>
+        storage(4, std::hash<std::string>{}, std::nullopt, std::nullopt,
+                repart_kv_test::partitioned_kv_test_paths());
+    const size_t key_count = 100;
+    for (size_t i = 0; i < key_count; ++i) {
+        storage.write("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+
+    // Scans make key0, key1, key10, key11 and key12 co-accessed
+    storage.enable_tracking(true);
+    std::vector<std::pair<std::string, std::string>> results;
+    for (int round = 0; round < 20; ++round) {
+        results.clear();
+        storage.scan("key0", 5, results);
+    }
+    std::this_thread::sleep_for(sleep_time);
+    storage.repartition();
+
+    // Reading key0 prefetches its neighbours, so reading them hits
+    std::string value;
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.read("key0", value));
+    ASSERT_STR_EQ("value0", value);
+    for (int i = 0; i < 1000 && storage.cache_stats().prefetched < 4; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(4, storage.cache_stats().prefetched);
+    const std::vector<std::string> neighbours = {"key1", "key10", "key11",
+                                                 "key12"};
+    for (const std::string &key : neighbours) {
+        ASSERT_STATUS_EQ(Status::SUCCESS, storage.read(key, value));
+        ASSERT_STR_EQ("value" + key.substr(3), value);
+    }
+    CacheStats stats = storage.cache_stats();
+    ASSERT_EQ(4, stats.hits);
+    ASSERT_EQ(0, stats.wasted);
+
+    // Keys without co-accesses prefetch nothing, and no key was lost
+    ASSERT_STATUS_EQ(Status::SUCCESS, storage.read("key50", value));
+    ASSERT_STR_EQ("value50", value);
+    for (size_t i = 0; i < key_count; ++i) {
+        ASSERT_STATUS_EQ(Status::SUCCESS,
+                         storage.read("key" + std::to_string(i), value));
+        ASSERT_STR_EQ("value" + std::to_string(i), value);
+    }
+    ASSERT_EQ(4, storage.cache_stats().prefetched);
+    END_TEST("co_access_prefetching")
+}
+
 // Test suite runner for a specific storage type
 template <typename StorageType>
 void run_repartitioning_test_suite(const std::string &storage_name) {
@@ -643,7 +1096,10 @@ void run_repartitioning_test_suite(const std::string &storage_name) {
          []() { test_untracked_keys_preservation<StorageType>(); }},
         {"partition_map_consistency",
          []() { test_partition_map_consistency<StorageType>(); }},
-        {"operation_count", []() { test_operation_count<StorageType>(); }}};
+        {"operation_count", []() { test_operation_count<StorageType>(); }},
+        {"plan_checkpoint", []() { test_plan_checkpoint<StorageType>(); }},
+        {"repartition_stats",
+         []() { test_repartition_stats<StorageType>(); }}};
 
     run_test_suite(storage_name, tests);
 }
@@ -673,7 +1129,7 @@ void run_repartitioning_suites_for_key_storage_impl(
         LmdbStorageEngine, STORAGE_SYNC, KeyMap>>(
         "SoftThreadedRepartitioningKeyValueStorage" + tag);
     run_repartitioning_test_suite<HardThreadedRepartitioningKeyValueStorage<
-        LmdbStorageEngine, STORAGE_SYNC, KeyMap, KeyMap>>(
+        LmdbStorageEngine, STORAGE_SYNC, KeyMap>>(
         "HardThreadedRepartitioningKeyValueStorage" + tag);
 }
 
@@ -699,6 +1155,28 @@ int main() {
             "LmdbKeyStorage");
         run_repartitioning_suites_for_key_storage<TkrzwTreeKeyStorage>(
             "TkrzwTreeKeyStorage");
+        run_test_suite("HardRepartitioningKeyValueStorage (tiered engines)",
+                       {{"hot_cold_tiering", test_hot_cold_tiering}});
+        run_test_suite("HardRepartitioningKeyValueStorage (cached engines)",
+                       {{"co_access_prefetching", test_co_access_prefetching}});
+        run_test_suite(
+            "HardThreadedRepartitioningKeyValueStorage (hot-key replication)",
+            {{"hot_key_replication", test_hot_key_replication}});
+        run_test_suite(
+            "HardThreadedRepartitioningKeyValueStorage (moved keys)",
+            {{"moved_keys_read_latest", test_moved_keys_read_latest}});
+        run_test_suite(
+            "SoftThreadedRepartitioningKeyValueStorage (routing cache)",
+            {{"routing_cache", test_routing_cache}});
+
+        // Fingerprint key maps only serve the hard storage
+        run_repartitioning_test_suite<HardRepartitioningKeyValueStorage<
+            MapStorageEngine, false, FingerprintKeyStorage>>(
+            "HardRepartitioningKeyValueStorage (FingerprintKeyStorage)");
+        run_repartitioning_test_suite<HardRepartitioningKeyValueStorage<
+            MapStorageEngine, true, FingerprintKeyStorage>>(
+            "HardRepartitioningKeyValueStorage (FingerprintKeyStorage) "
+            "[STORAGE_SYNC=true]");
 
         std::cout << "\n========================================\n";
         std::cout << "  All Repartitioning Tests PASSED!\n";
@@ -713,6 +1191,8 @@ int main() {
         std::cout << "  ✓ Data remains accessible after repartitioning\n";
         std::cout << "  ✓ Multiple repartitions can be performed\n";
         std::cout << "  ✓ Co-accessed keys can be optimally placed\n";
+        std::cout << "  ✓ Graph and placement plan survive a restart\n";
+        std::cout << "  ✓ Hot partitions move to the memory engine\n";
         std::cout << "  ✓ Total tests passed: " << tests_passed << "\n";
         std::cout << "  ✓ Total tests failed: " << tests_failed << "\n";
 
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "operation/Operation.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+/**
+ * @brief Admission control settings for threaded storage worker queues
+ *
+ * All limits are disabled by default, which keeps the historical behaviour of
+ * only blocking producers once a worker queue holds Q operations.
+ */
+struct AdmissionPolicy {
+    size_t max_queue_depth = 0; // Reject new requests at this depth (0: off)
+    std::chrono::microseconds target_delay{
+        0}; // CoDel target queueing delay (0: off)
+    std::chrono::microseconds interval{
+        100000}; // CoDel interval the delay must stay above target
+    std::chrono::microseconds deadline{
+        0}; // Deadline given to reads and scans on admission (0: none)
+
+    /**
+     * @brief Check whether any admission limit is configured
+     * @return true if at least one limit is enabled
+     */
+    bool enabled() const {
+        return max_queue_depth > 0 || target_delay.count() > 0 ||
+               deadline.count() > 0;
+    }
+
+    /**
+     * @brief Give an operation the configured deadline, if any
+     * @param operation The operation about to be enqueued
+     */
+    void apply_deadline(Operation &operation) const {
+        if (deadline.count() > 0) {
+            operation.deadline(std::chrono::steady_clock::now() + deadline);
+        }
+    }
+};
+
+/**
+ * @brief Per-worker admission controller
+ *
+ * Producers call admit() before enqueueing a client request; it fails when the
+ * queue is deeper than max_queue_depth or when the worker is in the CoDel
+ * "dropping" state, i.e. the queueing delay observed at dequeue time has stayed
+ * above target_delay for a whole interval. The state is left as soon as an
+ * operation is dequeued below the target or the queue drains.
+ *
+ * Only the worker thread calls on_dequeue() and expired(); producers touch
+ * nothing but atomics.
+ */
+class AdmissionController {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    AdmissionPolicy policy_;          // Configured limits
+    std::atomic_size_t depth_;        // Operations currently queued
+    std::atomic_bool dropping_;       // CoDel dropping state
+    Clock::time_point first_above_;   // When the delay may start dropping
+    bool above_target_;               // Delay is currently above target
+    std::atomic_size_t shed_count_;   // Requests rejected on admission
+    std::atomic_size_t expired_count_; // Requests that missed their deadline
+
+public:
+    /**
+     * @brief Constructor
+     * @param policy Admission limits for this worker queue
+     */
+    explicit AdmissionController(const AdmissionPolicy &policy) :
+        policy_(policy), depth_(0), dropping_(false), first_above_(),
+        above_target_(false), shed_count_(0), expired_count_(0) {}
+
+    /**
+     * @brief Decide whether a new client request may be enqueued
+     * @return true if admitted, false if the request should be answered with
+     * Status::BUSY
+     */
+    bool admit() {
+        if ((policy_.max_queue_depth > 0 &&
+             depth_.load(std::memory_order_relaxed) >=
+                 policy_.max_queue_depth) ||
+            dropping_.load(std::memory_order_relaxed)) {
+            shed_count_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Account for an operation entering the queue
+     * @param operation The operation being enqueued
+     *
+     * Scan and sync operations are shared by several workers, so only
+     * single-worker operations are timestamped for delay sampling.
+     */
+    void on_enqueue(Operation *operation) {
+        if (policy_.target_delay.count() > 0 &&
+            (operation->type() == Type::READ ||
+             operation->type() == Type::WRITE)) {
+            operation->enqueued_at(Clock::now());
+        }
+        depth_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Account for an operation leaving the queue and update the CoDel
+     * state with its queueing delay
+     * @param operation The dequeued operation
+     */
+    void on_dequeue(Operation *operation) {
+        size_t depth = depth_.fetch_sub(1, std::memory_order_relaxed) - 1;
+        if (policy_.target_delay.count() <= 0) {
+            return;
+        }
+        if (depth == 0) {
+            above_target_ = false;
+            dropping_.store(false, std::memory_order_relaxed);
+            return;
+        }
+        if (operation->type() != Type::READ &&
+            operation->type() != Type::WRITE) {
+            return;
+        }
+
+        Clock::time_point now = Clock::now();
+        if (now - operation->enqueued_at() < policy_.target_delay) {
+            above_target_ = false;
+            dropping_.store(false, std::memory_order_relaxed);
+        } else if (!above_target_) {
+            above_target_ = true;
+            first_above_ = now + policy_.interval;
+        } else if (now >= first_above_) {
+            dropping_.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Check whether a dequeued operation has missed its deadline
+     * @param operation The dequeued operation
+     * @return true if the deadline has passed and the operation should be
+     * answered with Status::BUSY
+     */
+    bool expired(const Operation *operation) {
+        if (operation->deadline() == Clock::time_point::max() ||
+            Clock::now() < operation->deadline()) {
+            return false;
+        }
+        expired_count_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Get the number of requests rejected on admission
+     * @return Shed request count
+     */
+    size_t shed_count() const {
+        return shed_count_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of requests dropped for missing their deadline
+     * @return Expired request count
+     */
+    size_t expired_count() const {
+        return expired_count_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the current queue depth
+     * @return Number of operations waiting in the queue
+     */
+    size_t depth() const { return depth_.load(std::memory_order_relaxed); }
+};
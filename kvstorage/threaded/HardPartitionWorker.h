@@ -1,105 +1,260 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <span>
 #include <thread>
-#include <semaphore>
-#include <boost/lockfree/spsc_queue.hpp>
+#include <utility>
 #include "kvstorage/threaded/operation/DoneOperation.h"
 #include "operation/Operation.h"
 #include "operation/HardReadOperation.h"
 #include "operation/HardWriteOperation.h"
 #include "operation/HardScanOperation.h"
 #include "operation/SyncOperation.h"
+#include "operation/Rendezvous.h"
+#include "AdmissionControl.h"
+#include "PriorityLanes.h"
+#include "StrandPool.h"
+#include "WriteCoalescer.h"
+#include "../../storage/MultiRead.h"
 
 /**
  * @brief Worker class for processing operations in a hard partition
  *
- * This class manages a queue of operations and processes them in a separate
- * thread. Unlike SoftPartitionWorker, it does not have a storage attribute.
- * The storage must be read from the operation object.
+ * This class manages a queue of operations and processes them as a strand on
+ * a StrandPool shared with the other workers (see SoftPartitionWorker).
+ * Unlike SoftPartitionWorker, it does not have a storage attribute. The
+ * storage must be read from the operation object. The queue is split into
+ * priority lanes (point reads, writes, scans and background control
+ * operations) served by weighted scheduling.
  *
  * @tparam StorageEngineType The storage engine type (must derive from
  * StorageEngine)
  * @tparam Q Maximum queue size for operations
  */
 template <typename StorageEngineType, size_t Q> class HardPartitionWorker {
+public:
+    // Number of buffered writes beyond which the oldest ones are applied
+    // before more queued writes are buffered
+    static constexpr size_t COALESCING_BATCH = 256;
+    // Buffered writes applied to the engines per write turn
+    static constexpr size_t WRITE_QUANTUM = 16;
+    // Keys read per scan turn before the worker yields to other lanes
+    static constexpr size_t SCAN_CHUNK = 64;
+    // Queued point reads served per read turn, looked up together by their
+    // engines (StorageEngine::multi_read())
+    static constexpr size_t READ_BATCH = 16;
+    // Turns per scheduling round for point reads, writes and scan chunks
+    static constexpr size_t READ_WEIGHT = 8;
+    static constexpr size_t WRITE_WEIGHT = 4;
+    static constexpr size_t SCAN_WEIGHT = 1;
+
+    using Pool = StrandPool<HardPartitionWorker>;
+
 private:
+    using WriteOperationType = HardWriteOperation<StorageEngineType>;
+    using ReadOperationType = HardReadOperation<StorageEngineType>;
+
     size_t partition_idx_; // Partition index for this worker
-    boost::lockfree::spsc_queue<Operation *>
-        queue_; // Lock-free SPSC queue of operations with capacity Q
-    std::counting_semaphore<Q>
-        available_sem_; // Semaphore with permits equal to items in queue
-    std::counting_semaphore<Q>
-        free_sem_;              // Semaphore with permits equal to free spaces
-    std::thread worker_thread_; // Thread running worker_loop method
+    WriteCoalescer<WriteOperationType>
+        coalescer_; // Writes dequeued but not yet applied
+    AdmissionController admission_; // Queue depth/delay based admission
+    PriorityLanes<Q> lanes_;        // Per-lane operation queues
+    std::atomic_size_t
+        buffered_read_count_; // Reads answered from the coalescing buffer
+    LaneScheduler scheduler_; // Weighted choice between the lanes
+    std::array<ReadOperationType *, READ_BATCH>
+        read_batch_; // Point reads popped for the current read turn
+    std::array<ReadRequest, READ_BATCH>
+        read_requests_; // Their engine lookups
+
+    // State of the scan whose keys this worker is reading, one chunk at a time
+    HardScanOperation<StorageEngineType>
+        *active_scan_; // Scan in progress (nullptr if none)
+    size_t scan_position_; // Next index of the scan's partition array
+
+    Strand strand_;                  // Scheduling state on the pool
+    std::unique_ptr<Pool> own_pool_; // Pool of a worker created without one
+    Pool *pool_;                     // Pool running this worker
+    Rendezvous::Ticket parked_; // Barrier this worker waits at (if any)
+    std::atomic_size_t
+        pending_wakes_; // Wake callbacks left at barriers, not run yet
+    bool done_;         // Stopped by a DoneOperation
 
 public:
     /**
      * @brief Constructor
      * @param partition_idx The partition index for this worker
+     * @param policy Admission limits for this worker's queue (default: none)
+     * @param pool Pool running the worker (default: a pool of one thread
+     * owned by the worker)
      */
-    explicit HardPartitionWorker(size_t partition_idx) :
-        partition_idx_(partition_idx),
-        queue_(Q),         // Initialize SPSC queue with capacity Q
-        available_sem_(0), // Initially no operations available
-        free_sem_(Q),      // Initially Q free spaces available
-        worker_thread_(std::thread(&HardPartitionWorker::worker_loop, this)) {}
+    explicit HardPartitionWorker(
+        size_t partition_idx,
+        const AdmissionPolicy &policy = AdmissionPolicy(),
+        Pool *pool = nullptr) :
+        partition_idx_(partition_idx), admission_(policy), lanes_(),
+        buffered_read_count_(0),
+        scheduler_(READ_WEIGHT, WRITE_WEIGHT, SCAN_WEIGHT),
+        active_scan_(nullptr), scan_position_(0),
+        own_pool_(pool == nullptr ? std::make_unique<Pool>(1) : nullptr),
+        pool_(pool == nullptr ? own_pool_.get() : pool), pending_wakes_(0),
+        done_(false) {}
 
     /**
-     * @brief Destructor - stops the worker thread
+     * @brief Destructor - stops the worker
      */
     ~HardPartitionWorker() {
-        // Signal the worker thread to stop by enqueueing a special operation
+        // Signal the worker to stop by enqueueing a special operation
         stop();
-        if (worker_thread_.joinable()) {
-            worker_thread_.join();
+        // The pool thread may still be returning from the stopping run, and
+        // the last participant of a barrier may still be running wake()
+        while (pending_wakes_.load(std::memory_order_acquire) > 0 ||
+               !strand_.idle()) {
+            std::this_thread::yield();
         }
     }
 
     /**
-     * @brief Read operation
-     * @param operation The read operation to perform
+     * @brief Read operations
+     * @param operations The read operations to perform (at most READ_BATCH)
+     *
+     * Expired reads and reads of a buffered key are answered right away. The
+     * others are grouped by engine (reads of moved keys still target older
+     * engines), and each group is looked up with a single multi_read() call.
      */
-    void read(HardReadOperation<StorageEngineType> *operation) {
-        StorageEngineType *storage = operation->storage();
-        Status status = storage->read(operation->key(), operation->value());
-        operation->status(status);
-        operation->notify();
+    void read(std::span<ReadOperationType *> operations) {
+        size_t count = 0;
+        for (ReadOperationType *operation : operations) {
+            if (admission_.expired(operation)) {
+                operation->status(Status::BUSY);
+                operation->notify();
+                continue;
+            }
+
+            // A write that is still buffered is the most recent value, as
+            // long as it targets the same engine the read was routed to
+            WriteOperationType *pending = coalescer_.find(operation->key());
+            if (pending != nullptr) {
+                if (pending->storage() == operation->storage()) {
+                    buffered_read_count_.fetch_add(1,
+                                                   std::memory_order_relaxed);
+                    operation->value(pending->value());
+                    operation->status(Status::SUCCESS);
+                    operation->notify();
+                    continue;
+                }
+                flush_writes();
+            }
+            read_requests_[count] = {&operation->key(), &operation->value()};
+            operations[count++] = operation;
+        }
+
+        for (size_t begin = 0; begin < count;) {
+            // Move the reads of the first remaining engine next to each other
+            StorageEngineType *storage = operations[begin]->storage();
+            size_t end = begin + 1;
+            for (size_t i = end; i < count; ++i) {
+                if (operations[i]->storage() == storage) {
+                    std::swap(operations[i], operations[end]);
+                    std::swap(read_requests_[i], read_requests_[end]);
+                    ++end;
+                }
+            }
+            storage->multi_read(
+                std::span(read_requests_.data() + begin, end - begin));
+            begin = end;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            operations[i]->status(read_requests_[i].status);
+            operations[i]->notify();
+        }
     }
 
     /**
      * @brief Write operation
      * @param operation The write operation to perform
+     *
+     * The write is buffered until a write turn applies it; a later write to
+     * the same key supersedes it in the meantime.
      */
     void write(HardWriteOperation<StorageEngineType> *operation) {
-        StorageEngineType *storage = operation->storage();
-        storage->write(operation->key(), operation->value());
-        delete operation;
+        // A key moved to a new engine by a repartition must not have its
+        // write to the old engine dropped, so only coalesce within one engine
+        WriteOperationType *pending = coalescer_.find(operation->key());
+        if (pending != nullptr && pending->storage() != operation->storage()) {
+            flush_writes();
+        }
+        coalescer_.add(operation);
+    }
+
+    /**
+     * @brief Apply the oldest buffered writes to their storage engines
+     * @param count Maximum number of writes to apply
+     */
+    void apply_writes(size_t count) {
+        coalescer_.flush_some(count, [](WriteOperationType *operation) {
+            operation->storage()->write(operation->key(), operation->value());
+        });
     }
 
+    /**
+     * @brief Apply all buffered writes to their storage engines
+     */
+    void flush_writes() { apply_writes(coalescer_.size()); }
+
     /**
      * @brief Scan operation
      * @param operation The scan operation to perform
+     *
+     * Only starts the scan: this worker's keys are then read in
+     * SCAN_CHUNK-sized chunks from scan turns (see scan_chunk()).
      */
     void scan(HardScanOperation<StorageEngineType> *operation) {
+        flush_writes();
+
+        // Skip the reads when the scan is no longer wanted, but still join
+        // the barrier so the other workers and the caller are released
+        if (admission_.expired(operation)) {
+            operation->status(Status::BUSY);
+            finish_scan(operation);
+            return;
+        }
+        active_scan_ = operation;
+        scan_position_ = 0;
+    }
+
+    /**
+     * @brief Read the next chunk of this worker's keys of the active scan,
+     * completing the scan when they have all been read
+     */
+    void scan_chunk() {
+        HardScanOperation<StorageEngineType> *operation = active_scan_;
         const auto &storages = operation->storages();
         const auto &partition_array = operation->partition_array();
         auto &results = operation->values();
 
-        // Iterate over each index in partition_array
-        for (size_t i = 0; i < partition_array.size(); ++i) {
+        // Iterate over the next indexes of partition_array
+        size_t read_count = 0;
+        for (; scan_position_ < partition_array.size() &&
+               read_count < SCAN_CHUNK;
+             ++scan_position_) {
             // Check if this key belongs to this worker's partition
-            if (partition_array[i] == partition_idx_) {
+            if (partition_array[scan_position_] == partition_idx_) {
                 // Get the storage for this partition
-                StorageEngineType *storage = storages[i];
-                const std::string &key = results[i].first;
+                StorageEngineType *storage = storages[scan_position_];
+                const std::string &key = results[scan_position_].first;
 
                 // Read the value for this key
                 std::string value;
                 Status read_status = storage->read(key, value);
+                ++read_count;
 
                 // Update the result with the value
                 if (read_status == Status::SUCCESS) {
-                    results[i].second = value;
+                    results[scan_position_].second = value;
                 } else {
                     // Key not found or error occurred - update operation status
                     operation->status(read_status);
@@ -107,10 +262,23 @@ public:
             }
         }
 
-        // Call is_coordinator (barrier wait)
-        bool is_coordinator = operation->is_coordinator();
+        if (scan_position_ == partition_array.size()) {
+            active_scan_ = nullptr;
+            finish_scan(operation);
+        }
+    }
 
-        // If coordinator, check status and set to SUCCESS if still PENDING
+    /**
+     * @brief Join the scan barriers once this worker's part is done
+     * @param operation The scan operation
+     *
+     * The worker then parks until the caller and every other worker have
+     * joined.
+     */
+    void finish_scan(HardScanOperation<StorageEngineType> *operation) {
+        // The last worker to finish is the coordinator: it sets the status to
+        // SUCCESS if still PENDING
+        bool is_coordinator = operation->arrive_workers().last();
         if (is_coordinator) {
             if (operation->status() == Status::PENDING) {
                 operation->status(Status::SUCCESS);
@@ -118,7 +286,7 @@ public:
         }
 
         // Sync with caller
-        operation->sync();
+        park(operation->arrive_caller(waker()));
     }
 
     /**
@@ -126,55 +294,105 @@ public:
      * @param operation The sync operation to perform
      */
     void sync(SyncOperation *operation) {
-        bool is_coordinator = operation->sync();
-        if (is_coordinator) {
+        flush_writes();
+        Rendezvous::Ticket ticket = operation->arrive(waker());
+        bool last = ticket.last();
+        park(std::move(ticket));
+        if (last) {
             delete operation;
         }
     }
 
     /**
-     * @brief Dequeue an operation from the queue
-     * @param operation Output parameter to store the dequeued operation
+     * @brief Stop taking operations until a barrier is released
+     * @param ticket This worker's arrival at the barrier
      *
-     * Waits for an available operation, removes it from the queue, and signals
-     * a free space.
+     * The worker must not touch the barrier's operation afterwards: the last
+     * participant may destroy it as soon as it is released. The last
+     * participant itself does not wait, and its wake callback is dropped.
+     */
+    void park(Rendezvous::Ticket ticket) {
+        if (ticket.last()) {
+            pending_wakes_.fetch_sub(1, std::memory_order_release);
+        }
+        parked_ = std::move(ticket);
+    }
+
+    /**
+     * @brief Make the wake callback left at a barrier
+     * @return Callback scheduling the worker, counted as pending until it
+     * has run so that the worker is not destroyed under it
      */
-    void dequeue(Operation *&operation) {
-        // Wait for an available operation
-        available_sem_.acquire();
+    std::function<void()> waker() {
+        pending_wakes_.fetch_add(1, std::memory_order_relaxed);
+        return [this] {
+            wake();
+            pending_wakes_.fetch_sub(1, std::memory_order_release);
+        };
+    }
 
-        // Dequeue from SPSC queue (lock-free)
-        if (!queue_.pop(operation)) {
-            // SPSC queue pop can fail if queue is empty, but we have semaphore
-            // so this should not happen
-            throw std::runtime_error("SPSC queue pop failed");
+    /**
+     * @brief Check whether the worker waits at a barrier
+     * @return true while parked
+     */
+    bool parked() {
+        if (!parked_.released()) {
+            return true;
         }
+        parked_ = Rendezvous::Ticket();
+        return false;
+    }
 
-        // Signal that a free space is available
-        free_sem_.release();
+    /**
+     * @brief Schedule the worker on its pool unless it is already scheduled
+     */
+    void wake() {
+        if (strand_.notify()) {
+            pool_->submit(this);
+        }
     }
 
     /**
      * @brief Enqueue an operation to the queue
      * @param operation The operation to enqueue
      *
-     * Waits for a free space in the queue, inserts the operation, and signals
-     * an available operation.
+     * Waits for a free space in the queue, inserts the operation on the lane
+     * of its type, signals an available operation and schedules the worker.
      */
     void enqueue(Operation *operation) {
-        // Wait for a free space in the queue
-        free_sem_.acquire();
+        admission_.on_enqueue(operation);
+        lanes_.push(operation);
+        wake();
+    }
 
-        // Enqueue to SPSC queue (lock-free)
-        if (!queue_.push(operation)) {
-            // SPSC queue push can fail if queue is full, but we have semaphore
-            // so this should not happen, but we'll retry just in case
-            throw std::runtime_error("SPSC queue push failed");
-        }
+    /**
+     * @brief Ask admission control whether a client request may be enqueued
+     * @return true if admitted, false if the caller should report
+     * Status::BUSY
+     *
+     * Control operations (sync, stop) bypass admission and are always
+     * enqueued.
+     */
+    bool admit() { return admission_.admit(); }
 
-        // Signal that an operation is available
-        available_sem_.release();
-    }
+    /**
+     * @brief Get the number of requests rejected by admission control
+     * @return Shed request count
+     */
+    size_t shed_count() const { return admission_.shed_count(); }
+
+    /**
+     * @brief Get the number of requests answered with Status::BUSY because
+     * they were still queued past their deadline
+     * @return Expired request count
+     */
+    size_t expired_count() const { return admission_.expired_count(); }
+
+    /**
+     * @brief Get the number of operations waiting in this worker's queue
+     * @return Queue depth (approximate while producers enqueue)
+     */
+    size_t queue_depth() const { return admission_.depth(); }
 
     void stop() {
         DoneOperation operation;
@@ -183,38 +401,158 @@ public:
     }
 
     /**
-     * @brief Worker loop that processes operations from the queue
+     * @brief Pop an operation from a lane
+     * @param lane The lane to pop from
+     * @param operation Output parameter to store the popped operation
+     * @return true if an operation was popped
+     */
+    bool pop(Lane lane, Operation *&operation) {
+        if (!lanes_.try_pop(lane, operation)) {
+            return false;
+        }
+        admission_.on_dequeue(operation);
+        return true;
+    }
+
+    /**
+     * @brief Pop up to READ_BATCH queued point reads into read_batch_
+     * @return Number of reads popped
+     */
+    size_t pop_reads() {
+        size_t count = 0;
+        Operation *operation;
+        while (count < READ_BATCH && pop(Lane::READ, operation)) {
+            read_batch_[count++] = static_cast<ReadOperationType *>(operation);
+        }
+        return count;
+    }
+
+    /**
+     * @brief Move the writes queued so far into the coalescing buffer
      *
-     * Continuously dequeues operations and processes them based on their type.
-     * Calls the respective function (read, write, or scan) for each operation.
+     * Called before serving a read or starting a scan, so that every write
+     * enqueued before it is visible. Writes pushed after the call started are
+     * left queued, which bounds the work; when the buffer is full, the oldest
+     * buffered writes are applied to make room.
      */
-    void worker_loop() {
+    void ingest_writes() {
+        size_t target = lanes_.pushed(Lane::WRITE);
         Operation *operation;
-        while (true) {
-            dequeue(operation);
-            // Process the operation based on its type
-            switch (operation->type()) {
-                case Type::READ:
-                    read(static_cast<HardReadOperation<StorageEngineType> *>(
-                        operation));
-                    break;
-                case Type::WRITE:
-                    write(static_cast<HardWriteOperation<StorageEngineType> *>(
-                        operation));
-                    break;
-                case Type::SCAN:
+        while (lanes_.popped(Lane::WRITE) < target) {
+            if (coalescer_.size() >= COALESCING_BATCH) {
+                apply_writes(WRITE_QUANTUM);
+            }
+            if (!pop(Lane::WRITE, operation)) {
+                // Held back by a fence, or enqueued concurrently and not
+                // published yet
+                break;
+            }
+            write(static_cast<WriteOperationType *>(operation));
+        }
+    }
+
+    /**
+     * @brief Process one turn of queued work
+     * @return false if there was nothing to do (the worker is idle until its
+     * next wake()), or the worker parked or stopped
+     *
+     * Same scheduling as SoftPartitionWorker::turn(): background operations
+     * once every operation enqueued before them has been popped, otherwise
+     * one read turn, write turn or scan chunk picked by weight.
+     */
+    bool turn() {
+        Operation *operation;
+        if (active_scan_ == nullptr && lanes_.ready(Lane::BACKGROUND)) {
+            if (!pop(Lane::BACKGROUND, operation)) {
+                return false;
+            }
+            if (operation->type() == Type::DONE) {
+                flush_writes();
+                done_ = true;
+                static_cast<DoneOperation *>(operation)->arrive();
+                return false;
+            }
+            sync(static_cast<SyncOperation *>(operation));
+            return true;
+        }
+
+        std::optional<Lane> lane = scheduler_.next(
+            {lanes_.ready(Lane::READ),
+             !coalescer_.empty() || lanes_.ready(Lane::WRITE),
+             active_scan_ != nullptr || lanes_.ready(Lane::SCAN)});
+        if (!lane.has_value()) {
+            return false;
+        }
+
+        switch (lane.value()) {
+            case Lane::READ: {
+                size_t count = pop_reads();
+                if (count == 0) {
+                    return false;
+                }
+                ingest_writes();
+                read(std::span(read_batch_.data(), count));
+                break;
+            }
+            case Lane::WRITE:
+                ingest_writes();
+                apply_writes(WRITE_QUANTUM);
+                break;
+            case Lane::SCAN:
+                if (active_scan_ == nullptr) {
+                    if (!pop(Lane::SCAN, operation)) {
+                        return false;
+                    }
+                    ingest_writes();
                     scan(static_cast<HardScanOperation<StorageEngineType> *>(
                         operation));
-                    break;
-                case Type::SYNC:
-                    sync(static_cast<SyncOperation *>(operation));
-                    break;
-                case Type::DONE:
-                    static_cast<DoneOperation *>(operation)->wait();
-                    return;
-                default:
-                    break;
+                }
+                if (active_scan_ != nullptr) {
+                    scan_chunk();
+                }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Run the worker's strand for a number of turns (pool threads only)
+     * @param turns Maximum number of turns
+     * @return true if work may be left
+     */
+    bool run(size_t turns) {
+        for (size_t i = 0; i < turns; ++i) {
+            if (done_ || parked() || !turn()) {
+                return false;
             }
         }
+        return true;
+    }
+
+    /**
+     * @brief Get the worker's scheduling state (for the pool)
+     * @return The strand
+     */
+    Strand &strand() { return strand_; }
+
+    /**
+     * @brief Get the number of writes dropped because a later write to the
+     * same key superseded them before they were applied
+     * @return Coalesced write count
+     */
+    size_t coalesced_write_count() const {
+        return coalescer_.coalesced_count();
+    }
+
+    /**
+     * @brief Get the number of operations served without reaching the storage
+     * engine (superseded writes and reads answered from the buffer)
+     * @return Absorbed operation count
+     */
+    size_t absorbed_count() const {
+        return coalescer_.coalesced_count() +
+               buffered_read_count_.load(std::memory_order_relaxed);
     }
 };
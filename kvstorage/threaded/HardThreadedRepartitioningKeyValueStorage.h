@@ -3,8 +3,14 @@
 #include "../RepartitioningKeyValueStorage.h"
 #include "../../keystorage/KeyStorage.h"
 #include "../../storage/StorageEngine.h"
+#include "../../storage/EngineTuning.h"
 #include "../Tracker.h"
+#include "../PartitionPlan.h"
+#include "../RepartitionStats.h"
 #include "HardPartitionWorker.h"
+#include "AdmissionControl.h"
+#include "PlacementIndex.h"
+#include "HotKeyReplication.h"
 #include "operation/HardReadOperation.h"
 #include "operation/HardWriteOperation.h"
 #include "operation/HardScanOperation.h"
@@ -24,6 +30,10 @@
 #include <condition_variable>
 #include <mutex>
 #include <memory>
+#include <deque>
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
 
 /**
  * @brief Hard threaded repartitioning key-value storage implementation
@@ -37,34 +47,82 @@
  * SoftThreadedRepartitioningKeyValueStorage (worker threads for async
  * processing).
  *
+ * Each key's {partition, storage engine} pair lives in a PlacementIndex, the
+ * single source of routing. Writers update it under the exclusive key-map
+ * lock; point reads only consult it, so they are wait-free up to the worker
+ * queue and never take the key-map lock. The ordered key map only lists the
+ * keys for scans: a key is added to it when first written and never updated
+ * afterwards.
+ *
+ * With a ReplicationPolicy, the hottest keys of each tracking window are also
+ * copied into other partitions when repartitioning. Their placement lists
+ * the copies, reads go to the copy whose worker has the shortest queue, and
+ * writes are enqueued on every copy under the key-map lock, so all copies
+ * apply a key's writes in the same order and a thread always reads its own
+ * writes. Scans only read the owning partition.
+ *
+ * Engines keep their internal locks: after a repartitioning, the previous
+ * owner of a key may still be flushing writes to an engine of an earlier
+ * level while its new owner and scans read it, and replica writes reach
+ * engines of any level.
+ *
  * @tparam StorageEngineTemplate Storage engine class template
  * @tparam STORAGE_SYNC Engine sync flag
- * @tparam StorageMapType Template for key storage type for key->engine
- * mapping (e.g., MapKeyStorage). Will be instantiated with StorageEngineType*
- * as value type.
- * @tparam PartitionMapType Template for key storage type for key->partition
- * mapping (e.g., MapKeyStorage). Will be instantiated with size_t as value
- * type.
+ * @tparam StorageMapType Template for the ordered key storage listing the
+ * keys for scans (e.g., MapKeyStorage). Its values are unused.
  * @tparam HashFunc Hash function type for key hashing (defaults to
  * std::hash<std::string>)
  * @tparam Q Maximum queue size for worker operations
  */
 template <template <bool> class StorageEngineTemplate, bool STORAGE_SYNC,
           template <typename> typename StorageMapType,
-          template <typename> typename PartitionMapType,
           typename HashFunc = std::hash<std::string>, size_t Q = 1024 * 1024>
 class HardThreadedRepartitioningKeyValueStorage
     : public RepartitioningKeyValueStorage<
           HardThreadedRepartitioningKeyValueStorage<
-              StorageEngineTemplate, STORAGE_SYNC, StorageMapType,
-              PartitionMapType, HashFunc, Q>,
+              StorageEngineTemplate, STORAGE_SYNC, StorageMapType, HashFunc,
+              Q>,
           StorageEngineTemplate, STORAGE_SYNC> {
 private:
     using StorageEngineType = StorageEngineTemplate<STORAGE_SYNC>;
+    using WorkerPool = typename HardPartitionWorker<StorageEngineType, Q>::Pool;
+
+    /**
+     * @brief Read-only copy of a hot key in another partition
+     */
+    struct Replica {
+        size_t partition;           // Partition (worker) index
+        StorageEngineType *storage; // Storage engine holding the copy
+    };
 
-    StorageMapType<StorageEngineType *>
-        storage_map_; // Maps keys to storage engine instances
-    PartitionMapType<size_t> partition_map_; // Maps keys to partition IDs
+    /**
+     * @brief Where a key lives: the worker serving it and its storage engine
+     * (whose level tells whether the key still awaits migration)
+     */
+    struct Placement {
+        size_t partition;              // Partition (worker) index
+        StorageEngineType *storage;    // Storage engine holding the key
+        std::vector<Replica> replicas; // Copies of a hot key (usually none)
+        size_t keys = 0; // Keys placed here, if interned (writer only)
+    };
+
+    StorageMapType<uint8_t>
+        storage_map_; // Ordered set of the written keys, for scans
+    PlacementIndex<Placement>
+        placement_index_; // Key placements, read without locking
+    std::map<std::pair<size_t, StorageEngineType *>, Placement>
+        placements_; // Interned placements, freed once no key refers to them
+                     // (writer only)
+    std::unordered_set<const Placement *>
+        replicated_placements_; // Placements of replicated keys, one per key
+                                // (writer only)
+    std::vector<const Placement *>
+        retired_placements_; // Replaced replicated placements, freed by
+                             // reclaim_placements()
+    std::vector<std::pair<std::string, Replica>>
+        stale_copies_; // Copies no placement lists any more, removed by
+                       // reclaim_placements()
+    std::vector<std::string> replicated_keys_; // Keys currently replicated
     std::shared_mutex
         key_map_lock_; // Mutex for thread-safe access to key mappers
     std::atomic_bool update_key_map_; // Flag indicating if the partition map
@@ -76,9 +134,16 @@ private:
     size_t partition_count_; // Number of partitions
     std::vector<StorageEngineType *>
         storages_;       // Vector of storage engine instances
+    std::vector<StorageEngineType *>
+        old_storages_;   // Engines of earlier levels, still holding keys
     size_t level_;       // Current level (tree depth or hierarchy level)
     HashFunc hash_func_; // Hash function for key hashing
     Tracker<> tracker_;  // Tracker for tracking key access patterns
+    PartitionPlan plan_; // Planned keys not placed yet (load_plan())
+    RepartitionStats repartition_stats_; // Last applied repartitioning
+    mutable std::mutex
+        repartition_stats_mutex_; // Guards repartition_stats_
+    ScanFanout scan_fanout_;      // Partitions touched per scan
 
     // Threading attributes for automatic repartitioning
     std::thread repartitioning_thread_; // Background thread for automatic
@@ -93,6 +158,8 @@ private:
     std::atomic<bool> running_;  // Flag to control the repartitioning loop
     std::condition_variable cv_; // Condition variable to wake the thread
     std::mutex cv_mutex_;        // Mutex for condition variable
+    std::unique_ptr<WorkerPool>
+        pool_; // Threads running the workers (outlives them)
     std::vector<std::unique_ptr<HardPartitionWorker<StorageEngineType, Q>>>
         workers_; // Workers for each partition
 
@@ -100,6 +167,9 @@ private:
                                             // repartitioning is enabled
     std::vector<std::string>
         paths_; // Paths for embedded database files (default: {/tmp})
+    AdmissionPolicy admission_; // Admission limits for the worker queues
+    ReplicationPolicy replication_; // Hot-key replication settings
+    EngineProfile profile_;         // Tuning of the storage engines
 
 public:
     /**
@@ -114,6 +184,16 @@ public:
      * @param paths Optional vector of paths for embedded database files
      * (default: {/tmp}) Each partition uses paths[i % paths.size()] to
      * distribute across paths
+     * @param admission Admission limits applied to every worker queue
+     * (default: none). Requests rejected by admission control, or still
+     * queued past their deadline, return Status::BUSY.
+     * @param replication Hot keys replicated at each repartitioning
+     * (default: none)
+     * @param thread_count Threads running the partition workers (default 0:
+     * one per partition, at most one per hardware thread). Partitions are
+     * strands on these threads, so there may be many more of them.
+     * @param profile Tuning of the storage engines and key maps (default: the
+     * EngineTuning profile)
      */
     HardThreadedRepartitioningKeyValueStorage(
         size_t partition_count, const HashFunc &hash_func = HashFunc(),
@@ -121,32 +201,41 @@ public:
             std::nullopt,
         std::optional<std::chrono::milliseconds> repartition_interval =
             std::nullopt,
-        const std::vector<std::string> &paths = {"/tmp"}) :
-        storage_map_(StorageMapType<StorageEngineType *>(
-            paths.empty() ? std::string("/tmp") : paths[0])),
-        partition_map_(PartitionMapType<size_t>(
-            paths.empty() ? std::string("/tmp") : paths[0])),
+        const std::vector<std::string> &paths = {"/tmp"},
+        const AdmissionPolicy &admission = AdmissionPolicy(),
+        const ReplicationPolicy &replication = ReplicationPolicy(),
+        size_t thread_count = 0,
+        const EngineProfile &profile = EngineTuning::profile()) :
+        storage_map_(make_key_storage<StorageMapType<uint8_t>>(
+            paths.empty() ? std::string("/tmp") : paths[0], profile)),
         update_key_map_(false), enable_tracking_(false),
         is_repartitioning_(false), partition_count_(partition_count), level_(0),
         hash_func_(hash_func), repartitioning_semaphore_(1),
         tracking_duration_(tracking_duration),
-        repartition_interval_(repartition_interval), running_(true), workers_(),
+        repartition_interval_(repartition_interval), running_(true),
+        pool_(std::make_unique<WorkerPool>(
+            thread_count > 0
+                ? thread_count
+                : WorkerPool::default_thread_count(partition_count))),
+        workers_(),
         auto_repartitioning_(false),
-        paths_(paths.empty() ? std::vector<std::string>{"/tmp"} : paths) {
+        paths_(paths.empty() ? std::vector<std::string>{"/tmp"} : paths),
+        admission_(admission), replication_(replication), profile_(profile) {
 
         // Create partition_count storage engine instances
         storages_.reserve(partition_count_);
         for (size_t i = 0; i < partition_count_; ++i) {
-            storages_.push_back(new StorageEngineType(
-                level_ + 1,
-                paths_[i % paths_.size()])); // Child storages at level + 1
+            storages_.push_back(new_engine<StorageEngineType>(
+                level_ + 1, paths_[i % paths_.size()], i,
+                profile_)); // Child storages at level + 1
         }
 
         // Create workers
         workers_.reserve(partition_count_);
         for (size_t i = 0; i < partition_count_; ++i) {
             workers_.emplace_back(
-                std::make_unique<HardPartitionWorker<StorageEngineType, Q>>(i));
+                std::make_unique<HardPartitionWorker<StorageEngineType, Q>>(
+                    i, admission_, pool_.get()));
         }
 
         // Start repartitioning thread if both durations are set
@@ -177,10 +266,23 @@ public:
             repartitioning_thread_.join();
         }
 
+        // Stop the workers first: they flush their buffered writes into the
+        // engines when they stop
+        workers_.clear();
+
         // Clean up storage engines
         for (auto *storage : storages_) {
             delete storage;
         }
+        for (auto *storage : old_storages_) {
+            delete storage;
+        }
+        for (const Placement *placement : replicated_placements_) {
+            delete placement;
+        }
+        for (const Placement *placement : retired_placements_) {
+            delete placement;
+        }
     }
 
     /**
@@ -190,29 +292,34 @@ public:
      * @return Status code indicating the result of the operation
      */
     Status read_impl(const std::string &key, std::string &value) {
-        // Lock key map for reading
-        key_map_lock_.lock_shared();
+        // A placement replaced meanwhile is not freed, nor a copy it lists
+        // removed, before the read is queued (see reclaim_placements())
+        std::optional<typename PlacementIndex<Placement>::Reader> reader(
+            std::in_place, placement_index_);
 
-        // Look up which storage owns this key
-        StorageEngineType *storage;
-        bool found = storage_map_.get(key, storage);
-        if (!found) {
+        // Look up which partition and storage own this key, without locking
+        const Placement *placement = placement_index_.find(key);
+        if (placement == nullptr) {
             // Key not found in any storage
-            key_map_lock_.unlock_shared();
             return Status::NOT_FOUND;
         }
+        size_t partition_idx = placement->partition;
+        StorageEngineType *storage = placement->storage;
+        if (!placement->replicas.empty()) {
+            least_loaded_copy(*placement, partition_idx, storage);
+        }
 
-        // Look up which partition owns this key
-        size_t partition_idx;
-        size_t next_partition_idx = hash_func_(key) % partition_count_;
-        partition_map_.get_or_insert(key, next_partition_idx, partition_idx);
+        if (!workers_[partition_idx]->admit()) {
+            return Status::BUSY;
+        }
 
+        // A write by this thread was enqueued on every copy before its
+        // placement was returned, so this read is queued behind it
         HardReadOperation<StorageEngineType> read_operation(key, value,
                                                             storage);
+        admission_.apply_deadline(read_operation);
         workers_[partition_idx]->enqueue(&read_operation);
-
-        // Unlock key map (we have the storage lock now)
-        key_map_lock_.unlock_shared();
+        reader.reset();
 
         // Track key access if enabled
         if (enable_tracking_.load(std::memory_order_relaxed)) {
@@ -233,33 +340,44 @@ public:
     Status write_impl(const std::string &key, const std::string &value) {
         // Lock key map for writing
         key_map_lock_.lock();
-        size_t partition_idx = 0;
 
-        // Look up or assign storage for this key
-        StorageEngineType *storage;
-
-        size_t next_partition_idx = hash_func_(key) % partition_count_;
-        StorageEngineType *next_storage = storages_[next_partition_idx];
+        // Look up or assign the partition and storage of this key
+        const Placement *current = placement_index_.find(key);
+        size_t partition_idx =
+            current != nullptr ? current->partition : initial_partition(key);
 
-        bool found_storage =
-            storage_map_.get_or_insert(key, next_storage, storage);
-        if (found_storage) {
-            partition_map_.get(key, partition_idx);
-        } else {
-            partition_map_.get_or_insert(key, next_partition_idx,
-                                         partition_idx);
+        // Admission is decided before the key is mapped so that a rejected
+        // write leaves no trace
+        if (admission_.enabled() && !workers_[partition_idx]->admit()) {
+            key_map_lock_.unlock();
+            return Status::BUSY;
         }
 
-        if (storage->level() != level_) {
+        StorageEngineType *storage;
+        if (current == nullptr) {
+            storage_map_.put(key, 0);
+            plan_.erase(key);
+            storage = storages_[partition_idx];
+        } else if (current->storage->level() != level_) {
             // Storage is from a different level - reassign to current level
             storage = storages_[partition_idx];
-            storage_map_.put(key, storage);
+        } else {
+            storage = current->storage;
         }
+        const Placement *placement =
+            publish_placement(key, partition_idx, storage);
 
         HardWriteOperation<StorageEngineType> *write_operation =
             new HardWriteOperation<StorageEngineType>(key, value, storage);
         workers_[partition_idx]->enqueue(write_operation);
 
+        // Replicas of a hot key are updated in the same order as the owner
+        for (const Replica &replica : placement->replicas) {
+            workers_[replica.partition]->enqueue(
+                new HardWriteOperation<StorageEngineType>(key, value,
+                                                          replica.storage));
+        }
+
         // Unlock key map (we have the partition lock now)
         key_map_lock_.unlock();
 
@@ -304,21 +422,24 @@ public:
                 break;
             }
 
-            StorageEngineType *storage = it.get_value();
-            size_t partition_idx;
-            size_t next_partition_idx =
-                hash_func_(it.get_key()) % partition_count_;
-            partition_map_.get_or_insert(it.get_key(), next_partition_idx,
-                                         partition_idx);
-            partition_set.insert(partition_idx);
-            partition_array.push_back(partition_idx);
-            storage_array.push_back(storage);
+            // Every listed key was placed when it was first written
+            const Placement *placement = placement_index_.find(it.get_key());
+            partition_set.insert(placement->partition);
+            partition_array.push_back(placement->partition);
+            storage_array.push_back(placement->storage);
             key_array.push_back(it.get_key());
 
             ++it;
             ++count;
         }
 
+        for (size_t partition_idx : partition_set) {
+            if (!workers_[partition_idx]->admit()) {
+                key_map_lock_.unlock_shared();
+                return Status::BUSY;
+            }
+        }
+
         // Pre-populate results with pairs containing keys from key_array
         results.reserve(key_array.size());
         for (const auto &key : key_array) {
@@ -332,11 +453,13 @@ public:
         HardScanOperation<StorageEngineType> scan_operation(
             initial_key_prefix, results, partition_set.size(),
             std::move(storage_array), std::move(partition_array));
+        admission_.apply_deadline(scan_operation);
         for (size_t partition_idx : partition_set) {
             workers_[partition_idx]->enqueue(&scan_operation);
         }
         // Unlock key map
         key_map_lock_.unlock_shared();
+        scan_fanout_.record(partition_set.size());
 
         // Track key access patterns if enabled
         if (enable_tracking_.load(std::memory_order_relaxed)) {
@@ -359,9 +482,9 @@ public:
      * Algorithm:
      * 1. Disable tracking
      * 2. Use METIS to partition the access pattern graph
-     * 3. Clear the graph for fresh tracking
-     * 4. Create new storage engines
-     * 5. Update partition_map with new assignments
+     * 3. Point the placement index at the new partitions
+     * 4. Clear the graph for fresh tracking
+     * 5. Create new storage engines
      *
      * Note: This implementation does not migrate existing data. Data migration
      * will occur lazily as keys are accessed and reassigned to new partitions.
@@ -371,18 +494,47 @@ public:
         is_repartitioning_ = true;
         enable_tracking_ = false;
 
+        RepartitionStats stats;
         bool success =
-            tracker_.prepare_for_partition_map_update(partition_count_);
+            tracker_.prepare_for_partition_map_update(partition_count_, stats);
+
+        // Hot keys of this tracking window, taken before the graph is cleared
+        std::vector<std::string> hot_keys;
+        if (replication_.enabled()) {
+            hot_keys = tracker_.hot_keys(replication_.hot_keys);
+        }
 
         if (success) {
             // Step 3: Lock and update partition assignments
+            const auto update_start = std::chrono::steady_clock::now();
             key_map_lock_.lock();
 
+            // Moved keys stay in their storage: their old workers apply the
+            // writes they buffered first, so the new ones read the latest
+            // values
+            drain_workers();
+
             // Save old storages
-            auto old_storages = storages_;
+            old_storages_.insert(old_storages_.end(), storages_.begin(),
+                                 storages_.end());
 
-            // Update partition_map with new assignments
-            tracker_.update_partition_map(partition_map_);
+            // Route reads of the moved keys to their new workers. Their data
+            // stays in the old storages until they are written again.
+            std::vector<idx_t> metis_partitions =
+                tracker_.get_metis_partitions();
+            const auto &idx_to_vertex = tracker_.get_idx_to_vertex();
+            for (size_t i = 0; i < metis_partitions.size(); ++i) {
+                const Placement *placement =
+                    placement_index_.find(idx_to_vertex[i]);
+                size_t partition_idx = static_cast<size_t>(metis_partitions[i]);
+                if (placement != nullptr &&
+                    placement->partition != partition_idx) {
+                    publish_placement(idx_to_vertex[i], partition_idx,
+                                      placement->storage);
+                    ++stats.keys_reassigned;
+                }
+            }
+            tracker_.lock_and_clear_graph();
 
             // Create new storage engines
             storages_.clear();
@@ -390,18 +542,167 @@ public:
             // Increment level for new storage engines
             level_++;
             for (size_t i = 0; i < partition_count_; ++i) {
-                storages_.push_back(
-                    new StorageEngineType(level_, paths_[i % paths_.size()]));
+                storages_.push_back(new_engine<StorageEngineType>(
+                    level_, paths_[i % paths_.size()], i, profile_));
             }
+            reclaim_placements();
 
             // Unlock key map
             key_map_lock_.unlock();
+            stats.update_time =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - update_start);
+
+            // Nothing is copied here: bytes_migrated stays 0
+            stats.scan_fanout = scan_fanout_.roll();
+            std::lock_guard<std::mutex> lock(repartition_stats_mutex_);
+            stats.cycle = repartition_stats_.cycle + 1;
+            repartition_stats_ = stats;
+        }
+
+        if (replication_.enabled()) {
+            replicate_hot_keys(hot_keys);
         }
 
         // Clear repartitioning flag
         is_repartitioning_ = false;
     }
 
+    /**
+     * @brief Replicate keys into other partitions, replacing the previously
+     * replicated set
+     *
+     * Called by repartition() with the hottest tracked keys when replication
+     * is enabled. Each key is read from its owner and copied into the
+     * ReplicationPolicy::replicas least charged other partitions while
+     * writers are held off; its reads are spread over the copies once they
+     * are queued. Keys that are no longer listed go back to being served by
+     * their owner only, and copies no placement lists any more are removed
+     * from their engines, whatever their level, once the reads routed to
+     * them have been served.
+     *
+     * @param keys Keys to replicate, hottest first; unknown keys are skipped
+     */
+    void replicate_hot_keys(const std::vector<std::string> &keys) {
+        std::set<std::string> listed(keys.begin(), keys.end());
+
+        key_map_lock_.lock();
+
+        // Read the current values from the owners, all workers at once
+        std::deque<std::string> hot;
+        std::deque<std::string> values;
+        std::deque<HardReadOperation<StorageEngineType>> reads;
+        std::set<std::string> seen;
+        for (const std::string &key : keys) {
+            const Placement *placement = placement_index_.find(key);
+            if (placement == nullptr || !seen.insert(key).second) {
+                continue;
+            }
+            hot.push_back(key);
+            values.emplace_back();
+            reads.emplace_back(hot.back(), values.back(), placement->storage);
+            workers_[placement->partition]->enqueue(&reads.back());
+        }
+        for (auto &read : reads) {
+            read.wait();
+        }
+
+        // Serve the keys that dropped out from their owners only
+        for (const std::string &key : replicated_keys_) {
+            const Placement *placement = placement_index_.find(key);
+            if (listed.count(key) == 0 && placement != nullptr) {
+                place(key,
+                      interned(placement->partition, placement->storage));
+            }
+        }
+        replicated_keys_.clear();
+
+        // Copies are enqueued before their placement is published, so reads
+        // routed to them find the value
+        ReplicaPlacer placer(partition_count_, replication_.replicas);
+        for (size_t i = 0; i < hot.size(); ++i) {
+            const Placement *owner = placement_index_.find(hot[i]);
+            if (reads[i].status() != Status::SUCCESS) {
+                continue;
+            }
+            Placement *placement =
+                new Placement{owner->partition, owner->storage, {}};
+            for (size_t partition_idx : placer.place(owner->partition)) {
+                StorageEngineType *storage = storages_[partition_idx];
+                workers_[partition_idx]->enqueue(
+                    new HardWriteOperation<StorageEngineType>(
+                        hot[i], values[i], storage));
+                placement->replicas.push_back(Replica{partition_idx, storage});
+            }
+            replicated_placements_.insert(placement);
+            place(hot[i], placement);
+            replicated_keys_.push_back(hot[i]);
+        }
+        reclaim_placements();
+
+        key_map_lock_.unlock();
+    }
+
+    /**
+     * @brief Get the number of keys currently replicated
+     * @return Replicated key count
+     */
+    size_t replicated_key_count() {
+        std::shared_lock<std::shared_mutex> lock(key_map_lock_);
+        return replicated_keys_.size();
+    }
+
+    /**
+     * @brief Get the partitions holding a read-only copy of a key
+     * @param key The key
+     * @return Replica partitions, empty if the key is not replicated
+     */
+    std::vector<size_t> replica_partitions(const std::string &key) const {
+        std::vector<size_t> partitions;
+        typename PlacementIndex<Placement>::Reader reader(placement_index_);
+        const Placement *placement = placement_index_.find(key);
+        if (placement != nullptr) {
+            for (const Replica &replica : placement->replicas) {
+                partitions.push_back(replica.partition);
+            }
+        }
+        return partitions;
+    }
+
+    Status save_plan_impl(const std::string &path) {
+        PartitionPlan plan(partition_count_);
+        key_map_lock_.lock_shared();
+        for (auto it = storage_map_.lower_bound(""); !it.is_end(); ++it) {
+            plan.assign(it.get_key(),
+                        placement_index_.find(it.get_key())->partition);
+        }
+        key_map_lock_.unlock_shared();
+        plan.graph() = tracker_.snapshot_graph();
+        return plan.save(path);
+    }
+
+    Status load_plan_impl(const std::string &path) {
+        PartitionPlan plan;
+        Status status = plan.load(path);
+        if (status != Status::SUCCESS) {
+            return status;
+        }
+        if (plan.partition_count() != partition_count_) {
+            return Status::ERROR;
+        }
+        tracker_.merge_graph(plan.graph());
+        plan.graph().clear();
+
+        key_map_lock_.lock();
+        // Keys already placed keep their partition
+        plan.erase_placed([this](const std::string &key) {
+            return placement_index_.find(key) != nullptr;
+        });
+        plan_ = std::move(plan);
+        key_map_lock_.unlock();
+        return Status::SUCCESS;
+    }
+
     // Interface methods required by the abstract base class
     void enable_tracking_impl(bool enable) { enable_tracking_ = enable; }
 
@@ -409,6 +710,13 @@ public:
 
     bool is_repartitioning_impl() const { return is_repartitioning_.load(); }
 
+    RepartitionStats repartition_stats_impl() const {
+        std::lock_guard<std::mutex> lock(repartition_stats_mutex_);
+        return repartition_stats_;
+    }
+
+    double scan_fanout_impl() const { return scan_fanout_.mean(); }
+
     const Graph &graph_impl() const { return tracker_.graph(); }
 
     size_t operation_count_impl() const {
@@ -416,10 +724,287 @@ public:
         for (auto *storage : storages_) {
             operation_count += storage->operation_count();
         }
+        // Operations the workers served without reaching an engine
+        for (const auto &worker : workers_) {
+            operation_count += worker->absorbed_count();
+        }
         return operation_count;
     }
 
+    /**
+     * @brief Get the number of writes the workers dropped because a later
+     * write to the same key in the same batch superseded them
+     * @return Coalesced write count summed over all workers
+     */
+    size_t coalesced_write_count() const {
+        size_t coalesced = 0;
+        for (const auto &worker : workers_) {
+            coalesced += worker->coalesced_write_count();
+        }
+        return coalesced;
+    }
+
+    /**
+     * @brief Get the number of requests rejected by admission control
+     * @return Shed request count summed over all workers
+     */
+    size_t shed_count() const {
+        size_t shed = 0;
+        for (const auto &worker : workers_) {
+            shed += worker->shed_count();
+        }
+        return shed;
+    }
+
+    /**
+     * @brief Get the number of requests answered with Status::BUSY because
+     * they were still queued past their deadline
+     * @return Expired request count summed over all workers
+     */
+    size_t expired_count() const {
+        size_t expired = 0;
+        for (const auto &worker : workers_) {
+            expired += worker->expired_count();
+        }
+        return expired;
+    }
+
+    /**
+     * @brief Get the number of threads running the partition workers
+     * @return Thread count
+     */
+    size_t thread_count() const { return pool_->thread_count(); }
+
+    /**
+     * @brief Get the number of times an idle thread took a worker queued on
+     * another thread
+     * @return Steal count
+     */
+    size_t steal_count() const { return pool_->steal_count(); }
+
 private:
+    /**
+     * @brief Choose the partition of a key written for the first time
+     * @param key The key
+     * @return The partition planned by load_plan(), or the key's hash
+     * partition
+     */
+    size_t initial_partition(const std::string &key) const {
+        size_t partition_idx;
+        if (plan_.partition_of(key, partition_idx)) {
+            return partition_idx;
+        }
+        return hash_func_(key) % partition_count_;
+    }
+
+    /**
+     * @brief Get the shared placement record of an unreplicated key
+     * @param partition_idx Partition (worker) serving the key
+     * @param storage Storage engine holding the key
+     * @return The interned placement
+     *
+     * Must be called with the key-map lock held exclusively.
+     */
+    const Placement *interned(size_t partition_idx,
+                              StorageEngineType *storage) {
+        auto it = placements_
+                      .try_emplace({partition_idx, storage},
+                                   Placement{partition_idx, storage, {}})
+                      .first;
+        return &it->second;
+    }
+
+    /**
+     * @brief Point the placement index at a key's current partition and
+     * storage
+     * @param key The key
+     * @param partition_idx Partition (worker) serving the key
+     * @param storage Storage engine holding the key
+     * @return The key's placement; a replicated key keeps its replicas
+     * other than the new partition
+     *
+     * Must be called with the key-map lock held exclusively.
+     */
+    const Placement *publish_placement(const std::string &key,
+                                       size_t partition_idx,
+                                       StorageEngineType *storage) {
+        const Placement *current = placement_index_.find(key);
+        if (current != nullptr && current->partition == partition_idx &&
+            current->storage == storage) {
+            return current;
+        }
+        std::vector<Replica> replicas;
+        if (current != nullptr) {
+            for (const Replica &replica : current->replicas) {
+                if (replica.partition != partition_idx) {
+                    replicas.push_back(replica);
+                }
+            }
+        }
+        const Placement *placement;
+        if (replicas.empty()) {
+            placement = interned(partition_idx, storage);
+        } else {
+            placement = new Placement{partition_idx, storage,
+                                      std::move(replicas)};
+            replicated_placements_.insert(placement);
+        }
+        place(key, placement);
+        return placement;
+    }
+
+    /**
+     * @brief Point the placement index at a placement, keeping the key
+     * counts of the interned placements
+     * @param key The key
+     * @param placement The key's new placement
+     *
+     * The replaced placement is retired if it was the key's own, and the
+     * copies it listed that the new one does not are marked stale. Must be
+     * called with the key-map lock held exclusively.
+     */
+    void place(const std::string &key, const Placement *placement) {
+        const Placement *current = placement_index_.find(key);
+        if (current == placement) {
+            return;
+        }
+        if (Placement *entry = interned_entry(placement)) {
+            ++entry->keys;
+        }
+        placement_index_.publish(key, placement);
+        if (current == nullptr) {
+            return;
+        }
+
+        for (const Replica &replica : current->replicas) {
+            if (!holds_copy(*placement, replica.storage)) {
+                stale_copies_.emplace_back(key, replica);
+            }
+        }
+        if (Placement *entry = interned_entry(current)) {
+            --entry->keys;
+        } else if (replicated_placements_.erase(current) > 0) {
+            retired_placements_.push_back(current);
+        }
+    }
+
+    /**
+     * @brief Check whether a placement reads a key from a storage engine
+     * @param placement The key's placement
+     * @param storage The storage engine
+     * @return true if the engine holds the key's owner copy or a replica
+     */
+    static bool holds_copy(const Placement &placement,
+                           const StorageEngineType *storage) {
+        if (placement.storage == storage) {
+            return true;
+        }
+        for (const Replica &replica : placement.replicas) {
+            if (replica.storage == storage) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Get the writable record of an interned placement
+     * @param placement A placement
+     * @return Its entry in placements_, or nullptr if it is not interned
+     */
+    Placement *interned_entry(const Placement *placement) {
+        auto it = placements_.find({placement->partition, placement->storage});
+        return it != placements_.end() && &it->second == placement
+                   ? &it->second
+                   : nullptr;
+    }
+
+    /**
+     * @brief Free the placements no key refers to any more, and remove the
+     * stale copies of replicated keys from their engines
+     *
+     * Waits for the readers that may still hold a replaced placement (see
+     * PlacementIndex::synchronize(), which also frees the index's retired
+     * slot arrays). Reads are queued before their reader ends, so once the
+     * workers are drained no read can reach a stale copy any more. Must be
+     * called with the key-map lock held exclusively.
+     */
+    void reclaim_placements() {
+        placement_index_.synchronize();
+
+        if (!stale_copies_.empty()) {
+            drain_workers();
+            std::string removed_value;
+            for (const auto &[key, replica] : stale_copies_) {
+                // The key may have been placed on that engine again since
+                const Placement *placement = placement_index_.find(key);
+                if (placement == nullptr ||
+                    !holds_copy(*placement, replica.storage)) {
+                    replica.storage->remove(key, removed_value);
+                }
+            }
+            stale_copies_.clear();
+        }
+
+        for (const Placement *placement : retired_placements_) {
+            delete placement;
+        }
+        retired_placements_.clear();
+        std::erase_if(placements_, [](const auto &entry) {
+            return entry.second.keys == 0;
+        });
+    }
+
+    /**
+     * @brief Wait until every worker has served the operations queued so
+     * far and applied its buffered writes
+     *
+     * Must be called with the key-map lock held exclusively, so that no
+     * write is queued meanwhile. The workers park at the fence until the
+     * caller has joined it too.
+     */
+    void drain_workers() {
+        SyncOperation *sync_operation =
+            new SyncOperation(partition_count_ + 1);
+        for (auto &worker : workers_) {
+            worker->enqueue(sync_operation);
+        }
+        // The last participant to arrive frees the operation
+        if (sync_operation->sync()) {
+            delete sync_operation;
+        }
+    }
+
+    /**
+     * @brief Pick the copy of a replicated key whose worker has the shortest
+     * queue
+     * @param placement The key's placement
+     * @param partition_idx Output: partition (worker) of the chosen copy
+     * @param storage Output: storage engine of the chosen copy
+     */
+    void least_loaded_copy(const Placement &placement, size_t &partition_idx,
+                           StorageEngineType *&storage) const {
+        // Start from a different copy on every call, so that idle workers
+        // share the reads too
+        thread_local size_t rotation = 0;
+        const size_t copies = placement.replicas.size() + 1;
+        const size_t start = rotation++;
+        size_t best_depth = SIZE_MAX;
+        for (size_t i = 0; i < copies; ++i) {
+            size_t copy = (start + i) % copies;
+            size_t partition = copy == 0
+                                   ? placement.partition
+                                   : placement.replicas[copy - 1].partition;
+            size_t depth = workers_[partition]->queue_depth();
+            if (depth < best_depth) {
+                best_depth = depth;
+                partition_idx = partition;
+                storage = copy == 0 ? placement.storage
+                                    : placement.replicas[copy - 1].storage;
+            }
+        }
+    }
+
     /**
      * @brief Background thread loop for automatic repartitioning
      *
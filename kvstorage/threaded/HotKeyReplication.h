@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Hot-key read replication settings for the hard threaded storage
+ *
+ * A single hot key keeps its partition's worker busy however the keys are
+ * balanced, since partitioning cannot split a key. With replication enabled,
+ * every repartitioning copies the hot_keys most accessed keys of the tracking
+ * window into `replicas` other partitions. Reads of a replicated key go to
+ * whichever of its workers has the shortest queue, and writes are enqueued on
+ * all of them. Disabled by default.
+ */
+struct ReplicationPolicy {
+    size_t hot_keys = 0; // Keys replicated per repartitioning (0: off)
+    size_t replicas = 0; // Read-only copies of each of them, besides the
+                         // owning partition (capped at partitions - 1)
+
+    /**
+     * @brief Check whether hot keys are replicated
+     * @return true if both settings are non-zero
+     */
+    bool enabled() const { return hot_keys > 0 && replicas > 0; }
+};
+
+/**
+ * @brief Spreads the replicas of a set of hot keys over the partitions
+ *
+ * Each partition is charged for the hot keys it owns or replicates, and
+ * every key's replicas go to the least charged partitions other than its
+ * owner, so no partition collects more than its share of hot reads.
+ */
+class ReplicaPlacer {
+private:
+    std::vector<size_t> load_; // Hot keys served by each partition
+    size_t replicas_;          // Replicas per key
+
+public:
+    /**
+     * @brief Constructor
+     * @param partition_count Number of partitions
+     * @param replicas Replicas per key (capped at partition_count - 1)
+     */
+    ReplicaPlacer(size_t partition_count, size_t replicas) :
+        load_(partition_count, 0),
+        replicas_(std::min(replicas,
+                           partition_count > 0 ? partition_count - 1 : 0)) {}
+
+    /**
+     * @brief Choose the replica partitions of the next hot key
+     * @param owner Partition owning the key
+     * @return Up to `replicas` distinct partitions, none of them the owner
+     */
+    std::vector<size_t> place(size_t owner) {
+        std::vector<size_t> candidates;
+        candidates.reserve(load_.size());
+        for (size_t p = 0; p < load_.size(); ++p) {
+            if (p != owner) {
+                candidates.push_back(p);
+            }
+        }
+        // Least charged first; ties go to the partitions following the owner
+        auto distance = [&](size_t p) {
+            return (p + load_.size() - owner) % load_.size();
+        };
+        std::sort(candidates.begin(), candidates.end(),
+                  [&](size_t a, size_t b) {
+                      return load_[a] != load_[b] ? load_[a] < load_[b]
+                                                  : distance(a) < distance(b);
+                  });
+        candidates.resize(replicas_);
+        if (owner < load_.size()) {
+            ++load_[owner];
+        }
+        for (size_t p : candidates) {
+            ++load_[p];
+        }
+        return candidates;
+    }
+};
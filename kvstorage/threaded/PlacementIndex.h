@@ -0,0 +1,267 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Read-mostly concurrent index from keys to placements
+ *
+ * Maps every key to a pointer to an immutable placement record (e.g. the
+ * partition and storage engine that own the key). Lookups are wait-free:
+ * they never take a lock, never retry and never write shared state, so
+ * readers do not contend with each other or with the writer.
+ *
+ * Updates follow a read-copy-update discipline and must be serialized by the
+ * caller (the threaded storages hold their exclusive key-map lock):
+ * - changing a key's placement is a single atomic pointer store on the key's
+ *   node, so readers see either the old or the new placement;
+ * - a new key is published by storing its node into an empty slot of an
+ *   open-addressing table (keys are never removed, so probe chains only
+ *   grow);
+ * - growing the table builds a new slot array over the same nodes and then
+ *   publishes it; readers still probing the old array see every key that
+ *   existed when they started.
+ *
+ * Readers that keep a placement beyond find() bracket their use of it with a
+ * Reader. synchronize() waits until every Reader that started before it has
+ * ended: after it returns, placements replaced before the call may be freed,
+ * and it frees the slot arrays retired by growth. A Reader costs one atomic
+ * increment and decrement on a counter sharded over cache lines, and readers
+ * never wait for the writer. Nodes live until the index is destroyed.
+ *
+ * @tparam Placement Placement record type. Records are owned by the caller,
+ * which frees replaced ones once synchronize() has returned.
+ */
+template <typename Placement> class PlacementIndex {
+private:
+    /**
+     * @brief Key with its current placement
+     */
+    struct Node {
+        const std::string key; // The key
+        const size_t hash;     // Hash of the key
+        std::atomic<const Placement *> placement; // Current placement
+
+        Node(const std::string &k, size_t h, const Placement *p) :
+            key(k), hash(h), placement(p) {}
+    };
+
+    /**
+     * @brief Open-addressing slot array with linear probing
+     */
+    struct Table {
+        size_t mask; // Capacity - 1 (capacity is a power of two)
+        std::unique_ptr<std::atomic<Node *>[]> slots; // nullptr: empty slot
+
+        explicit Table(size_t capacity) :
+            mask(capacity - 1),
+            slots(std::make_unique<std::atomic<Node *>[]>(capacity)) {
+            for (size_t i = 0; i < capacity; ++i) {
+                slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    /**
+     * @brief Count of the Readers in progress that picked one shard
+     */
+    struct alignas(64) ReaderShard {
+        std::atomic_size_t count{0};
+    };
+
+    static constexpr size_t INITIAL_CAPACITY = 1024;
+    static constexpr size_t READER_SHARDS = 16;
+
+    std::atomic<Table *> table_; // Current slot array
+    std::vector<std::unique_ptr<Table>>
+        tables_; // Current and retired slot arrays (writer only)
+    std::deque<Node> nodes_;        // Nodes, stable addresses (writer only)
+    std::atomic_size_t size_;       // Number of indexed keys
+    std::hash<std::string> hasher_; // Key hash function
+    std::atomic<uint64_t> phase_;   // Readers count in shards of phase_ % 2
+    mutable std::array<std::array<ReaderShard, READER_SHARDS>, 2>
+        readers_; // Readers in progress, per phase
+
+    /**
+     * @brief Get the calling thread's reader shard
+     * @return Shard index, picked once per thread
+     */
+    static size_t reader_shard() {
+        static std::atomic_size_t next_shard{0};
+        thread_local const size_t index =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % READER_SHARDS;
+        return index;
+    }
+
+    /**
+     * @brief Wait until no Reader counts in a phase's shards
+     * @param phase The phase (0 or 1)
+     */
+    void wait_for_readers(size_t phase) const {
+        for (const ReaderShard &shard : readers_[phase]) {
+            while (shard.count.load(std::memory_order_seq_cst) > 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /**
+     * @brief Find a key's node in a slot array
+     * @param table The slot array
+     * @param key The key
+     * @param hash Hash of the key
+     * @return The node, or nullptr if the key is not in the array
+     */
+    static Node *probe(const Table *table, const std::string &key,
+                       size_t hash) {
+        for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+            Node *node = table->slots[i].load(std::memory_order_acquire);
+            if (node == nullptr) {
+                return nullptr;
+            }
+            if (node->hash == hash && node->key == key) {
+                return node;
+            }
+        }
+    }
+
+    /**
+     * @brief Store a node into the first empty slot of its probe chain
+     * @param table The slot array
+     * @param node The node to insert
+     */
+    static void insert(Table *table, Node *node) {
+        size_t i = node->hash & table->mask;
+        while (table->slots[i].load(std::memory_order_relaxed) != nullptr) {
+            i = (i + 1) & table->mask;
+        }
+        table->slots[i].store(node, std::memory_order_release);
+    }
+
+public:
+    /**
+     * @brief Scope during which placements found in the index stay valid
+     *
+     * Must not wait for the writer, or for anything the writer may wait for
+     * while it synchronizes.
+     */
+    class Reader {
+    private:
+        std::atomic_size_t *count_; // Shard counting this reader
+
+    public:
+        /**
+         * @brief Constructor - starts the read section
+         * @param index The index read from
+         */
+        explicit Reader(const PlacementIndex &index) {
+            size_t phase = index.phase_.load(std::memory_order_seq_cst) % 2;
+            count_ = &index.readers_[phase][reader_shard()].count;
+            count_->fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        /**
+         * @brief Destructor - ends the read section
+         */
+        ~Reader() { count_->fetch_sub(1, std::memory_order_release); }
+
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+    };
+
+    /**
+     * @brief Constructor
+     */
+    PlacementIndex() : size_(0), phase_(0) {
+        tables_.push_back(std::make_unique<Table>(INITIAL_CAPACITY));
+        table_.store(tables_.back().get(), std::memory_order_release);
+    }
+
+    // Copy constructor and assignment operator are deleted
+    PlacementIndex(const PlacementIndex &) = delete;
+    PlacementIndex &operator=(const PlacementIndex &) = delete;
+
+    /**
+     * @brief Look up a key's placement (wait-free, safe from any thread)
+     * @param key The key
+     * @return The key's placement, or nullptr if the key is not indexed
+     */
+    const Placement *find(const std::string &key) const {
+        const Table *table = table_.load(std::memory_order_acquire);
+        Node *node = probe(table, key, hasher_(key));
+        return node != nullptr
+                   ? node->placement.load(std::memory_order_acquire)
+                   : nullptr;
+    }
+
+    /**
+     * @brief Set a key's placement, indexing the key if needed
+     * @param key The key
+     * @param placement The new placement
+     *
+     * Calls must be serialized by the caller.
+     */
+    void publish(const std::string &key, const Placement *placement) {
+        size_t hash = hasher_(key);
+        Table *table = table_.load(std::memory_order_relaxed);
+        Node *node = probe(table, key, hash);
+        if (node != nullptr) {
+            node->placement.store(placement, std::memory_order_release);
+            return;
+        }
+
+        // Keep the load factor at or below one half
+        size_t capacity = table->mask + 1;
+        if (2 * (size_.load(std::memory_order_relaxed) + 1) > capacity) {
+            auto grown = std::make_unique<Table>(2 * capacity);
+            for (size_t i = 0; i < capacity; ++i) {
+                Node *existing =
+                    table->slots[i].load(std::memory_order_relaxed);
+                if (existing != nullptr) {
+                    insert(grown.get(), existing);
+                }
+            }
+            table = grown.get();
+            tables_.push_back(std::move(grown));
+            table_.store(table, std::memory_order_release);
+        }
+
+        nodes_.emplace_back(key, hash, placement);
+        insert(table, &nodes_.back());
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Wait until every Reader that started before the call has ended,
+     * then free the retired slot arrays
+     *
+     * Placements replaced before the call are unreachable afterwards. Calls
+     * must be serialized with publish() by the caller.
+     */
+    void synchronize() {
+        // Order the replacements before the reader counts are read
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // Flip the phase twice: a Reader that read the phase just before a
+        // flip counts in the phase drained by the next one
+        for (size_t i = 0; i < 2; ++i) {
+            uint64_t phase = phase_.fetch_add(1, std::memory_order_seq_cst);
+            wait_for_readers(phase % 2);
+        }
+        tables_.erase(tables_.begin(), tables_.end() - 1);
+    }
+
+    /**
+     * @brief Get the number of indexed keys
+     * @return Key count
+     */
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <semaphore>
+#include <stdexcept>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <tbb/concurrent_queue.h>
+#include "operation/Operation.h"
+
+/**
+ * @brief Priority lanes of a partition worker queue
+ *
+ * READ, WRITE and SCAN are data lanes served by weighted scheduling.
+ * BACKGROUND carries control operations (repartition syncs and shutdown),
+ * which act as fences over the data lanes.
+ */
+enum class Lane : size_t { READ = 0, WRITE = 1, SCAN = 2, BACKGROUND = 3 };
+
+/**
+ * @brief Get the lane an operation type is queued on
+ * @param type The operation type
+ * @return The lane for the type
+ */
+inline Lane lane_of(Type type) {
+    switch (type) {
+        case Type::READ:
+            return Lane::READ;
+        case Type::WRITE:
+            return Lane::WRITE;
+        case Type::SCAN:
+            return Lane::SCAN;
+        default:
+            return Lane::BACKGROUND;
+    }
+}
+
+/**
+ * @brief Multi-lane operation queue with fence semantics
+ *
+ * Every data lane is a multi-producer queue, since client threads may enqueue
+ * concurrently (reads do not take the key-map lock exclusively, or at all);
+ * only the worker pops, from one pool thread at a time. The total number of
+ * queued operations is bounded by Q through a shared pair of semaphores, so
+ * producers block exactly as with a single queue.
+ *
+ * A background (control) operation records how many operations had been
+ * pushed to each data lane when it was enqueued. Until it is processed, only
+ * those earlier operations may be popped from the data lanes, and it becomes
+ * ready once all of them have been popped. This keeps the guarantee the
+ * threaded storages rely on: a SyncOperation is processed after everything
+ * enqueued before it and before everything enqueued after it. Data
+ * operations are counted before they are inserted, so an operation whose
+ * push returned before the fence's began is always among the counted ones.
+ * Operations pushed concurrently with a control operation may land on either
+ * side of it (the hard storage enqueues point reads without any lock).
+ *
+ * Popping requires a permit from the available semaphore; permits are
+ * fungible across lanes. The worker never waits for a permit: a producer
+ * wakes the worker once its permit is released.
+ *
+ * @tparam Q Maximum number of queued operations
+ */
+template <size_t Q> class PriorityLanes {
+public:
+    static constexpr size_t DATA_LANES = 3; // READ, WRITE and SCAN
+    // Control operations that may be queued at once (a handful per
+    // repartitioning cycle, plus shutdown)
+    static constexpr size_t FENCE_CAPACITY = Q < 1024 ? Q : 1024;
+
+private:
+    struct Fence {
+        Operation *operation;                  // Control operation
+        std::array<size_t, DATA_LANES> marks; // Pushes per lane at enqueue
+    };
+
+    std::array<tbb::concurrent_queue<Operation *>, DATA_LANES>
+        lanes_;                                 // Data lanes
+    boost::lockfree::spsc_queue<Fence> fences_; // Background lane
+    std::array<std::atomic_size_t, DATA_LANES>
+        pushed_; // Operations pushed per data lane (producers)
+    std::array<size_t, DATA_LANES>
+        popped_; // Operations popped per data lane (worker only)
+    std::counting_semaphore<Q>
+        available_sem_; // Semaphore with permits equal to items in queue
+    std::counting_semaphore<Q>
+        free_sem_; // Semaphore with permits equal to free spaces
+
+public:
+    /**
+     * @brief Constructor
+     */
+    PriorityLanes() :
+        fences_(FENCE_CAPACITY), available_sem_(0), free_sem_(Q) {
+        for (size_t i = 0; i < DATA_LANES; ++i) {
+            pushed_[i].store(0, std::memory_order_relaxed);
+            popped_[i] = 0;
+        }
+    }
+
+    // Copy constructor and assignment operator are deleted
+    PriorityLanes(const PriorityLanes &) = delete;
+    PriorityLanes &operator=(const PriorityLanes &) = delete;
+
+    /**
+     * @brief Enqueue an operation on the lane of its type
+     * @param operation The operation to enqueue
+     *
+     * Waits for a free space, inserts the operation, and signals an
+     * available operation.
+     */
+    void push(Operation *operation) {
+        free_sem_.acquire();
+
+        Lane lane = lane_of(operation->type());
+        bool pushed;
+        if (lane == Lane::BACKGROUND) {
+            Fence fence{operation, {}};
+            for (size_t i = 0; i < DATA_LANES; ++i) {
+                fence.marks[i] = pushed_[i].load(std::memory_order_acquire);
+            }
+            pushed = fences_.push(fence);
+        } else {
+            // Counted first: a fence enqueued after this push returns must
+            // wait for the operation
+            size_t idx = static_cast<size_t>(lane);
+            pushed_[idx].fetch_add(1, std::memory_order_acq_rel);
+            lanes_[idx].push(operation);
+            pushed = true;
+        }
+        if (!pushed) {
+            throw std::runtime_error("Fence queue push failed");
+        }
+
+        available_sem_.release();
+    }
+
+    /**
+     * @brief Check whether a lane has an operation that may be popped now
+     * @param lane The lane to check
+     * @return true if the lane's front operation is not held back by a fence
+     * (for BACKGROUND: if the front fence has been reached)
+     */
+    bool ready(Lane lane) {
+        if (lane == Lane::BACKGROUND) {
+            if (fences_.read_available() == 0) {
+                return false;
+            }
+            const Fence &fence = fences_.front();
+            for (size_t i = 0; i < DATA_LANES; ++i) {
+                if (popped_[i] < fence.marks[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // An operation is counted just before it is in the queue
+        size_t idx = static_cast<size_t>(lane);
+        if (popped_[idx] == pushed_[idx].load(std::memory_order_acquire)) {
+            return false;
+        }
+        return fences_.read_available() == 0 ||
+               popped_[idx] < fences_.front().marks[idx];
+    }
+
+    /**
+     * @brief Pop the front operation of a lane without waiting
+     * @param lane The lane to pop from
+     * @param operation Output parameter to store the popped operation
+     * @return true if an operation was popped, false if the lane is not ready
+     * or its operation or permit has not been published yet
+     */
+    bool try_pop(Lane lane, Operation *&operation) {
+        if (!ready(lane) || !available_sem_.try_acquire()) {
+            return false;
+        }
+
+        bool popped;
+        if (lane == Lane::BACKGROUND) {
+            Fence fence{nullptr, {}};
+            popped = fences_.pop(fence);
+            operation = fence.operation;
+        } else {
+            size_t idx = static_cast<size_t>(lane);
+            if (!lanes_[idx].try_pop(operation)) {
+                // Counted but still being inserted: its producer wakes the
+                // worker once it is in
+                available_sem_.release();
+                return false;
+            }
+            ++popped_[idx];
+            popped = true;
+        }
+        if (!popped) {
+            // The permit guarantees a pushed operation, so this should not
+            // happen
+            throw std::runtime_error("Lane queue pop failed");
+        }
+
+        free_sem_.release();
+        return true;
+    }
+
+    /**
+     * @brief Get the number of operations ever pushed to a data lane
+     * @param lane The data lane
+     * @return Push count
+     */
+    size_t pushed(Lane lane) const {
+        return pushed_[static_cast<size_t>(lane)].load(
+            std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Get the number of operations ever popped from a data lane
+     * @param lane The data lane
+     * @return Pop count
+     */
+    size_t popped(Lane lane) const {
+        return popped_[static_cast<size_t>(lane)];
+    }
+};
+
+/**
+ * @brief Weighted scheduler over the data lanes
+ *
+ * Each lane receives weight credits per round and every turn consumes one
+ * credit. Lanes are tried in priority order (reads, writes, scans); a lane
+ * without work is skipped, so idle capacity is never wasted, and credits are
+ * refilled once no lane with work has any left.
+ */
+class LaneScheduler {
+private:
+    std::array<size_t, 3> weights_; // Credits per round for each data lane
+    std::array<size_t, 3> credits_; // Credits left in the current round
+
+public:
+    /**
+     * @brief Constructor
+     * @param read_weight Turns given to point reads per round
+     * @param write_weight Turns given to writes per round
+     * @param scan_weight Turns (scan chunks) given to scans per round
+     */
+    LaneScheduler(size_t read_weight, size_t write_weight, size_t scan_weight) :
+        weights_{read_weight, write_weight, scan_weight},
+        credits_{read_weight, write_weight, scan_weight} {}
+
+    /**
+     * @brief Pick the lane to serve next
+     * @param has_work Whether each data lane has work
+     * @return The lane to serve, or std::nullopt if no lane has work
+     */
+    std::optional<Lane> next(const std::array<bool, 3> &has_work) {
+        for (int round = 0; round < 2; ++round) {
+            for (size_t i = 0; i < credits_.size(); ++i) {
+                if (has_work[i] && credits_[i] > 0) {
+                    --credits_[i];
+                    return static_cast<Lane>(i);
+                }
+            }
+            credits_ = weights_;
+        }
+        return std::nullopt;
+    }
+};
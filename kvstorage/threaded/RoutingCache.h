@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Small per-thread cache of key routes, validated by key-map epoch
+ *
+ * A direct-mapped table of recently routed keys. Each entry remembers the
+ * key-map epoch it was filled at and only hits while the storage is still at
+ * that epoch, so a repartitioning invalidates the whole cache at once without
+ * touching it. An entry can still be used after its epoch ended if the
+ * repartitioning happens between the check and the enqueue; the worker then
+ * bounces the operation (Status::STALE_ROUTE) and the caller re-routes it
+ * through the key map.
+ *
+ * A thread keeps one cache per storage type (see bind()): it is cleared when
+ * the thread switches to another storage instance.
+ *
+ * @tparam Route The cached route (e.g. a partition index)
+ * @tparam SLOTS Number of entries
+ */
+template <typename Route, size_t SLOTS = 256> class RoutingCache {
+private:
+    struct Entry {
+        std::string key; // Routed key
+        Route route;     // Where the key was routed
+        uint64_t epoch;  // Key-map epoch the route was valid at
+        bool valid;      // Entry filled since the last clear
+    };
+
+    std::array<Entry, SLOTS> entries_;
+    uint64_t owner_; // Storage instance the entries belong to (0: none)
+
+public:
+    /**
+     * @brief Constructor - creates an empty cache bound to no storage
+     */
+    RoutingCache() : entries_(), owner_(0) {}
+
+    /**
+     * @brief Get an identifier for a new storage instance
+     * @return Identifier, never 0 and never reused
+     */
+    static uint64_t next_owner() {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Bind the cache to a storage instance, clearing it if it held
+     * another instance's routes
+     * @param owner The storage's identifier (from next_owner())
+     */
+    void bind(uint64_t owner) {
+        if (owner_ != owner) {
+            for (Entry &entry : entries_) {
+                entry.valid = false;
+            }
+            owner_ = owner;
+        }
+    }
+
+    /**
+     * @brief Look up a key's route
+     * @param key The key
+     * @param hash The key's hash
+     * @param epoch The storage's current key-map epoch
+     * @param route Output parameter receiving the route on a hit
+     * @return true if the key was routed at this epoch
+     */
+    bool find(const std::string &key, size_t hash, uint64_t epoch,
+              Route &route) const {
+        const Entry &entry = entries_[hash % SLOTS];
+        if (!entry.valid || entry.epoch != epoch || entry.key != key) {
+            return false;
+        }
+        route = entry.route;
+        return true;
+    }
+
+    /**
+     * @brief Remember a key's route, replacing the entry of its slot
+     * @param key The key
+     * @param hash The key's hash
+     * @param epoch The key-map epoch the route was read at
+     * @param route The route
+     */
+    void store(const std::string &key, size_t hash, uint64_t epoch,
+               const Route &route) {
+        Entry &entry = entries_[hash % SLOTS];
+        entry.key = key;
+        entry.route = route;
+        entry.epoch = epoch;
+        entry.valid = true;
+    }
+};
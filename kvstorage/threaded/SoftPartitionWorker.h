@@ -1,91 +1,263 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
 #include <thread>
-#include <semaphore>
-#include <boost/lockfree/spsc_queue.hpp>
+#include <vector>
 #include "kvstorage/threaded/operation/DoneOperation.h"
 #include "operation/Operation.h"
 #include "operation/ReadOperation.h"
 #include "operation/SyncOperation.h"
 #include "operation/WriteOperation.h"
 #include "operation/ScanOperation.h"
+#include "operation/Rendezvous.h"
+#include "AdmissionControl.h"
+#include "PriorityLanes.h"
+#include "StrandPool.h"
+#include "WriteCoalescer.h"
+#include "../../storage/MultiRead.h"
 
 /**
  * @brief Worker class for processing operations in a soft partition
  *
- * This class manages a queue of operations and processes them in a separate
- * thread. It uses semaphores to control queue capacity and ensure thread-safe
- * operation processing.
+ * This class manages a queue of operations and processes them as a strand: a
+ * serial executor run by a StrandPool shared with the other workers, so the
+ * partition count is not bound to the thread count. Operations of a worker
+ * are never processed by two threads at once, and keep their queue order.
+ * The queue is split into priority lanes (point reads, writes, scans and
+ * background control operations) served by weighted scheduling, so point
+ * reads are not stuck behind long scans or write bursts. It uses semaphores to
+ * control queue capacity and ensure thread-safe operation processing.
+ *
+ * A worker never blocks its pool thread. At a barrier (syncs, and the end of
+ * a scan it coordinates), it parks instead: it stops taking operations until
+ * the last participant arrives and wakes it up.
  *
  * @tparam StorageEngineType The storage engine type (must derive from
  * StorageEngine)
  * @tparam Q Maximum queue size for operations
  */
 template <typename StorageEngineType, size_t Q> class SoftPartitionWorker {
+public:
+    // Number of buffered writes beyond which the oldest ones are applied
+    // before more queued writes are buffered
+    static constexpr size_t COALESCING_BATCH = 256;
+    // Buffered writes applied to the engine per write turn
+    static constexpr size_t WRITE_QUANTUM = 16;
+    // Keys scanned per scan turn before the worker yields to other lanes
+    static constexpr size_t SCAN_CHUNK = 64;
+    // Queued point reads served per read turn, looked up together by the
+    // engine (StorageEngine::multi_read())
+    static constexpr size_t READ_BATCH = 16;
+    // Turns per scheduling round for point reads, writes and scan chunks
+    static constexpr size_t READ_WEIGHT = 8;
+    static constexpr size_t WRITE_WEIGHT = 4;
+    static constexpr size_t SCAN_WEIGHT = 1;
+
+    using Pool = StrandPool<SoftPartitionWorker>;
+
 private:
     StorageEngineType &storage_; // Storage engine reference
-    boost::lockfree::spsc_queue<Operation *>
-        queue_; // Lock-free SPSC queue of operations with capacity Q
-    std::counting_semaphore<Q>
-        available_sem_; // Semaphore with permits equal to items in queue
-    std::counting_semaphore<Q>
-        free_sem_;              // Semaphore with permits equal to free spaces
-    std::thread worker_thread_; // Thread running worker_loop method
+    WriteCoalescer<WriteOperation>
+        coalescer_; // Writes dequeued but not yet applied
+    AdmissionController admission_; // Queue depth/delay based admission
+    PriorityLanes<Q> lanes_;        // Per-lane operation queues
+    std::atomic_size_t
+        buffered_read_count_; // Reads answered from the coalescing buffer
+    LaneScheduler scheduler_; // Weighted choice between the lanes
+    std::array<ReadOperation *, READ_BATCH>
+        read_batch_; // Point reads popped for the current read turn
+    std::array<ReadRequest, READ_BATCH>
+        read_requests_; // Their engine lookups
+
+    // State of the scan this worker is coordinating, one chunk at a time
+    ScanOperation *active_scan_; // Scan in progress (nullptr if none)
+    std::string scan_next_key_;  // First key of the next chunk
+    std::vector<std::pair<std::string, std::string>>
+        scan_results_; // Pairs gathered so far
+
+    Strand strand_;                  // Scheduling state on the pool
+    std::unique_ptr<Pool> own_pool_; // Pool of a worker created without one
+    Pool *pool_;                     // Pool running this worker
+    Rendezvous::Ticket parked_; // Barrier this worker waits at (if any)
+    std::atomic_size_t
+        pending_wakes_; // Wake callbacks left at barriers, not run yet
+    bool done_;         // Stopped by a DoneOperation
+    uint64_t epoch_;    // Latest key-map epoch whose sync was passed
 
 public:
     /**
      * @brief Constructor
      * @param storage Reference to the storage engine
+     * @param policy Admission limits for this worker's queue (default: none)
+     * @param pool Pool running the worker (default: a pool of one thread
+     * owned by the worker)
      */
-    explicit SoftPartitionWorker(StorageEngineType &storage) :
-        storage_(storage), queue_(Q), // Initialize SPSC queue with capacity Q
-        available_sem_(0),            // Initially no operations available
-        free_sem_(Q),                 // Initially Q free spaces available
-        worker_thread_(std::thread(&SoftPartitionWorker::worker_loop, this)) {}
+    explicit SoftPartitionWorker(
+        StorageEngineType &storage,
+        const AdmissionPolicy &policy = AdmissionPolicy(),
+        Pool *pool = nullptr) :
+        storage_(storage), admission_(policy), lanes_(),
+        buffered_read_count_(0),
+        scheduler_(READ_WEIGHT, WRITE_WEIGHT, SCAN_WEIGHT),
+        active_scan_(nullptr),
+        own_pool_(pool == nullptr ? std::make_unique<Pool>(1) : nullptr),
+        pool_(pool == nullptr ? own_pool_.get() : pool), pending_wakes_(0),
+        done_(false), epoch_(0) {}
 
     /**
-     * @brief Destructor - stops the worker thread
+     * @brief Destructor - stops the worker
      */
     ~SoftPartitionWorker() {
-        // Signal the worker thread to stop by enqueueing a special operation
+        // Signal the worker to stop by enqueueing a special operation
         stop();
-        if (worker_thread_.joinable()) {
-            worker_thread_.join();
+        // The pool thread may still be returning from the stopping run, and
+        // the last participant of a barrier may still be running wake()
+        while (pending_wakes_.load(std::memory_order_acquire) > 0 ||
+               !strand_.idle()) {
+            std::this_thread::yield();
         }
     }
 
     /**
-     * @brief Read operation
-     * @param operation The read operation to perform
+     * @brief Read operations
+     * @param operations The read operations to perform (at most READ_BATCH)
+     *
+     * Expired reads and reads of a buffered key are answered right away; the
+     * others are looked up with a single multi_read() call. Reads routed
+     * before the last key-map change this worker synced on are bounced with
+     * Status::STALE_ROUTE: the key may belong to another worker now.
      */
-    void read(ReadOperation *operation) {
-        Status status = storage_.read(operation->key(), operation->value());
-        operation->status(status);
-        operation->notify();
+    void read(std::span<ReadOperation *> operations) {
+        size_t count = 0;
+        for (ReadOperation *operation : operations) {
+            if (operation->epoch() < epoch_) {
+                operation->status(Status::STALE_ROUTE);
+                operation->notify();
+                continue;
+            }
+            if (admission_.expired(operation)) {
+                operation->status(Status::BUSY);
+                operation->notify();
+                continue;
+            }
+
+            // A write that is still buffered is the most recent value
+            WriteOperation *pending = coalescer_.find(operation->key());
+            if (pending != nullptr) {
+                buffered_read_count_.fetch_add(1, std::memory_order_relaxed);
+                operation->value(pending->value());
+                operation->status(Status::SUCCESS);
+                operation->notify();
+                continue;
+            }
+            read_requests_[count] = {&operation->key(), &operation->value()};
+            operations[count++] = operation;
+        }
+
+        storage_.multi_read(std::span(read_requests_.data(), count));
+        for (size_t i = 0; i < count; ++i) {
+            operations[i]->status(read_requests_[i].status);
+            operations[i]->notify();
+        }
     }
 
     /**
      * @brief Write operation
-     * @param operation The read operation to perform
+     * @param operation The write operation to perform
+     *
+     * The write is buffered until a write turn applies it; a later write to
+     * the same key supersedes it in the meantime.
      */
-    void write(WriteOperation *operation) {
-        storage_.write(operation->key(), operation->value());
-        delete operation;
+    void write(WriteOperation *operation) { coalescer_.add(operation); }
+
+    /**
+     * @brief Apply the oldest buffered writes to the storage engine
+     * @param count Maximum number of writes to apply
+     */
+    void apply_writes(size_t count) {
+        coalescer_.flush_some(count, [this](WriteOperation *operation) {
+            storage_.write(operation->key(), operation->value());
+        });
     }
 
+    /**
+     * @brief Apply all buffered writes to the storage engine
+     */
+    void flush_writes() { apply_writes(coalescer_.size()); }
+
     /**
      * @brief Scan operation
      * @param operation The scan operation to perform
+     *
+     * Only starts the scan: the coordinator then scans the storage in
+     * SCAN_CHUNK-sized chunks from scan turns (see scan_chunk()).
      */
     void scan(ScanOperation *operation) {
-        bool is_coordinator = operation->is_coordinator();
-        if (is_coordinator) {
-            size_t limit = operation->limit();
-            Status status =
-                storage_.scan(operation->key(), limit, operation->values());
-            operation->status(status);
+        // The coordinator scans the shared storage, so every worker must
+        // publish its buffered writes before reaching the barrier. The last
+        // worker to arrive coordinates. The others are done once their
+        // writes are flushed: they join the caller without parking and go on
+        // serving their queues while the coordinator scans (the scan is not a
+        // snapshot, as the coordinator's own writes interleave with its
+        // chunks too). They must not touch the operation afterwards.
+        flush_writes();
+        bool is_coordinator = operation->arrive_workers().last();
+        if (!is_coordinator) {
+            operation->arrive_caller({});
+            return;
+        }
+        if (admission_.expired(operation)) {
+            operation->status(Status::BUSY);
+            park(operation->arrive_caller(waker()));
+            return;
         }
-        operation->sync();
+        active_scan_ = operation;
+        scan_next_key_ = operation->key();
+        scan_results_.clear();
+        scan_results_.reserve(operation->limit());
+    }
+
+    /**
+     * @brief Scan the next chunk of the active scan, completing it when the
+     * limit is reached or the storage is exhausted
+     */
+    void scan_chunk() {
+        ScanOperation *operation = active_scan_;
+        size_t limit = operation->limit();
+        size_t wanted = std::min(SCAN_CHUNK, limit - scan_results_.size());
+
+        std::vector<std::pair<std::string, std::string>> chunk;
+        Status status = storage_.scan(scan_next_key_, wanted, chunk);
+        if (status == Status::SUCCESS) {
+            for (auto &pair : chunk) {
+                scan_results_.push_back(std::move(pair));
+            }
+        }
+
+        bool done = status != Status::SUCCESS || chunk.size() < wanted ||
+                    scan_results_.size() >= limit;
+        if (!done) {
+            // Smallest key greater than the last one returned
+            scan_next_key_ = scan_results_.back().first + '\0';
+            return;
+        }
+
+        if (!scan_results_.empty()) {
+            status = Status::SUCCESS;
+        } else if (status == Status::SUCCESS) {
+            status = Status::NOT_FOUND;
+        }
+        operation->values() = std::move(scan_results_);
+        scan_results_.clear();
+        operation->status(status);
+        active_scan_ = nullptr;
+        park(operation->arrive_caller(waker()));
     }
 
     /**
@@ -93,55 +265,108 @@ public:
      * @param operation The sync operation to perform
      */
     void sync(SyncOperation *operation) {
-        bool is_coordinator = operation->sync();
-        if (is_coordinator) {
+        flush_writes();
+        // Reads routed before this sync's key-map change are bounced from now
+        // on (the operation may be deleted once every worker has arrived)
+        epoch_ = std::max(epoch_, operation->epoch());
+        Rendezvous::Ticket ticket = operation->arrive(waker());
+        bool last = ticket.last();
+        park(std::move(ticket));
+        if (last) {
             delete operation;
         }
     }
 
     /**
-     * @brief Dequeue an operation from the queue
-     * @param operation Output parameter to store the dequeued operation
+     * @brief Stop taking operations until a barrier is released
+     * @param ticket This worker's arrival at the barrier
      *
-     * Waits for an available operation, removes it from the queue, and signals
-     * a free space.
+     * The worker must not touch the barrier's operation afterwards: the last
+     * participant may destroy it as soon as it is released. The last
+     * participant itself does not wait, and its wake callback is dropped.
+     */
+    void park(Rendezvous::Ticket ticket) {
+        if (ticket.last()) {
+            pending_wakes_.fetch_sub(1, std::memory_order_release);
+        }
+        parked_ = std::move(ticket);
+    }
+
+    /**
+     * @brief Make the wake callback left at a barrier
+     * @return Callback scheduling the worker, counted as pending until it
+     * has run so that the worker is not destroyed under it
      */
-    void dequeue(Operation *&operation) {
-        // Wait for an available operation
-        available_sem_.acquire();
+    std::function<void()> waker() {
+        pending_wakes_.fetch_add(1, std::memory_order_relaxed);
+        return [this] {
+            wake();
+            pending_wakes_.fetch_sub(1, std::memory_order_release);
+        };
+    }
 
-        // Dequeue from SPSC queue (lock-free)
-        if (!queue_.pop(operation)) {
-            // SPSC queue pop can fail if queue is empty, but we have semaphore
-            // so this should not happen
-            throw std::runtime_error("SPSC queue pop failed");
+    /**
+     * @brief Check whether the worker waits at a barrier
+     * @return true while parked
+     */
+    bool parked() {
+        if (!parked_.released()) {
+            return true;
         }
+        parked_ = Rendezvous::Ticket();
+        return false;
+    }
 
-        // Signal that a free space is available
-        free_sem_.release();
+    /**
+     * @brief Schedule the worker on its pool unless it is already scheduled
+     */
+    void wake() {
+        if (strand_.notify()) {
+            pool_->submit(this);
+        }
     }
 
     /**
      * @brief Enqueue an operation to the queue
      * @param operation The operation to enqueue
      *
-     * Waits for a free space in the queue, inserts the operation, and signals
-     * an available operation.
+     * Waits for a free space in the queue, inserts the operation on the lane
+     * of its type, signals an available operation and schedules the worker.
      */
     void enqueue(Operation *operation) {
-        // Wait for a free space in the queue
-        free_sem_.acquire();
+        admission_.on_enqueue(operation);
+        lanes_.push(operation);
+        wake();
+    }
 
-        // Enqueue to SPSC queue (lock-free)
-        if (!queue_.push(operation)) {
-            // SPSC queue push can fail if queue is full, but we have semaphore
-            // so this should not happen, but we'll retry just in case
-            throw std::runtime_error("SPSC queue push failed");
-        }
+    /**
+     * @brief Ask admission control whether a client request may be enqueued
+     * @return true if admitted, false if the caller should report
+     * Status::BUSY
+     *
+     * Control operations (sync, stop) bypass admission and are always
+     * enqueued.
+     */
+    bool admit() { return admission_.admit(); }
 
-        // Signal that an operation is available
-        available_sem_.release();
-    }
+    /**
+     * @brief Get the number of requests rejected by admission control
+     * @return Shed request count
+     */
+    size_t shed_count() const { return admission_.shed_count(); }
+
+    /**
+     * @brief Get the number of requests answered with Status::BUSY because
+     * they were still queued past their deadline
+     * @return Expired request count
+     */
+    size_t expired_count() const { return admission_.expired_count(); }
+
+    /**
+     * @brief Get the number of operations waiting in this worker's queue
+     * @return Queue depth (approximate while producers enqueue)
+     */
+    size_t queue_depth() const { return admission_.depth(); }
 
     void stop() {
         DoneOperation operation;
@@ -150,37 +375,166 @@ public:
     }
 
     /**
-     * @brief Worker loop that processes operations from the queue
+     * @brief Pop an operation from a lane
+     * @param lane The lane to pop from
+     * @param operation Output parameter to store the popped operation
+     * @return true if an operation was popped
+     */
+    bool pop(Lane lane, Operation *&operation) {
+        if (!lanes_.try_pop(lane, operation)) {
+            return false;
+        }
+        admission_.on_dequeue(operation);
+        return true;
+    }
+
+    /**
+     * @brief Pop up to READ_BATCH queued point reads into read_batch_
+     * @return Number of reads popped
+     */
+    size_t pop_reads() {
+        size_t count = 0;
+        Operation *operation;
+        while (count < READ_BATCH && pop(Lane::READ, operation)) {
+            read_batch_[count++] = static_cast<ReadOperation *>(operation);
+        }
+        return count;
+    }
+
+    /**
+     * @brief Move the writes queued so far into the coalescing buffer
+     *
+     * Called before serving a read or starting a scan, so that every write
+     * enqueued before it is visible. Writes pushed after the call started are
+     * left queued, which bounds the work; when the buffer is full, the oldest
+     * buffered writes are applied to make room.
+     */
+    void ingest_writes() {
+        size_t target = lanes_.pushed(Lane::WRITE);
+        Operation *operation;
+        while (lanes_.popped(Lane::WRITE) < target) {
+            if (coalescer_.size() >= COALESCING_BATCH) {
+                apply_writes(WRITE_QUANTUM);
+            }
+            if (!pop(Lane::WRITE, operation)) {
+                // Held back by a fence, or enqueued concurrently and not
+                // published yet
+                break;
+            }
+            write(static_cast<WriteOperation *>(operation));
+        }
+    }
+
+    /**
+     * @brief Process one turn of queued work
+     * @return false if there was nothing to do (the worker is idle until its
+     * next wake()), or the worker parked or stopped
      *
-     * Continuously dequeues operations and processes them based on their type.
-     * Calls the respective function (read, write, or scan) for each operation.
+     * Background operations (syncs, stop) run as soon as every operation
+     * enqueued before them has been popped. Otherwise the scheduler picks
+     * between one read turn (up to READ_BATCH queued point reads, looked up
+     * together), one write turn (buffer the queued writes and apply up to
+     * WRITE_QUANTUM of them) and one scan chunk, by weight. Reads
+     * and scans first buffer the queued writes, so they observe every write
+     * enqueued before them. The worker only goes idle once nothing is queued
+     * and no write is left to apply. A lane that looks ready but cannot be
+     * popped yet is being pushed to, and its producer wakes the worker once
+     * the operation is published.
      */
-    void worker_loop() {
+    bool turn() {
         Operation *operation;
-        while (true) {
-            dequeue(operation);
-            // Process the operation based on its type
-            switch (operation->type()) {
-                case Type::READ:
-                    read(static_cast<ReadOperation *>(operation));
-                    break;
-                case Type::WRITE:
-                    write(static_cast<WriteOperation *>(operation));
-                    break;
-                case Type::SCAN:
+        if (active_scan_ == nullptr && lanes_.ready(Lane::BACKGROUND)) {
+            if (!pop(Lane::BACKGROUND, operation)) {
+                return false;
+            }
+            if (operation->type() == Type::DONE) {
+                flush_writes();
+                done_ = true;
+                static_cast<DoneOperation *>(operation)->arrive();
+                return false;
+            }
+            sync(static_cast<SyncOperation *>(operation));
+            return true;
+        }
+
+        std::optional<Lane> lane = scheduler_.next(
+            {lanes_.ready(Lane::READ),
+             !coalescer_.empty() || lanes_.ready(Lane::WRITE),
+             active_scan_ != nullptr || lanes_.ready(Lane::SCAN)});
+        if (!lane.has_value()) {
+            return false;
+        }
+
+        switch (lane.value()) {
+            case Lane::READ: {
+                size_t count = pop_reads();
+                if (count == 0) {
+                    return false;
+                }
+                ingest_writes();
+                read(std::span(read_batch_.data(), count));
+                break;
+            }
+            case Lane::WRITE:
+                ingest_writes();
+                apply_writes(WRITE_QUANTUM);
+                break;
+            case Lane::SCAN:
+                if (active_scan_ == nullptr) {
+                    if (!pop(Lane::SCAN, operation)) {
+                        return false;
+                    }
+                    ingest_writes();
                     scan(static_cast<ScanOperation *>(operation));
-                    break;
-                case Type::SYNC:
-                    sync(static_cast<SyncOperation *>(operation));
-                    break;
-                case Type::DONE:
-                    static_cast<DoneOperation *>(operation)->wait();
-                    return;
-                default:
-                    break;
+                }
+                if (active_scan_ != nullptr) {
+                    scan_chunk();
+                }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Run the worker's strand for a number of turns (pool threads only)
+     * @param turns Maximum number of turns
+     * @return true if work may be left
+     */
+    bool run(size_t turns) {
+        for (size_t i = 0; i < turns; ++i) {
+            if (done_ || parked() || !turn()) {
+                return false;
             }
         }
+        return true;
     }
 
+    /**
+     * @brief Get the worker's scheduling state (for the pool)
+     * @return The strand
+     */
+    Strand &strand() { return strand_; }
+
     size_t operation_count() const { return storage_.operation_count(); }
+
+    /**
+     * @brief Get the number of writes dropped because a later write to the
+     * same key superseded them before they were applied
+     * @return Coalesced write count
+     */
+    size_t coalesced_write_count() const {
+        return coalescer_.coalesced_count();
+    }
+
+    /**
+     * @brief Get the number of operations served without reaching the storage
+     * engine (superseded writes and reads answered from the buffer)
+     * @return Absorbed operation count
+     */
+    size_t absorbed_count() const {
+        return coalescer_.coalesced_count() +
+               buffered_read_count_.load(std::memory_order_relaxed);
+    }
 };
@@ -3,8 +3,13 @@
 #include "../RepartitioningKeyValueStorage.h"
 #include "../../keystorage/KeyStorage.h"
 #include "../../storage/StorageEngine.h"
+#include "../../storage/EngineTuning.h"
 #include "../Tracker.h"
+#include "../PartitionPlan.h"
+#include "../RepartitionStats.h"
 #include "SoftPartitionWorker.h"
+#include "AdmissionControl.h"
+#include "RoutingCache.h"
 #include <string>
 #include <vector>
 #include <cstddef>
@@ -18,6 +23,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <cstdint>
 
 /**
  * @brief Soft repartitioning key-value storage implementation
@@ -29,6 +35,13 @@
  * This implementation uses a single storage engine and partition-level locks
  * to provide non-disruptive repartitioning that preserves existing data access.
  *
+ * Each client thread keeps a RoutingCache of the partitions its reads and
+ * writes were routed to, tagged with the key-map epoch. Every repartitioning
+ * advances the epoch, so point reads of a cached key skip the key map and its
+ * lock until the next repartitioning. The sync that starts an epoch tells the
+ * workers about it, and a worker bounces reads routed at an older epoch back
+ * to the caller, which routes them again through the key map.
+ *
  * @tparam StorageEngineTemplate Storage engine class template
  * @tparam STORAGE_SYNC Engine sync flag
  * @tparam StorageMapType Template for key storage type for partition->engine
@@ -55,12 +68,18 @@ class SoftThreadedRepartitioningKeyValueStorage
           StorageEngineTemplate, STORAGE_SYNC> {
 private:
     using StorageEngineType = StorageEngineTemplate<STORAGE_SYNC>;
+    using WorkerPool = typename SoftPartitionWorker<StorageEngineType, Q>::Pool;
 
     PartitionMapType<size_t> key_map_; // Maps key ranges to partition IDs
     std::atomic_bool update_key_map_;  // Flag indicating if the partition map
                                        // should be updated
     std::shared_mutex
         key_map_lock_; // Mutex for thread-safe access to key mappers
+    std::atomic<uint64_t>
+        epoch_; // Key-map epoch, advanced by every repartitioning
+    uint64_t routing_owner_; // This storage in the per-thread routing caches
+    std::atomic_size_t
+        stale_route_count_; // Cached routes bounced by a worker
     std::atomic_bool
         enable_tracking_; // Enable/disable tracking of key access patterns
 
@@ -68,6 +87,11 @@ private:
     StorageEngineType storage_; // Storage engine instance for the storage
     HashFunc hash_func_;        // Hash function for key hashing
     Tracker<> tracker_;         // Tracker for tracking key access patterns
+    PartitionPlan plan_;        // Planned keys not placed yet (load_plan())
+    RepartitionStats repartition_stats_; // Last applied repartitioning
+    mutable std::mutex
+        repartition_stats_mutex_; // Guards repartition_stats_
+    ScanFanout scan_fanout_;      // Partitions touched per scan
 
     // Threading attributes for automatic repartitioning
     std::thread repartitioning_thread_; // Background thread for automatic
@@ -82,6 +106,8 @@ private:
     std::atomic<bool> running_;  // Flag to control the repartitioning loop
     std::condition_variable cv_; // Condition variable to wake the thread
     std::mutex cv_mutex_;        // Mutex for condition variable
+    std::unique_ptr<WorkerPool>
+        pool_; // Threads running the workers (outlives them)
     std::vector<std::unique_ptr<SoftPartitionWorker<StorageEngineType, Q>>>
         workers_; // Workers for each partition
 
@@ -89,6 +115,7 @@ private:
                                             // repartitioning is enabled
     std::vector<std::string>
         paths_; // Paths for embedded database files (default: {/tmp})
+    AdmissionPolicy admission_; // Admission limits for the worker queues
 
 public:
     /**
@@ -103,6 +130,14 @@ public:
      * @param paths Optional vector of paths for embedded database files
      * (default: {/tmp}) Uses the first path since this storage has only one
      * storage engine
+     * @param admission Admission limits applied to every worker queue
+     * (default: none). Requests rejected by admission control, or still
+     * queued past their deadline, return Status::BUSY.
+     * @param thread_count Threads running the partition workers (default 0:
+     * one per partition, at most one per hardware thread). Partitions are
+     * strands on these threads, so there may be many more of them.
+     * @param profile Tuning of the storage engines and key maps (default: the
+     * EngineTuning profile)
      */
     SoftThreadedRepartitioningKeyValueStorage(
         size_t partition_count, const HashFunc &hash_func = HashFunc(),
@@ -110,24 +145,36 @@ public:
             std::nullopt,
         std::optional<std::chrono::milliseconds> repartition_interval =
             std::nullopt,
-        const std::vector<std::string> &paths = {"/tmp"}) :
-        key_map_(PartitionMapType<size_t>(paths.empty() ? std::string("/tmp")
-                                                        : paths[0])),
-        update_key_map_(false), enable_tracking_(false),
+        const std::vector<std::string> &paths = {"/tmp"},
+        const AdmissionPolicy &admission = AdmissionPolicy(),
+        size_t thread_count = 0,
+        const EngineProfile &profile = EngineTuning::profile()) :
+        key_map_(make_key_storage<PartitionMapType<size_t>>(
+            paths.empty() ? std::string("/tmp") : paths[0], profile)),
+        update_key_map_(false), epoch_(0),
+        routing_owner_(RoutingCache<size_t>::next_owner()),
+        stale_route_count_(0), enable_tracking_(false),
         partition_count_(partition_count),
-        storage_(StorageEngineType(0, paths.empty() ? "/tmp" : paths[0])),
+        storage_(make_engine<StorageEngineType>(
+            0, paths.empty() ? "/tmp" : paths[0], profile)),
         hash_func_(hash_func), tracker_(), is_repartitioning_(false),
         tracking_duration_(tracking_duration),
-        repartition_interval_(repartition_interval), running_(true), workers_(),
+        repartition_interval_(repartition_interval), running_(true),
+        pool_(std::make_unique<WorkerPool>(
+            thread_count > 0
+                ? thread_count
+                : WorkerPool::default_thread_count(partition_count))),
+        workers_(),
         auto_repartitioning_(false),
-        paths_(paths.empty() ? std::vector<std::string>{"/tmp"} : paths) {
+        paths_(paths.empty() ? std::vector<std::string>{"/tmp"} : paths),
+        admission_(admission) {
 
         // Create workers
         workers_.reserve(partition_count_);
         for (size_t i = 0; i < partition_count_; ++i) {
             workers_.emplace_back(
                 std::make_unique<SoftPartitionWorker<StorageEngineType, Q>>(
-                    storage_));
+                    storage_, admission_, pool_.get()));
         }
 
         // Start repartitioning thread if both durations are set
@@ -164,32 +211,62 @@ public:
      * @return Status code indicating the result of the operation
      */
     Status read_impl(const std::string &key, std::string &value) {
-        // Lock key map for reading
-        key_map_lock_.lock_shared();
+        Status status = Status::STALE_ROUTE;
 
-        // Look up which partition owns this key
+        // Route the read without the key map if this thread routed the key
+        // during the current epoch
+        RoutingCache<size_t> &cache = routing_cache();
+        size_t hash = hash_func_(key);
+        uint64_t epoch = epoch_.load(std::memory_order_acquire);
         size_t partition_idx;
-        bool found = key_map_.get(key, partition_idx);
-        if (!found) {
-            // If the key is not mapped it is not stored
-            key_map_lock_.unlock_shared();
-            return Status::NOT_FOUND;
+        if (cache.find(key, hash, epoch, partition_idx)) {
+            if (!workers_[partition_idx]->admit()) {
+                return Status::BUSY;
+            }
+            status = read_at(key, value, partition_idx, epoch);
+            if (status == Status::STALE_ROUTE) {
+                stale_route_count_.fetch_add(1, std::memory_order_relaxed);
+            }
         }
 
-        ReadOperation read_operation(key, value);
-        workers_[partition_idx]->enqueue(&read_operation);
+        if (status == Status::STALE_ROUTE) {
+            // Lock key map for reading
+            key_map_lock_.lock_shared();
 
-        // Unlock key map (we have the storage lock now)
-        key_map_lock_.unlock_shared();
+            // Look up which partition owns this key
+            bool found = key_map_.get(key, partition_idx);
+            if (!found) {
+                // If the key is not mapped it is not stored
+                key_map_lock_.unlock_shared();
+                return Status::NOT_FOUND;
+            }
+
+            if (!workers_[partition_idx]->admit()) {
+                key_map_lock_.unlock_shared();
+                return Status::BUSY;
+            }
+
+            // Routed under the lock, so the epoch cannot end before the read
+            // is queued ahead of the next sync
+            epoch = epoch_.load(std::memory_order_relaxed);
+            ReadOperation read_operation(key, value);
+            admission_.apply_deadline(read_operation);
+            read_operation.epoch(epoch);
+            workers_[partition_idx]->enqueue(&read_operation);
+
+            // Unlock key map (we have the storage lock now)
+            key_map_lock_.unlock_shared();
+
+            cache.store(key, hash, epoch, partition_idx);
+            read_operation.wait();
+            status = read_operation.status();
+        }
 
         // Track key access if enabled
         if (enable_tracking_.load(std::memory_order_relaxed)) {
             tracker_.update(key);
         }
-
-        // Read value from storage
-        read_operation.wait();
-        return read_operation.status();
+        return status;
     }
 
     /**
@@ -204,15 +281,34 @@ public:
 
         // Look up or assign partition for this key
         size_t partition_idx;
-        size_t next_partition_idx = hash_func_(key) % partition_count_;
-        key_map_.get_or_insert(key, next_partition_idx, partition_idx);
+        size_t next_partition_idx = initial_partition(key);
+
+        // Admission is decided before the key is mapped so that a rejected
+        // write leaves no trace
+        if (admission_.enabled()) {
+            if (!key_map_.get(key, partition_idx)) {
+                partition_idx = next_partition_idx;
+            }
+            if (!workers_[partition_idx]->admit()) {
+                key_map_lock_.unlock();
+                return Status::BUSY;
+            }
+        }
+
+        if (!key_map_.get_or_insert(key, next_partition_idx, partition_idx)) {
+            plan_.erase(key);
+        }
 
         WriteOperation *write_operation = new WriteOperation(key, value);
         workers_[partition_idx]->enqueue(write_operation);
+        uint64_t epoch = epoch_.load(std::memory_order_relaxed);
 
         // Unlock key map (we have the partition lock now)
         key_map_lock_.unlock();
 
+        // Later reads of this key by this thread can skip the key map
+        routing_cache().store(key, hash_func_(key), epoch, partition_idx);
+
         // Track key access if enabled
         if (enable_tracking_.load(std::memory_order_relaxed)) {
             tracker_.update(key);
@@ -260,14 +356,23 @@ public:
             ++count;
         }
 
+        for (size_t partition_idx : partition_set) {
+            if (!workers_[partition_idx]->admit()) {
+                key_map_lock_.unlock_shared();
+                return Status::BUSY;
+            }
+        }
+
         results.resize(limit);
         ScanOperation scan_operation(initial_key_prefix, results,
                                      partition_set.size());
+        admission_.apply_deadline(scan_operation);
         for (size_t partition_idx : partition_set) {
             workers_[partition_idx]->enqueue(&scan_operation);
         }
         // Unlock key map
         key_map_lock_.unlock_shared();
+        scan_fanout_.record(partition_set.size());
 
         // Track key access patterns if enabled
         if (enable_tracking_.load(std::memory_order_relaxed)) {
@@ -307,28 +412,46 @@ public:
         this->enable_tracking(false);
 
         // Step 1: Partition the graph using METIS
+        RepartitionStats stats;
         bool success =
-            tracker_.prepare_for_partition_map_update(partition_count_);
+            tracker_.prepare_for_partition_map_update(partition_count_, stats);
 
         if (success) {
             // Lock key map so it can be changed safely
+            const auto update_start = std::chrono::steady_clock::now();
             key_map_lock_.lock();
 
-            // Update partition_map with new assignments
-            tracker_.update_partition_map(key_map_);
+            // Update partition_map with new assignments; the data stays in
+            // the shared engine, so nothing is migrated
+            stats.keys_reassigned = tracker_.update_partition_map(key_map_);
 
             // Submit Sync operation to all workers
             // This way, future enqueued operations will
             // be processed only after every previously
             // enqueued operations, to any worker, are processed
             // This voids multiple workers acting in the same partition
-            SyncOperation *sync_operation = new SyncOperation(partition_count_);
+            // The sync starts a new epoch: cached routes are no longer used,
+            // and reads routed by them before the change are bounced
+            uint64_t epoch = epoch_.load(std::memory_order_relaxed) + 1;
+            epoch_.store(epoch, std::memory_order_release);
+            SyncOperation *sync_operation =
+                new SyncOperation(partition_count_, epoch);
             for (size_t i = 0; i < partition_count_; ++i) {
                 workers_[i]->enqueue(sync_operation);
             }
 
             // Unlock key map
             key_map_lock_.unlock();
+            stats.update_time =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - update_start);
+
+            stats.scan_fanout = scan_fanout_.roll();
+            {
+                std::lock_guard<std::mutex> lock(repartition_stats_mutex_);
+                stats.cycle = repartition_stats_.cycle + 1;
+                repartition_stats_ = stats;
+            }
 
             // We release the semaphore to allow the repartitioning
             // thread to proceed to the next repartitioning cycle
@@ -338,6 +461,40 @@ public:
         is_repartitioning_ = false;
     }
 
+    Status save_plan_impl(const std::string &path) {
+        PartitionPlan plan(partition_count_);
+        key_map_lock_.lock_shared();
+        for (auto it = key_map_.lower_bound(""); !it.is_end(); ++it) {
+            plan.assign(it.get_key(), it.get_value());
+        }
+        key_map_lock_.unlock_shared();
+        plan.graph() = tracker_.snapshot_graph();
+        return plan.save(path);
+    }
+
+    Status load_plan_impl(const std::string &path) {
+        PartitionPlan plan;
+        Status status = plan.load(path);
+        if (status != Status::SUCCESS) {
+            return status;
+        }
+        if (plan.partition_count() != partition_count_) {
+            return Status::ERROR;
+        }
+        tracker_.merge_graph(plan.graph());
+        plan.graph().clear();
+
+        key_map_lock_.lock();
+        // Keys already placed keep their partition
+        plan.erase_placed([this](const std::string &key) {
+            size_t partition_idx;
+            return key_map_.get(key, partition_idx);
+        });
+        plan_ = std::move(plan);
+        key_map_lock_.unlock();
+        return Status::SUCCESS;
+    }
+
     // Interface methods required by the abstract base class
     void enable_tracking_impl(bool enable) { enable_tracking_ = enable; }
 
@@ -345,11 +502,134 @@ public:
 
     bool is_repartitioning_impl() const { return is_repartitioning_.load(); }
 
+    RepartitionStats repartition_stats_impl() const {
+        std::lock_guard<std::mutex> lock(repartition_stats_mutex_);
+        return repartition_stats_;
+    }
+
+    double scan_fanout_impl() const { return scan_fanout_.mean(); }
+
     const Graph &graph_impl() const { return tracker_.graph(); }
 
-    size_t operation_count_impl() const { return storage_.operation_count(); }
+    size_t operation_count_impl() const {
+        size_t operation_count = storage_.operation_count();
+        // Operations the workers served without reaching the engine
+        for (const auto &worker : workers_) {
+            operation_count += worker->absorbed_count();
+        }
+        return operation_count;
+    }
+
+    /**
+     * @brief Get the number of writes the workers dropped because a later
+     * write to the same key in the same batch superseded them
+     * @return Coalesced write count summed over all workers
+     */
+    size_t coalesced_write_count() const {
+        size_t coalesced = 0;
+        for (const auto &worker : workers_) {
+            coalesced += worker->coalesced_write_count();
+        }
+        return coalesced;
+    }
+
+    /**
+     * @brief Get the number of requests rejected by admission control
+     * @return Shed request count summed over all workers
+     */
+    size_t shed_count() const {
+        size_t shed = 0;
+        for (const auto &worker : workers_) {
+            shed += worker->shed_count();
+        }
+        return shed;
+    }
+
+    /**
+     * @brief Get the number of requests answered with Status::BUSY because
+     * they were still queued past their deadline
+     * @return Expired request count summed over all workers
+     */
+    size_t expired_count() const {
+        size_t expired = 0;
+        for (const auto &worker : workers_) {
+            expired += worker->expired_count();
+        }
+        return expired;
+    }
+
+    /**
+     * @brief Get the number of threads running the partition workers
+     * @return Thread count
+     */
+    size_t thread_count() const { return pool_->thread_count(); }
+
+    /**
+     * @brief Get the number of times an idle thread took a worker queued on
+     * another thread
+     * @return Steal count
+     */
+    size_t steal_count() const { return pool_->steal_count(); }
+
+    /**
+     * @brief Get the number of reads routed by a thread's routing cache that
+     * a worker bounced because the key map changed in the meantime
+     * @return Stale route count
+     */
+    size_t stale_route_count() const {
+        return stale_route_count_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the current key-map epoch
+     * @return Number of key-map changes so far (repartitionings)
+     */
+    uint64_t epoch() const { return epoch_.load(std::memory_order_acquire); }
 
 private:
+    /**
+     * @brief Get the calling thread's routing cache, bound to this storage
+     * @return The cache
+     */
+    RoutingCache<size_t> &routing_cache() {
+        static thread_local RoutingCache<size_t> cache;
+        cache.bind(routing_owner_);
+        return cache;
+    }
+
+    /**
+     * @brief Read a key from a partition routed without the key map
+     * @param key The key to read
+     * @param value Reference to store the value
+     * @param partition_idx The cached partition of the key
+     * @param epoch The key-map epoch the route is valid at
+     * @return The read's status, Status::STALE_ROUTE if the worker had
+     * already started a later epoch
+     */
+    Status read_at(const std::string &key, std::string &value,
+                   size_t partition_idx, uint64_t epoch) {
+        ReadOperation read_operation(key, value);
+        admission_.apply_deadline(read_operation);
+        read_operation.epoch(epoch);
+        workers_[partition_idx]->enqueue(&read_operation);
+        read_operation.wait();
+        return read_operation.status();
+    }
+
+    /**
+     * @brief Choose the partition of a key written for the first time
+     * @param key The key
+     * @return The partition planned by load_plan(), or the key's hash
+     * partition
+     */
+    size_t initial_partition(const std::string &key) const {
+        size_t partition_idx;
+        if (plan_.partition_of(key, partition_idx)) {
+            return partition_idx;
+        }
+        return hash_func_(key) % partition_count_;
+    }
+
     /**
      * @brief Background thread loop for automatic repartitioning
      *
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Scheduling state of a serial executor (strand)
+ *
+ * A strand is scheduled (queued on a pool or running) at most once at a
+ * time, so the work it runs is never executed by two threads at once and
+ * keeps its order. notify() is called after new work was made visible to the
+ * strand. It schedules an idle strand, and makes a running strand run again
+ * once the current run ends, so a notification never gets lost.
+ */
+class Strand {
+private:
+    static constexpr uint8_t SCHEDULED = 1; // Queued or running
+    static constexpr uint8_t NOTIFIED = 2;  // Notified since the run began
+
+    std::atomic<uint8_t> state_{0};
+
+public:
+    /**
+     * @brief Signal new work
+     * @return true if the strand was idle, in which case the caller must
+     * submit it to the pool
+     */
+    bool notify() {
+        return (state_.fetch_or(SCHEDULED | NOTIFIED,
+                                std::memory_order_acq_rel) &
+                SCHEDULED) == 0;
+    }
+
+    /**
+     * @brief Start a run (pool threads only)
+     *
+     * Work signalled by every notification so far is visible to the run.
+     */
+    void begin() { state_.exchange(SCHEDULED, std::memory_order_acq_rel); }
+
+    /**
+     * @brief End a run (pool threads only)
+     * @param more Whether the run stopped with work left
+     * @return true if the strand must be queued again; false if it went idle,
+     * after which the pool no longer touches it
+     */
+    bool end(bool more) {
+        if (more) {
+            return true;
+        }
+        uint8_t expected = SCHEDULED;
+        return !state_.compare_exchange_strong(expected, 0,
+                                               std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief Check whether the strand is neither queued nor running
+     * @return true if idle
+     */
+    bool idle() const { return state_.load(std::memory_order_acquire) == 0; }
+};
+
+/**
+ * @brief Fixed pool of threads running strands, with work stealing
+ *
+ * Decouples partition workers from threads: any number of workers run as
+ * strands on N threads. Each thread has its own queue of scheduled strands.
+ * A thread runs the strands of its own queue in FIFO order and, once it is
+ * empty, steals the oldest strand of another thread's queue. Strands
+ * submitted from a pool thread go to that thread's queue, others are spread
+ * round robin. A strand runs for at most TURNS turns before it is queued
+ * again behind the others, so a busy partition cannot starve the partitions
+ * sharing its thread.
+ *
+ * Tasks must provide:
+ * - `Strand &strand()`: the task's scheduling state
+ * - `bool run(size_t turns)`: run up to `turns` turns of work without
+ *   blocking, returning true if work may be left
+ *
+ * A task must not be destroyed before its strand is idle.
+ *
+ * @tparam Task The task type (a partition worker)
+ */
+template <typename Task> class StrandPool {
+public:
+    // Turns a strand runs before it yields its thread
+    static constexpr size_t TURNS = 32;
+
+private:
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task *> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_; // One per thread
+    std::atomic_size_t queued_;   // Strands in all queues
+    std::atomic_size_t sleeping_; // Threads waiting for a strand
+    std::atomic_size_t next_;     // Round robin over queues for outsiders
+    std::atomic_size_t steal_count_;
+    std::atomic<bool> stopping_;
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::vector<std::thread> threads_;
+
+    // Pool and queue of the calling thread (nullptr outside pool threads)
+    static inline thread_local StrandPool *current_pool_ = nullptr;
+    static inline thread_local size_t current_queue_ = 0;
+
+    /**
+     * @brief Push a strand to the back of a queue and wake a sleeping thread
+     * @param index Queue index
+     * @param task The task to queue
+     */
+    void push(size_t index, Task *task) {
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(task);
+            // Pairs with the check of queued_ by a thread going to sleep
+            queued_.fetch_add(1, std::memory_order_seq_cst);
+        }
+        if (sleeping_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            sleep_cv_.notify_one();
+        }
+    }
+
+    /**
+     * @brief Pop the oldest strand of a queue
+     * @param index Queue index
+     * @return The task, or nullptr if the queue is empty
+     */
+    Task *pop(size_t index) {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        if (queues_[index]->tasks.empty()) {
+            return nullptr;
+        }
+        Task *task = queues_[index]->tasks.front();
+        queues_[index]->tasks.pop_front();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    /**
+     * @brief Find a strand for a thread, stealing when its queue is empty
+     * @param index The thread's queue index
+     * @return The task, or nullptr if every queue is empty
+     */
+    Task *next(size_t index) {
+        Task *task = pop(index);
+        for (size_t i = 1; task == nullptr && i < queues_.size(); ++i) {
+            task = pop((index + i) % queues_.size());
+            if (task != nullptr) {
+                steal_count_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return task;
+    }
+
+    /**
+     * @brief Loop of a pool thread
+     * @param index The thread's queue index
+     */
+    void thread_loop(size_t index) {
+        current_pool_ = this;
+        current_queue_ = index;
+        while (true) {
+            Task *task = next(index);
+            if (task != nullptr) {
+                Strand &strand = task->strand();
+                strand.begin();
+                bool more = task->run(TURNS);
+                if (strand.end(more)) {
+                    push(index, task);
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleeping_.fetch_add(1, std::memory_order_seq_cst);
+            sleep_cv_.wait(lock, [this] {
+                return stopping_.load(std::memory_order_acquire) ||
+                       queued_.load(std::memory_order_seq_cst) > 0;
+            });
+            sleeping_.fetch_sub(1, std::memory_order_relaxed);
+            if (stopping_.load(std::memory_order_acquire)) {
+                return;
+            }
+        }
+    }
+
+public:
+    /**
+     * @brief Constructor - starts the threads
+     * @param thread_count Number of threads (at least one is started)
+     */
+    explicit StrandPool(size_t thread_count) :
+        queued_(0), sleeping_(0), next_(0), steal_count_(0),
+        stopping_(false) {
+        thread_count = std::max<size_t>(thread_count, 1);
+        queues_.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i) {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+        threads_.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads_.emplace_back(&StrandPool::thread_loop, this, i);
+        }
+    }
+
+    /**
+     * @brief Destructor - stops and joins the threads
+     *
+     * Every task must be idle by then.
+     */
+    ~StrandPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stopping_.store(true, std::memory_order_release);
+        }
+        sleep_cv_.notify_all();
+        for (std::thread &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    StrandPool(const StrandPool &) = delete;
+    StrandPool &operator=(const StrandPool &) = delete;
+
+    /**
+     * @brief Schedule a strand whose notify() returned true
+     * @param task The task to run
+     */
+    void submit(Task *task) {
+        if (current_pool_ == this) {
+            push(current_queue_, task);
+        } else {
+            push(next_.fetch_add(1, std::memory_order_relaxed) %
+                     queues_.size(),
+                 task);
+        }
+    }
+
+    /**
+     * @brief Get the number of threads
+     * @return Thread count
+     */
+    size_t thread_count() const { return threads_.size(); }
+
+    /**
+     * @brief Get the number of strands a thread took from another thread's
+     * queue
+     * @return Steal count
+     */
+    size_t steal_count() const {
+        return steal_count_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the default thread count for a number of strands
+     * @param strand_count Number of strands (partitions)
+     * @return One thread per strand, at most one per hardware thread
+     */
+    static size_t default_thread_count(size_t strand_count) {
+        size_t hardware = std::thread::hardware_concurrency();
+        if (hardware == 0) {
+            return std::max<size_t>(strand_count, 1);
+        }
+        return std::max<size_t>(std::min(strand_count, hardware), 1);
+    }
+};
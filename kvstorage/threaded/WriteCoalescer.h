@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Collapses superseded writes buffered by a partition worker
+ *
+ * Partition workers hand every WRITE they dequeue to the coalescer instead of
+ * applying it immediately. When a later write to the same key arrives before
+ * the pending writes are flushed, the older operation is dropped (last writer
+ * wins) and only the newest value reaches the storage engine.
+ *
+ * The coalescer never reorders writes to distinct keys: flush() and
+ * flush_some() apply the surviving operations in the order their slots were
+ * first taken. Workers are responsible for calling flush() before any
+ * operation that observes storage state beyond a single key (scans, syncs,
+ * shutdown) and for draining it before going idle, so writes are never held
+ * back while the worker has nothing else to do.
+ *
+ * @tparam WriteOperationType Write operation type (WriteOperation or
+ * HardWriteOperation<...>)
+ */
+template <typename WriteOperationType> class WriteCoalescer {
+private:
+    std::vector<WriteOperationType *>
+        pending_; // Surviving writes, in first-arrival order
+    size_t head_; // First slot of pending_ not applied yet
+    std::unordered_map<std::string_view, size_t>
+        index_; // Key (viewing the pending operation's key) to slot
+    std::atomic_size_t coalesced_count_; // Writes dropped as superseded
+
+public:
+    /**
+     * @brief Constructor
+     */
+    WriteCoalescer() : head_(0), coalesced_count_(0) {}
+
+    /**
+     * @brief Destructor - drops any writes that were never flushed
+     */
+    ~WriteCoalescer() {
+        for (size_t i = head_; i < pending_.size(); ++i) {
+            delete pending_[i];
+        }
+    }
+
+    // Copy constructor and assignment operator are deleted
+    WriteCoalescer(const WriteCoalescer &) = delete;
+    WriteCoalescer &operator=(const WriteCoalescer &) = delete;
+
+    /**
+     * @brief Find the pending write for a key
+     * @param key The key to look up
+     * @return The pending write operation, or nullptr if there is none
+     */
+    WriteOperationType *find(const std::string &key) const {
+        auto it = index_.find(std::string_view(key));
+        return it != index_.end() ? pending_[it->second] : nullptr;
+    }
+
+    /**
+     * @brief Add a write, replacing a pending write to the same key
+     * @param operation The write operation (ownership is taken)
+     */
+    void add(WriteOperationType *operation) {
+        auto it = index_.find(std::string_view(operation->key()));
+        if (it == index_.end()) {
+            index_.emplace(operation->key(), pending_.size());
+            pending_.push_back(operation);
+            return;
+        }
+
+        // The map key views the old operation's string, re-point it before
+        // the old operation is deleted
+        size_t slot = it->second;
+        index_.erase(it);
+        delete pending_[slot];
+        pending_[slot] = operation;
+        index_.emplace(operation->key(), slot);
+        coalesced_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Apply all pending writes in order and release them
+     * @param apply Callable invoked with each surviving write operation. It
+     * must not delete the operation.
+     */
+    template <typename ApplyFunc> void flush(ApplyFunc &&apply) {
+        flush_some(pending_.size() - head_, apply);
+    }
+
+    /**
+     * @brief Apply the oldest pending writes in order and release them
+     * @param count Maximum number of writes to apply
+     * @param apply Callable invoked with each applied write operation. It
+     * must not delete the operation.
+     */
+    template <typename ApplyFunc>
+    void flush_some(size_t count, ApplyFunc &&apply) {
+        size_t end = std::min(pending_.size(), head_ + count);
+        for (; head_ < end; ++head_) {
+            WriteOperationType *operation = pending_[head_];
+            index_.erase(std::string_view(operation->key()));
+            apply(operation);
+            delete operation;
+        }
+        if (head_ == pending_.size()) {
+            pending_.clear();
+            head_ = 0;
+        }
+    }
+
+    /**
+     * @brief Check whether there are writes waiting to be flushed
+     * @return true if no writes are pending
+     */
+    bool empty() const { return pending_.empty(); }
+
+    /**
+     * @brief Get the number of writes waiting to be applied
+     * @return Pending write count
+     */
+    size_t size() const { return pending_.size() - head_; }
+
+    /**
+     * @brief Get the number of writes dropped because a later write to the
+     * same key superseded them
+     * @return Coalesced write count
+     */
+    size_t coalesced_count() const {
+        return coalesced_count_.load(std::memory_order_relaxed);
+    }
+};
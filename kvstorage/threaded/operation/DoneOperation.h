@@ -1,20 +1,18 @@
 #pragma once
 
 #include "Operation.h"
-#include <pthread.h>
+#include "Rendezvous.h"
 
 class DoneOperation : public Operation {
 private:
-    pthread_barrier_t barrier_;
+    Rendezvous barrier_;
 
 public:
-    // Constructor takes references to key and value strings
-    DoneOperation() : Operation(nullptr, Type::DONE) {
-        pthread_barrier_init(&barrier_, NULL, 2);
-    }
+    // Constructor
+    DoneOperation() : Operation(nullptr, Type::DONE), barrier_(2) {}
 
-    // Destructor
-    ~DoneOperation() { destroy_barrier(); }
+    // Destructor (default)
+    ~DoneOperation() = default;
 
     // Copy constructor and assignment operator are deleted
     // to prevent copying of DoneOperation objects
@@ -26,9 +24,9 @@ public:
     DoneOperation(DoneOperation &&) = delete;
     DoneOperation &operator=(DoneOperation &&) = delete;
 
-    // Destroy barrier
-    void destroy_barrier() { pthread_barrier_destroy(&barrier_); }
+    // Wait method that waits for the other side
+    void wait() { barrier_.wait(); }
 
-    // Wait method that waits for the barrier
-    void wait() { pthread_barrier_wait(&barrier_); }
+    // Signal the waiting side without blocking
+    void arrive() { barrier_.arrive(); }
 };
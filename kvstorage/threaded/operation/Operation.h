@@ -1,6 +1,8 @@
 #pragma once
 
 #include "storage/Status.h"
+#include <chrono>
+#include <cstdint>
 #include <string>
 
 enum class Type {
@@ -17,11 +19,17 @@ protected:
     Type type_;
     std::string *key_;
     Status status_;
+    std::chrono::steady_clock::time_point
+        enqueued_at_; // When the operation entered a worker queue
+    std::chrono::steady_clock::time_point
+        deadline_; // Point after which the result is no longer wanted
+    uint64_t epoch_; // Key-map epoch the operation was routed at
 
 public:
     // Constructor takes a key pointer and type
     Operation(std::string *key, Type type) :
-        type_(type), key_(key), status_(Status::PENDING) {}
+        type_(type), key_(key), status_(Status::PENDING), enqueued_at_(),
+        deadline_(std::chrono::steady_clock::time_point::max()), epoch_(0) {}
 
     // Destructor (default)
     ~Operation() = default;
@@ -45,4 +53,27 @@ public:
     Status status() { return status_; }
 
     void status(Status status) { status_ = status; }
+
+    std::chrono::steady_clock::time_point enqueued_at() const {
+        return enqueued_at_;
+    }
+
+    void enqueued_at(std::chrono::steady_clock::time_point time) {
+        enqueued_at_ = time;
+    }
+
+    std::chrono::steady_clock::time_point deadline() const { return deadline_; }
+
+    // Set the deadline; operations that are still queued past it are answered
+    // with Status::BUSY instead of being executed
+    void deadline(std::chrono::steady_clock::time_point deadline) {
+        deadline_ = deadline;
+    }
+
+    uint64_t epoch() const { return epoch_; }
+
+    // Set the key-map epoch; a worker that has already passed the sync of a
+    // later epoch answers it with Status::STALE_ROUTE so the caller re-routes
+    // it. Syncs carry the epoch they start.
+    void epoch(uint64_t epoch) { epoch_ = epoch; }
 };
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief One-shot barrier for a fixed number of participants, usable both by
+ * threads and by strands
+ *
+ * Threads call wait(), which blocks until every participant has arrived.
+ * Partition workers run as strands on a shared thread pool and must not block
+ * a pool thread, so they call arrive() instead: it returns at once with a
+ * Ticket, and the worker parks until the ticket is released. The last
+ * participant to arrive releases everyone and runs the wake callbacks of the
+ * parked strands.
+ *
+ * The shared state outlives the Rendezvous as long as a Ticket refers to it,
+ * so a released participant never touches the operation that owned the
+ * barrier, which its owner may already have destroyed.
+ */
+class Rendezvous {
+private:
+    struct State {
+        std::mutex mutex;
+        std::condition_variable released_cv;
+        size_t waiting;                           // Participants not arrived
+        std::atomic<bool> released{false};        // Everyone has arrived
+        std::vector<std::function<void()>> wakes; // Parked strands
+    };
+
+    std::shared_ptr<State> state_;
+
+public:
+    /**
+     * @brief Arrival of one participant
+     */
+    class Ticket {
+    private:
+        std::shared_ptr<State> state_;
+        bool last_;
+
+    public:
+        Ticket() : state_(), last_(false) {}
+        Ticket(std::shared_ptr<State> state, bool last) :
+            state_(std::move(state)), last_(last) {}
+
+        /**
+         * @brief Check whether this participant was the last to arrive
+         * @return true for exactly one participant
+         */
+        bool last() const { return last_; }
+
+        /**
+         * @brief Check whether every participant has arrived
+         * @return true once the rendezvous is released (always for an empty
+         * ticket)
+         */
+        bool released() const {
+            return state_ == nullptr ||
+                   state_->released.load(std::memory_order_acquire);
+        }
+    };
+
+    /**
+     * @brief Constructor
+     * @param participants Number of arrivals that release the rendezvous
+     */
+    explicit Rendezvous(size_t participants) :
+        state_(std::make_shared<State>()) {
+        state_->waiting = participants;
+    }
+
+    Rendezvous(const Rendezvous &) = delete;
+    Rendezvous &operator=(const Rendezvous &) = delete;
+
+    /**
+     * @brief Arrive without blocking
+     * @param wake Called once the rendezvous is released, unless this
+     * participant is the last to arrive (it may run on another thread)
+     * @return Ticket telling whether this participant was the last and
+     * whether the rendezvous is released
+     */
+    Ticket arrive(std::function<void()> wake = {}) {
+        std::shared_ptr<State> state = state_;
+        std::vector<std::function<void()>> wakes;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (--state->waiting > 0) {
+                if (wake) {
+                    state->wakes.push_back(std::move(wake));
+                }
+                return Ticket(std::move(state), false);
+            }
+            state->released.store(true, std::memory_order_release);
+            wakes.swap(state->wakes);
+        }
+        state->released_cv.notify_all();
+        for (const std::function<void()> &parked : wakes) {
+            parked();
+        }
+        return Ticket(std::move(state), true);
+    }
+
+    /**
+     * @brief Arrive and block until every participant has arrived
+     * @return true for the last participant to arrive
+     */
+    bool wait() {
+        // The last participant may destroy the Rendezvous once released
+        std::shared_ptr<State> state = state_;
+        Ticket ticket = arrive();
+        if (!ticket.last()) {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->released_cv.wait(lock, [&state] {
+                return state->released.load(std::memory_order_acquire);
+            });
+        }
+        return ticket.last();
+    }
+};
@@ -1,16 +1,18 @@
 #pragma once
 
 #include "Operation.h"
+#include "Rendezvous.h"
 #include "../future/Future.h"
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
-#include <pthread.h>
 
 class ScanOperation : public Operation {
 private:
     std::vector<std::pair<std::string, std::string>> *results_;
-    pthread_barrier_t barrier_;
-    pthread_barrier_t called_barrier_;
+    Rendezvous barrier_;
+    Rendezvous called_barrier_;
 
 public:
     // Constructor takes references to key and value strings
@@ -18,14 +20,11 @@ public:
                   std::vector<std::pair<std::string, std::string>> &values,
                   size_t partition_count) :
         Operation(const_cast<std::string *>(&key), Type::SCAN),
-        results_(&values) {
-        pthread_barrier_init(&barrier_, NULL, partition_count);
-        pthread_barrier_init(&called_barrier_, NULL,
-                             partition_count + 1); // +1 for the caller
-    }
+        results_(&values), barrier_(partition_count),
+        called_barrier_(partition_count + 1) {} // +1 for the caller
 
     // Destructor (default)
-    ~ScanOperation() { destroy_barriers(); }
+    ~ScanOperation() = default;
 
     // Copy constructor and assignment operator are deleted
     // to prevent copying of ScanOperation objects
@@ -42,20 +41,22 @@ public:
         return *results_;
     }
 
-    // Destroy barriers
-    void destroy_barriers() {
-        pthread_barrier_destroy(&barrier_);
-        pthread_barrier_destroy(&called_barrier_);
-    }
-
     // Sync workers returning coordinator
-    bool is_coordinator() {
-        return pthread_barrier_wait(&barrier_) == PTHREAD_BARRIER_SERIAL_THREAD;
-    }
+    bool is_coordinator() { return barrier_.wait(); }
+
+    // Join the workers without blocking; the last worker to join is the
+    // coordinator (see Rendezvous::arrive)
+    Rendezvous::Ticket arrive_workers() { return barrier_.arrive(); }
 
     // Get limit
     size_t limit() { return results_->size(); }
 
     // Sync workers with caller
-    void sync() { pthread_barrier_wait(&called_barrier_); }
+    void sync() { called_barrier_.wait(); }
+
+    // Join the caller without blocking; wake is called once the caller and
+    // every worker have joined
+    Rendezvous::Ticket arrive_caller(std::function<void()> wake) {
+        return called_barrier_.arrive(std::move(wake));
+    }
 };
@@ -1,23 +1,28 @@
 #pragma once
 
 #include "Operation.h"
+#include "Rendezvous.h"
 #include "../future/Future.h"
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
-#include <pthread.h>
 
 class SyncOperation : public Operation {
 private:
-    pthread_barrier_t barrier_;
+    Rendezvous barrier_;
 
 public:
-    // Constructor takes references to key and value strings
-    SyncOperation(size_t partition_count) : Operation(nullptr, Type::SYNC) {
-        pthread_barrier_init(&barrier_, NULL, partition_count);
+    // Constructor takes the number of partitions to synchronize and the
+    // key-map epoch that starts once they have (0: unchanged)
+    SyncOperation(size_t partition_count, uint64_t epoch = 0) :
+        Operation(nullptr, Type::SYNC), barrier_(partition_count) {
+        this->epoch(epoch);
     }
 
     // Destructor (default)
-    ~SyncOperation() { destroy_barrier(); }
+    ~SyncOperation() = default;
 
     // Copy constructor and assignment operator are deleted
     // to prevent copying of ScanOperation objects
@@ -30,10 +35,11 @@ public:
     SyncOperation &operator=(SyncOperation &&) = delete;
 
     // Wait for all partitions to synchronize
-    bool sync() {
-        return pthread_barrier_wait(&barrier_) == PTHREAD_BARRIER_SERIAL_THREAD;
-    }
+    bool sync() { return barrier_.wait(); }
 
-    // Destroy barrier
-    void destroy_barrier() { pthread_barrier_destroy(&barrier_); }
+    // Join the synchronization without blocking; wake is called once all
+    // partitions have joined (see Rendezvous::arrive)
+    Rendezvous::Ticket arrive(std::function<void()> wake) {
+        return barrier_.arrive(std::move(wake));
+    }
 };
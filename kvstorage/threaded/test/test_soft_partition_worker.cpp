@@ -4,7 +4,9 @@
 #include "../../../storage/MapStorageEngine.h"
 #include "../../../utils/test_assertions.h"
 #include "../../../utils/test_resources.h"
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 // Test result tracking
@@ -115,13 +117,348 @@ void test_sync_multiple_workers() {
     END_TEST("sync_multiple_workers")
 }
 
+void test_coalesced_writes() {
+    TEST("coalesced_writes")
+    MapStorageEngine<> engine(0, worker_test_engine_path());
+    Worker<16> worker(engine);
+
+    // Park the worker on a barrier so the following operations are drained
+    // as a single batch
+    SyncOperation *sync_operation = new SyncOperation(2);
+    worker.enqueue(sync_operation);
+
+    std::string key = "hot";
+    for (int i = 0; i < 5; ++i) {
+        worker.enqueue(new WriteOperation(key, "v" + std::to_string(i)));
+    }
+    std::string other_key = "cold";
+    worker.enqueue(new WriteOperation(other_key, "c0"));
+
+    std::string read_value;
+    ReadOperation read_operation(key, read_value);
+    worker.enqueue(&read_operation);
+
+    if (sync_operation->sync()) {
+        delete sync_operation;
+    }
+    read_operation.wait();
+
+    // Read-your-writes holds for the value still buffered in the batch
+    ASSERT_STATUS_EQ(Status::SUCCESS, read_operation.status());
+    ASSERT_STR_EQ("v4", read_value);
+    ASSERT_EQ(4, worker.coalesced_write_count());
+
+    // The scan must observe the surviving writes
+    std::vector<std::pair<std::string, std::string>> values = {{"", ""},
+                                                               {"", ""}};
+    std::string start_key = "a";
+    ScanOperation scan_operation(start_key, values, 1);
+    worker.enqueue(&scan_operation);
+    scan_operation.sync();
+
+    ASSERT_STATUS_EQ(Status::SUCCESS, scan_operation.status());
+    ASSERT_STR_EQ("cold", values[0].first);
+    ASSERT_STR_EQ("c0", values[0].second);
+    ASSERT_STR_EQ("hot", values[1].first);
+    ASSERT_STR_EQ("v4", values[1].second);
+    END_TEST("coalesced_writes")
+}
+
+void test_admission_control() {
+    TEST("admission_control")
+    MapStorageEngine<> engine(0, worker_test_engine_path());
+    AdmissionPolicy policy;
+    policy.max_queue_depth = 2;
+    Worker<16> worker(engine, policy);
+
+    SyncOperation *sync_operation = new SyncOperation(2);
+    worker.enqueue(sync_operation);
+
+    // Wait until the worker has taken the sync: it is then parked on it, and
+    // nothing else is queued
+    while (worker.queue_depth() > 0) {
+        std::this_thread::yield();
+    }
+
+    // Fill the queue up to its depth limit while the worker is parked
+    std::string key = "k1";
+    std::string last_value;
+    size_t admitted = 0;
+    while (worker.admit()) {
+        last_value = "v" + std::to_string(admitted++);
+        worker.enqueue(new WriteOperation(key, last_value));
+    }
+    ASSERT_EQ(2, admitted);
+    ASSERT_EQ(1, worker.shed_count());
+
+    // A read whose deadline passed while queued is answered with BUSY
+    std::string expired_value;
+    ReadOperation expired_read(key, expired_value);
+    expired_read.deadline(std::chrono::steady_clock::now());
+    worker.enqueue(&expired_read);
+
+    if (sync_operation->sync()) {
+        delete sync_operation;
+    }
+    expired_read.wait();
+    ASSERT_STATUS_EQ(Status::BUSY, expired_read.status());
+    ASSERT_EQ(1, worker.expired_count());
+
+    // Once drained, requests are admitted again
+    ASSERT_TRUE(worker.admit());
+    std::string read_value;
+    ReadOperation read_operation(key, read_value);
+    worker.enqueue(&read_operation);
+    read_operation.wait();
+    ASSERT_STATUS_EQ(Status::SUCCESS, read_operation.status());
+    ASSERT_STR_EQ(last_value, read_value);
+    END_TEST("admission_control")
+}
+
+void test_chunked_scan_with_reads() {
+    TEST("chunked_scan_with_reads")
+    MapStorageEngine<> engine(0, worker_test_engine_path());
+    const size_t key_count = 3 * Worker<64>::SCAN_CHUNK + 5;
+    for (size_t i = 0; i < key_count; ++i) {
+        std::string key = "k" + std::string(i < 10 ? "00" : i < 100 ? "0" : "") +
+                          std::to_string(i);
+        engine.write(key, "v" + std::to_string(i));
+    }
+    Worker<64> worker(engine);
+
+    // Park the worker so the scan and the reads queue up on their lanes
+    SyncOperation *sync_operation = new SyncOperation(2);
+    worker.enqueue(sync_operation);
+
+    std::string start_key = "k";
+    std::vector<std::pair<std::string, std::string>> values(key_count);
+    ScanOperation scan_operation(start_key, values, 1);
+    worker.enqueue(&scan_operation);
+
+    std::vector<std::string> read_keys = {"k000", "k100", "k150"};
+    std::vector<std::string> read_values(read_keys.size());
+    std::vector<std::unique_ptr<ReadOperation>> reads;
+    for (size_t i = 0; i < read_keys.size(); ++i) {
+        reads.push_back(
+            std::make_unique<ReadOperation>(read_keys[i], read_values[i]));
+        worker.enqueue(reads.back().get());
+    }
+
+    if (sync_operation->sync()) {
+        delete sync_operation;
+    }
+
+    for (auto &read : reads) {
+        read->wait();
+        ASSERT_STATUS_EQ(Status::SUCCESS, read->status());
+    }
+    ASSERT_STR_EQ("v0", read_values[0]);
+    ASSERT_STR_EQ("v100", read_values[1]);
+    ASSERT_STR_EQ("v150", read_values[2]);
+
+    // The scan is split into chunks but returns every key in order
+    scan_operation.sync();
+    ASSERT_STATUS_EQ(Status::SUCCESS, scan_operation.status());
+    ASSERT_EQ(key_count, values.size());
+    ASSERT_STR_EQ("k000", values.front().first);
+    ASSERT_STR_EQ("v" + std::to_string(key_count - 1), values.back().second);
+    for (size_t i = 1; i < values.size(); ++i) {
+        ASSERT_TRUE(values[i - 1].first < values[i].first);
+    }
+    END_TEST("chunked_scan_with_reads")
+}
+
+void test_batched_reads() {
+    TEST("batched_reads")
+    MapStorageEngine<> engine(0, worker_test_engine_path());
+    for (int i = 0; i < 40; ++i) {
+        engine.write("k" + std::to_string(i), "v" + std::to_string(i));
+    }
+    Worker<64> worker(engine);
+
+    // Park the worker so the reads are popped in READ_BATCH-sized turns
+    SyncOperation *sync_operation = new SyncOperation(2);
+    worker.enqueue(sync_operation);
+    std::string written_key = "k3";
+    worker.enqueue(new WriteOperation(written_key, "new"));
+
+    // Existing, missing, repeated and just written keys in one batch
+    std::vector<std::string> read_keys;
+    for (int i = 39; i >= 0; i -= 2) {
+        read_keys.push_back("k" + std::to_string(i));
+    }
+    read_keys.push_back("missing");
+    read_keys.push_back("k7");
+    std::vector<std::string> read_values(read_keys.size());
+    std::vector<std::unique_ptr<ReadOperation>> reads;
+    for (size_t i = 0; i < read_keys.size(); ++i) {
+        reads.push_back(
+            std::make_unique<ReadOperation>(read_keys[i], read_values[i]));
+        worker.enqueue(reads.back().get());
+    }
+    ASSERT_GT(read_keys.size(), Worker<64>::READ_BATCH);
+
+    if (sync_operation->sync()) {
+        delete sync_operation;
+    }
+    for (size_t i = 0; i < reads.size(); ++i) {
+        reads[i]->wait();
+        if (read_keys[i] == "missing") {
+            ASSERT_STATUS_EQ(Status::NOT_FOUND, reads[i]->status());
+        } else if (read_keys[i] == written_key) {
+            ASSERT_STATUS_EQ(Status::SUCCESS, reads[i]->status());
+            ASSERT_STR_EQ("new", read_values[i]);
+        } else {
+            ASSERT_STATUS_EQ(Status::SUCCESS, reads[i]->status());
+            ASSERT_STR_EQ("v" + read_keys[i].substr(1), read_values[i]);
+        }
+    }
+    END_TEST("batched_reads")
+}
+
+void test_shared_pool() {
+    TEST("shared_pool")
+    MapStorageEngine<> engine(0, worker_test_engine_path());
+
+    // Many more workers than threads: barriers over all of them only
+    // complete if waiting workers do not hold a thread
+    const size_t worker_count = 64;
+    Worker<64>::Pool pool(2);
+    std::vector<std::unique_ptr<Worker<64>>> workers;
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.push_back(
+            std::make_unique<Worker<64>>(engine, AdmissionPolicy(), &pool));
+    }
+    ASSERT_EQ(2, pool.thread_count());
+
+    // Each worker applies its operations in queue order
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < worker_count; ++i) {
+        keys.push_back("k" + std::string(i < 10 ? "0" : "") +
+                       std::to_string(i));
+    }
+    for (int version = 0; version < 10; ++version) {
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers[i]->enqueue(
+                new WriteOperation(keys[i], "v" + std::to_string(version)));
+        }
+    }
+    SyncOperation *sync_operation = new SyncOperation(worker_count);
+    for (auto &worker : workers) {
+        worker->enqueue(sync_operation);
+    }
+
+    std::string start_key = "k";
+    std::vector<std::pair<std::string, std::string>> values(worker_count);
+    ScanOperation scan_operation(start_key, values, worker_count);
+    for (auto &worker : workers) {
+        worker->enqueue(&scan_operation);
+    }
+    scan_operation.sync();
+    ASSERT_STATUS_EQ(Status::SUCCESS, scan_operation.status());
+    ASSERT_EQ(worker_count, values.size());
+    for (size_t i = 0; i < worker_count; ++i) {
+        ASSERT_STR_EQ(keys[i], values[i].first);
+        ASSERT_STR_EQ("v9", values[i].second);
+    }
+
+    std::vector<std::string> read_values(worker_count);
+    std::vector<std::unique_ptr<ReadOperation>> reads;
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers[i]->enqueue(new WriteOperation(keys[i], "last"));
+        reads.push_back(
+            std::make_unique<ReadOperation>(keys[i], read_values[i]));
+        workers[i]->enqueue(reads.back().get());
+    }
+    for (size_t i = 0; i < worker_count; ++i) {
+        reads[i]->wait();
+        ASSERT_STATUS_EQ(Status::SUCCESS, reads[i]->status());
+        ASSERT_STR_EQ("last", read_values[i]);
+    }
+    workers.clear();
+    END_TEST("shared_pool")
+}
+
+void test_scan_releases_other_workers() {
+    TEST("scan_releases_other_workers")
+    MapStorageEngine<> engine(0, worker_test_engine_path());
+    std::string key = "k1";
+    engine.write(key, "v1");
+    Worker<8> worker(engine);
+    Worker<8> coordinator(engine);
+
+    // Park the second worker so that it joins the scan last and coordinates
+    SyncOperation *sync_operation = new SyncOperation(2);
+    coordinator.enqueue(sync_operation);
+
+    std::string start_key = "k";
+    std::vector<std::pair<std::string, std::string>> values(1);
+    ScanOperation scan_operation(start_key, values, 2);
+    worker.enqueue(&scan_operation);
+    coordinator.enqueue(&scan_operation);
+
+    // The fence makes the read follow the first worker's part of the scan,
+    // which ends once its writes are flushed: it must not wait for the
+    // coordinator
+    worker.enqueue(new SyncOperation(1));
+    std::string value;
+    ReadOperation read_operation(key, value);
+    worker.enqueue(&read_operation);
+    read_operation.wait();
+    ASSERT_STATUS_EQ(Status::SUCCESS, read_operation.status());
+    ASSERT_STR_EQ("v1", value);
+
+    if (sync_operation->sync()) {
+        delete sync_operation;
+    }
+    scan_operation.sync();
+    ASSERT_STATUS_EQ(Status::SUCCESS, scan_operation.status());
+    ASSERT_EQ(1, values.size());
+    ASSERT_STR_EQ("k1", values[0].first);
+    END_TEST("scan_releases_other_workers")
+}
+
+void test_stale_route() {
+    TEST("stale_route")
+    MapStorageEngine<> engine(0, worker_test_engine_path());
+    std::string key = "k1";
+    engine.write(key, "v1");
+    Worker<8> worker(engine);
+
+    // The key map moves to epoch 1 once the worker passes this sync
+    worker.enqueue(new SyncOperation(1, 1));
+
+    // A read routed at epoch 0 is bounced back to the caller
+    std::string stale_value;
+    ReadOperation stale_read(key, stale_value);
+    worker.enqueue(&stale_read);
+    stale_read.wait();
+    ASSERT_STATUS_EQ(Status::STALE_ROUTE, stale_read.status());
+
+    std::string value;
+    ReadOperation read_operation(key, value);
+    read_operation.epoch(1);
+    worker.enqueue(&read_operation);
+    read_operation.wait();
+    ASSERT_STATUS_EQ(Status::SUCCESS, read_operation.status());
+    ASSERT_STR_EQ("v1", value);
+    END_TEST("stale_route")
+}
+
 int main() {
     std::vector<std::pair<std::string, TestFunction>> tests = {
         {"stop_signal", test_stop_signal},
         {"single_read_operation", test_single_read_operation},
         {"single_write_operation", test_single_write_operation},
         {"single_scan_operation", test_single_scan_operation},
-        {"sync_multiple_workers", test_sync_multiple_workers}};
+        {"sync_multiple_workers", test_sync_multiple_workers},
+        {"coalesced_writes", test_coalesced_writes},
+        {"admission_control", test_admission_control},
+        {"chunked_scan_with_reads", test_chunked_scan_with_reads},
+        {"batched_reads", test_batched_reads},
+        {"shared_pool", test_shared_pool},
+        {"scan_releases_other_workers", test_scan_releases_other_workers},
+        {"stale_route", test_stale_route}};
 
     run_test_suite("SoftPartitionWorker", tests);
 
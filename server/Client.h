@@ -0,0 +1,232 @@
+#pragma once
+
+#include "Endpoint.h"
+#include "Protocol.h"
+#include <cerrno>
+#include <cstddef>
+#include <poll.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+/**
+ * @brief Client of a Server, with request pipelining
+ *
+ * send_read(), send_write() and send_scan() only queue a request; flush()
+ * sends every queued request and receive() returns the responses one at a
+ * time, in request order. read(), write() and scan() are the blocking
+ * one-request-at-a-time equivalents.
+ *
+ * While flushing, responses already arriving are buffered, so a client may
+ * queue more requests than the socket buffers hold without deadlocking with
+ * the server (which stops reading once it has a backlog of unsent responses).
+ *
+ * Not thread-safe: use one Client per thread.
+ */
+class Client {
+public:
+    static constexpr size_t READ_CHUNK = 64 * 1024; // Bytes per recv()
+
+private:
+    int fd_;              // Socket
+    std::string output_;  // Queued request frames
+    std::string input_;   // Received bytes not yet decoded
+    size_t input_offset_; // Bytes of input already decoded
+    size_t outstanding_;  // Requests sent or queued, not yet answered
+
+    /**
+     * @brief Read whatever the socket has into the input buffer
+     * @param wait Block until at least one byte arrives
+     * @return false if the connection failed or was closed
+     */
+    bool receive_some(bool wait) {
+        input_.erase(0, input_offset_);
+        input_offset_ = 0;
+        char buffer[READ_CHUNK];
+        for (;;) {
+            ssize_t received = ::recv(fd_, buffer, sizeof(buffer),
+                                      wait ? 0 : MSG_DONTWAIT);
+            if (received > 0) {
+                input_.append(buffer, static_cast<size_t>(received));
+                return true;
+            }
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            return !wait && received < 0 &&
+                   (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+
+public:
+    /**
+     * @brief Constructor - connects to a server
+     * @param endpoint The server endpoint ("unix:<path>" or "tcp:<port>")
+     * @throws std::runtime_error if the connection fails
+     */
+    explicit Client(const std::string &endpoint) :
+        fd_(Endpoint(endpoint).connect()), input_offset_(0), outstanding_(0) {}
+
+    /**
+     * @brief Destructor - closes the connection
+     */
+    ~Client() { ::close(fd_); }
+
+    // Copy constructor and assignment operator are deleted
+    Client(const Client &) = delete;
+    Client &operator=(const Client &) = delete;
+
+    /**
+     * @brief Queue a read request
+     * @param key The key to read
+     */
+    void send_read(std::string_view key) {
+        encode_read(output_, key);
+        ++outstanding_;
+    }
+
+    /**
+     * @brief Queue a write request
+     * @param key The key to write
+     * @param value The value to write
+     */
+    void send_write(std::string_view key, std::string_view value) {
+        encode_write(output_, key, value);
+        ++outstanding_;
+    }
+
+    /**
+     * @brief Queue a scan request
+     * @param key_start The starting key
+     * @param limit Maximum number of key-value pairs to return
+     */
+    void send_scan(std::string_view key_start, uint32_t limit) {
+        encode_scan(output_, key_start, limit);
+        ++outstanding_;
+    }
+
+    /**
+     * @brief Get the number of requests not answered yet
+     * @return Outstanding request count
+     */
+    size_t outstanding() const { return outstanding_; }
+
+    /**
+     * @brief Send every queued request
+     * @return Status::SUCCESS, or Status::ERROR if the connection failed
+     */
+    Status flush() {
+        size_t offset = 0;
+        while (offset < output_.size()) {
+            ssize_t sent = ::send(fd_, output_.data() + offset,
+                                  output_.size() - offset,
+                                  MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent > 0) {
+                offset += static_cast<size_t>(sent);
+                continue;
+            }
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                return Status::ERROR;
+            }
+            // Socket full: wait for room, draining responses meanwhile
+            pollfd descriptor{fd_, POLLIN | POLLOUT, 0};
+            if (::poll(&descriptor, 1, -1) < 0 && errno != EINTR) {
+                return Status::ERROR;
+            }
+            if ((descriptor.revents & POLLIN) && !receive_some(false)) {
+                return Status::ERROR;
+            }
+        }
+        output_.clear();
+        return Status::SUCCESS;
+    }
+
+    /**
+     * @brief Get the response to the oldest outstanding request
+     *
+     * Flushes queued requests first and blocks until the response arrives.
+     *
+     * @param response Output parameter to store the response
+     * @return Status::SUCCESS, or Status::ERROR if nothing is outstanding, the
+     * connection failed or the server sent a malformed frame
+     */
+    Status receive(Response &response) {
+        if (outstanding_ == 0 ||
+            (!output_.empty() && flush() != Status::SUCCESS)) {
+            return Status::ERROR;
+        }
+        for (;;) {
+            size_t consumed = 0;
+            DecodeResult result = decode_response(
+                std::string_view(input_).substr(input_offset_), response,
+                consumed);
+            if (result == DecodeResult::FRAME) {
+                input_offset_ += consumed;
+                --outstanding_;
+                return Status::SUCCESS;
+            }
+            if (result == DecodeResult::INVALID || !receive_some(true)) {
+                return Status::ERROR;
+            }
+        }
+    }
+
+    /**
+     * @brief Read a value
+     * @param key The key to read
+     * @param value Output parameter to store the value
+     * @return The server's status, or Status::ERROR on connection failure
+     */
+    Status read(std::string_view key, std::string &value) {
+        send_read(key);
+        Response response;
+        if (receive(response) != Status::SUCCESS) {
+            return Status::ERROR;
+        }
+        value = std::move(response.value);
+        return response.status;
+    }
+
+    /**
+     * @brief Write a value
+     * @param key The key to write
+     * @param value The value to write
+     * @return The server's status, or Status::ERROR on connection failure
+     */
+    Status write(std::string_view key, std::string_view value) {
+        send_write(key, value);
+        Response response;
+        if (receive(response) != Status::SUCCESS) {
+            return Status::ERROR;
+        }
+        return response.status;
+    }
+
+    /**
+     * @brief Scan from a starting key
+     * @param key_start The starting key
+     * @param limit Maximum number of key-value pairs to return
+     * @param results Output parameter to store the key-value pairs
+     * @return The server's status, or Status::ERROR on connection failure
+     */
+    Status scan(std::string_view key_start, uint32_t limit,
+                std::vector<std::pair<std::string, std::string>> &results) {
+        send_scan(key_start, limit);
+        Response response;
+        if (receive(response) != Status::SUCCESS) {
+            return Status::ERROR;
+        }
+        results = std::move(response.results);
+        return response.status;
+    }
+};
+
+} // namespace server
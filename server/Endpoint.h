@@ -0,0 +1,173 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace server {
+
+/**
+ * @brief A local endpoint: a Unix domain socket or a loopback TCP port
+ *
+ * Written as "unix:<path>" or "tcp:<port>" (the port is bound on 127.0.0.1
+ * only; "tcp:127.0.0.1:<port>" and "tcp:localhost:<port>" are accepted too).
+ */
+class Endpoint {
+private:
+    bool unix_;        // Unix domain socket, otherwise loopback TCP
+    std::string path_; // Socket path (Unix)
+    uint16_t port_;    // Port (TCP)
+
+    static std::string error_text(const std::string &what) {
+        return what + ": " + std::strerror(errno);
+    }
+
+public:
+    /**
+     * @brief Parse an endpoint
+     * @param endpoint The endpoint string
+     * @throws std::runtime_error if the endpoint is malformed
+     */
+    explicit Endpoint(const std::string &endpoint) : unix_(false), port_(0) {
+        if (endpoint.rfind("unix:", 0) == 0) {
+            unix_ = true;
+            path_ = endpoint.substr(5);
+            if (path_.empty() ||
+                path_.size() >= sizeof(sockaddr_un::sun_path)) {
+                throw std::runtime_error("Invalid socket path: " + endpoint);
+            }
+            return;
+        }
+        if (endpoint.rfind("tcp:", 0) != 0) {
+            throw std::runtime_error("Invalid endpoint: " + endpoint);
+        }
+        std::string port = endpoint.substr(4);
+        for (const char *host : {"127.0.0.1:", "localhost:"}) {
+            if (port.rfind(host, 0) == 0) {
+                port = port.substr(std::strlen(host));
+            }
+        }
+        unsigned long value = 0;
+        try {
+            size_t used = 0;
+            value = std::stoul(port, &used);
+            if (used != port.size()) {
+                value = 0;
+            }
+        } catch (const std::exception &) {
+            value = 0;
+        }
+        if (value == 0 || value > 65535) {
+            throw std::runtime_error("Invalid endpoint: " + endpoint);
+        }
+        port_ = static_cast<uint16_t>(value);
+    }
+
+    /**
+     * @brief Check whether this is a Unix domain socket
+     * @return true for "unix:" endpoints
+     */
+    bool is_unix() const { return unix_; }
+
+    /**
+     * @brief Get the socket path of a Unix endpoint
+     * @return The path (empty for TCP)
+     */
+    const std::string &path() const { return path_; }
+
+    /**
+     * @brief Create a non-blocking listening socket
+     *
+     * An existing file at a Unix socket path is replaced.
+     *
+     * @return The socket descriptor
+     * @throws std::runtime_error if the socket cannot be bound
+     */
+    int listen() const {
+        int fd = ::socket(unix_ ? AF_UNIX : AF_INET,
+                          SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::runtime_error(error_text("socket"));
+        }
+        int result;
+        if (unix_) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path_.c_str(), path_.size() + 1);
+            ::unlink(path_.c_str());
+            result = ::bind(fd, reinterpret_cast<sockaddr *>(&address),
+                            sizeof(address));
+        } else {
+            int one = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port_);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            result = ::bind(fd, reinterpret_cast<sockaddr *>(&address),
+                            sizeof(address));
+        }
+        if (result != 0 || ::listen(fd, SOMAXCONN) != 0) {
+            std::string message = error_text("bind/listen");
+            ::close(fd);
+            throw std::runtime_error(message);
+        }
+        return fd;
+    }
+
+    /**
+     * @brief Open a blocking connection to the endpoint
+     * @return The socket descriptor
+     * @throws std::runtime_error if the connection fails
+     */
+    int connect() const {
+        int fd = ::socket(unix_ ? AF_UNIX : AF_INET,
+                          SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::runtime_error(error_text("socket"));
+        }
+        int result;
+        if (unix_) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path_.c_str(), path_.size() + 1);
+            result = ::connect(fd, reinterpret_cast<sockaddr *>(&address),
+                               sizeof(address));
+        } else {
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port_);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            result = ::connect(fd, reinterpret_cast<sockaddr *>(&address),
+                               sizeof(address));
+        }
+        if (result != 0) {
+            std::string message = error_text("connect");
+            ::close(fd);
+            throw std::runtime_error(message);
+        }
+        set_no_delay(fd);
+        return fd;
+    }
+
+    /**
+     * @brief Disable Nagle's algorithm on a TCP socket (no-op for Unix)
+     * @param fd The socket descriptor
+     */
+    void set_no_delay(int fd) const {
+        if (!unix_) {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    }
+};
+
+} // namespace server
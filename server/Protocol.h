@@ -0,0 +1,299 @@
+#pragma once
+
+#include "../storage/Status.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+/**
+ * @brief Request operation codes
+ */
+enum class Opcode : uint8_t { READ = 0, WRITE = 1, SCAN = 2 };
+
+/**
+ * @brief Result of decoding a frame from a receive buffer
+ */
+enum class DecodeResult {
+    FRAME,      // A whole frame was decoded
+    INCOMPLETE, // More bytes are needed
+    INVALID     // The bytes are not a valid frame (the peer must be dropped)
+};
+
+// Largest frame body accepted from a peer
+inline constexpr uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+/**
+ * @brief A decoded request (views into the receive buffer)
+ */
+struct Request {
+    Opcode opcode = Opcode::READ;
+    std::string_view key;   // Read/write key, or scan start key
+    std::string_view value; // Write value
+    uint32_t limit = 0;     // Scan limit
+};
+
+/**
+ * @brief A decoded response
+ */
+struct Response {
+    Opcode opcode = Opcode::READ;
+    Status status = Status::ERROR;
+    std::string value; // Read value
+    std::vector<std::pair<std::string, std::string>> results; // Scan results
+};
+
+/*
+ * Wire format. Every frame is a 4-byte little-endian body length followed by
+ * the body; strings are a 4-byte length followed by the raw bytes. Requests
+ * are pipelined: a client may send any number of frames before reading, and
+ * responses come back in request order on the same connection.
+ *
+ * Request bodies:  READ  <op> <key>
+ *                  WRITE <op> <key> <value>
+ *                  SCAN  <op> <key> <u32 limit>
+ * Response bodies: <op> <status> then, on Status::SUCCESS,
+ *                  READ  <value>
+ *                  SCAN  <u32 count> then count <key> <value> pairs
+ */
+
+namespace detail {
+
+inline void put_u32(std::string &out, uint32_t value) {
+    char bytes[4] = {static_cast<char>(value), static_cast<char>(value >> 8),
+                     static_cast<char>(value >> 16),
+                     static_cast<char>(value >> 24)};
+    out.append(bytes, sizeof(bytes));
+}
+
+inline void put_string(std::string &out, std::string_view value) {
+    put_u32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+inline bool get_u32(std::string_view &in, uint32_t &value) {
+    if (in.size() < 4) {
+        return false;
+    }
+    const auto *bytes = reinterpret_cast<const unsigned char *>(in.data());
+    value = static_cast<uint32_t>(bytes[0]) |
+            static_cast<uint32_t>(bytes[1]) << 8 |
+            static_cast<uint32_t>(bytes[2]) << 16 |
+            static_cast<uint32_t>(bytes[3]) << 24;
+    in.remove_prefix(4);
+    return true;
+}
+
+inline bool get_string(std::string_view &in, std::string_view &value) {
+    uint32_t size;
+    if (!get_u32(in, size) || size > in.size()) {
+        return false;
+    }
+    value = in.substr(0, size);
+    in.remove_prefix(size);
+    return true;
+}
+
+/**
+ * @brief Start a frame, returning the offset of its length field
+ */
+inline size_t begin_frame(std::string &out) {
+    size_t offset = out.size();
+    put_u32(out, 0);
+    return offset;
+}
+
+/**
+ * @brief Fill in the length field of a frame started by begin_frame()
+ */
+inline void end_frame(std::string &out, size_t offset) {
+    std::string length;
+    put_u32(length, static_cast<uint32_t>(out.size() - offset - 4));
+    std::memcpy(out.data() + offset, length.data(), 4);
+}
+
+/**
+ * @brief Split the next frame body off a buffer
+ * @param buffer Bytes received so far
+ * @param body Output parameter to store the body
+ * @param consumed Output parameter to store the frame size (length included)
+ */
+inline DecodeResult next_frame(std::string_view buffer, std::string_view &body,
+                               size_t &consumed) {
+    uint32_t size;
+    if (!get_u32(buffer, size)) {
+        return DecodeResult::INCOMPLETE;
+    }
+    if (size == 0 || size > MAX_FRAME_SIZE) {
+        return DecodeResult::INVALID;
+    }
+    if (buffer.size() < size) {
+        return DecodeResult::INCOMPLETE;
+    }
+    body = buffer.substr(0, size);
+    consumed = 4 + static_cast<size_t>(size);
+    return DecodeResult::FRAME;
+}
+
+} // namespace detail
+
+/**
+ * @brief Append a READ request frame
+ */
+inline void encode_read(std::string &out, std::string_view key) {
+    size_t frame = detail::begin_frame(out);
+    out.push_back(static_cast<char>(Opcode::READ));
+    detail::put_string(out, key);
+    detail::end_frame(out, frame);
+}
+
+/**
+ * @brief Append a WRITE request frame
+ */
+inline void encode_write(std::string &out, std::string_view key,
+                         std::string_view value) {
+    size_t frame = detail::begin_frame(out);
+    out.push_back(static_cast<char>(Opcode::WRITE));
+    detail::put_string(out, key);
+    detail::put_string(out, value);
+    detail::end_frame(out, frame);
+}
+
+/**
+ * @brief Append a SCAN request frame
+ */
+inline void encode_scan(std::string &out, std::string_view key,
+                        uint32_t limit) {
+    size_t frame = detail::begin_frame(out);
+    out.push_back(static_cast<char>(Opcode::SCAN));
+    detail::put_string(out, key);
+    detail::put_u32(out, limit);
+    detail::end_frame(out, frame);
+}
+
+/**
+ * @brief Decode the next request frame of a receive buffer
+ * @param buffer Bytes received so far
+ * @param request Output parameter to store the request (views into buffer)
+ * @param consumed Output parameter to store the number of bytes decoded
+ * @return Decode result
+ */
+inline DecodeResult decode_request(std::string_view buffer, Request &request,
+                                   size_t &consumed) {
+    std::string_view body;
+    DecodeResult result = detail::next_frame(buffer, body, consumed);
+    if (result != DecodeResult::FRAME) {
+        return result;
+    }
+
+    request.opcode = static_cast<Opcode>(body.front());
+    body.remove_prefix(1);
+    bool valid = detail::get_string(body, request.key);
+    switch (request.opcode) {
+        case Opcode::READ:
+            break;
+        case Opcode::WRITE:
+            valid = valid && detail::get_string(body, request.value);
+            break;
+        case Opcode::SCAN:
+            valid = valid && detail::get_u32(body, request.limit);
+            break;
+        default:
+            valid = false;
+            break;
+    }
+    return valid && body.empty() ? DecodeResult::FRAME : DecodeResult::INVALID;
+}
+
+/**
+ * @brief Append a READ or WRITE response frame
+ * @param value The read value (ignored for writes and failed reads)
+ */
+inline void encode_response(std::string &out, Opcode opcode, Status status,
+                            std::string_view value = {}) {
+    size_t frame = detail::begin_frame(out);
+    out.push_back(static_cast<char>(opcode));
+    out.push_back(static_cast<char>(status));
+    if (opcode == Opcode::READ && status == Status::SUCCESS) {
+        detail::put_string(out, value);
+    }
+    detail::end_frame(out, frame);
+}
+
+/**
+ * @brief Append a SCAN response frame
+ */
+inline void encode_scan_response(
+    std::string &out, Status status,
+    const std::vector<std::pair<std::string, std::string>> &results) {
+    size_t frame = detail::begin_frame(out);
+    out.push_back(static_cast<char>(Opcode::SCAN));
+    out.push_back(static_cast<char>(status));
+    if (status == Status::SUCCESS) {
+        detail::put_u32(out, static_cast<uint32_t>(results.size()));
+        for (const auto &[key, value] : results) {
+            detail::put_string(out, key);
+            detail::put_string(out, value);
+        }
+    }
+    detail::end_frame(out, frame);
+}
+
+/**
+ * @brief Decode the next response frame of a receive buffer
+ * @param buffer Bytes received so far
+ * @param response Output parameter to store the response
+ * @param consumed Output parameter to store the number of bytes decoded
+ * @return Decode result
+ */
+inline DecodeResult decode_response(std::string_view buffer,
+                                    Response &response, size_t &consumed) {
+    std::string_view body;
+    DecodeResult result = detail::next_frame(buffer, body, consumed);
+    if (result != DecodeResult::FRAME) {
+        return result;
+    }
+    if (body.size() < 2 ||
+        static_cast<uint8_t>(body[0]) > static_cast<uint8_t>(Opcode::SCAN) ||
+        static_cast<uint8_t>(body[1]) > static_cast<uint8_t>(Status::BUSY)) {
+        return DecodeResult::INVALID;
+    }
+    response.opcode = static_cast<Opcode>(body[0]);
+    response.status = static_cast<Status>(body[1]);
+    response.value.clear();
+    response.results.clear();
+    body.remove_prefix(2);
+
+    bool valid = true;
+    if (response.status == Status::SUCCESS) {
+        std::string_view key;
+        std::string_view value;
+        uint32_t count = 0;
+        switch (response.opcode) {
+            case Opcode::READ:
+                valid = detail::get_string(body, value);
+                response.value.assign(value);
+                break;
+            case Opcode::SCAN:
+                valid = detail::get_u32(body, count);
+                for (uint32_t i = 0; valid && i < count; ++i) {
+                    valid = detail::get_string(body, key) &&
+                            detail::get_string(body, value);
+                    if (valid) {
+                        response.results.emplace_back(key, value);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return valid && body.empty() ? DecodeResult::FRAME : DecodeResult::INVALID;
+}
+
+} // namespace server
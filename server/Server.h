@@ -0,0 +1,371 @@
+#pragma once
+
+#include "Endpoint.h"
+#include "Protocol.h"
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+/**
+ * @brief Serves a key-value storage over a local socket
+ *
+ * Runs loop_count event loops, each an epoll instance on its own thread. The
+ * listening socket is registered in every loop with EPOLLEXCLUSIVE, so each
+ * new connection wakes a single loop, which accepts it and serves it for its
+ * whole lifetime; connection state is therefore never shared between threads.
+ * The storage is called directly from the loop threads, so it must accept
+ * concurrent callers (every storage type used by the runner does).
+ *
+ * Connections are edge-triggered. When a connection becomes readable, its
+ * loop reads everything available, executes every complete request in the
+ * buffer and answers all of them with a single write, so a pipelining client
+ * pays one system call per batch rather than per request. Once a connection
+ * has OUTPUT_LIMIT bytes of unsent responses, the loop stops reading from it
+ * until EPOLLOUT reports that the peer is draining them again.
+ *
+ * A malformed or oversized frame closes the connection.
+ *
+ * @tparam StorageType Storage exposing read(), write() and scan() with the
+ * KeyValueStorage signatures
+ */
+template <typename StorageType> class Server {
+public:
+    static constexpr size_t READ_CHUNK = 64 * 1024;     // Bytes per recv()
+    static constexpr size_t OUTPUT_LIMIT = 1024 * 1024; // Unsent bytes cap
+
+private:
+    /**
+     * @brief State of one client connection (owned by a single loop)
+     */
+    struct Connection {
+        int fd;                   // Socket
+        std::string input;        // Received bytes not yet executed
+        std::string output;       // Responses not yet sent
+        size_t output_offset = 0; // Bytes of output already sent
+    };
+
+    /**
+     * @brief One event loop and its connections
+     */
+    struct alignas(64) Loop {
+        int epoll_fd = -1; // epoll instance
+        std::unordered_map<int, std::unique_ptr<Connection>>
+            connections;                // Connections by descriptor
+        std::atomic_size_t requests{0}; // Requests served
+        std::thread thread;             // Loop thread
+    };
+
+    StorageType &storage_; // Served storage
+    Endpoint endpoint_;    // Listening endpoint
+    int listen_fd_;        // Listening socket
+    int stop_fd_;          // eventfd signalled by stop()
+    std::vector<std::unique_ptr<Loop>> loops_; // Event loops
+
+    /**
+     * @brief Execute every complete request buffered on a connection
+     * @param loop The connection's loop
+     * @param connection The connection
+     * @return false if the input holds a malformed frame
+     */
+    bool execute(Loop &loop, Connection &connection) {
+        std::string key;
+        std::string value;
+        std::vector<std::pair<std::string, std::string>> results;
+        size_t offset = 0;
+        size_t executed = 0;
+        bool valid = true;
+        while (connection.output.size() - connection.output_offset <
+               OUTPUT_LIMIT) {
+            Request request;
+            size_t consumed = 0;
+            DecodeResult result = decode_request(
+                std::string_view(connection.input).substr(offset), request,
+                consumed);
+            if (result != DecodeResult::FRAME) {
+                valid = result == DecodeResult::INCOMPLETE;
+                break;
+            }
+            key.assign(request.key);
+            Status status = Status::ERROR;
+            switch (request.opcode) {
+                case Opcode::READ:
+                    status = storage_.read(key, value);
+                    encode_response(connection.output, Opcode::READ, status,
+                                    value);
+                    break;
+                case Opcode::WRITE:
+                    status = storage_.write(key, std::string(request.value));
+                    encode_response(connection.output, Opcode::WRITE, status);
+                    break;
+                case Opcode::SCAN:
+                    results.clear();
+                    status = storage_.scan(key, request.limit, results);
+                    encode_scan_response(connection.output, status, results);
+                    break;
+            }
+            offset += consumed;
+            ++executed;
+        }
+        connection.input.erase(0, offset);
+        loop.requests.fetch_add(executed, std::memory_order_relaxed);
+        return valid;
+    }
+
+    /**
+     * @brief Send as much of a connection's pending output as the socket takes
+     * @param connection The connection
+     * @return false if the connection failed
+     */
+    static bool flush(Connection &connection) {
+        while (connection.output_offset < connection.output.size()) {
+            ssize_t sent = ::send(
+                connection.fd,
+                connection.output.data() + connection.output_offset,
+                connection.output.size() - connection.output_offset,
+                MSG_NOSIGNAL);
+            if (sent > 0) {
+                connection.output_offset += static_cast<size_t>(sent);
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else {
+                return sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            }
+        }
+        connection.output.clear();
+        connection.output_offset = 0;
+        return true;
+    }
+
+    /**
+     * @brief Make all the progress possible on a connection
+     *
+     * Alternates executing buffered requests, sending responses and reading
+     * more requests until the socket has nothing more to read or the output
+     * cap is reached.
+     *
+     * @param loop The connection's loop
+     * @param connection The connection
+     * @return false if the connection must be closed
+     */
+    bool service(Loop &loop, Connection &connection) {
+        char buffer[READ_CHUNK];
+        for (;;) {
+            if (!execute(loop, connection) || !flush(connection)) {
+                return false;
+            }
+            if (connection.output.size() - connection.output_offset >=
+                OUTPUT_LIMIT) {
+                return true; // Resumed by EPOLLOUT
+            }
+            ssize_t received = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                connection.input.append(buffer, static_cast<size_t>(received));
+            } else if (received < 0 && errno == EINTR) {
+                continue;
+            } else {
+                return received < 0 &&
+                       (errno == EAGAIN || errno == EWOULDBLOCK);
+            }
+        }
+    }
+
+    /**
+     * @brief Accept every pending connection into a loop
+     * @param loop The accepting loop
+     */
+    void accept_all(Loop &loop) {
+        for (;;) {
+            int fd = ::accept4(listen_fd_, nullptr, nullptr,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return; // EAGAIN, or an aborted connection
+            }
+            endpoint_.set_no_delay(fd);
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            event.data.fd = fd;
+            if (::epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+                ::close(fd);
+                continue;
+            }
+            auto connection = std::make_unique<Connection>();
+            connection->fd = fd;
+            loop.connections.emplace(fd, std::move(connection));
+        }
+    }
+
+    /**
+     * @brief Close a connection and forget it
+     */
+    static void close_connection(Loop &loop, int fd) {
+        ::epoll_ctl(loop.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        loop.connections.erase(fd);
+    }
+
+    /**
+     * @brief Event loop thread body
+     * @param loop The loop to run
+     */
+    void run(Loop &loop) {
+        constexpr int MAX_EVENTS = 64;
+        epoll_event events[MAX_EVENTS];
+        for (;;) {
+            int count = ::epoll_wait(loop.epoll_fd, events, MAX_EVENTS, -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == stop_fd_) {
+                    for (auto &[connection_fd, connection] : loop.connections) {
+                        ::close(connection_fd);
+                    }
+                    loop.connections.clear();
+                    return;
+                }
+                if (fd == listen_fd_) {
+                    accept_all(loop);
+                    continue;
+                }
+                auto it = loop.connections.find(fd);
+                if (it != loop.connections.end() &&
+                    !service(loop, *it->second)) {
+                    close_connection(loop, fd);
+                }
+            }
+        }
+    }
+
+    void close_descriptors() {
+        for (auto &loop : loops_) {
+            if (loop->epoll_fd >= 0) {
+                ::close(loop->epoll_fd);
+                loop->epoll_fd = -1;
+            }
+        }
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+            listen_fd_ = -1;
+            if (endpoint_.is_unix()) {
+                ::unlink(endpoint_.path().c_str());
+            }
+        }
+        if (stop_fd_ >= 0) {
+            ::close(stop_fd_);
+            stop_fd_ = -1;
+        }
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param storage The storage to serve (must outlive the server)
+     * @param endpoint Endpoint to listen on ("unix:<path>" or "tcp:<port>")
+     * @param loop_count Number of event loop threads
+     * @throws std::runtime_error if the endpoint is malformed
+     */
+    Server(StorageType &storage, const std::string &endpoint,
+           size_t loop_count) :
+        storage_(storage), endpoint_(endpoint), listen_fd_(-1), stop_fd_(-1) {
+        if (loop_count == 0) {
+            throw std::runtime_error("Server needs at least one event loop");
+        }
+        for (size_t i = 0; i < loop_count; ++i) {
+            loops_.push_back(std::make_unique<Loop>());
+        }
+    }
+
+    /**
+     * @brief Destructor - stops the loops and removes the socket file
+     */
+    ~Server() { stop(); }
+
+    // Copy constructor and assignment operator are deleted
+    Server(const Server &) = delete;
+    Server &operator=(const Server &) = delete;
+
+    /**
+     * @brief Bind the endpoint and start the event loops
+     * @throws std::runtime_error if the endpoint cannot be bound
+     */
+    void start() {
+        listen_fd_ = endpoint_.listen();
+        stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        bool ready = stop_fd_ >= 0;
+        for (auto &loop : loops_) {
+            loop->epoll_fd = ready ? ::epoll_create1(EPOLL_CLOEXEC) : -1;
+            ready = loop->epoll_fd >= 0;
+
+            epoll_event listen_event{};
+            listen_event.events = EPOLLIN | EPOLLEXCLUSIVE;
+            listen_event.data.fd = listen_fd_;
+            epoll_event stop_event{};
+            stop_event.events = EPOLLIN;
+            stop_event.data.fd = stop_fd_;
+            ready = ready &&
+                    ::epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, listen_fd_,
+                                &listen_event) == 0 &&
+                    ::epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, stop_fd_,
+                                &stop_event) == 0;
+        }
+        if (!ready) {
+            close_descriptors();
+            throw std::runtime_error("Failed to set up the server event loops");
+        }
+        for (auto &loop : loops_) {
+            Loop *raw = loop.get();
+            loop->thread = std::thread([this, raw]() { run(*raw); });
+        }
+    }
+
+    /**
+     * @brief Stop the event loops, closing every connection
+     *
+     * Requests already executed are answered only as far as the sockets took
+     * their responses.
+     */
+    void stop() {
+        if (stop_fd_ >= 0) {
+            uint64_t one = 1;
+            ssize_t written = ::write(stop_fd_, &one, sizeof(one));
+            (void)written;
+        }
+        for (auto &loop : loops_) {
+            if (loop->thread.joinable()) {
+                loop->thread.join();
+            }
+        }
+        close_descriptors();
+    }
+
+    /**
+     * @brief Get the number of requests executed so far
+     * @return Request count over all loops
+     */
+    size_t request_count() const {
+        size_t count = 0;
+        for (const auto &loop : loops_) {
+            count += loop->requests.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+};
+
+} // namespace server
@@ -0,0 +1,239 @@
+#include "Client.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Log-linear latency histogram (about 6% resolution)
+ *
+ * Values below 16 get their own bucket; above, each power of two is split
+ * into 16 buckets.
+ */
+class LatencyHistogram {
+private:
+    static constexpr size_t SUB_BUCKETS = 16;
+    std::vector<uint64_t> buckets_; // Sample count per bucket
+    uint64_t count_;                // Total samples
+
+    static size_t bucket_of(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        unsigned top = 63 - static_cast<unsigned>(std::countl_zero(value));
+        uint64_t sub = (value >> (top - 4)) & (SUB_BUCKETS - 1);
+        return (top - 3) * SUB_BUCKETS + static_cast<size_t>(sub);
+    }
+
+    static uint64_t lower_bound_of(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        unsigned top = static_cast<unsigned>(bucket / SUB_BUCKETS) + 3;
+        uint64_t sub = bucket % SUB_BUCKETS;
+        return (uint64_t(1) << top) | (sub << (top - 4));
+    }
+
+public:
+    LatencyHistogram() : buckets_(61 * SUB_BUCKETS, 0), count_(0) {}
+
+    void record(uint64_t value) {
+        ++buckets_[bucket_of(value)];
+        ++count_;
+    }
+
+    void merge(const LatencyHistogram &other) {
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            buckets_[i] += other.buckets_[i];
+        }
+        count_ += other.count_;
+    }
+
+    uint64_t count() const { return count_; }
+
+    /**
+     * @brief Get a percentile
+     * @param fraction Percentile as a fraction (0.99 for p99)
+     * @return Lower bound of the bucket holding the percentile
+     */
+    uint64_t percentile(double fraction) const {
+        uint64_t rank = static_cast<uint64_t>(fraction * count_);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            seen += buckets_[i];
+            if (seen > rank) {
+                return lower_bound_of(i);
+            }
+        }
+        return 0;
+    }
+};
+
+// Global parameters
+std::string ENDPOINT;
+size_t CONNECTIONS = 1;
+size_t PIPELINE_DEPTH = 16;
+size_t DURATION_S = 10;
+size_t KEY_COUNT = 100000;
+size_t READ_PERCENT = 50;
+size_t SCAN_PERCENT = 0;
+size_t VALUE_SIZE = 100;
+uint32_t SCAN_LIMIT = 10;
+
+/**
+ * @brief Client connection body
+ *
+ * Keeps up to PIPELINE_DEPTH requests in flight. Once half of them have been
+ * answered, the window is refilled with a single flush, so requests reach the
+ * server in batches.
+ */
+void connection_loop(size_t id, const std::atomic<bool> &running,
+                     LatencyHistogram &latencies, uint64_t &errors) {
+    server::Client client(ENDPOINT);
+    std::mt19937_64 random(id + 1);
+    std::uniform_int_distribution<size_t> key_dist(0, KEY_COUNT - 1);
+    std::uniform_int_distribution<size_t> op_dist(0, 99);
+    const std::string value(VALUE_SIZE, 'v');
+    std::deque<std::chrono::steady_clock::time_point> issued;
+    server::Response response;
+
+    const size_t refill_at = std::max<size_t>(1, PIPELINE_DEPTH / 2);
+    while (running.load(std::memory_order_relaxed) || !issued.empty()) {
+        if (running.load(std::memory_order_relaxed) &&
+            client.outstanding() < refill_at) {
+            auto now = std::chrono::steady_clock::now();
+            while (client.outstanding() < PIPELINE_DEPTH) {
+                std::string key = "key:" + std::to_string(key_dist(random));
+                size_t op = op_dist(random);
+                if (op < READ_PERCENT) {
+                    client.send_read(key);
+                } else if (op < READ_PERCENT + SCAN_PERCENT) {
+                    client.send_scan(key, SCAN_LIMIT);
+                } else {
+                    client.send_write(key, value);
+                }
+                issued.push_back(now);
+            }
+            if (client.flush() != Status::SUCCESS) {
+                ++errors;
+                return;
+            }
+        }
+        if (client.receive(response) != Status::SUCCESS) {
+            ++errors;
+            return;
+        }
+        if (response.status == Status::ERROR) {
+            ++errors;
+        }
+        latencies.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - issued.front())
+                .count()));
+        issued.pop_front();
+    }
+}
+
+void print_usage(const char *program_name) {
+    std::cout << "Usage: " << program_name
+              << " <endpoint> [connections] [pipeline_depth] [duration_s] "
+                 "[key_count] [read_percent] [scan_percent] [value_size] "
+                 "[scan_limit]"
+              << std::endl;
+    std::cout << "  endpoint: unix:<socket_path> or tcp:<port>" << std::endl;
+    std::cout << "  connections: Client threads, one connection each "
+                 "(default: 1)"
+              << std::endl;
+    std::cout << "  pipeline_depth: Requests in flight per connection "
+                 "(default: 16)"
+              << std::endl;
+    std::cout << "  duration_s: Run time in seconds (default: 10)"
+              << std::endl;
+    std::cout << "  key_count: Uniformly drawn keys key:0..key:N-1 "
+                 "(default: 100000)"
+              << std::endl;
+    std::cout << "  read_percent / scan_percent: Request mix, the rest are "
+                 "writes (default: 50 / 0)"
+              << std::endl;
+    std::cout << "  value_size: Bytes per written value (default: 100)"
+              << std::endl;
+    std::cout << "  scan_limit: Pairs per scan (default: 10)" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    ENDPOINT = argv[1];
+    try {
+        size_t *parameters[] = {&CONNECTIONS,  &PIPELINE_DEPTH, &DURATION_S,
+                                &KEY_COUNT,    &READ_PERCENT,   &SCAN_PERCENT,
+                                &VALUE_SIZE};
+        for (int i = 2; i < argc && i < 9; ++i) {
+            *parameters[i - 2] = std::stoull(argv[i]);
+        }
+        if (argc >= 10) {
+            SCAN_LIMIT = static_cast<uint32_t>(std::stoul(argv[9]));
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: Invalid numeric argument" << std::endl;
+        return 1;
+    }
+    if (CONNECTIONS == 0 || PIPELINE_DEPTH == 0 || KEY_COUNT == 0 ||
+        READ_PERCENT + SCAN_PERCENT > 100) {
+        std::cerr << "Error: connections, pipeline_depth and key_count must be "
+                     "positive, and read_percent + scan_percent at most 100"
+                  << std::endl;
+        return 1;
+    }
+
+    std::atomic<bool> running(true);
+    std::vector<LatencyHistogram> latencies(CONNECTIONS);
+    std::vector<uint64_t> errors(CONNECTIONS, 0);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < CONNECTIONS; ++i) {
+        threads.emplace_back([i, &running, &latencies, &errors]() {
+            try {
+                connection_loop(i, running, latencies[i], errors[i]);
+            } catch (const std::exception &e) {
+                std::cerr << "Connection " << i << ": " << e.what()
+                          << std::endl;
+                ++errors[i];
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(DURATION_S));
+    running.store(false, std::memory_order_relaxed);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    LatencyHistogram total;
+    uint64_t total_errors = 0;
+    for (size_t i = 0; i < CONNECTIONS; ++i) {
+        total.merge(latencies[i]);
+        total_errors += errors[i];
+    }
+    std::cout << "Requests: " << total.count() << " in " << std::fixed
+              << std::setprecision(2) << elapsed << "s ("
+              << static_cast<double>(total.count()) / elapsed << " req/s)"
+              << std::endl;
+    std::cout << "Latency (us): p50 " << total.percentile(0.5) / 1000.0
+              << ", p99 " << total.percentile(0.99) / 1000.0 << ", p99.9 "
+              << total.percentile(0.999) / 1000.0 << std::endl;
+    std::cout << "Errors: " << total_errors << std::endl;
+    return total_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,344 @@
+#include "Server.h"
+#include "kvstorage/HardRepartitioningKeyValueStorage.h"
+#include "kvstorage/LockStrippingKeyValueStorage.h"
+#include "kvstorage/RangePartitionedKeyValueStorage.h"
+#include "kvstorage/SoftRepartitioningKeyValueStorage.h"
+#include "kvstorage/threaded/SoftThreadedRepartitioningKeyValueStorage.h"
+#include "kvstorage/threaded/HardThreadedRepartitioningKeyValueStorage.h"
+#include "storage/TkrzwTreeStorageEngine.h"
+#include "storage/TkrzwHashStorageEngine.h"
+#include "storage/LmdbStorageEngine.h"
+#include "storage/LevelDBStorageEngine.h"
+#include "storage/MapStorageEngine.h"
+#include "storage/TbbStorageEngine.h"
+#include "storage/TieredStorageEngine.h"
+#include "keystorage/TkrzwTreeKeyStorage.h"
+#include "keystorage/TkrzwHashKeyStorage.h"
+#include "keystorage/LmdbKeyStorage.h"
+#include "keystorage/AbslBtreeKeyStorage.h"
+#include "keystorage/SliceBtreeKeyStorage.h"
+#include "keystorage/LevelDBKeyStorage.h"
+#include "keystorage/FingerprintKeyStorage.h"
+#include <cctype>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Global parameters
+std::string ENDPOINT;
+size_t PARTITION_COUNT = 4;
+size_t LOOP_COUNT = 1;
+std::string STORAGE_TYPE = "soft";         // Default to soft repartitioning
+std::string STORAGE_ENGINE = "tkrzw_tree"; // Default to TkrzwTreeStorageEngine
+std::string KEY_MAP = "absl"; // Ordered key map of the map and tbb engines
+bool STORAGE_SYNC = false;
+std::vector<std::string> STORAGE_PATHS = {
+    "/tmp"}; // Default paths for embedded database files
+std::chrono::milliseconds TRACKING_DURATION(
+    100); // Duration to track key accesses before repartitioning
+std::chrono::milliseconds
+    REPARTITION_INTERVAL(5000); // Interval between repartitioning cycles
+std::string PLAN_FILE;          // Placement checkpoint (empty: none)
+
+/**
+ * @brief Construct a storage with the constructor its type offers
+ */
+template <typename StorageType> StorageType make_storage() {
+    if constexpr (std::is_constructible_v<
+                      StorageType, size_t, std::hash<std::string>,
+                      std::chrono::milliseconds, std::chrono::milliseconds,
+                      std::vector<std::string>>) {
+        // Repartitioning storages, threaded or not
+        return StorageType(PARTITION_COUNT, std::hash<std::string>(),
+                           TRACKING_DURATION, REPARTITION_INTERVAL,
+                           STORAGE_PATHS);
+    } else if constexpr (std::is_constructible_v<
+                             StorageType, size_t,
+                             std::optional<std::chrono::milliseconds>,
+                             std::vector<std::string>>) {
+        return StorageType(
+            PARTITION_COUNT,
+            std::optional<std::chrono::milliseconds>(REPARTITION_INTERVAL),
+            STORAGE_PATHS);
+    } else if constexpr (std::is_constructible_v<StorageType, size_t,
+                                                 std::hash<std::string>,
+                                                 std::vector<std::string>>) {
+        return StorageType(PARTITION_COUNT, std::hash<std::string>(),
+                           STORAGE_PATHS);
+    } else {
+        return StorageType(0, STORAGE_PATHS[0]);
+    }
+}
+
+/**
+ * @brief Serve a storage until SIGINT or SIGTERM
+ */
+template <typename StorageType> int serve(const std::string &storage_name) {
+    // Block the stop signals before any thread starts, so only sigwait()
+    // below receives them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    StorageType storage = make_storage<StorageType>();
+    if constexpr (requires { storage.load_plan(PLAN_FILE); }) {
+        if (!PLAN_FILE.empty()) {
+            Status status = storage.load_plan(PLAN_FILE);
+            std::cout << "Placement plan " << PLAN_FILE << ": "
+                      << (status == Status::SUCCESS     ? "loaded"
+                          : status == Status::NOT_FOUND ? "not found"
+                                                        : "invalid, ignored")
+                      << std::endl;
+        }
+    }
+
+    server::Server<StorageType> server(storage, ENDPOINT, LOOP_COUNT);
+    try {
+        server.start();
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << "Serving " << storage_name << " (" << PARTITION_COUNT
+              << " partitions) on " << ENDPOINT << " with " << LOOP_COUNT
+              << " event loop(s)" << std::endl;
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    server.stop();
+    std::cout << "Stopped after " << server.request_count() << " requests"
+              << std::endl;
+
+    if constexpr (requires { storage.save_plan(PLAN_FILE); }) {
+        if (!PLAN_FILE.empty()) {
+            Status status = storage.save_plan(PLAN_FILE);
+            std::cout << "Placement plan " << PLAN_FILE << ": "
+                      << (status == Status::SUCCESS ? "saved" : "save failed")
+                      << std::endl;
+        }
+    }
+    return 0;
+}
+
+/** Hot partitions in memory (std::map), cold partitions in LMDB. */
+template <bool SYNC>
+using MapLmdbTieredStorageEngine =
+    TieredStorageEngine<MapStorageEngine, LmdbStorageEngine, SYNC>;
+
+/** Hot partitions in memory (std::map), cold partitions in LevelDB. */
+template <bool SYNC>
+using MapLevelDBTieredStorageEngine =
+    TieredStorageEngine<MapStorageEngine, LevelDBStorageEngine, SYNC>;
+
+template <template <bool> class Engine, bool StorageSync,
+          template <typename> class OrderedKeyStorageType>
+int serve_with_engine(const char *engine_name) {
+    if (STORAGE_TYPE == "hard") {
+        return serve<HardRepartitioningKeyValueStorage<Engine, StorageSync,
+                                                       OrderedKeyStorageType>>(
+            "HardRepartitioningKeyValueStorage");
+    } else if (STORAGE_TYPE == "hard_fingerprint") {
+        return serve<HardRepartitioningKeyValueStorage<Engine, StorageSync,
+                                                       FingerprintKeyStorage>>(
+            "HardRepartitioningKeyValueStorage<FingerprintKeyStorage>");
+    } else if (STORAGE_TYPE == "soft") {
+        return serve<SoftRepartitioningKeyValueStorage<
+            Engine, StorageSync, OrderedKeyStorageType,
+            OrderedKeyStorageType>>("SoftRepartitioningKeyValueStorage");
+    } else if (STORAGE_TYPE == "threaded") {
+        return serve<SoftThreadedRepartitioningKeyValueStorage<
+            Engine, StorageSync, OrderedKeyStorageType>>(
+            "SoftThreadedRepartitioningKeyValueStorage");
+    } else if (STORAGE_TYPE == "hard_threaded") {
+        return serve<HardThreadedRepartitioningKeyValueStorage<
+            Engine, StorageSync, OrderedKeyStorageType>>(
+            "HardThreadedRepartitioningKeyValueStorage");
+    } else if (STORAGE_TYPE == "engine") {
+        return serve<Engine<StorageSync>>(engine_name);
+    } else if (STORAGE_TYPE == "lock_stripping") {
+        return serve<LockStrippingKeyValueStorage<Engine, StorageSync>>(
+            "LockStrippingKeyValueStorage");
+    } else {
+        return serve<RangePartitionedKeyValueStorage<Engine, StorageSync>>(
+            "RangePartitionedKeyValueStorage");
+    }
+}
+
+template <template <bool> class Engine,
+          template <typename> class OrderedKeyStorageType>
+int serve_with_cli_sync(const char *engine_name) {
+    return STORAGE_SYNC
+               ? serve_with_engine<Engine, true, OrderedKeyStorageType>(
+                     engine_name)
+               : serve_with_engine<Engine, false, OrderedKeyStorageType>(
+                     engine_name);
+}
+
+void print_usage(const char *program_name) {
+    std::cout << "Usage: " << program_name
+              << " <endpoint> [partition_count] [loops] [storage_type] "
+                 "[storage_engine] [storage_paths] [repartition_interval_ms] "
+                 "[sync] [plan_file] [key_map]"
+              << std::endl;
+    std::cout << "  endpoint: unix:<socket_path> or tcp:<port> (loopback only)"
+              << std::endl;
+    std::cout << "  partition_count: Number of partitions (default: 4)"
+              << std::endl;
+    std::cout << "  loops: Number of event loop threads (default: 1)"
+              << std::endl;
+    std::cout << "  storage_type: 'hard', 'hard_fingerprint', 'soft', "
+                 "'threaded', 'hard_threaded', 'engine', 'lock_stripping' or "
+                 "'range' (default: soft)"
+              << std::endl;
+    std::cout << "  storage_engine: 'tkrzw_tree', 'tkrzw_hash', 'lmdb', "
+                 "'leveldb', 'map', 'tbb', 'tiered_lmdb' or 'tiered_leveldb' "
+                 "(default: tkrzw_tree)"
+              << std::endl;
+    std::cout << "  storage_paths: Comma-separated paths for database files "
+                 "(default: /tmp)"
+              << std::endl;
+    std::cout << "  repartition_interval_ms: Interval between repartitioning "
+                 "cycles (default: 5000, 0 disables)"
+              << std::endl;
+    std::cout << "  sync: 'true' or 'false' (default: false)" << std::endl;
+    std::cout << "  plan_file: Placement plan loaded at start and saved on "
+                 "shutdown (default: none)"
+              << std::endl;
+    std::cout << "  key_map: Ordered key map of the map and tbb engines, "
+                 "'absl' or 'slice' (default: absl)"
+              << std::endl;
+    std::cout << std::endl;
+    std::cout << "Stops on SIGINT or SIGTERM." << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    ENDPOINT = argv[1];
+
+    try {
+        if (argc >= 3) {
+            PARTITION_COUNT = std::stoull(argv[2]);
+        }
+        if (argc >= 4) {
+            LOOP_COUNT = std::stoull(argv[3]);
+        }
+        if (argc >= 8) {
+            int64_t interval_ms = std::stoll(argv[7]);
+            REPARTITION_INTERVAL = std::chrono::milliseconds(interval_ms);
+            if (interval_ms == 0) {
+                TRACKING_DURATION = std::chrono::milliseconds(0);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: Invalid numeric argument" << std::endl;
+        return 1;
+    }
+    if (PARTITION_COUNT == 0 || LOOP_COUNT == 0) {
+        std::cerr << "Error: partition_count and loops must be greater than 0"
+                  << std::endl;
+        return 1;
+    }
+
+    if (argc >= 5) {
+        STORAGE_TYPE = argv[4];
+        if (STORAGE_TYPE != "hard" && STORAGE_TYPE != "hard_fingerprint" &&
+            STORAGE_TYPE != "soft" && STORAGE_TYPE != "threaded" &&
+            STORAGE_TYPE != "hard_threaded" && STORAGE_TYPE != "engine" &&
+            STORAGE_TYPE != "lock_stripping" && STORAGE_TYPE != "range") {
+            std::cerr << "Error: invalid storage_type: " << STORAGE_TYPE
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (argc >= 6) {
+        STORAGE_ENGINE = argv[5];
+    }
+    if (argc >= 7) {
+        STORAGE_PATHS.clear();
+        std::stringstream ss(argv[6]);
+        std::string path;
+        while (std::getline(ss, path, ',')) {
+            if (!path.empty()) {
+                STORAGE_PATHS.push_back(path);
+            }
+        }
+        if (STORAGE_PATHS.empty()) {
+            STORAGE_PATHS = {"/tmp"};
+        }
+    }
+    if (argc >= 9) {
+        std::string sync_arg = argv[8];
+        for (auto &ch : sync_arg) {
+            ch =
+                static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        }
+        STORAGE_SYNC = sync_arg == "1" || sync_arg == "true" ||
+                       sync_arg == "on" || sync_arg == "yes";
+    }
+    if (argc >= 10) {
+        PLAN_FILE = argv[9];
+    }
+    if (argc >= 11) {
+        KEY_MAP = argv[10];
+        if (KEY_MAP != "absl" && KEY_MAP != "slice") {
+            std::cerr << "Error: invalid key_map: " << KEY_MAP << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        if (STORAGE_ENGINE == "tkrzw_tree") {
+            return serve_with_cli_sync<TkrzwTreeStorageEngine,
+                                       TkrzwTreeKeyStorage>(
+                "TkrzwTreeStorageEngine");
+        } else if (STORAGE_ENGINE == "tkrzw_hash") {
+            return serve_with_cli_sync<TkrzwHashStorageEngine,
+                                       TkrzwHashKeyStorage>(
+                "TkrzwHashStorageEngine");
+        } else if (STORAGE_ENGINE == "lmdb") {
+            return serve_with_cli_sync<LmdbStorageEngine, LmdbKeyStorage>(
+                "LmdbStorageEngine");
+        } else if (STORAGE_ENGINE == "leveldb") {
+            return serve_with_cli_sync<LevelDBStorageEngine,
+                                       LevelDBKeyStorage>(
+                "LevelDBStorageEngine");
+        } else if (STORAGE_ENGINE == "map" && KEY_MAP == "slice") {
+            return serve_with_cli_sync<MapStorageEngine, SliceBtreeKeyStorage>(
+                "MapStorageEngine");
+        } else if (STORAGE_ENGINE == "map") {
+            return serve_with_cli_sync<MapStorageEngine, AbslBtreeKeyStorage>(
+                "MapStorageEngine");
+        } else if (STORAGE_ENGINE == "tbb" && KEY_MAP == "slice") {
+            return serve_with_cli_sync<TbbStorageEngine, SliceBtreeKeyStorage>(
+                "TbbStorageEngine");
+        } else if (STORAGE_ENGINE == "tbb") {
+            return serve_with_cli_sync<TbbStorageEngine, AbslBtreeKeyStorage>(
+                "TbbStorageEngine");
+        } else if (STORAGE_ENGINE == "tiered_lmdb") {
+            return serve_with_cli_sync<MapLmdbTieredStorageEngine,
+                                       LmdbKeyStorage>(
+                "TieredStorageEngine<Map, Lmdb>");
+        } else if (STORAGE_ENGINE == "tiered_leveldb") {
+            return serve_with_cli_sync<MapLevelDBTieredStorageEngine,
+                                       LevelDBKeyStorage>(
+                "TieredStorageEngine<Map, LevelDB>");
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    std::cerr << "Error: invalid storage_engine: " << STORAGE_ENGINE
+              << std::endl;
+    return 1;
+}
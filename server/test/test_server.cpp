@@ -0,0 +1,217 @@
+#include "../Client.h"
+#include "../Protocol.h"
+#include "../Server.h"
+#include "../../kvstorage/LockStrippingKeyValueStorage.h"
+#include "../../storage/MapStorageEngine.h"
+#include "../../utils/test_assertions.h"
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Test result tracking
+int tests_passed = 0;
+int tests_failed = 0;
+
+using Storage = LockStrippingKeyValueStorage<MapStorageEngine, true>;
+
+const std::string ENDPOINT = "unix:/tmp/repart_kv_test_server.sock";
+
+void testProtocolRoundTrip() {
+    TEST("protocol_round_trip")
+    std::string bytes;
+    server::encode_write(bytes, "key", std::string("v\0lue", 5));
+    server::encode_scan(bytes, "a", 7);
+
+    server::Request request;
+    size_t consumed = 0;
+    ASSERT_TRUE(server::decode_request(bytes, request, consumed) ==
+                server::DecodeResult::FRAME);
+    ASSERT_TRUE(request.opcode == server::Opcode::WRITE);
+    ASSERT_STR_EQ("key", std::string(request.key));
+    ASSERT_EQ(5, request.value.size());
+    std::string_view rest = std::string_view(bytes).substr(consumed);
+    ASSERT_TRUE(server::decode_request(rest, request, consumed) ==
+                server::DecodeResult::FRAME);
+    ASSERT_TRUE(request.opcode == server::Opcode::SCAN);
+    ASSERT_EQ(7, request.limit);
+
+    // Every strict prefix of a frame is incomplete
+    for (size_t size = 0; size < consumed; ++size) {
+        ASSERT_TRUE(server::decode_request(rest.substr(0, size), request,
+                                           consumed) ==
+                    server::DecodeResult::INCOMPLETE);
+    }
+
+    std::string reply;
+    server::encode_scan_response(reply, Status::SUCCESS,
+                                 {{"a", "1"}, {"b", "2"}});
+    server::Response response;
+    ASSERT_TRUE(server::decode_response(reply, response, consumed) ==
+                server::DecodeResult::FRAME);
+    ASSERT_EQ(2, response.results.size());
+    ASSERT_STR_EQ("b", response.results[1].first);
+
+    // Unknown opcode
+    std::string invalid("\x02\x00\x00\x00\x09\x00", 6);
+    ASSERT_TRUE(server::decode_request(invalid, request, consumed) ==
+                server::DecodeResult::INVALID);
+    END_TEST("protocol_round_trip")
+}
+
+void testPipelinedRequests() {
+    TEST("pipelined_requests")
+    Storage storage(4);
+    server::Server<Storage> server(storage, ENDPOINT, 2);
+    server.start();
+
+    server::Client client(ENDPOINT);
+    const size_t count = 1000;
+    for (size_t i = 0; i < count; ++i) {
+        client.send_write("key:" + std::to_string(1000 + i),
+                          "value:" + std::to_string(i));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        client.send_read("key:" + std::to_string(1000 + i));
+    }
+    client.send_read("missing");
+    client.send_scan("key:1500", 3);
+    ASSERT_STATUS_EQ(Status::SUCCESS, client.flush());
+    ASSERT_EQ(2 * count + 2, client.outstanding());
+
+    server::Response response;
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_STATUS_EQ(Status::SUCCESS, client.receive(response));
+        ASSERT_TRUE(response.opcode == server::Opcode::WRITE);
+        ASSERT_STATUS_EQ(Status::SUCCESS, response.status);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_STATUS_EQ(Status::SUCCESS, client.receive(response));
+        ASSERT_TRUE(response.opcode == server::Opcode::READ);
+        ASSERT_STR_EQ("value:" + std::to_string(i), response.value);
+    }
+    ASSERT_STATUS_EQ(Status::SUCCESS, client.receive(response));
+    ASSERT_STATUS_EQ(Status::NOT_FOUND, response.status);
+    ASSERT_STATUS_EQ(Status::SUCCESS, client.receive(response));
+    ASSERT_TRUE(response.opcode == server::Opcode::SCAN);
+    ASSERT_EQ(3, response.results.size());
+    ASSERT_STR_EQ("key:1500", response.results[0].first);
+    ASSERT_STR_EQ("key:1502", response.results[2].first);
+    ASSERT_EQ(0, client.outstanding());
+    ASSERT_EQ(2 * count + 2, server.request_count());
+
+    // Blocking calls on the same connection
+    std::string value;
+    ASSERT_STATUS_EQ(Status::SUCCESS, client.write("single", "one"));
+    ASSERT_STATUS_EQ(Status::SUCCESS, client.read("single", value));
+    ASSERT_STR_EQ("one", value);
+    END_TEST("pipelined_requests")
+}
+
+void testBackpressure() {
+    TEST("backpressure")
+    Storage storage(4);
+    server::Server<Storage> server(storage, ENDPOINT, 1);
+    server.start();
+
+    // Far more response bytes than the socket buffers and the server's
+    // output cap hold, all requested before reading any response
+    server::Client client(ENDPOINT);
+    const std::string value(4096, 'x');
+    ASSERT_STATUS_EQ(Status::SUCCESS, client.write("big", value));
+    const size_t count = 5000;
+    for (size_t i = 0; i < count; ++i) {
+        client.send_read("big");
+    }
+    ASSERT_STATUS_EQ(Status::SUCCESS, client.flush());
+    server::Response response;
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_STATUS_EQ(Status::SUCCESS, client.receive(response));
+        ASSERT_EQ(value.size(), response.value.size());
+    }
+    END_TEST("backpressure")
+}
+
+void testConcurrentClients() {
+    TEST("concurrent_clients")
+    Storage storage(4);
+    server::Server<Storage> server(storage, ENDPOINT, 4);
+    server.start();
+
+    const size_t client_count = 8;
+    const size_t count = 500;
+    std::vector<std::thread> threads;
+    std::vector<size_t> failures(client_count, 0);
+    for (size_t c = 0; c < client_count; ++c) {
+        threads.emplace_back([c, count, &failures]() {
+            server::Client client(ENDPOINT);
+            const std::string prefix = std::to_string(c) + ":";
+            for (size_t i = 0; i < count; ++i) {
+                client.send_write(prefix + std::to_string(i),
+                                  std::to_string(i));
+                client.send_read(prefix + std::to_string(i));
+            }
+            server::Response response;
+            for (size_t i = 0; i < count; ++i) {
+                bool ok = client.receive(response) == Status::SUCCESS &&
+                          response.status == Status::SUCCESS &&
+                          client.receive(response) == Status::SUCCESS &&
+                          response.value == std::to_string(i);
+                failures[c] += ok ? 0 : 1;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (size_t c = 0; c < client_count; ++c) {
+        ASSERT_EQ(0, failures[c]);
+    }
+    ASSERT_EQ(2 * client_count * count, server.request_count());
+    END_TEST("concurrent_clients")
+}
+
+void testMalformedFrame() {
+    TEST("malformed_frame")
+    Storage storage(4);
+    server::Server<Storage> server(storage, ENDPOINT, 1);
+    server.start();
+
+    int fd = server::Endpoint(ENDPOINT).connect();
+    // Frame length over MAX_FRAME_SIZE
+    const char frame[] = {'\xff', '\xff', '\xff', '\xff', '\x00'};
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(frame)),
+              ::send(fd, frame, sizeof(frame), MSG_NOSIGNAL));
+    char byte;
+    ASSERT_EQ(0, ::recv(fd, &byte, 1, 0)); // Closed by the server
+    ::close(fd);
+
+    // The server keeps serving other connections
+    server::Client client(ENDPOINT);
+    ASSERT_STATUS_EQ(Status::SUCCESS, client.write("key", "value"));
+    END_TEST("malformed_frame")
+}
+
+int main() {
+    std::vector<std::pair<std::string, TestFunction>> tests = {
+        {"protocol_round_trip", testProtocolRoundTrip},
+        {"pipelined_requests", testPipelinedRequests},
+        {"backpressure", testBackpressure},
+        {"concurrent_clients", testConcurrentClients},
+        {"malformed_frame", testMalformedFrame}};
+
+    run_test_suite("Server", tests);
+
+    std::cout << "Tests passed: " << tests_passed << std::endl;
+    std::cout << "Tests failed: " << tests_failed << std::endl;
+
+    if (tests_failed == 0) {
+        std::cout << "✓ All server tests passed!" << std::endl;
+        return 0;
+    } else {
+        std::cout << "✗ Some server tests failed!" << std::endl;
+        return 1;
+    }
+}
@@ -8,8 +8,11 @@
 #include <filesystem>
 #include <iomanip>
 #include <sstream>
+#include <map>
 #include <memory>
+#include <tuple>
 #include "workload/Workload.h"
+#include "workload/RequestLog.h"
 #if __has_include("request/request_generator.h")
 #include "request/request_generator.h"
 #elif __has_include("../../loadgen/src/request/request_generator.h")
@@ -24,35 +27,47 @@
 #endif
 #include "kvstorage/HardRepartitioningKeyValueStorage.h"
 #include "kvstorage/LockStrippingKeyValueStorage.h"
+#include "kvstorage/RangePartitionedKeyValueStorage.h"
 #include "kvstorage/SoftRepartitioningKeyValueStorage.h"
 #include "kvstorage/threaded/SoftThreadedRepartitioningKeyValueStorage.h"
 #include "kvstorage/threaded/HardThreadedRepartitioningKeyValueStorage.h"
 #include "storage/TkrzwTreeStorageEngine.h"
 #include "storage/TkrzwHashStorageEngine.h"
 #include "storage/LmdbStorageEngine.h"
+#include "storage/EngineTuning.h"
+#include "storage/EnginePersistence.h"
 #include "storage/LevelDBStorageEngine.h"
+#include "storage/LevelDBTuning.h"
+#include "storage/CompactionScheduler.h"
 #include "storage/MapStorageEngine.h"
 #include "storage/TbbStorageEngine.h"
+#include "storage/TieredStorageEngine.h"
+#include "storage/CachedStorageEngine.h"
 #include "keystorage/TkrzwTreeKeyStorage.h"
 #include "keystorage/TkrzwHashKeyStorage.h"
 #include "keystorage/LmdbKeyStorage.h"
 #include "keystorage/AbslBtreeKeyStorage.h"
+#include "keystorage/SliceBtreeKeyStorage.h"
 #include "keystorage/LevelDBKeyStorage.h"
-#include "keystorage/UnorderedDenseKeyStorage.h"
+#include "keystorage/FingerprintKeyStorage.h"
 #include "repart_kv_api.h"
 #include <cassert>
 #include <cctype>
 #include <barrier>
 #include <random>
 #include <set>
+#include <algorithm>
 
 // Global parameters
 size_t PARTITION_COUNT = 4;
 size_t TEST_WORKERS = 1;
 std::string STORAGE_TYPE = "soft";         // Default to soft repartitioning
 std::string STORAGE_ENGINE = "tkrzw_tree"; // Default to TkrzwTreeStorageEngine
+std::string KEY_MAP = "absl"; // Ordered key map of the map and tbb engines
 /** When true, storage engines use \c StorageEngine<true> (hard sync). */
 bool STORAGE_SYNC = false;
+/** When true, writes go through a group-commit write-ahead log instead. */
+bool STORAGE_WAL = false;
 std::vector<std::string> STORAGE_PATHS = {
     "/tmp"}; // Default paths for embedded database files
 std::string LOADGEN_CONFIG_FILE;
@@ -71,6 +86,46 @@ size_t *TIMES_INDEX = nullptr;
 
 long MAX_DURATION = 20; // Maximum duration of the experiment in seconds
 
+// Admission control for the threaded storages (all limits off by default)
+AdmissionPolicy ADMISSION_POLICY;
+std::chrono::microseconds
+    ADMISSION_RETRY_AFTER(100); // Client back-off after a BUSY reply
+std::atomic_size_t BUSY_RETRIES(0); // Operations retried after a BUSY reply
+
+// Placement checkpoint of the repartitioning storages: loaded before the
+// preload and saved after the run (empty: disabled)
+std::string PLAN_FILE;
+
+// Persistent engine store: partition engines reopen the data of a previous
+// run with the same name and the key map is rebuilt from it (empty: off)
+std::string ENGINE_STORE;
+
+// Online checkpoint taken while the workload runs (see kvstorage/Checkpoint.h)
+std::string CHECKPOINT_DIR; // Checkpoint directory (empty: off)
+std::chrono::milliseconds CHECKPOINT_AFTER(0); // Delay after the preload
+CheckpointOptions CHECKPOINT_OPTIONS;          // Image write budget
+
+// Hot keys copied into other partitions by hard_threaded
+ReplicationPolicy REPLICATION_POLICY;
+
+// Request recording and replay (see workload/RequestLog.h)
+std::string RECORD_FILE; // Log to record the run's requests to (empty: off)
+std::string REPLAY_FILE; // Log to replay instead of the generated requests
+double REPLAY_SPEED = 1.0; // Replay pacing: 1 original, 2 twice as fast, 0
+                           // as fast as possible
+std::unique_ptr<workload::RequestRecorder> RECORDER; // Active recorder
+std::vector<std::vector<workload::RecordedRequest>>
+    REPLAY_REQUESTS; // Requests to replay, per client thread
+
+// Engine tuning: [engine.*] sections of the config, then the leveldb and
+// lmdb arguments (see storage/EngineTuning.h). Passed to the storage when it
+// is created.
+EngineProfile ENGINE_PROFILE; // Tuning of every engine and key storage
+std::string ENGINE_PROFILE_TAG; // Profile name or digest (empty: defaults)
+
+// LevelDB compaction (see storage/CompactionScheduler.h)
+CompactionScheduler::Settings COMPACTION; // Cross-partition compaction I/O
+
 bool *RUNNING = nullptr;
 /**
  * @brief Write operation latency data (start,end pairs) to CSV after experiment
@@ -230,23 +285,58 @@ template <typename T>
 auto try_construct_repartitioning(T *, size_t partition_count,
                                   const std::vector<std::string> &paths)
     -> decltype(T(partition_count, std::hash<std::string>(), TRACKING_DURATION,
-                  REPARTITION_INTERVAL, paths)) {
+                  REPARTITION_INTERVAL, paths, ENGINE_PROFILE)) {
+    return T(partition_count, std::hash<std::string>(), TRACKING_DURATION,
+             REPARTITION_INTERVAL, paths, ENGINE_PROFILE);
+}
+
+template <typename T>
+auto try_construct_admission(T *, size_t partition_count,
+                             const std::vector<std::string> &paths)
+    -> decltype(T(partition_count, std::hash<std::string>(), TRACKING_DURATION,
+                  REPARTITION_INTERVAL, paths, ADMISSION_POLICY, 0,
+                  ENGINE_PROFILE)) {
+    return T(partition_count, std::hash<std::string>(), TRACKING_DURATION,
+             REPARTITION_INTERVAL, paths, ADMISSION_POLICY, 0, ENGINE_PROFILE);
+}
+
+template <typename T>
+auto try_construct_replication(T *, size_t partition_count,
+                               const std::vector<std::string> &paths)
+    -> decltype(T(partition_count, std::hash<std::string>(), TRACKING_DURATION,
+                  REPARTITION_INTERVAL, paths, ADMISSION_POLICY,
+                  REPLICATION_POLICY, 0, ENGINE_PROFILE)) {
     return T(partition_count, std::hash<std::string>(), TRACKING_DURATION,
-             REPARTITION_INTERVAL, paths);
+             REPARTITION_INTERVAL, paths, ADMISSION_POLICY, REPLICATION_POLICY,
+             0, ENGINE_PROFILE);
+}
+
+template <typename T>
+auto try_construct_range(T *, size_t partition_count,
+                         const std::vector<std::string> &paths)
+    -> decltype(T(partition_count,
+                  std::optional<std::chrono::milliseconds>(
+                      REPARTITION_INTERVAL),
+                  paths, RangeBalancePolicy(), ENGINE_PROFILE)) {
+    return T(partition_count,
+             std::optional<std::chrono::milliseconds>(REPARTITION_INTERVAL),
+             paths, RangeBalancePolicy(), ENGINE_PROFILE);
 }
 
 template <typename T>
 auto try_construct_partitioned(T *, size_t partition_count,
                                const std::vector<std::string> &paths)
-    -> decltype(T(partition_count, std::hash<std::string>(), paths)) {
-    return T(partition_count, std::hash<std::string>(), paths);
+    -> decltype(T(partition_count, std::hash<std::string>(), paths,
+                  ENGINE_PROFILE)) {
+    return T(partition_count, std::hash<std::string>(), paths, ENGINE_PROFILE);
 }
 
 template <typename T>
 auto try_construct_storage_engine(T *, size_t level,
                                   const std::vector<std::string> &paths)
     -> decltype(T(level, paths.empty() ? "/tmp" : paths[0])) {
-    return T(level, paths.empty() ? "/tmp" : paths[0]);
+    return make_engine<T>(level, paths.empty() ? "/tmp" : paths[0],
+                          ENGINE_PROFILE);
 }
 
 template <typename T> auto try_construct_default(T *) -> decltype(T()) {
@@ -359,10 +449,18 @@ void metrics_loop(const std::vector<size_t> &executed_counts,
     std::chrono::high_resolution_clock::time_point start_time =
         std::chrono::high_resolution_clock::now();
 
-    // Write CSV header
+    // Write CSV header; tuned engines add a column with their settings
+    const std::string engine_settings =
+        ENGINE_PROFILE_TAG.empty()
+            ? std::string()
+            : "," + EngineTuning::describe(ENGINE_PROFILE, STORAGE_ENGINE);
     file << "elapsed_time_ms,executed_count,memory_kb,disk_kb,Tracking,"
-            "Repartitioning"
-         << std::endl;
+            "Repartitioning";
+    if constexpr (requires { storage.repartition_stats(); }) {
+        file << ",Repartition_cycle,Edge_cut,Imbalance,Keys_reassigned,"
+                "Bytes_migrated,Prepare_ms,Partition_ms,Update_ms,Scan_fanout";
+    }
+    file << (engine_settings.empty() ? "" : ",Engine_profile") << std::endl;
 
     // Track previous tracking state to detect transitions
     bool prev_tracking_enabled = false;
@@ -412,7 +510,24 @@ void metrics_loop(const std::vector<size_t> &executed_counts,
              << format_with_separators(memory_kb) << ","
              << format_with_separators(disk_kb) << ","
              << (current_tracking_enabled ? 'o' : 'x') << ","
-             << repartitioning_status << std::endl;
+             << repartitioning_status;
+
+        // Quality and cost of the last repartitioning. The fractional
+        // columns are written plainly: format_with_separators() uses a
+        // decimal comma.
+        if constexpr (requires { storage.repartition_stats(); }) {
+            RepartitionStats stats = storage.repartition_stats();
+            auto ms = [](std::chrono::nanoseconds time) {
+                return std::chrono::duration<double, std::milli>(time).count();
+            };
+            file << "," << stats.cycle << "," << stats.edge_cut << ","
+                 << std::fixed << std::setprecision(3) << stats.imbalance
+                 << "," << stats.keys_reassigned << ","
+                 << stats.bytes_migrated << "," << ms(stats.prepare_time)
+                 << "," << ms(stats.partition_time) << ","
+                 << ms(stats.update_time) << "," << stats.scan_fanout;
+        }
+        file << engine_settings << std::endl;
 
         // Update previous tracking state
         prev_tracking_enabled = current_tracking_enabled;
@@ -427,12 +542,24 @@ void metrics_loop(const std::vector<size_t> &executed_counts,
     file.close();
 }
 
+/**
+ * @brief Back off after a BUSY reply before the operation is retried
+ */
+static void wait_after_busy() {
+    BUSY_RETRIES.fetch_add(1, std::memory_order_relaxed);
+    std::this_thread::sleep_for(ADMISSION_RETRY_AFTER);
+}
+
 template <typename StorageType>
 void execute_operation(const workload::Operation &op, StorageType &storage) {
     switch (op.type) {
         case workload::OperationType::READ: {
             std::string value;
             Status status = storage.read(op.key, value);
+            while (status == Status::BUSY) {
+                wait_after_busy();
+                status = storage.read(op.key, value);
+            }
             if (status != Status::SUCCESS) {
                 std::cerr << "Error: Failed to read key: " << op.key
                           << std::endl;
@@ -444,6 +571,10 @@ void execute_operation(const workload::Operation &op, StorageType &storage) {
             const std::string *value_ptr =
                 op.value.empty() ? &workload::DEFAULT_VALUE : &op.value;
             Status status = storage.write(op.key, *value_ptr);
+            while (status == Status::BUSY) {
+                wait_after_busy();
+                status = storage.write(op.key, *value_ptr);
+            }
             if (status != Status::SUCCESS) {
                 std::cerr << "Error: Failed to write key: " << op.key
                           << std::endl;
@@ -454,6 +585,11 @@ void execute_operation(const workload::Operation &op, StorageType &storage) {
         case workload::OperationType::SCAN: {
             std::vector<std::pair<std::string, std::string>> results;
             Status status = storage.scan(op.key, op.limit, results);
+            while (status == Status::BUSY) {
+                wait_after_busy();
+                results.clear();
+                status = storage.scan(op.key, op.limit, results);
+            }
             if (status != Status::SUCCESS) {
                 std::cerr << "Error: Failed to scan key: " << op.key
                           << std::endl;
@@ -502,28 +638,41 @@ template <typename StorageType>
 void worker_function(size_t worker_id, workload::RequestGenerator &generator,
                      StorageType &storage, std::vector<size_t> &executed_counts,
                      std::barrier<> &start_barrier) {
-    loadgen::types::Type type;
-    long key;
-    std::string value;
-    long scan_size;
-
-    if (generator.current_phase() ==
-        workload::RequestGenerator::Phase::LOADING) {
-        generator.skip_current_phase();
-    }
-
-    assert(generator.current_phase() ==
-           workload::RequestGenerator::Phase::OPERATIONS);
     std::vector<workload::Operation> operations;
-    workload::RequestGenerator::Phase phase =
-        generator.next(type, key, value, scan_size);
-    while (phase == workload::RequestGenerator::Phase::OPERATIONS) {
-        operations.push_back(
-            make_operation_from_request(type, key, value, scan_size));
-        phase = generator.next(type, key, value, scan_size);
+    std::vector<uint64_t> issue_times; // Replay only
+    if (!REPLAY_FILE.empty()) {
+        auto &requests = REPLAY_REQUESTS[worker_id];
+        operations.reserve(requests.size());
+        issue_times.reserve(requests.size());
+        for (auto &request : requests) {
+            issue_times.push_back(request.issue_ns);
+            operations.push_back(std::move(request.operation));
+        }
+        requests.clear();
+    } else {
+        loadgen::types::Type type;
+        long key;
+        std::string value;
+        long scan_size;
+
+        if (generator.current_phase() ==
+            workload::RequestGenerator::Phase::LOADING) {
+            generator.skip_current_phase();
+        }
+
+        assert(generator.current_phase() ==
+               workload::RequestGenerator::Phase::OPERATIONS);
+        workload::RequestGenerator::Phase phase =
+            generator.next(type, key, value, scan_size);
+        while (phase == workload::RequestGenerator::Phase::OPERATIONS) {
+            operations.push_back(
+                make_operation_from_request(type, key, value, scan_size));
+            phase = generator.next(type, key, value, scan_size);
+        }
     }
 
     start_barrier.arrive_and_wait();
+    const auto replay_start = std::chrono::steady_clock::now();
 
     std::mt19937 rng(
         static_cast<std::mt19937::result_type>(worker_id + THINKING_SEED));
@@ -535,6 +684,9 @@ void worker_function(size_t worker_id, workload::RequestGenerator &generator,
         std::exponential_distribution<double> thinking_dist(
             1.0 / static_cast<double>(THINKING_TIME.count()));
         for (const auto &operation : operations) {
+            if (RECORDER) {
+                RECORDER->record(worker_id, operation);
+            }
             auto op_start = std::chrono::high_resolution_clock::now();
             execute_operation(operation, storage);
             auto op_end = std::chrono::high_resolution_clock::now();
@@ -554,7 +706,18 @@ void worker_function(size_t worker_id, workload::RequestGenerator &generator,
             }
         }
     } else {
-        for (const auto &operation : operations) {
+        for (size_t i = 0; i < operations.size(); ++i) {
+            const auto &operation = operations[i];
+            // Replayed requests wait for their (scaled) recorded issue time
+            if (!issue_times.empty() && REPLAY_SPEED > 0) {
+                std::this_thread::sleep_until(
+                    replay_start +
+                    std::chrono::nanoseconds(static_cast<int64_t>(
+                        static_cast<double>(issue_times[i]) / REPLAY_SPEED)));
+            }
+            if (RECORDER) {
+                RECORDER->record(worker_id, operation);
+            }
             auto op_start = std::chrono::high_resolution_clock::now();
             execute_operation(operation, storage);
             auto op_end = std::chrono::high_resolution_clock::now();
@@ -583,8 +746,46 @@ template <typename StorageType> void run_workload_with_storage(
     std::cout << "\n=== Initializing Storage ===" << std::endl;
 
     StorageType storage = [&]() -> StorageType {
-        // Try RepartitioningKeyValueStorage constructor first
+        // The hard threaded storage also replicates hot keys
         if constexpr (requires {
+                          try_construct_replication(
+                              static_cast<StorageType *>(nullptr),
+                              partition_count, STORAGE_PATHS);
+                      }) {
+            std::cout << "Created " << storage_type_name << " with "
+                      << partition_count << " partitions (Threaded)"
+                      << std::endl;
+            std::cout << "Tracking duration: " << TRACKING_DURATION.count()
+                      << "ms, Repartition interval: "
+                      << REPARTITION_INTERVAL.count() << "ms" << std::endl;
+            if (REPLICATION_POLICY.enabled()) {
+                std::cout << "Hot-key replication: "
+                          << REPLICATION_POLICY.hot_keys << " keys, "
+                          << REPLICATION_POLICY.replicas << " replicas"
+                          << std::endl;
+            }
+            return try_construct_replication(
+                static_cast<StorageType *>(nullptr), partition_count,
+                STORAGE_PATHS);
+        }
+        // Threaded storages accept admission limits on top of the
+        // RepartitioningKeyValueStorage constructor arguments
+        else if constexpr (requires {
+                          try_construct_admission(
+                              static_cast<StorageType *>(nullptr),
+                              partition_count, STORAGE_PATHS);
+                      }) {
+            std::cout << "Created " << storage_type_name << " with "
+                      << partition_count << " partitions (Threaded)"
+                      << std::endl;
+            std::cout << "Tracking duration: " << TRACKING_DURATION.count()
+                      << "ms, Repartition interval: "
+                      << REPARTITION_INTERVAL.count() << "ms" << std::endl;
+            return try_construct_admission(static_cast<StorageType *>(nullptr),
+                                           partition_count, STORAGE_PATHS);
+        }
+        // Try RepartitioningKeyValueStorage constructor
+        else if constexpr (requires {
                           try_construct_repartitioning(
                               static_cast<StorageType *>(nullptr),
                               partition_count, STORAGE_PATHS);
@@ -598,6 +799,19 @@ template <typename StorageType> void run_workload_with_storage(
                 static_cast<StorageType *>(nullptr), partition_count,
                 STORAGE_PATHS);
         }
+        // Try range-partitioned constructor (rebalancing interval only)
+        else if constexpr (requires {
+                               try_construct_range(
+                                   static_cast<StorageType *>(nullptr),
+                                   partition_count, STORAGE_PATHS);
+                           }) {
+            std::cout << "Created " << storage_type_name << " with "
+                      << partition_count << " initial ranges" << std::endl;
+            std::cout << "Rebalance interval: " << REPARTITION_INTERVAL.count()
+                      << "ms" << std::endl;
+            return try_construct_range(static_cast<StorageType *>(nullptr),
+                                       partition_count, STORAGE_PATHS);
+        }
         // Try PartitionedKeyValueStorage constructor (e.g. LockStripping)
         else if constexpr (requires {
                                try_construct_partitioned(
@@ -631,6 +845,50 @@ template <typename StorageType> void run_workload_with_storage(
         }
     }();
 
+    // Rebuild the key map from the engines of a previous run
+    if constexpr (requires { storage.recover(); }) {
+        if (!ENGINE_STORE.empty()) {
+            const RecoveryStats recovery = storage.recover();
+            std::cout << "Recovered "
+                      << format_with_separators(recovery.keys) << " keys ("
+                      << std::fixed << std::setprecision(3)
+                      << recovery.gigabytes() << " GB) from store "
+                      << ENGINE_STORE << " in "
+                      << std::chrono::duration<double>(recovery.duration)
+                             .count()
+                      << " s (" << recovery.seconds_per_gb() << " s/GB)"
+                      << std::defaultfloat << std::endl;
+        }
+    }
+
+    // Restore the access graph and placement of a previous run
+    if constexpr (requires { storage.load_plan(PLAN_FILE); }) {
+        if (!PLAN_FILE.empty()) {
+            Status status = storage.load_plan(PLAN_FILE);
+            std::cout << "Placement plan " << PLAN_FILE << ": "
+                      << (status == Status::SUCCESS     ? "loaded"
+                          : status == Status::NOT_FOUND ? "not found"
+                                                        : "invalid, ignored")
+                      << std::endl;
+        }
+    }
+
+    // Log writes to a group-commit write-ahead log in the first path
+    if constexpr (requires { storage.enable_write_ahead_log(""); }) {
+        if (STORAGE_WAL) {
+            const std::string wal_dir =
+                (std::filesystem::path(STORAGE_PATHS[0]) / "repart_kv_wal")
+                    .string();
+            Status status = storage.enable_write_ahead_log(wal_dir);
+            std::cout << "Write-ahead log " << wal_dir << ": "
+                      << (status == Status::SUCCESS ? "enabled" : "failed")
+                      << std::endl;
+            if (status != Status::SUCCESS) {
+                return;
+            }
+        }
+    }
+
     // Setup metrics tracking
     std::vector<size_t> executed_counts(test_workers,
                                         0); // One counter per worker
@@ -641,13 +899,24 @@ template <typename StorageType> void run_workload_with_storage(
 
     // Create metrics filename:
     // workload__testworkers__storagetype__partitions__storageengine__paths.csv
+    // (storageengine is <engine>+<profile> for tuned engines, and gets a
+    // +slice suffix with the slice key map)
     std::string metrics_file =
         workload_filename + "__" + std::to_string(test_workers) + "__" +
         STORAGE_TYPE + "__" + std::to_string(partition_count) + "__" +
-        STORAGE_ENGINE + "__" + std::to_string(STORAGE_PATHS.size()) + "__" +
+        STORAGE_ENGINE +
+        (KEY_MAP == "slice" && (STORAGE_ENGINE == "map" ||
+                                STORAGE_ENGINE == "tbb")
+             ? "+slice"
+             : "") +
+        (ENGINE_PROFILE_TAG.empty() ? "" : "+" + ENGINE_PROFILE_TAG) + "__" +
+        std::to_string(STORAGE_PATHS.size()) + "__" +
         std::to_string(REPARTITION_INTERVAL.count()) + "__" +
         std::to_string(THINKING_TIME.count()) + "__" +
-        (STORAGE_SYNC ? "sync_on" : "sync_off") + ".csv";
+        (STORAGE_WAL    ? "sync_wal"
+         : STORAGE_SYNC ? "sync_on"
+                        : "sync_off") +
+        ".csv";
 
     // Execute operations
     std::cout << "\n=== Executing Workload ===" << std::endl;
@@ -696,11 +965,58 @@ template <typename StorageType> void run_workload_with_storage(
     }
 
     std::cout << "Loading workload into memory... " << std::flush;
+    if (RECORDER) {
+        RECORDER->start();
+    }
     start_barrier.arrive_and_wait();
     std::cout << " [DONE]" << std::endl;
 
     auto start_time = std::chrono::high_resolution_clock::now();
 
+    // Checkpoint the storage while the workers keep running
+    std::thread checkpoint_thread;
+    if constexpr (requires(CheckpointStats &stats) {
+                      storage.checkpoint(CHECKPOINT_DIR, CHECKPOINT_OPTIONS,
+                                         stats);
+                  }) {
+        if (!CHECKPOINT_DIR.empty()) {
+            checkpoint_thread = std::thread([&storage, start_time]() {
+                auto any_running = []() {
+                    for (size_t i = 0; i < TEST_WORKERS; ++i) {
+                        if (RUNNING[i]) {
+                            return true;
+                        }
+                    }
+                    return false;
+                };
+                while (std::chrono::high_resolution_clock::now() - start_time <
+                           CHECKPOINT_AFTER &&
+                       any_running()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                CheckpointStats stats;
+                Status status = storage.checkpoint(
+                    CHECKPOINT_DIR, CHECKPOINT_OPTIONS, stats);
+                if (status != Status::SUCCESS) {
+                    std::cerr << "\nWarning: could not write checkpoint "
+                              << CHECKPOINT_DIR << std::endl;
+                    return;
+                }
+                std::cout << "\nCheckpoint " << CHECKPOINT_DIR << ": "
+                          << format_with_separators(stats.bytes >> 10)
+                          << " KiB in "
+                          << std::chrono::duration_cast<
+                                 std::chrono::milliseconds>(stats.duration)
+                                 .count()
+                          << " ms, writers paused "
+                          << std::chrono::duration_cast<
+                                 std::chrono::microseconds>(stats.pause)
+                                 .count()
+                          << " us" << std::endl;
+            });
+        }
+    }
+
     std::cout << "Executing workload... " << std::flush;
 
     while (std::chrono::duration_cast<std::chrono::seconds>(
@@ -727,12 +1043,30 @@ template <typename StorageType> void run_workload_with_storage(
     for (auto &thread : worker_threads) {
         thread.join();
     }
+    if (checkpoint_thread.joinable()) {
+        checkpoint_thread.join();
+    }
     std::cout << " [DONE]" << std::endl;
 
     // Stop metrics logging
     metrics_running = false;
     metrics_thread.join();
 
+    if (RECORDER) {
+        size_t recorded = RECORDER->recorded_count();
+        RECORDER.reset(); // Writes the remaining buffered requests
+        std::cout << "Recorded " << format_with_separators(recorded)
+                  << " requests to " << RECORD_FILE << std::endl;
+    }
+
+    if constexpr (requires { storage.save_plan(PLAN_FILE); }) {
+        if (!PLAN_FILE.empty() &&
+            storage.save_plan(PLAN_FILE) != Status::SUCCESS) {
+            std::cerr << "Warning: could not save placement plan to "
+                      << PLAN_FILE << std::endl;
+        }
+    }
+
     auto end_time = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
         end_time - start_time);
@@ -758,6 +1092,73 @@ template <typename StorageType> void run_workload_with_storage(
               << " ms" << std::endl;
     std::cout << "Operations per second: "
               << format_with_separators(operations_per_second, 2) << std::endl;
+    if (ADMISSION_POLICY.enabled()) {
+        std::cout << "Operations retried after BUSY: "
+                  << format_with_separators(BUSY_RETRIES.load()) << std::endl;
+    }
+    if constexpr (requires {
+                      storage.shed_count();
+                      storage.expired_count();
+                  }) {
+        if (ADMISSION_POLICY.enabled()) {
+            std::cout << "Shed at admission: "
+                      << format_with_separators(storage.shed_count())
+                      << ", expired in queue: "
+                      << format_with_separators(storage.expired_count())
+                      << std::endl;
+        }
+    }
+    if constexpr (requires { storage.replicated_key_count(); }) {
+        if (REPLICATION_POLICY.enabled()) {
+            std::cout << "Replicated hot keys: "
+                      << storage.replicated_key_count() << std::endl;
+        }
+    }
+    if constexpr (requires { storage.cache_stats(); }) {
+        CacheStats cache = storage.cache_stats();
+        std::cout << "Cache hit rate: "
+                  << format_with_separators(100.0 * cache.hit_rate(), 2)
+                  << "% (" << format_with_separators(cache.hits) << " hits, "
+                  << format_with_separators(cache.misses) << " misses)"
+                  << std::endl;
+        std::cout << "Prefetched entries: "
+                  << format_with_separators(cache.prefetched) << " ("
+                  << format_with_separators(
+                         100.0 * cache.wasted_prefetch_ratio(), 2)
+                  << "% wasted)" << std::endl;
+    }
+    if constexpr (requires { storage.repartition_stats(); }) {
+        RepartitionStats stats = storage.repartition_stats();
+        if (stats.cycle > 0) {
+            std::cout << "Last repartitioning (cycle " << stats.cycle
+                      << "): edge cut "
+                      << format_with_separators(stats.edge_cut)
+                      << ", imbalance "
+                      << format_with_separators(stats.imbalance, 3) << ", "
+                      << format_with_separators(stats.keys_reassigned)
+                      << " keys reassigned, "
+                      << format_with_separators(stats.bytes_migrated)
+                      << " bytes migrated, scan fan-out "
+                      << format_with_separators(stats.scan_fanout, 2)
+                      << std::endl;
+        }
+    }
+    if constexpr (requires { storage.coalesced_write_count(); }) {
+        std::cout << "Coalesced writes: "
+                  << format_with_separators(storage.coalesced_write_count())
+                  << std::endl;
+    }
+    if constexpr (requires {
+                      storage.range_count();
+                      storage.split_count();
+                      storage.merge_count();
+                  }) {
+        std::cout << "Ranges: " << storage.range_count() << " (splits: "
+                  << format_with_separators(storage.split_count())
+                  << ", merges: "
+                  << format_with_separators(storage.merge_count()) << ")"
+                  << std::endl;
+    }
     std::cout << "Metrics saved to: " << metrics_file << std::endl;
 
     output_latency_csv(metrics_file, start_time, test_workers);
@@ -771,6 +1172,25 @@ template <typename StorageType> void run_workload_with_storage(
     }
 }
 
+/** Hot partitions in memory (std::map), cold partitions in LMDB. */
+template <bool SYNC>
+using MapLmdbTieredStorageEngine =
+    TieredStorageEngine<MapStorageEngine, LmdbStorageEngine, SYNC>;
+
+/** Hot partitions in memory (std::map), cold partitions in LevelDB. */
+template <bool SYNC>
+using MapLevelDBTieredStorageEngine =
+    TieredStorageEngine<MapStorageEngine, LevelDBStorageEngine, SYNC>;
+
+/** LMDB partitions behind a read cache. */
+template <bool SYNC>
+using CachedLmdbStorageEngine = CachedStorageEngine<LmdbStorageEngine, SYNC>;
+
+/** LevelDB partitions behind a read cache. */
+template <bool SYNC>
+using CachedLevelDBStorageEngine =
+    CachedStorageEngine<LevelDBStorageEngine, SYNC>;
+
 /**
  * @brief Dispatch STORAGE_TYPE for a given \c template<bool> storage engine.
  *
@@ -793,6 +1213,13 @@ void run_workload_for_engine_template(
         run_workload_with_storage<StorageType>(
             generators, PARTITION_COUNT, TEST_WORKERS,
             "HardRepartitioningKeyValueStorage");
+    } else if (STORAGE_TYPE == "hard_fingerprint") {
+        using StorageType =
+            HardRepartitioningKeyValueStorage<Engine, StorageSync,
+                                              FingerprintKeyStorage>;
+        run_workload_with_storage<StorageType>(
+            generators, PARTITION_COUNT, TEST_WORKERS,
+            "HardRepartitioningKeyValueStorage<FingerprintKeyStorage>");
     } else if (STORAGE_TYPE == "soft") {
         using StorageType = SoftRepartitioningKeyValueStorage<
             Engine, StorageSync, OrderedKeyStorageType, OrderedKeyStorageType>;
@@ -809,8 +1236,7 @@ void run_workload_for_engine_template(
     } else if (STORAGE_TYPE == "hard_threaded") {
         using StorageType =
             HardThreadedRepartitioningKeyValueStorage<Engine, StorageSync,
-                                                      OrderedKeyStorageType,
-                                                      UnorderedDenseKeyStorage>;
+                                                      OrderedKeyStorageType>;
         run_workload_with_storage<StorageType>(
             generators, PARTITION_COUNT, TEST_WORKERS,
             "HardThreadedRepartitioningKeyValueStorage");
@@ -822,6 +1248,12 @@ void run_workload_for_engine_template(
         using StorageType = LockStrippingKeyValueStorage<Engine, StorageSync>;
         run_workload_with_storage<StorageType>(
             generators, PARTITION_COUNT, TEST_WORKERS, lock_stripping_label);
+    } else if (STORAGE_TYPE == "range") {
+        using StorageType =
+            RangePartitionedKeyValueStorage<Engine, StorageSync>;
+        run_workload_with_storage<StorageType>(
+            generators, PARTITION_COUNT, TEST_WORKERS,
+            "RangePartitionedKeyValueStorage");
     }
 }
 
@@ -860,14 +1292,38 @@ void execute_with_storage_config(
         run_workload_for_engine_with_cli_sync<LevelDBStorageEngine,
                                               LevelDBKeyStorage>(
             generators, "LevelDBStorageEngine");
+    } else if (STORAGE_ENGINE == "map" && KEY_MAP == "slice") {
+        run_workload_for_engine_with_cli_sync<MapStorageEngine,
+                                              SliceBtreeKeyStorage>(
+            generators, "MapStorageEngine");
     } else if (STORAGE_ENGINE == "map") {
         run_workload_for_engine_with_cli_sync<MapStorageEngine,
                                               AbslBtreeKeyStorage>(
             generators, "MapStorageEngine");
+    } else if (STORAGE_ENGINE == "tbb" && KEY_MAP == "slice") {
+        run_workload_for_engine_with_cli_sync<TbbStorageEngine,
+                                              SliceBtreeKeyStorage>(
+            generators, "TbbStorageEngine");
     } else if (STORAGE_ENGINE == "tbb") {
         run_workload_for_engine_with_cli_sync<TbbStorageEngine,
                                               AbslBtreeKeyStorage>(
             generators, "TbbStorageEngine");
+    } else if (STORAGE_ENGINE == "tiered_lmdb") {
+        run_workload_for_engine_with_cli_sync<MapLmdbTieredStorageEngine,
+                                              LmdbKeyStorage>(
+            generators, "TieredStorageEngine<Map, Lmdb>");
+    } else if (STORAGE_ENGINE == "tiered_leveldb") {
+        run_workload_for_engine_with_cli_sync<MapLevelDBTieredStorageEngine,
+                                              LevelDBKeyStorage>(
+            generators, "TieredStorageEngine<Map, LevelDB>");
+    } else if (STORAGE_ENGINE == "cached_lmdb") {
+        run_workload_for_engine_with_cli_sync<CachedLmdbStorageEngine,
+                                              LmdbKeyStorage>(
+            generators, "CachedStorageEngine<Lmdb>");
+    } else if (STORAGE_ENGINE == "cached_leveldb") {
+        run_workload_for_engine_with_cli_sync<CachedLevelDBStorageEngine,
+                                              LevelDBKeyStorage>(
+            generators, "CachedStorageEngine<LevelDB>");
     }
 }
 
@@ -879,23 +1335,28 @@ void print_usage(const char *program_name) {
               << " <loadgen_config.toml> [partition_count] [test_workers] "
                  "[storage_type] [storage_engine] "
                  "[thinking_time_ns] [storage_paths] "
-                 "[repartition_interval_ms] [max_duration_s] [sync]"
+                 "[repartition_interval_ms] [max_duration_s] [sync] "
+                 "[admission] [plan_file] [trace] [leveldb] [lmdb] [store] "
+                 "[checkpoint] [replication] [key_map]"
               << std::endl;
     std::cout << "\nArguments:" << std::endl;
     std::cout << "  loadgen_config   Path to a LoadGen TOML configuration file "
-                 "(used for all workers)"
+                 "(used for all workers). Its [engine.*] sections tune the "
+                 "storage backends (see storage/EngineTuning.h)"
               << std::endl;
     std::cout << "  partition_count  Number of partitions (default: 4)"
               << std::endl;
     std::cout << "  test_workers     Number of worker threads (default: 1)"
               << std::endl;
-    std::cout << "  storage_type     Storage implementation: 'hard', 'soft', "
-                 "'threaded', 'hard_threaded', 'engine', or 'lock_stripping' "
-                 "(default: soft)"
+    std::cout << "  storage_type     Storage implementation: 'hard', "
+                 "'hard_fingerprint', 'soft', 'threaded', 'hard_threaded', "
+                 "'engine', 'lock_stripping', or 'range' (default: soft)"
               << std::endl;
     std::cout << "  storage_engine   Storage engine backend: 'tkrzw_tree', "
                  "'tkrzw_hash', "
-                 "'lmdb', 'leveldb', 'map', or 'tbb' (default: tkrzw_tree)"
+                 "'lmdb', 'leveldb', 'map', 'tbb', 'tiered_lmdb', "
+                 "'tiered_leveldb', 'cached_lmdb', or 'cached_leveldb' "
+                 "(default: tkrzw_tree)"
               << std::endl;
     std::cout
         << "  thinking_time_ns Thinking time delay in nanoseconds (default: 0)"
@@ -914,12 +1375,76 @@ void print_usage(const char *program_name) {
                  "(default: 20)"
               << std::endl;
     std::cout << "  sync             Storage engine durability sync: 'false', "
-                 "'true', '0', or '1' (default: false)"
+                 "'true', '0', or '1' (default: false), or 'wal' to make "
+                 "writes durable through a group-commit write-ahead log in "
+                 "<first storage path>/repart_kv_wal instead"
+              << std::endl;
+    std::cout << "  admission        Admission control for 'threaded' and "
+                 "'hard_threaded', as comma-separated key=value pairs: "
+                 "depth=<ops>, target_us=<us>, interval_us=<us>, "
+                 "deadline_us=<us>, retry_us=<us> (default: off). Rejected "
+                 "operations are retried by the client after retry_us."
+              << std::endl;
+    std::cout << "  plan_file        Placement checkpoint for 'hard', "
+                 "'hard_fingerprint', 'soft', 'threaded' and 'hard_threaded': "
+                 "the access graph and "
+                 "key-to-partition plan are loaded from it before the preload "
+                 "(if it exists) and saved to it after the run (default: off)"
+              << std::endl;
+    std::cout << "  trace            Request recording or replay, as "
+                 "comma-separated key=value pairs: record=<log> writes every "
+                 "issued request with its time and client thread to <log>; "
+                 "replay=<log> issues the requests of <log> instead of the "
+                 "generated ones, on as many client threads as were "
+                 "recorded; speed=<x> scales replay pacing (1: original, 2: "
+                 "twice as fast, 0: as fast as possible; default: 1). The "
+                 "preload still comes from loadgen_config."
+              << std::endl;
+    std::cout << "  leveldb          LevelDB tuning, as comma-separated "
+                 "key=value pairs: cache_mb=<MiB> (block cache), "
+                 "bloom_bits=<bits per key>, write_buffer_kb=<KiB>, each "
+                 "optionally prefixed with p<partition>. to set one "
+                 "partition only (e.g. p0.cache_mb=64); compaction_mbps=<MiB/s>"
+                 " and burst_mb=<MiB> cap background table writes across all "
+                 "partitions; stagger_ms=<ms> spaces compactions apart; "
+                 "compact_interval_ms=<ms> compacts the partitions one after "
+                 "the other (default: LevelDB defaults, no limits)"
+              << std::endl;
+    std::cout << "  lmdb             LMDB tuning, as comma-separated key=value "
+                 "pairs: map_mb=<MiB> (initial map, doubled whenever full), "
+                 "max_map_mb=<MiB> (growth limit, 0: none), writemap=<0|1>, "
+                 "mapasync=<0|1> (with writemap and sync=false), "
+                 "max_readers=<n> (default: map_mb=1024, no limit, "
+                 "writemap=0, max_readers=1024)"
+              << std::endl;
+    std::cout << "  store            Persistent engine store name for hard, "
+                 "hard_fingerprint and lock_stripping with a disk engine: "
+                 "partition engines reopen <path>/repart_kv_storage/<store> "
+                 "and the key map is rebuilt from them (default: off)"
+              << std::endl;
+    std::cout << "  checkpoint       Online checkpoint for hard, "
+                 "hard_fingerprint and soft, as comma-separated key=value "
+                 "pairs: dir=<directory> (must not exist), after_s=<seconds "
+                 "into the workload>, mbps=<MiB/s image write budget> "
+                 "(default: off). Tkrzw engines hold writers for their whole "
+                 "file copy, which mbps does not slow down"
+              << std::endl;
+    std::cout << "  replication      Hot-key read replication for "
+                 "hard_threaded, as comma-separated key=value pairs: "
+                 "hot=<keys replicated per repartitioning>, "
+                 "replicas=<copies of each> (default: off)"
+              << std::endl;
+    std::cout << "  key_map          Ordered key map of the map and tbb "
+                 "engines: 'absl' (AbslBtreeKeyStorage) or 'slice' "
+                 "(SliceBtreeKeyStorage) (default: absl)"
               << std::endl;
     std::cout << "\nStorage Types:" << std::endl;
     std::cout << "  hard            HardRepartitioningKeyValueStorage (creates "
                  "new storage engines)"
               << std::endl;
+    std::cout << "  hard_fingerprint  HardRepartitioningKeyValueStorage with "
+                 "a fingerprint key map (compact, for point lookups)"
+              << std::endl;
     std::cout << "  soft            SoftRepartitioningKeyValueStorage (uses "
                  "single storage with partition locks)"
               << std::endl;
@@ -936,6 +1461,9 @@ void print_usage(const char *program_name) {
         << "  lock_stripping  LockStrippingKeyValueStorage (partitioned with "
            "lock striping, no repartitioning)"
         << std::endl;
+    std::cout << "  range           RangePartitionedKeyValueStorage (key "
+                 "ranges split and merged by load, no graph)"
+              << std::endl;
     std::cout << "\nStorage Engines:" << std::endl;
     std::cout
         << "  tkrzw_tree      TkrzwTreeStorageEngine (sorted key-value storage)"
@@ -953,6 +1481,20 @@ void print_usage(const char *program_name) {
     std::cout << "  tbb             TbbStorageEngine (in-memory TBB "
                  "concurrent_hash_map)"
               << std::endl;
+    std::cout << "  tiered_lmdb     TieredStorageEngine: hot partitions in "
+                 "memory, cold ones in LMDB ('hard' re-tiers them by access "
+                 "weight at each repartitioning)"
+              << std::endl;
+    std::cout << "  tiered_leveldb  TieredStorageEngine: hot partitions in "
+                 "memory, cold ones in LevelDB"
+              << std::endl;
+    std::cout << "  cached_lmdb     CachedStorageEngine: CLOCK read cache in "
+                 "front of each LMDB partition ('hard' prefetches the keys "
+                 "co-accessed with every key read)"
+              << std::endl;
+    std::cout << "  cached_leveldb  CachedStorageEngine: CLOCK read cache in "
+                 "front of each LevelDB partition"
+              << std::endl;
     std::cout << "\nWorkload file format:" << std::endl;
     std::cout << "  0,<key>         : READ operation" << std::endl;
     std::cout << "  1,<key>         : WRITE operation (uses 1KB default value)"
@@ -973,6 +1515,13 @@ int run_repart_kv(int argc, char *argv[]) {
                   << LOADGEN_CONFIG_FILE << std::endl;
         return 1;
     }
+    try {
+        ENGINE_PROFILE = EngineTuning::load(LOADGEN_CONFIG_FILE);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: Invalid engine setting: " << e.what()
+                  << std::endl;
+        return 1;
+    }
 
     if (argc >= 3) {
         try {
@@ -1006,12 +1555,14 @@ int run_repart_kv(int argc, char *argv[]) {
 
     if (argc >= 5) {
         STORAGE_TYPE = argv[4];
-        if (STORAGE_TYPE != "hard" && STORAGE_TYPE != "soft" &&
-            STORAGE_TYPE != "threaded" && STORAGE_TYPE != "hard_threaded" &&
-            STORAGE_TYPE != "engine" && STORAGE_TYPE != "lock_stripping") {
-            std::cerr << "Error: storage_type must be 'hard', 'soft', "
-                         "'threaded', 'hard_threaded', 'engine', or "
-                         "'lock_stripping', got: "
+        if (STORAGE_TYPE != "hard" && STORAGE_TYPE != "hard_fingerprint" &&
+            STORAGE_TYPE != "soft" && STORAGE_TYPE != "threaded" &&
+            STORAGE_TYPE != "hard_threaded" && STORAGE_TYPE != "engine" &&
+            STORAGE_TYPE != "lock_stripping" && STORAGE_TYPE != "range") {
+            std::cerr << "Error: storage_type must be 'hard', "
+                         "'hard_fingerprint', 'soft', 'threaded', "
+                         "'hard_threaded', 'engine', 'lock_stripping', or "
+                         "'range', got: "
                       << STORAGE_TYPE << std::endl;
             return 1;
         }
@@ -1021,10 +1572,16 @@ int run_repart_kv(int argc, char *argv[]) {
         STORAGE_ENGINE = argv[5];
         if (STORAGE_ENGINE != "tkrzw_tree" && STORAGE_ENGINE != "tkrzw_hash" &&
             STORAGE_ENGINE != "lmdb" && STORAGE_ENGINE != "leveldb" &&
-            STORAGE_ENGINE != "map" && STORAGE_ENGINE != "tbb") {
+            STORAGE_ENGINE != "map" && STORAGE_ENGINE != "tbb" &&
+            STORAGE_ENGINE != "tiered_lmdb" &&
+            STORAGE_ENGINE != "tiered_leveldb" &&
+            STORAGE_ENGINE != "cached_lmdb" &&
+            STORAGE_ENGINE != "cached_leveldb") {
             std::cerr
                 << "Error: storage_engine must be 'tkrzw_tree', 'tkrzw_hash', "
-                   "'lmdb', 'leveldb', 'map', or 'tbb', got: "
+                   "'lmdb', 'leveldb', 'map', 'tbb', 'tiered_lmdb', "
+                   "'tiered_leveldb', 'cached_lmdb', or 'cached_leveldb', "
+                   "got: "
                 << STORAGE_ENGINE << std::endl;
             return 1;
         }
@@ -1095,13 +1652,356 @@ int run_repart_kv(int argc, char *argv[]) {
         } else if (sync_arg == "0" || sync_arg == "false" ||
                    sync_arg == "off" || sync_arg == "no") {
             STORAGE_SYNC = false;
+        } else if (sync_arg == "wal") {
+            STORAGE_SYNC = false;
+            STORAGE_WAL = true;
         } else {
-            std::cerr << "Error: sync must be 'true' or 'false' (or 1/0), got: "
+            std::cerr << "Error: sync must be 'true', 'false' (or 1/0) or "
+                         "'wal', got: "
                       << argv[10] << std::endl;
             return 1;
         }
     }
 
+    if (argc >= 12) {
+        std::stringstream ss(argv[11]);
+        std::string entry;
+        while (std::getline(ss, entry, ',')) {
+            const size_t eq = entry.find('=');
+            if (entry.empty()) {
+                continue;
+            }
+            try {
+                if (eq == std::string::npos) {
+                    throw std::invalid_argument(entry);
+                }
+                const std::string name = entry.substr(0, eq);
+                const unsigned long long number =
+                    std::stoull(entry.substr(eq + 1));
+                if (name == "depth") {
+                    ADMISSION_POLICY.max_queue_depth = number;
+                } else if (name == "target_us") {
+                    ADMISSION_POLICY.target_delay =
+                        std::chrono::microseconds(number);
+                } else if (name == "interval_us") {
+                    ADMISSION_POLICY.interval =
+                        std::chrono::microseconds(number);
+                } else if (name == "deadline_us") {
+                    ADMISSION_POLICY.deadline =
+                        std::chrono::microseconds(number);
+                } else if (name == "retry_us") {
+                    ADMISSION_RETRY_AFTER = std::chrono::microseconds(number);
+                } else {
+                    throw std::invalid_argument(entry);
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "Error: Invalid admission setting: " << entry
+                          << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    if (argc >= 13) {
+        PLAN_FILE = argv[12];
+    }
+
+    if (argc >= 14) {
+        std::stringstream ss(argv[13]);
+        std::string entry;
+        while (std::getline(ss, entry, ',')) {
+            const size_t eq = entry.find('=');
+            if (entry.empty()) {
+                continue;
+            }
+            const std::string name = entry.substr(0, eq);
+            const std::string setting =
+                eq == std::string::npos ? std::string() : entry.substr(eq + 1);
+            try {
+                if (name == "record" && !setting.empty()) {
+                    RECORD_FILE = setting;
+                } else if (name == "replay" && !setting.empty()) {
+                    REPLAY_FILE = setting;
+                } else if (name == "speed") {
+                    REPLAY_SPEED = std::stod(setting);
+                    if (REPLAY_SPEED < 0) {
+                        throw std::invalid_argument(entry);
+                    }
+                } else {
+                    throw std::invalid_argument(entry);
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "Error: Invalid trace setting: " << entry
+                          << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    if (argc >= 15) {
+        std::stringstream ss(argv[14]);
+        std::string entry;
+        std::vector<std::tuple<size_t, std::string, size_t>> overrides;
+        auto set_option = [](LevelDBPartitionOptions &options,
+                             const std::string &name, size_t number) {
+            if (name == "cache_mb") {
+                options.block_cache_size = number << 20;
+            } else if (name == "bloom_bits") {
+                options.bloom_bits_per_key = static_cast<int>(number);
+            } else if (name == "write_buffer_kb") {
+                options.write_buffer_size = number << 10;
+            } else {
+                return false;
+            }
+            return true;
+        };
+        while (std::getline(ss, entry, ',')) {
+            const size_t eq = entry.find('=');
+            if (entry.empty()) {
+                continue;
+            }
+            try {
+                if (eq == std::string::npos) {
+                    throw std::invalid_argument(entry);
+                }
+                std::string name = entry.substr(0, eq);
+                const size_t number = std::stoull(entry.substr(eq + 1));
+                const size_t dot = name.find('.');
+                if (name[0] == 'p' && dot != std::string::npos) {
+                    size_t used = 0;
+                    const size_t partition =
+                        std::stoull(name.substr(1, dot - 1), &used);
+                    if (used != dot - 1) {
+                        throw std::invalid_argument(entry);
+                    }
+                    LevelDBPartitionOptions check;
+                    if (!set_option(check, name.substr(dot + 1), number)) {
+                        throw std::invalid_argument(entry);
+                    }
+                    overrides.emplace_back(partition, name.substr(dot + 1),
+                                           number);
+                } else if (name == "compaction_mbps") {
+                    COMPACTION.bytes_per_second = number << 20;
+                } else if (name == "burst_mb") {
+                    COMPACTION.burst_bytes = number << 20;
+                } else if (name == "stagger_ms") {
+                    COMPACTION.stagger = std::chrono::milliseconds(number);
+                } else if (name == "compact_interval_ms") {
+                    COMPACTION.interval = std::chrono::milliseconds(number);
+                } else if (!set_option(ENGINE_PROFILE.leveldb, name,
+                                       number)) {
+                    throw std::invalid_argument(entry);
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "Error: Invalid leveldb setting: " << entry
+                          << std::endl;
+                return 1;
+            }
+        }
+        // Overrides start from the shared options, whatever their order
+        for (const auto &[partition, name, number] : overrides) {
+            auto it = ENGINE_PROFILE.leveldb_partitions
+                          .try_emplace(partition, ENGINE_PROFILE.leveldb)
+                          .first;
+            set_option(it->second, name, number);
+        }
+    }
+    CompactionScheduler::instance().configure(COMPACTION);
+
+    if (argc >= 16) {
+        std::stringstream ss(argv[15]);
+        std::string entry;
+        while (std::getline(ss, entry, ',')) {
+            const size_t eq = entry.find('=');
+            if (entry.empty()) {
+                continue;
+            }
+            try {
+                if (eq == std::string::npos) {
+                    throw std::invalid_argument(entry);
+                }
+                const std::string name = entry.substr(0, eq);
+                const size_t number = std::stoull(entry.substr(eq + 1));
+                if (name == "map_mb" && number > 0) {
+                    ENGINE_PROFILE.lmdb.map_size = number << 20;
+                } else if (name == "max_map_mb") {
+                    ENGINE_PROFILE.lmdb.max_map_size = number << 20;
+                } else if (name == "writemap" && number <= 1) {
+                    ENGINE_PROFILE.lmdb.write_map = number == 1;
+                } else if (name == "mapasync" && number <= 1) {
+                    ENGINE_PROFILE.lmdb.map_async = number == 1;
+                } else if (name == "max_readers" && number > 0) {
+                    ENGINE_PROFILE.lmdb.max_readers =
+                        static_cast<unsigned int>(number);
+                } else {
+                    throw std::invalid_argument(entry);
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "Error: Invalid lmdb setting: " << entry
+                          << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (argc >= 17 && std::string(argv[16]) != "off") {
+        ENGINE_STORE = argv[16];
+        for (char c : ENGINE_STORE) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' &&
+                c != '_') {
+                std::cerr << "Error: store must contain only letters, digits, "
+                             "'-' and '_', got: "
+                          << ENGINE_STORE << std::endl;
+                return 1;
+            }
+        }
+        if (STORAGE_TYPE != "hard" && STORAGE_TYPE != "hard_fingerprint" &&
+            STORAGE_TYPE != "lock_stripping") {
+            std::cerr << "Error: store requires storage_type 'hard', "
+                         "'hard_fingerprint' or 'lock_stripping', got: "
+                      << STORAGE_TYPE << std::endl;
+            return 1;
+        }
+        if (STORAGE_ENGINE != "tkrzw_tree" && STORAGE_ENGINE != "tkrzw_hash" &&
+            STORAGE_ENGINE != "lmdb" && STORAGE_ENGINE != "leveldb") {
+            std::cerr << "Error: store requires storage_engine 'tkrzw_tree', "
+                         "'tkrzw_hash', 'lmdb' or 'leveldb', got: "
+                      << STORAGE_ENGINE << std::endl;
+            return 1;
+        }
+    }
+    EnginePersistence::set_name(ENGINE_STORE);
+
+    if (argc >= 18) {
+        std::stringstream ss(argv[17]);
+        std::string entry;
+        while (std::getline(ss, entry, ',')) {
+            const size_t eq = entry.find('=');
+            if (entry.empty()) {
+                continue;
+            }
+            const std::string name = entry.substr(0, eq);
+            const std::string setting =
+                eq == std::string::npos ? std::string() : entry.substr(eq + 1);
+            try {
+                if (name == "dir" && !setting.empty()) {
+                    CHECKPOINT_DIR = setting;
+                } else if (name == "after_s") {
+                    CHECKPOINT_AFTER = std::chrono::milliseconds(
+                        static_cast<long>(std::stod(setting) * 1000));
+                } else if (name == "mbps") {
+                    CHECKPOINT_OPTIONS.bytes_per_second =
+                        std::stoull(setting) << 20;
+                } else {
+                    throw std::invalid_argument(entry);
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "Error: Invalid checkpoint setting: " << entry
+                          << std::endl;
+                return 1;
+            }
+        }
+        if (!CHECKPOINT_DIR.empty() && STORAGE_TYPE != "hard" &&
+            STORAGE_TYPE != "hard_fingerprint" && STORAGE_TYPE != "soft") {
+            std::cerr << "Error: checkpoint requires storage_type 'hard', "
+                         "'hard_fingerprint' or 'soft', got: "
+                      << STORAGE_TYPE << std::endl;
+            return 1;
+        }
+    }
+
+    if (argc >= 19) {
+        std::stringstream ss(argv[18]);
+        std::string entry;
+        while (std::getline(ss, entry, ',')) {
+            const size_t eq = entry.find('=');
+            if (entry.empty()) {
+                continue;
+            }
+            try {
+                if (eq == std::string::npos) {
+                    throw std::invalid_argument(entry);
+                }
+                const std::string name = entry.substr(0, eq);
+                const unsigned long long number =
+                    std::stoull(entry.substr(eq + 1));
+                if (name == "hot") {
+                    REPLICATION_POLICY.hot_keys = number;
+                } else if (name == "replicas") {
+                    REPLICATION_POLICY.replicas = number;
+                } else {
+                    throw std::invalid_argument(entry);
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "Error: Invalid replication setting: " << entry
+                          << std::endl;
+                return 1;
+            }
+        }
+        if (REPLICATION_POLICY.enabled() && STORAGE_TYPE != "hard_threaded") {
+            std::cerr << "Error: replication requires storage_type "
+                         "'hard_threaded', got: "
+                      << STORAGE_TYPE << std::endl;
+            return 1;
+        }
+    }
+
+    if (argc >= 20) {
+        KEY_MAP = argv[19];
+        if (KEY_MAP != "absl" && KEY_MAP != "slice") {
+            std::cerr << "Error: key_map must be 'absl' or 'slice', got: "
+                      << KEY_MAP << std::endl;
+            return 1;
+        }
+    }
+
+    // Runs with a non-default tuning of their engine get their own metrics
+    // files: the profile name, or else a digest (FNV-1a) of the settings
+    const std::string engine_settings =
+        EngineTuning::describe(ENGINE_PROFILE, STORAGE_ENGINE);
+    if (!ENGINE_PROFILE.name.empty()) {
+        ENGINE_PROFILE_TAG = ENGINE_PROFILE.name;
+        for (char &c : ENGINE_PROFILE_TAG) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-') {
+                c = '-';
+            }
+        }
+    } else if (engine_settings !=
+               EngineTuning::describe(EngineProfile(), STORAGE_ENGINE)) {
+        uint32_t digest = 2166136261u;
+        for (char c : engine_settings) {
+            digest = (digest ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        std::ostringstream tag;
+        tag << std::hex << std::setw(8) << std::setfill('0') << digest;
+        ENGINE_PROFILE_TAG = tag.str();
+    }
+
+    if (!REPLAY_FILE.empty()) {
+        try {
+            REPLAY_REQUESTS = workload::read_request_log(REPLAY_FILE);
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        if (REPLAY_REQUESTS.size() != TEST_WORKERS) {
+            std::cout << "Replaying on " << REPLAY_REQUESTS.size()
+                      << " client threads, as recorded (test_workers "
+                      << TEST_WORKERS << " ignored)" << std::endl;
+            TEST_WORKERS = REPLAY_REQUESTS.size();
+        }
+        // Recorded issue times already include the clients' thinking time
+        THINKING_TIME = std::chrono::nanoseconds(0);
+    }
+    if (!RECORD_FILE.empty()) {
+        try {
+            RECORDER = std::make_unique<workload::RequestRecorder>(
+                RECORD_FILE, TEST_WORKERS);
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     std::filesystem::path config_path(LOADGEN_CONFIG_FILE);
     WORKLOAD_NAME = config_path.stem().string();
     if (WORKLOAD_NAME.empty()) {
@@ -1114,7 +2014,12 @@ int run_repart_kv(int argc, char *argv[]) {
     std::cout << "Test workers: " << TEST_WORKERS << std::endl;
     std::cout << "Storage type: " << STORAGE_TYPE << std::endl;
     std::cout << "Storage engine: " << STORAGE_ENGINE << std::endl;
-    std::cout << "Storage sync: " << (STORAGE_SYNC ? "on" : "off") << std::endl;
+    if (STORAGE_ENGINE == "map" || STORAGE_ENGINE == "tbb") {
+        std::cout << "Key map: " << KEY_MAP << std::endl;
+    }
+    std::cout << "Storage sync: "
+              << (STORAGE_WAL ? "write-ahead log" : STORAGE_SYNC ? "on" : "off")
+              << std::endl;
     std::cout << "Thinking time: " << THINKING_TIME.count() << "ns"
               << std::endl;
     std::cout << "Storage paths: ";
@@ -1129,6 +2034,60 @@ int run_repart_kv(int argc, char *argv[]) {
               << std::endl;
     std::cout << "Repartition interval: " << REPARTITION_INTERVAL.count()
               << "ms" << std::endl;
+    if (!RECORD_FILE.empty()) {
+        std::cout << "Recording requests to: " << RECORD_FILE << std::endl;
+    }
+    if (!REPLAY_FILE.empty()) {
+        std::cout << "Replaying requests from: " << REPLAY_FILE << " (speed "
+                  << REPLAY_SPEED << ")" << std::endl;
+    }
+    if (!CHECKPOINT_DIR.empty()) {
+        std::cout << "Checkpoint: " << CHECKPOINT_DIR << " after "
+                  << CHECKPOINT_AFTER.count() << "ms, "
+                  << (CHECKPOINT_OPTIONS.bytes_per_second >> 20)
+                  << "MiB/s (0: unlimited)" << std::endl;
+    }
+    if (!ENGINE_STORE.empty()) {
+        std::cout << "Engine store: " << ENGINE_STORE
+                  << " (reopened, key map recovered)" << std::endl;
+    }
+    if (!ENGINE_PROFILE_TAG.empty()) {
+        std::cout << "Engine profile: " << ENGINE_PROFILE_TAG << " ("
+                  << EngineTuning::describe(ENGINE_PROFILE, STORAGE_ENGINE)
+                  << ")" << std::endl;
+    }
+    if (STORAGE_ENGINE.find("leveldb") != std::string::npos) {
+        const LevelDBPartitionOptions &leveldb = ENGINE_PROFILE.leveldb;
+        std::cout << "LevelDB options: cache="
+                  << (leveldb.block_cache_size >> 20)
+                  << "MiB, bloom_bits=" << leveldb.bloom_bits_per_key
+                  << ", write_buffer=" << (leveldb.write_buffer_size >> 10)
+                  << "KiB ("
+                  << ENGINE_PROFILE.leveldb_partitions.size()
+                  << " partition overrides; 0: LevelDB default)" << std::endl;
+        std::cout << "Compaction: "
+                  << (COMPACTION.bytes_per_second >> 20) << "MiB/s, stagger="
+                  << COMPACTION.stagger.count() << "ms, interval="
+                  << COMPACTION.interval.count() << "ms (0: unlimited/off)"
+                  << std::endl;
+    }
+    if (STORAGE_ENGINE.find("lmdb") != std::string::npos) {
+        const LmdbOptions &lmdb = ENGINE_PROFILE.lmdb;
+        std::cout << "LMDB options: map=" << (lmdb.map_size >> 20)
+                  << "MiB, max_map=" << (lmdb.max_map_size >> 20)
+                  << "MiB (0: unlimited), writemap=" << lmdb.write_map
+                  << ", mapasync=" << lmdb.map_async
+                  << ", max_readers=" << lmdb.max_readers << std::endl;
+    }
+    if (ADMISSION_POLICY.enabled()) {
+        std::cout << "Admission control: depth="
+                  << ADMISSION_POLICY.max_queue_depth
+                  << ", target=" << ADMISSION_POLICY.target_delay.count()
+                  << "us, interval=" << ADMISSION_POLICY.interval.count()
+                  << "us, deadline=" << ADMISSION_POLICY.deadline.count()
+                  << "us, retry=" << ADMISSION_RETRY_AFTER.count() << "us"
+                  << std::endl;
+    }
     std::cout << std::endl;
 
     std::vector<std::unique_ptr<workload::RequestGenerator>> generators;
@@ -1146,6 +2105,9 @@ int run_repart_kv(int argc, char *argv[]) {
     }
 
     size_t n_operations = generators[0]->config().n_operations * TEST_WORKERS;
+    for (const auto &requests : REPLAY_REQUESTS) {
+        n_operations = std::max(n_operations, requests.size());
+    }
     START_TIMES =
         new std::chrono::high_resolution_clock::time_point *[TEST_WORKERS];
     END_TIMES =
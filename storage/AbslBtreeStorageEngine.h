@@ -7,6 +7,7 @@
 #include <vector>
 #include <algorithm>
 #include <shared_mutex>
+#include <span>
 
 /**
  * @brief absl::btree_map implementation of StorageEngine
@@ -60,6 +61,17 @@ public:
         return Status::NOT_FOUND;
     }
 
+    /**
+     * @brief Implementation: Read a batch of keys under one shared lock,
+     * overlapping their lookups (see multi_read::ordered_multi_read())
+     * @param requests Keys to read; each receives its value and status
+     */
+    void multi_read_impl(std::span<ReadRequest> requests) const {
+        lock_.lock_shared();
+        multi_read::ordered_multi_read(storage_, requests);
+        lock_.unlock_shared();
+    }
+
     /**
      * @brief Implementation: Write a key-value pair
      * @param key The key to write
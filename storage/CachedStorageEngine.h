@@ -0,0 +1,572 @@
+#pragma once
+
+#include "StorageEngineIterator.h"
+#include "StorageEngine.h"
+#include "EngineThreading.h"
+#include "EngineTuning.h"
+#include "../kvstorage/threaded/StrandPool.h"
+#include <ankerl/unordered_dense.h>
+#include <tbb/concurrent_queue.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Counters of a CachedStorageEngine's read cache
+ */
+struct CacheStats {
+    uint64_t hits = 0;       // Reads served from the cache
+    uint64_t misses = 0;     // Reads that went to the engine
+    uint64_t prefetched = 0; // Entries loaded by prefetch()
+    uint64_t wasted = 0;     // Prefetched entries dropped before any read
+
+    /**
+     * @brief Get the fraction of reads served from the cache
+     * @return Hits over reads, 0 before the first read
+     */
+    double hit_rate() const {
+        uint64_t reads = hits + misses;
+        if (reads == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(hits) / static_cast<double>(reads);
+    }
+
+    /**
+     * @brief Get the fraction of prefetched entries never read
+     *
+     * Prefetched entries still cached and not read yet are not counted as
+     * wasted, since they may still be read.
+     *
+     * @return Wasted over prefetched entries, 0 before the first prefetch
+     */
+    double wasted_prefetch_ratio() const {
+        if (prefetched == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(wasted) / static_cast<double>(prefetched);
+    }
+
+    CacheStats &operator+=(const CacheStats &other) {
+        hits += other.hits;
+        misses += other.misses;
+        prefetched += other.prefetched;
+        wasted += other.wasted;
+        return *this;
+    }
+};
+
+/**
+ * @brief Storage engine that keeps a CLOCK read cache in front of another
+ * engine
+ *
+ * Meant for disk engines (LMDB, LevelDB): reads are served from memory when
+ * the key is cached, and prefetch() loads keys the caller expects to be read
+ * soon in the background, so a dependent read that follows finds its key
+ * cached. HardRepartitioningKeyValueStorage prefetches the strongest
+ * access-graph neighbours of every key it reads. Prefetches run on a pool
+ * shared by every engine of the type (prefetch_pool()), each engine as one
+ * strand, rather than on a thread per engine.
+ *
+ * The cache holds up to PartitionCacheTuning::capacity entries, split by key
+ * hash into up to MAX_SHARDS shards of at least MIN_SHARD_ENTRIES entries,
+ * each a CLOCK of its own. CLOCK gives every entry a referenced bit, set
+ * when it is read; the hand clears set bits and evicts the first entry it
+ * finds without one. Prefetched entries start unreferenced, so those that
+ * are never read leave first. A hit holds its shard's lock shared only and
+ * sets the bit with a relaxed store, so concurrent hits do not serialize;
+ * misses lock their shard exclusively to insert.
+ *
+ * Writes go to the engine and refresh a cached entry; removes drop it. They
+ * hold the internal engine lock exclusively, while reads and prefetches hold
+ * it shared, so the cache never keeps a value older than the engine's.
+ * Prefetches beyond PartitionCacheTuning::prefetch_queue pending ones are
+ * dropped. Scans and checkpoints go to the engine. Iterator lookups, which
+ * serve the scans of partitioned storages, use cached values but neither
+ * fill the cache nor count as hits or misses, so a long scan does not
+ * flush it.
+ *
+ * Like the other engines, operations do not take the StorageEngine lock().
+ *
+ * @tparam EngineTemplate Engine template behind the cache (e.g.
+ *         \c LmdbStorageEngine)
+ * @tparam SYNC Durable sync flag, forwarded to the engine
+ */
+template <template <bool> class EngineTemplate, bool SYNC = false>
+class CachedStorageEngine
+    : public StorageEngine<CachedStorageEngine<EngineTemplate, SYNC>, SYNC> {
+public:
+    using BackingEngineType = EngineTemplate<SYNC>;
+
+private:
+    using Base = StorageEngine<CachedStorageEngine<EngineTemplate, SYNC>, SYNC>;
+
+    // Most shards the cache is split into
+    static constexpr size_t MAX_SHARDS = 16;
+    // Fewest entries of a shard, so small caches keep a single clock
+    static constexpr size_t MIN_SHARD_ENTRIES = 256;
+
+    struct Entry {
+        std::string key;
+        std::string value;
+        std::atomic<bool> referenced; // Read since the hand last passed
+        std::atomic<bool> prefetched; // Loaded by prefetch(), not read yet
+
+        Entry(const std::string &k, const std::string &v, bool p) :
+            key(k), value(v), referenced(!p), prefetched(p) {}
+    };
+
+    /**
+     * @brief One CLOCK of the cache
+     *
+     * Hits hold mutex shared and only store to the atomic bits of their
+     * entry; inserts, evictions, refreshes and removes hold it exclusively.
+     */
+    struct alignas(64) Shard {
+        std::shared_mutex mutex;   // Guards the fields below
+        std::deque<Entry> entries; // Cached entries (the clock)
+        ankerl::unordered_dense::map<std::string, size_t>
+            slots;           // Key -> index in entries
+        size_t capacity = 0; // Entries this shard holds at most
+        size_t hand = 0;     // Next entry the clock hand looks at
+    };
+
+    std::unique_ptr<BackingEngineType> engine_; // Engine behind the cache
+    PartitionCacheTuning tuning_;               // Capacity and queue size
+    mutable std::shared_mutex engine_lock_;     // Exclusive to update engine_
+    mutable std::vector<std::unique_ptr<Shard>> shards_; // The cache
+    mutable ShardedCounter hits_;       // Reads served from the cache
+    mutable ShardedCounter misses_;     // Reads that went to the engine
+    mutable ShardedCounter prefetched_; // Entries loaded by prefetch()
+    mutable ShardedCounter wasted_;     // Prefetched entries never read
+    tbb::concurrent_bounded_queue<std::string>
+        prefetch_queue_;        // Keys waiting to be prefetched
+    std::atomic<bool> running_; // Cleared to stop prefetching
+    Strand strand_;             // Scheduling state on prefetch_pool()
+
+    Shard &shard_of(const std::string &key) const {
+        return *shards_[ankerl::unordered_dense::hash<std::string>{}(key) %
+                        shards_.size()];
+    }
+
+    /**
+     * @brief Look a key up in the cache and mark it referenced
+     * @return true on a hit
+     */
+    bool lookup(const std::string &key, std::string &value) const {
+        Shard &shard = shard_of(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.slots.find(key);
+        if (it == shard.slots.end()) {
+            misses_.add();
+            return false;
+        }
+        Entry &entry = shard.entries[it->second];
+        // Store only when the bits change, so hot entries stay shared
+        if (!entry.referenced.load(std::memory_order_relaxed)) {
+            entry.referenced.store(true, std::memory_order_relaxed);
+        }
+        if (entry.prefetched.load(std::memory_order_relaxed)) {
+            entry.prefetched.store(false, std::memory_order_relaxed);
+        }
+        value = entry.value;
+        hits_.add();
+        return true;
+    }
+
+    /**
+     * @brief Cache a value read from the engine, evicting an entry if full
+     *
+     * The caller holds engine_lock_ (shared at least), so value is the
+     * engine's current one.
+     *
+     * @param prefetched Whether prefetch() loaded the value
+     * @return false if the key was already cached (the entry is left as is)
+     */
+    bool insert(const std::string &key, const std::string &value,
+                bool prefetched) const {
+        Shard &shard = shard_of(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (shard.capacity == 0 || shard.slots.contains(key)) {
+            return false;
+        }
+        size_t slot;
+        if (shard.entries.size() < shard.capacity) {
+            slot = shard.entries.size();
+            shard.entries.emplace_back(key, value, prefetched);
+        } else {
+            while (shard.entries[shard.hand].referenced.load(
+                std::memory_order_relaxed)) {
+                shard.entries[shard.hand].referenced.store(
+                    false, std::memory_order_relaxed);
+                shard.hand = (shard.hand + 1) % shard.entries.size();
+            }
+            slot = shard.hand;
+            shard.hand = (shard.hand + 1) % shard.entries.size();
+            Entry &victim = shard.entries[slot];
+            if (victim.prefetched.load(std::memory_order_relaxed)) {
+                wasted_.add();
+            }
+            shard.slots.erase(victim.key);
+            victim.key = key;
+            victim.value = value;
+            victim.referenced.store(!prefetched, std::memory_order_relaxed);
+            victim.prefetched.store(prefetched, std::memory_order_relaxed);
+        }
+        shard.slots.emplace(key, slot);
+        if (prefetched) {
+            prefetched_.add();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Drop a key from the cache; the caller holds engine_lock_
+     * exclusively
+     */
+    void erase(const std::string &key) {
+        Shard &shard = shard_of(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.slots.find(key);
+        if (it == shard.slots.end()) {
+            return;
+        }
+        size_t slot = it->second;
+        shard.slots.erase(it);
+        if (shard.entries[slot].prefetched.load(std::memory_order_relaxed)) {
+            wasted_.add();
+        }
+        // The last entry takes the freed slot
+        if (slot + 1 != shard.entries.size()) {
+            Entry &entry = shard.entries[slot];
+            Entry &last = shard.entries.back();
+            entry.key = std::move(last.key);
+            entry.value = std::move(last.value);
+            entry.referenced.store(
+                last.referenced.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            entry.prefetched.store(
+                last.prefetched.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            shard.slots[entry.key] = slot;
+        }
+        shard.entries.pop_back();
+        if (shard.hand >= shard.entries.size()) {
+            shard.hand = 0;
+        }
+    }
+
+    /**
+     * @brief Replace the value of a cached key; the caller holds engine_lock_
+     * exclusively
+     */
+    void refresh(const std::string &key, const std::string &value) {
+        Shard &shard = shard_of(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.slots.find(key);
+        if (it != shard.slots.end()) {
+            shard.entries[it->second].value = value;
+        }
+    }
+
+    /**
+     * @brief Read a key for a scan: from the cache if it is there, without
+     * caching it or counting it
+     */
+    Status scan_read(const std::string &key, std::string &value) const {
+        {
+            Shard &shard = shard_of(key);
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.slots.find(key);
+            if (it != shard.slots.end()) {
+                value = shard.entries[it->second].value;
+                return Status::SUCCESS;
+            }
+        }
+        std::shared_lock<std::shared_mutex> lock(engine_lock_);
+        return engine_->read(key, value);
+    }
+
+    bool cached(const std::string &key) const {
+        Shard &shard = shard_of(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.slots.contains(key);
+    }
+
+    void start(size_t level, const std::string &path,
+               std::optional<size_t> partition, const EngineProfile &profile) {
+        engine_.reset(
+            new_engine<BackingEngineType>(level, path, partition, profile));
+        const size_t shard_count = std::clamp<size_t>(
+            tuning_.capacity / MIN_SHARD_ENTRIES, 1, MAX_SHARDS);
+        shards_.reserve(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+            shards_[i]->capacity = tuning_.capacity / shard_count +
+                                   (i < tuning_.capacity % shard_count);
+        }
+        prefetch_queue_.set_capacity(
+            static_cast<std::ptrdiff_t>(tuning_.prefetch_queue));
+    }
+
+public:
+    using PrefetchPool = StrandPool<CachedStorageEngine>;
+
+    /**
+     * @brief Get the pool running the prefetches of every engine of the type
+     * @return The pool, started on first use with a quarter of the hardware
+     * threads (at least one)
+     */
+    static PrefetchPool &prefetch_pool() {
+        static PrefetchPool pool(
+            std::max<size_t>(std::thread::hardware_concurrency() / 4, 1));
+        return pool;
+    }
+
+    // The cache and the engine behind it take their parts of a whole profile
+    using TuningType = EngineProfile;
+
+    /**
+     * @brief Get this engine's tuning in a profile
+     * @param profile The profile
+     * @param partition Partition index, if known (unused)
+     * @return The whole profile
+     */
+    static const EngineProfile &
+    profile_tuning(const EngineProfile &profile,
+                   std::optional<size_t> partition) {
+        (void)partition;
+        return profile;
+    }
+
+    /**
+     * @brief Constructor
+     * @param level The hierarchy level for this storage engine (default: 0)
+     * @param path Optional path for embedded database files (default: /tmp)
+     * @param tuning Cache capacity and prefetch queue size
+     */
+    explicit CachedStorageEngine(
+        size_t level = 0, const std::string &path = "/tmp",
+        const PartitionCacheTuning &tuning = EngineTuning::profile().cache) :
+        Base(level, path), tuning_(tuning), running_(true) {
+        start(level, path, std::nullopt, EngineTuning::profile());
+    }
+
+    /**
+     * @brief Constructor - tunes the cache and the engine behind it
+     * @param level The hierarchy level for this storage engine
+     * @param path Path for embedded database files
+     * @param profile Tuning of the cache and of the engine
+     */
+    CachedStorageEngine(size_t level, const std::string &path,
+                        const EngineProfile &profile) :
+        Base(level, path), tuning_(profile.cache), running_(true) {
+        start(level, path, std::nullopt, profile);
+    }
+
+    /**
+     * @brief Constructor - creates the engine of a partition
+     *
+     * The engine behind the cache is created with the partition index if it
+     * takes one (e.g. LevelDB's per-partition options, or the partition's
+     * EnginePersistence store).
+     *
+     * @param level The hierarchy level for this storage engine
+     * @param path Path for embedded database files
+     * @param partition Partition index
+     * @param profile Tuning of the cache and of the engine (default: the
+     * EngineTuning profile)
+     */
+    CachedStorageEngine(
+        size_t level, const std::string &path, size_t partition,
+        const EngineProfile &profile = EngineTuning::profile()) :
+        Base(level, path), tuning_(profile.cache), running_(true) {
+        start(level, path, partition, profile);
+    }
+
+    /**
+     * @brief Destructor - drops the pending prefetches and waits for the
+     * pool to let go of the engine
+     */
+    ~CachedStorageEngine() {
+        running_.store(false, std::memory_order_release);
+        while (!strand_.idle()) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Copy constructor and assignment operator are deleted
+    CachedStorageEngine(const CachedStorageEngine &) = delete;
+    CachedStorageEngine &operator=(const CachedStorageEngine &) = delete;
+
+    /**
+     * @brief Load a key into the cache in the background
+     *
+     * Returns at once. Keys already cached or absent from the engine are
+     * skipped, and the key is dropped when the prefetch queue is full.
+     *
+     * @param key The key expected to be read soon
+     */
+    void prefetch(const std::string &key) {
+        if (prefetch_queue_.try_push(key) && strand_.notify()) {
+            prefetch_pool().submit(this);
+        }
+    }
+
+    /**
+     * @brief Get the engine's scheduling state (for the prefetch pool)
+     * @return The strand
+     */
+    Strand &strand() { return strand_; }
+
+    /**
+     * @brief Load queued keys into the cache (prefetch pool threads only)
+     * @param turns Most keys to load
+     * @return true if keys may be left in the queue
+     */
+    bool run(size_t turns) {
+        std::string key;
+        std::string value;
+        for (size_t i = 0; i < turns; ++i) {
+            if (!running_.load(std::memory_order_acquire) ||
+                !prefetch_queue_.try_pop(key)) {
+                return false;
+            }
+            if (cached(key)) {
+                continue;
+            }
+            std::shared_lock<std::shared_mutex> lock(engine_lock_);
+            if (engine_->read(key, value) == Status::SUCCESS) {
+                insert(key, value, true);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Get the cache counters
+     * @return Hits, misses, prefetched and wasted entries since creation
+     * (approximate while other threads use the engine)
+     */
+    CacheStats cache_stats() const {
+        CacheStats stats;
+        stats.hits = hits_.load();
+        stats.misses = misses_.load();
+        stats.prefetched = prefetched_.load();
+        stats.wasted = wasted_.load();
+        return stats;
+    }
+
+    /**
+     * @brief Get the number of cached entries
+     * @return Entries, at most the capacity
+     */
+    size_t cached_count() const {
+        size_t count = 0;
+        for (const auto &shard : shards_) {
+            std::shared_lock<std::shared_mutex> lock(shard->mutex);
+            count += shard->entries.size();
+        }
+        return count;
+    }
+
+    /**
+     * @brief Get the cache tuning
+     * @return Capacity and prefetch queue size
+     */
+    const PartitionCacheTuning &cache_tuning() const { return tuning_; }
+
+    Status read_impl(const std::string &key, std::string &value) const {
+        if (lookup(key, value)) {
+            return Status::SUCCESS;
+        }
+        std::shared_lock<std::shared_mutex> lock(engine_lock_);
+        Status status = engine_->read(key, value);
+        if (status == Status::SUCCESS) {
+            insert(key, value, false);
+        }
+        return status;
+    }
+
+    Status write_impl(const std::string &key, const std::string &value) {
+        std::unique_lock<std::shared_mutex> lock(engine_lock_);
+        Status status = engine_->write(key, value);
+        if (status == Status::SUCCESS) {
+            refresh(key, value);
+        } else {
+            erase(key);
+        }
+        return status;
+    }
+
+    Status remove_impl(const std::string &key, std::string &removed_value) {
+        std::unique_lock<std::shared_mutex> lock(engine_lock_);
+        erase(key);
+        return engine_->remove(key, removed_value);
+    }
+
+    Status
+    scan_impl(const std::string &initial_key_prefix, size_t limit,
+              std::vector<std::pair<std::string, std::string>> &results) const {
+        std::shared_lock<std::shared_mutex> lock(engine_lock_);
+        return engine_->scan(initial_key_prefix, limit, results);
+    }
+
+    /**
+     * @brief Write a point-in-time image of the engine behind the cache
+     *
+     * The image has the engine's own format, so it reopens as that engine
+     * or as a CachedStorageEngine over it.
+     */
+    Status checkpoint_impl(const std::string &directory, size_t partition,
+                           TokenBucket &throttle,
+                           const std::function<void()> &captured) {
+        return engine_->checkpoint(directory, partition, throttle, captured);
+    }
+
+    /**
+     * @brief Iterator over a CachedStorageEngine
+     *
+     * Looks keys up in the cache, then in the engine, without filling the
+     * cache (see CachedStorageEngine).
+     */
+    class CachedIterator
+        : public StorageEngineIterator<CachedIterator, CachedStorageEngine> {
+    public:
+        explicit CachedIterator(CachedStorageEngine &engine) :
+            StorageEngineIterator<CachedIterator, CachedStorageEngine>(engine) {
+        }
+
+        Status find_impl(const std::string &key, std::string &value) const {
+            return this->engine_->scan_read(key, value);
+        }
+    };
+
+    CachedIterator iterator_impl() { return CachedIterator(*this); }
+
+    using IteratorType = CachedIterator;
+};
+
+/**
+ * @brief Whether an engine type is a CachedStorageEngine
+ */
+template <typename T> struct is_cached_storage_engine : std::false_type {};
+
+template <template <bool> class Engine, bool SYNC>
+struct is_cached_storage_engine<CachedStorageEngine<Engine, SYNC>>
+    : std::true_type {};
+
+template <typename T>
+inline constexpr bool is_cached_storage_engine_v =
+    is_cached_storage_engine<T>::value;
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "TokenBucket.h"
+#include <leveldb/db.h>
+#include <leveldb/env.h>
+#include <leveldb/status.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Cross-partition I/O scheduler for LevelDB compactions
+ *
+ * Every partition of a partitioned storage on LevelDB is its own leveldb::DB
+ * with its own background compactions, so several partitions tend to compact
+ * at once and saturate the disk. LevelDBStorageEngine opens its databases
+ * with env(), and registers them here, so that:
+ * - table files written in the background (memtable flushes and compaction
+ *   outputs) draw from one token bucket shared by all partitions, capping
+ *   their combined write rate; log writes on the request path are not
+ *   throttled;
+ * - manual compactions (compact()) run one database at a time, at least
+ *   stagger apart;
+ * - optionally, a rotation thread compacts the registered databases one
+ *   after the other, every interval, so their compactions are spread in time
+ *   instead of piling up.
+ *
+ * One scheduler serves the whole process (instance()).
+ */
+class CompactionScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Scheduler settings; zero disables a limit
+     */
+    struct Settings {
+        uint64_t bytes_per_second = 0; // Background table write rate
+        uint64_t burst_bytes = 0;      // Bucket capacity (0: one second)
+        std::chrono::milliseconds stagger{0};  // Gap between compactions
+        std::chrono::milliseconds interval{0}; // Rotation period (0: off)
+    };
+
+private:
+    /**
+     * @brief Table file whose appends draw from the token bucket
+     */
+    class ThrottledFile : public leveldb::WritableFile {
+    private:
+        leveldb::WritableFile *file_; // Owned file being written
+        TokenBucket &bucket_;         // Scheduler's bucket
+
+    public:
+        ThrottledFile(leveldb::WritableFile *file, TokenBucket &bucket) :
+            file_(file), bucket_(bucket) {}
+
+        ~ThrottledFile() override { delete file_; }
+
+        leveldb::Status Append(const leveldb::Slice &data) override {
+            bucket_.acquire(data.size());
+            return file_->Append(data);
+        }
+
+        leveldb::Status Close() override { return file_->Close(); }
+        leveldb::Status Flush() override { return file_->Flush(); }
+        leveldb::Status Sync() override { return file_->Sync(); }
+    };
+
+    /**
+     * @brief Default Env whose table files are throttled
+     */
+    class ThrottledEnv : public leveldb::EnvWrapper {
+    private:
+        TokenBucket &bucket_; // Scheduler's bucket
+
+        static bool is_table_file(const std::string &name) {
+            for (const char *suffix : {".ldb", ".sst"}) {
+                std::string ending(suffix);
+                if (name.size() >= ending.size() &&
+                    name.compare(name.size() - ending.size(), ending.size(),
+                                 ending) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    public:
+        explicit ThrottledEnv(TokenBucket &bucket) :
+            leveldb::EnvWrapper(leveldb::Env::Default()), bucket_(bucket) {}
+
+        leveldb::Status
+        NewWritableFile(const std::string &name,
+                        leveldb::WritableFile **result) override {
+            leveldb::Status status = target()->NewWritableFile(name, result);
+            if (status.ok() && is_table_file(name)) {
+                *result = new ThrottledFile(*result, bucket_);
+            }
+            return status;
+        }
+    };
+
+    TokenBucket bucket_;                    // Shared background write budget
+    ThrottledEnv env_;                      // Env of the registered databases
+    mutable std::mutex mutex_;              // Guards the fields below
+    std::condition_variable changed_;       // Signals any change below
+    std::vector<leveldb::DB *> databases_;  // Registered databases
+    size_t next_;                           // Next database of the rotation
+    leveldb::DB *compacting_;               // Database being compacted
+    Clock::time_point earliest_;            // Earliest next compaction start
+    std::chrono::milliseconds stagger_;     // Gap between compactions
+    std::chrono::milliseconds interval_;    // Rotation period (0: off)
+    size_t compactions_;                    // Compactions completed
+    bool stopping_;                         // Rotation thread must exit
+    std::thread rotation_;                  // Rotation thread, if started
+
+    CompactionScheduler() :
+        env_(bucket_), next_(0), compacting_(nullptr),
+        earliest_(Clock::now()), stagger_(0), interval_(0), compactions_(0),
+        stopping_(false) {}
+
+    /**
+     * @brief Wait for the compaction slot, take it and run a compaction
+     * @param lock Lock on mutex_, held on entry and on return
+     * @param pick Chooses the database once the slot is free (nullptr: none)
+     */
+    template <typename Pick>
+    void run(std::unique_lock<std::mutex> &lock, Pick &&pick) {
+        for (;;) {
+            if (compacting_ != nullptr) {
+                changed_.wait(lock);
+            } else if (Clock::now() < earliest_) {
+                changed_.wait_until(lock, earliest_);
+            } else {
+                break;
+            }
+        }
+        leveldb::DB *db = pick();
+        if (db == nullptr) {
+            return;
+        }
+        compacting_ = db;
+        lock.unlock();
+        db->CompactRange(nullptr, nullptr);
+        lock.lock();
+        compacting_ = nullptr;
+        earliest_ = Clock::now() + stagger_;
+        ++compactions_;
+        changed_.notify_all();
+    }
+
+    void rotate() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (interval_.count() == 0) {
+                changed_.wait(lock);
+                continue;
+            }
+            if (changed_.wait_for(lock, interval_,
+                                  [this] { return stopping_; })) {
+                break;
+            }
+            run(lock, [this]() -> leveldb::DB * {
+                if (stopping_ || databases_.empty()) {
+                    return nullptr;
+                }
+                return databases_[next_++ % databases_.size()];
+            });
+        }
+    }
+
+public:
+    ~CompactionScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        changed_.notify_all();
+        if (rotation_.joinable()) {
+            rotation_.join();
+        }
+    }
+
+    // Copy constructor and assignment operator are deleted
+    CompactionScheduler(const CompactionScheduler &) = delete;
+    CompactionScheduler &operator=(const CompactionScheduler &) = delete;
+
+    /**
+     * @brief Get the process-wide scheduler
+     * @return The scheduler
+     */
+    static CompactionScheduler &instance() {
+        static CompactionScheduler scheduler;
+        return scheduler;
+    }
+
+    /**
+     * @brief Apply new settings
+     *
+     * Starts the rotation thread the first time an interval is set.
+     *
+     * @param settings The settings
+     */
+    void configure(const Settings &settings) {
+        bucket_.configure(settings.bytes_per_second, settings.burst_bytes);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stagger_ = settings.stagger;
+            interval_ = settings.interval;
+            if (interval_.count() > 0 && !rotation_.joinable()) {
+                rotation_ = std::thread(&CompactionScheduler::rotate, this);
+            }
+        }
+        changed_.notify_all();
+    }
+
+    /**
+     * @brief Get the current settings
+     * @return The settings
+     */
+    Settings settings() const {
+        Settings settings;
+        settings.bytes_per_second = bucket_.rate();
+        settings.burst_bytes = bucket_.burst();
+        std::lock_guard<std::mutex> lock(mutex_);
+        settings.stagger = stagger_;
+        settings.interval = interval_;
+        return settings;
+    }
+
+    /**
+     * @brief Get the Env databases must be opened with to be throttled
+     * @return The throttled Env (valid for the life of the process)
+     */
+    leveldb::Env *env() { return &env_; }
+
+    /**
+     * @brief Register a database for rotation and manual compaction
+     * @param db The open database
+     */
+    void add(leveldb::DB *db) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        databases_.push_back(db);
+    }
+
+    /**
+     * @brief Unregister a database before closing it
+     *
+     * Waits for a compaction of the database to finish.
+     *
+     * @param db The database
+     */
+    void remove(leveldb::DB *db) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [&] { return compacting_ != db; });
+        databases_.erase(std::remove(databases_.begin(), databases_.end(), db),
+                         databases_.end());
+    }
+
+    /**
+     * @brief Compact a whole database once no other compaction runs
+     *
+     * Blocks until the compaction slot is free and stagger has elapsed since
+     * the previous compaction, then until the compaction is done.
+     *
+     * @param db The database
+     */
+    void compact(leveldb::DB *db) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        run(lock, [db] { return db; });
+    }
+
+    /**
+     * @brief Get the number of compactions run by the scheduler
+     * @return Completed manual and rotation compactions
+     */
+    size_t compactions() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return compactions_;
+    }
+
+    /**
+     * @brief Get the number of registered databases
+     * @return Open databases using the scheduler
+     */
+    size_t database_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return databases_.size();
+    }
+};
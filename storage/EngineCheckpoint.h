@@ -0,0 +1,205 @@
+#pragma once
+
+#include "Status.h"
+#include "TokenBucket.h"
+#include <unistd.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Point-in-time images of storage engines
+ *
+ * StorageEngine::checkpoint() writes the image of one partition's engine
+ * into a checkpoint directory, under the same <engine>_<partition> name the
+ * engine uses in an EnginePersistence store. LMDB copies its environment
+ * with compaction (mdb_env_copyfd2), LevelDB writes a new database from a
+ * snapshot and Tkrzw copies its file (CopyFileData). Engines without a
+ * native copy are read into memory and written as a record file,
+ * partition_<partition>.img, in the format below.
+ *
+ * Record files start with the 8-byte magic "RPKVIMG1". Each record is a 1
+ * byte followed by its key and its value, each a LEB128 varint length and
+ * the raw bytes. A 0 byte and the record count (varint) end the file, so a
+ * truncated file is detected.
+ *
+ * Image bytes go through a TokenBucket shared by all the partitions of a
+ * checkpoint, in chunks of up to CHUNK_BYTES.
+ */
+class EngineCheckpoint {
+private:
+    static constexpr std::string_view MAGIC{"RPKVIMG1", 8};
+
+    static void append_varint(std::string &out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    static bool read_varint(std::istream &in, uint64_t &value) {
+        value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            int byte = in.get();
+            if (byte == std::char_traits<char>::eof()) {
+                return false;
+            }
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool read_string(std::istream &in, std::string &value) {
+        uint64_t size;
+        if (!read_varint(in, size)) {
+            return false;
+        }
+        value.resize(size);
+        in.read(value.data(), static_cast<std::streamsize>(size));
+        return static_cast<uint64_t>(in.gcount()) == size;
+    }
+
+public:
+    static constexpr size_t CHUNK_BYTES = 1 << 20; // Bytes per throttled write
+
+    /**
+     * @brief Get the record file of a partition in a checkpoint directory
+     * @param directory Checkpoint directory
+     * @param partition Partition index
+     * @return <directory>/partition_<partition>.img
+     */
+    static std::string record_file(const std::string &directory,
+                                   size_t partition) {
+        return directory + "/partition_" + std::to_string(partition) + ".img";
+    }
+
+    /**
+     * @brief Write records to a record file
+     * @param file File to create
+     * @param records Key-value pairs, in any order
+     * @param throttle Budget the written bytes are taken from
+     * @return Status::SUCCESS, or Status::ERROR if the file could not be
+     * written
+     */
+    static Status
+    write_records(const std::string &file,
+                  const std::vector<std::pair<std::string, std::string>> &records,
+                  TokenBucket &throttle) {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return Status::ERROR;
+        }
+        std::string chunk(MAGIC);
+        for (const auto &[key, value] : records) {
+            chunk.push_back(1);
+            append_varint(chunk, key.size());
+            chunk.append(key);
+            append_varint(chunk, value.size());
+            chunk.append(value);
+            if (chunk.size() >= CHUNK_BYTES) {
+                throttle.acquire(chunk.size());
+                out.write(chunk.data(),
+                          static_cast<std::streamsize>(chunk.size()));
+                chunk.clear();
+            }
+        }
+        chunk.push_back(0);
+        append_varint(chunk, records.size());
+        throttle.acquire(chunk.size());
+        out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        out.flush();
+        return out ? Status::SUCCESS : Status::ERROR;
+    }
+
+    /**
+     * @brief Read the records of a record file
+     * @param file File written by write_records()
+     * @param apply Called with each key and value, in file order
+     * @return Status::SUCCESS, Status::NOT_FOUND if the file does not exist,
+     * or Status::ERROR if it is invalid or truncated (records before the
+     * damage have been applied)
+     */
+    static Status read_records(
+        const std::string &file,
+        const std::function<void(const std::string &, const std::string &)>
+            &apply) {
+        std::ifstream in(file, std::ios::binary);
+        if (!in) {
+            return Status::NOT_FOUND;
+        }
+        char magic[MAGIC.size()];
+        in.read(magic, sizeof(magic));
+        if (in.gcount() != sizeof(magic) ||
+            std::string_view(magic, sizeof(magic)) != MAGIC) {
+            return Status::ERROR;
+        }
+        std::string key;
+        std::string value;
+        uint64_t count = 0;
+        for (int marker = in.get(); marker == 1; marker = in.get()) {
+            if (!read_string(in, key) || !read_string(in, value)) {
+                return Status::ERROR;
+            }
+            apply(key, value);
+            ++count;
+        }
+        uint64_t expected;
+        if (!in || !read_varint(in, expected) || expected != count) {
+            return Status::ERROR;
+        }
+        return Status::SUCCESS;
+    }
+
+    /**
+     * @brief Copy what an engine writes into a pipe to a file
+     *
+     * Reads until the write end is closed. Reading at the budget's pace
+     * slows the writer down once the pipe is full.
+     *
+     * @param fd Read end of the pipe (left open)
+     * @param file File to create
+     * @param throttle Budget the copied bytes are taken from
+     * @param first_bytes Called when the first bytes arrive, or at the end if
+     * none do
+     * @return Status::SUCCESS, or Status::ERROR if the file could not be
+     * written (the pipe is still drained)
+     */
+    static Status drain(int fd, const std::string &file, TokenBucket &throttle,
+                        const std::function<void()> &first_bytes) {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        std::vector<char> buffer(64 << 10);
+        bool started = false;
+        bool failed = false;
+        while (true) {
+            ssize_t n = ::read(fd, buffer.data(), buffer.size());
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                failed = failed || n < 0;
+                break;
+            }
+            if (!started) {
+                started = true;
+                first_bytes();
+            }
+            throttle.acquire(static_cast<uint64_t>(n));
+            out.write(buffer.data(), n);
+        }
+        if (!started) {
+            first_bytes();
+        }
+        out.flush();
+        return out && !failed ? Status::SUCCESS : Status::ERROR;
+    }
+};
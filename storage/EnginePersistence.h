@@ -0,0 +1,88 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Process-wide switch for partition engines that survive a restart
+ *
+ * Disk engines normally open a fresh temporary file under
+ * <path>/repart_kv_storage/<process id>, truncated, so nothing outlives the
+ * process. With a store name set, the partition-aware constructors (used
+ * through new_engine()) open <path>/repart_kv_storage/<name>/
+ * <engine>_<partition> instead, keep what it holds and leave it on disk when
+ * closed. A storage created again with the same name, paths and partition
+ * count then reopens the data of the previous run, and
+ * HardRepartitioningKeyValueStorage::recover() rebuilds its key map from it.
+ *
+ * Set the name before creating the storage. Engines that swap their files
+ * at runtime (TieredStorageEngine), and storages that create partition
+ * engines at runtime (HardThreadedRepartitioningKeyValueStorage and
+ * RangePartitionedKeyValueStorage), must not be used with a name set.
+ */
+class EnginePersistence {
+private:
+    struct Registry {
+        std::mutex mutex; // Guards name
+        std::string name; // Store name (empty: temporary engines)
+    };
+
+    static Registry &registry() {
+        static Registry instance;
+        return instance;
+    }
+
+public:
+    /**
+     * @brief Set the store partition engines reopen
+     * @param name Store name (empty: back to temporary engines)
+     */
+    static void set_name(const std::string &name) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.name = name;
+    }
+
+    /**
+     * @brief Get the store name
+     * @return The name, empty if engines are temporary
+     */
+    static std::string name() {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        return r.name;
+    }
+
+    /**
+     * @brief Check whether partition engines are persistent
+     * @return true if a store name is set
+     */
+    static bool enabled() { return !name().empty(); }
+
+    /**
+     * @brief Get the name of a partition's file within a store
+     * @param engine Engine file prefix (e.g. "lmdb")
+     * @param partition Partition index
+     * @return <engine>_<partition>
+     */
+    static std::string file_name(const std::string &engine, size_t partition) {
+        return engine + "_" + std::to_string(partition);
+    }
+
+    /**
+     * @brief Get the file of a partition in the store, creating its directory
+     * @param path Path for database files, as given to the engine
+     * @param engine Engine file prefix (e.g. "lmdb")
+     * @param partition Partition index
+     * @return <path>/repart_kv_storage/<name>/<engine>_<partition>
+     */
+    static std::string partition_path(const std::string &path,
+                                      const std::string &engine,
+                                      size_t partition) {
+        std::filesystem::path directory =
+            std::filesystem::path(path) / "repart_kv_storage" / name();
+        std::filesystem::create_directories(directory);
+        return (directory / file_name(engine, partition)).string();
+    }
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Statistics counter sharded over cache lines
+ *
+ * Each thread adds to one of SHARDS padded slots, picked once per thread,
+ * so threads sharing an engine do not bounce a single cache line. load()
+ * sums the slots; it is exact once the adding threads are done and
+ * approximate while they run.
+ */
+class ShardedCounter {
+public:
+    static constexpr size_t SHARDS = 16;
+
+    /**
+     * @brief Add to the calling thread's slot
+     * @param count Amount to add
+     */
+    void add(size_t count = 1) {
+        shards_[shard()].value.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the sum of all slots
+     * @return Counter value
+     */
+    size_t load() const {
+        size_t total = 0;
+        for (const Shard &shard : shards_) {
+            total += shard.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic_size_t value{0};
+    };
+
+    std::array<Shard, SHARDS> shards_;
+
+    static size_t shard() {
+        static std::atomic_size_t next_shard{0};
+        thread_local const size_t index =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return index;
+    }
+};
@@ -0,0 +1,478 @@
+#pragma once
+
+#include "LevelDBTuning.h"
+#include "LmdbTuning.h"
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Record compression of a TKRZW database
+ */
+enum class TkrzwCompression { NONE, ZLIB, ZSTD, LZ4, LZMA };
+
+/**
+ * @brief Tuning of a TKRZW TreeDBM (TkrzwTreeStorageEngine,
+ * TkrzwTreeKeyStorage)
+ *
+ * Zero keeps TKRZW's own default for a setting.
+ */
+struct TkrzwTreeTuning {
+    TkrzwCompression compression = TkrzwCompression::NONE; // Record codec
+    int32_t max_page_size = 0;    // Bytes of a B+ tree page
+    int32_t max_branches = 0;     // Children of an inner node
+    int32_t max_cached_pages = 0; // Pages kept in the page cache
+
+    bool operator==(const TkrzwTreeTuning &) const = default;
+};
+
+/**
+ * @brief Tuning of a TKRZW HashDBM (TkrzwHashStorageEngine,
+ * TkrzwHashKeyStorage)
+ *
+ * Zero keeps TKRZW's own default for a setting.
+ */
+struct TkrzwHashTuning {
+    TkrzwCompression compression = TkrzwCompression::NONE; // Record codec
+    int64_t num_buckets = 0;                               // Hash buckets
+
+    bool operator==(const TkrzwHashTuning &) const = default;
+};
+
+/**
+ * @brief Tuning of the read cache of a CachedStorageEngine
+ */
+struct PartitionCacheTuning {
+    size_t capacity = 4096;       // Entries cached per partition
+    size_t prefetch_queue = 1024; // Pending prefetches; more are dropped
+
+    bool operator==(const PartitionCacheTuning &) const = default;
+};
+
+/**
+ * @brief Tuning of every engine and key storage backend
+ *
+ * The defaults are the settings the backends had before they were tunable.
+ */
+struct EngineProfile {
+    std::string name; // Label echoed into the metrics (empty: none)
+    TkrzwTreeTuning tkrzw_tree{TkrzwCompression::ZLIB, 0, 0, 0};
+    TkrzwHashTuning tkrzw_hash{TkrzwCompression::NONE, 1000000};
+    TkrzwTreeTuning tkrzw_tree_keys{TkrzwCompression::NONE, 8192, 256, 0};
+    TkrzwHashTuning tkrzw_hash_keys{TkrzwCompression::NONE, 100000};
+    LevelDBPartitionOptions leveldb; // Defaults of every partition
+    std::map<size_t, LevelDBPartitionOptions>
+        leveldb_partitions;     // Per-partition LevelDB overrides
+    LmdbOptions lmdb;           // Environment settings
+    PartitionCacheTuning cache; // Read cache of cached engines
+
+    bool operator==(const EngineProfile &) const = default;
+};
+
+/**
+ * @brief Process-wide engine profile, loaded from the [engine.*] sections of
+ * a TOML file
+ *
+ * Sections and keys (the keys are the fields of the tuning structs):
+ * - [engine]: name
+ * - [engine.tkrzw_tree], [engine.tkrzw_tree_keys]: compression ("none",
+ *   "zlib", "zstd", "lz4", "lzma"), max_page_size, max_branches,
+ *   max_cached_pages
+ * - [engine.tkrzw_hash], [engine.tkrzw_hash_keys]: compression, num_buckets
+ * - [engine.leveldb]: block_cache_size, bloom_bits_per_key, write_buffer_size
+ * - [engine.lmdb]: map_size, max_map_size, write_map, map_async, max_readers
+ * - [engine.cache]: capacity, prefetch_queue
+ *
+ * Dotted keys (engine.lmdb.map_size = ...) work as well. Everything outside
+ * [engine.*] is left to the workload generator.
+ *
+ * Partitioned storages take a profile as their last constructor argument and
+ * hand every engine and key map they create its part of it; engines and key
+ * storages take their own tuning struct. Both default to profile(), the
+ * process-wide profile, which only serves callers that pass none.
+ */
+class EngineTuning {
+private:
+    struct Registry {
+        std::mutex mutex;      // Guards profile
+        EngineProfile profile; // Profile of backends created from now on
+    };
+
+    static Registry &registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    static std::string trim(const std::string &text) {
+        size_t begin = 0;
+        size_t end = text.size();
+        while (begin < end && std::isspace(static_cast<unsigned char>(
+                                  text[begin]))) {
+            ++begin;
+        }
+        while (end > begin &&
+               std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+            --end;
+        }
+        return text.substr(begin, end - begin);
+    }
+
+    // Drop a comment, ignoring '#' inside a quoted string
+    static std::string strip_comment(const std::string &line) {
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (line[i] == '"') {
+                quoted = !quoted;
+            } else if (line[i] == '#' && !quoted) {
+                return line.substr(0, i);
+            }
+        }
+        return line;
+    }
+
+    static std::string unquote(const std::string &value) {
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            return value.substr(1, value.size() - 2);
+        }
+        return value;
+    }
+
+    // TOML integer (underscores allowed as digit separators)
+    static uint64_t to_number(const std::string &value) {
+        std::string digits;
+        for (char c : value) {
+            if (c != '_') {
+                digits += c;
+            }
+        }
+        size_t used = 0;
+        uint64_t number = digits.empty() || digits[0] == '-'
+                              ? 0
+                              : std::stoull(digits, &used);
+        if (used == 0 || used != digits.size()) {
+            throw std::invalid_argument(value);
+        }
+        return number;
+    }
+
+    static bool to_bool(const std::string &value) {
+        if (value == "true") {
+            return true;
+        }
+        if (value == "false") {
+            return false;
+        }
+        throw std::invalid_argument(value);
+    }
+
+    static TkrzwCompression to_compression(const std::string &value) {
+        const std::string name = unquote(value);
+        if (name == "none") {
+            return TkrzwCompression::NONE;
+        }
+        if (name == "zlib") {
+            return TkrzwCompression::ZLIB;
+        }
+        if (name == "zstd") {
+            return TkrzwCompression::ZSTD;
+        }
+        if (name == "lz4") {
+            return TkrzwCompression::LZ4;
+        }
+        if (name == "lzma") {
+            return TkrzwCompression::LZMA;
+        }
+        throw std::invalid_argument(value);
+    }
+
+    static const char *compression_name(TkrzwCompression compression) {
+        switch (compression) {
+        case TkrzwCompression::ZLIB:
+            return "zlib";
+        case TkrzwCompression::ZSTD:
+            return "zstd";
+        case TkrzwCompression::LZ4:
+            return "lz4";
+        case TkrzwCompression::LZMA:
+            return "lzma";
+        default:
+            return "none";
+        }
+    }
+
+    static int32_t to_int32(const std::string &value) {
+        uint64_t number = to_number(value);
+        if (number > INT32_MAX) {
+            throw std::invalid_argument(value);
+        }
+        return static_cast<int32_t>(number);
+    }
+
+    static bool set_tree(TkrzwTreeTuning &tuning, const std::string &key,
+                         const std::string &value) {
+        if (key == "compression") {
+            tuning.compression = to_compression(value);
+        } else if (key == "max_page_size") {
+            tuning.max_page_size = to_int32(value);
+        } else if (key == "max_branches") {
+            tuning.max_branches = to_int32(value);
+        } else if (key == "max_cached_pages") {
+            tuning.max_cached_pages = to_int32(value);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    static bool set_hash(TkrzwHashTuning &tuning, const std::string &key,
+                         const std::string &value) {
+        if (key == "compression") {
+            tuning.compression = to_compression(value);
+        } else if (key == "num_buckets") {
+            tuning.num_buckets = static_cast<int64_t>(to_number(value));
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    static bool set_leveldb(LevelDBPartitionOptions &options,
+                            const std::string &key, const std::string &value) {
+        if (key == "block_cache_size") {
+            options.block_cache_size = to_number(value);
+        } else if (key == "bloom_bits_per_key") {
+            options.bloom_bits_per_key = to_int32(value);
+        } else if (key == "write_buffer_size") {
+            options.write_buffer_size = to_number(value);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    static bool set_lmdb(LmdbOptions &options, const std::string &key,
+                         const std::string &value) {
+        if (key == "map_size" && to_number(value) > 0) {
+            options.map_size = to_number(value);
+        } else if (key == "max_map_size") {
+            options.max_map_size = to_number(value);
+        } else if (key == "write_map") {
+            options.write_map = to_bool(value);
+        } else if (key == "map_async") {
+            options.map_async = to_bool(value);
+        } else if (key == "max_readers" && to_number(value) > 0) {
+            options.max_readers = static_cast<unsigned int>(to_int32(value));
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    static bool set_cache(PartitionCacheTuning &tuning, const std::string &key,
+                          const std::string &value) {
+        if (key == "capacity" && to_number(value) > 0) {
+            tuning.capacity = to_number(value);
+        } else if (key == "prefetch_queue" && to_number(value) > 0) {
+            tuning.prefetch_queue = to_number(value);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+public:
+    /**
+     * @brief Set one setting of a profile
+     * @param profile The profile
+     * @param section Section below engine ("" for [engine] itself)
+     * @param key Setting name
+     * @param value TOML value (quoted string, integer or boolean)
+     * @throws std::invalid_argument for an unknown setting or a bad value
+     */
+    static void set(EngineProfile &profile, const std::string &section,
+                    const std::string &key, const std::string &value) {
+        bool known = false;
+        try {
+            if (section.empty()) {
+                known = key == "name";
+                if (known) {
+                    profile.name = unquote(value);
+                }
+            } else if (section == "tkrzw_tree") {
+                known = set_tree(profile.tkrzw_tree, key, value);
+            } else if (section == "tkrzw_tree_keys") {
+                known = set_tree(profile.tkrzw_tree_keys, key, value);
+            } else if (section == "tkrzw_hash") {
+                known = set_hash(profile.tkrzw_hash, key, value);
+            } else if (section == "tkrzw_hash_keys") {
+                known = set_hash(profile.tkrzw_hash_keys, key, value);
+            } else if (section == "leveldb") {
+                known = set_leveldb(profile.leveldb, key, value);
+            } else if (section == "lmdb") {
+                known = set_lmdb(profile.lmdb, key, value);
+            } else if (section == "cache") {
+                known = set_cache(profile.cache, key, value);
+            }
+        } catch (const std::exception &) {
+            known = false;
+        }
+        if (!known) {
+            throw std::invalid_argument(
+                "engine" + (section.empty() ? "" : "." + section) + "." +
+                key + " = " + value);
+        }
+    }
+
+    /**
+     * @brief Read a profile from the [engine.*] sections of a TOML file
+     * @param path Path to the TOML file
+     * @return The defaults, overridden by the file's settings
+     * @throws std::runtime_error if the file cannot be read
+     * @throws std::invalid_argument for an unknown setting or a bad value
+     */
+    static EngineProfile load(const std::string &path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open " + path);
+        }
+        EngineProfile profile;
+        std::string table;
+        std::string line;
+        while (std::getline(file, line)) {
+            line = trim(strip_comment(line));
+            if (line.empty()) {
+                continue;
+            }
+            if (line.front() == '[') {
+                if (line.back() != ']') {
+                    throw std::invalid_argument(line);
+                }
+                table = trim(line.substr(1, line.size() - 2));
+                continue;
+            }
+            const size_t eq = line.find('=');
+            if (eq == std::string::npos) {
+                continue;
+            }
+            std::string key = trim(line.substr(0, eq));
+            if (!table.empty()) {
+                key = table + "." + key;
+            }
+            if (key.rfind("engine.", 0) != 0) {
+                continue;
+            }
+            key = key.substr(7);
+            const size_t dot = key.rfind('.');
+            const std::string section =
+                dot == std::string::npos ? "" : key.substr(0, dot);
+            set(profile, section, key.substr(dot + 1),
+                trim(line.substr(eq + 1)));
+        }
+        return profile;
+    }
+
+    /**
+     * @brief Describe the settings a storage engine runs with
+     * @param profile The profile
+     * @param engine Runner storage engine name (tkrzw_tree, lmdb, ...)
+     * @return key=value pairs separated by ';' (empty for untuned engines)
+     */
+    static std::string describe(const EngineProfile &profile,
+                                const std::string &engine) {
+        std::ostringstream out;
+        auto tree = [&](const char *label, const TkrzwTreeTuning &t) {
+            out << label << ".compression=" << compression_name(t.compression)
+                << ";" << label << ".max_page_size=" << t.max_page_size << ";"
+                << label << ".max_branches=" << t.max_branches << ";" << label
+                << ".max_cached_pages=" << t.max_cached_pages;
+        };
+        auto hash = [&](const char *label, const TkrzwHashTuning &t) {
+            out << label << ".compression=" << compression_name(t.compression)
+                << ";" << label << ".num_buckets=" << t.num_buckets;
+        };
+        if (engine == "tkrzw_tree") {
+            tree("tkrzw_tree", profile.tkrzw_tree);
+            out << ";";
+            tree("tkrzw_tree_keys", profile.tkrzw_tree_keys);
+        } else if (engine == "tkrzw_hash") {
+            hash("tkrzw_hash", profile.tkrzw_hash);
+            out << ";";
+            hash("tkrzw_hash_keys", profile.tkrzw_hash_keys);
+        } else if (engine.find("leveldb") != std::string::npos) {
+            out << "leveldb.block_cache_size="
+                << profile.leveldb.block_cache_size
+                << ";leveldb.bloom_bits_per_key="
+                << profile.leveldb.bloom_bits_per_key
+                << ";leveldb.write_buffer_size="
+                << profile.leveldb.write_buffer_size;
+        } else if (engine.find("lmdb") != std::string::npos) {
+            out << "lmdb.map_size=" << profile.lmdb.map_size
+                << ";lmdb.max_map_size=" << profile.lmdb.max_map_size
+                << ";lmdb.write_map=" << profile.lmdb.write_map
+                << ";lmdb.map_async=" << profile.lmdb.map_async
+                << ";lmdb.max_readers=" << profile.lmdb.max_readers;
+        }
+        if (engine.rfind("cached_", 0) == 0) {
+            out << ";cache.capacity=" << profile.cache.capacity
+                << ";cache.prefetch_queue=" << profile.cache.prefetch_queue;
+        }
+        return out.str();
+    }
+
+    /**
+     * @brief Get the LevelDB options of a partition
+     * @param profile The profile
+     * @param partition Partition index, if known
+     * @return The partition's override, or the profile's defaults
+     */
+    static LevelDBPartitionOptions
+    leveldb_options(const EngineProfile &profile,
+                    std::optional<size_t> partition) {
+        if (partition.has_value()) {
+            auto it = profile.leveldb_partitions.find(*partition);
+            if (it != profile.leveldb_partitions.end()) {
+                return it->second;
+            }
+        }
+        return profile.leveldb;
+    }
+
+    /**
+     * @brief Make a profile the default of storages created without one
+     *
+     * Also sets the LevelDBTuning defaults and overrides and the LmdbTuning
+     * options.
+     *
+     * @param profile The profile
+     */
+    static void set_profile(const EngineProfile &profile) {
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.profile = profile;
+        }
+        LevelDBTuning::reset();
+        LevelDBTuning::set_defaults(profile.leveldb);
+        for (const auto &[partition, options] : profile.leveldb_partitions) {
+            LevelDBTuning::set_partition(partition, options);
+        }
+        LmdbTuning::set_options(profile.lmdb);
+    }
+
+    /**
+     * @brief Get the default profile
+     * @return The profile
+     */
+    static EngineProfile profile() {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        return r.profile;
+    }
+};
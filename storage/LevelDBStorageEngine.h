@@ -2,7 +2,13 @@
 
 #include "StorageEngineIterator.h"
 #include "StorageEngine.h"
+#include "CompactionScheduler.h"
+#include "EnginePersistence.h"
+#include "EngineTuning.h"
+#include "LevelDBTuning.h"
+#include <leveldb/cache.h>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
 #include <leveldb/options.h>
 #include <leveldb/status.h>
 #include <leveldb/write_batch.h>
@@ -13,6 +19,7 @@
 #include <atomic>
 #include <chrono>
 #include <filesystem>
+#include <optional>
 
 /**
  * @brief LevelDB-based implementation of StorageEngine
@@ -31,6 +38,10 @@
  * - Efficient range queries via iterator Seek()
  * - Good for scan-heavy and write-heavy workloads
  *
+ * Databases take their block cache, bloom filter and write buffer settings
+ * from LevelDBTuning (per partition with the partition-aware constructor) and
+ * run their background writes through the process-wide CompactionScheduler.
+ *
  * Note: This class is NOT thread-safe by default. Users must manually
  * call lock()/unlock() or lock_shared()/unlock_shared() when needed.
  *
@@ -39,6 +50,9 @@
 template <bool SYNC = false> class LevelDBStorageEngine
     : public StorageEngine<LevelDBStorageEngine<SYNC>, SYNC> {
 private:
+    // Declared before db_: the database must close before they are freed
+    std::unique_ptr<leveldb::Cache> block_cache_;
+    std::unique_ptr<const leveldb::FilterPolicy> filter_policy_;
     std::unique_ptr<leveldb::DB> db_;
     bool is_open_;
     std::string db_path_;
@@ -51,37 +65,130 @@ private:
         return o;
     }
 
+    /**
+     * @brief Open (creating if missing) the database at a path
+     * @param file_path Path to the database directory
+     * @param tuning Options of the database
+     */
+    void open(const std::string &file_path,
+              const LevelDBPartitionOptions &tuning) {
+        leveldb::Options options;
+        options.create_if_missing = true;
+        options.error_if_exists = false;
+        options.env = CompactionScheduler::instance().env();
+        if (tuning.block_cache_size > 0) {
+            block_cache_.reset(leveldb::NewLRUCache(tuning.block_cache_size));
+            options.block_cache = block_cache_.get();
+        }
+        if (tuning.bloom_bits_per_key > 0) {
+            filter_policy_.reset(
+                leveldb::NewBloomFilterPolicy(tuning.bloom_bits_per_key));
+            options.filter_policy = filter_policy_.get();
+        }
+        if (tuning.write_buffer_size > 0) {
+            options.write_buffer_size = tuning.write_buffer_size;
+        }
+
+        leveldb::DB *db = nullptr;
+        leveldb::Status status = leveldb::DB::Open(options, file_path, &db);
+        if (status.ok() && db) {
+            db_.reset(db);
+            db_path_ = file_path;
+            is_open_ = true;
+            CompactionScheduler::instance().add(db);
+        }
+    }
+
+    /**
+     * @brief Close the database, if open
+     */
+    void close() {
+        if (db_) {
+            CompactionScheduler::instance().remove(db_.get());
+            db_.reset();
+        }
+        is_open_ = false;
+        filter_policy_.reset();
+        block_cache_.reset();
+    }
+
+    /**
+     * @brief Get a fresh path for a temporary database, creating its parent
+     */
+    std::string temp_path() const {
+        std::filesystem::create_directories(
+            this->path_ + std::string("/repart_kv_storage/") + id_);
+        return this->path_ + std::string("/repart_kv_storage/") + id_ +
+               std::string("/leveldb_temp_") +
+               std::to_string(
+                   db_counter_.fetch_add(1, std::memory_order_relaxed));
+    }
+
 public:
+    using TuningType = LevelDBPartitionOptions;
+
+    /**
+     * @brief Get this engine's options in a profile
+     * @param profile The profile
+     * @param partition Partition index, if known
+     * @return The partition's override, or the profile's defaults
+     */
+    static LevelDBPartitionOptions
+    profile_tuning(const EngineProfile &profile,
+                   std::optional<size_t> partition) {
+        return EngineTuning::leveldb_options(profile, partition);
+    }
+
     /**
      * @brief Constructor - creates a temporary database
      * @param level The hierarchy level for this storage engine (default: 0)
      * @param path Optional path for database files (default: /tmp)
+     * @param tuning Database options (default: the LevelDBTuning defaults)
      *
      * Note: LevelDB requires a file path. Uses a temporary directory
      * for in-memory-like behavior.
      */
-    explicit LevelDBStorageEngine(size_t level = 0,
-                                  const std::string &path = "/tmp") :
+    explicit LevelDBStorageEngine(
+        size_t level = 0, const std::string &path = "/tmp",
+        const LevelDBPartitionOptions &tuning = LevelDBTuning::options()) :
         StorageEngine<LevelDBStorageEngine<SYNC>, SYNC>(level, path),
         db_(nullptr), is_open_(false) {
-        std::string temp_path =
-            this->path_ + std::string("/repart_kv_storage/") + id_ +
-            std::string("/leveldb_temp_") +
-            std::to_string(db_counter_.fetch_add(1, std::memory_order_relaxed));
-        std::filesystem::create_directories(
-            this->path_ + std::string("/repart_kv_storage/") + id_);
+        open(temp_path(), tuning);
+    }
 
-        leveldb::Options options;
-        options.create_if_missing = true;
-        options.error_if_exists = false;
+    /**
+     * @brief Constructor - creates the database of a partition with the
+     * partition's LevelDBTuning options
+     * @param level The hierarchy level for this storage engine
+     * @param path Path for database files
+     * @param partition Partition index
+     */
+    LevelDBStorageEngine(size_t level, const std::string &path,
+                         size_t partition) :
+        LevelDBStorageEngine(level, path, partition,
+                             LevelDBTuning::options(partition)) {}
 
-        leveldb::DB *db = nullptr;
-        leveldb::Status status = leveldb::DB::Open(options, temp_path, &db);
-        if (status.ok() && db) {
-            db_.reset(db);
-            db_path_ = temp_path;
-            is_open_ = true;
-        }
+    /**
+     * @brief Constructor - creates the database of a partition
+     *
+     * The database is temporary, or the partition's database in the
+     * EnginePersistence store if one is set (reopened with its contents).
+     *
+     * @param level The hierarchy level for this storage engine
+     * @param path Path for database files
+     * @param partition Partition index
+     * @param tuning Database options
+     */
+    LevelDBStorageEngine(size_t level, const std::string &path,
+                         size_t partition,
+                         const LevelDBPartitionOptions &tuning) :
+        StorageEngine<LevelDBStorageEngine<SYNC>, SYNC>(level, path),
+        db_(nullptr), is_open_(false) {
+        open(EnginePersistence::enabled()
+                 ? EnginePersistence::partition_path(path, "leveldb",
+                                                     partition)
+                 : temp_path(),
+             tuning);
     }
 
     /**
@@ -95,27 +202,13 @@ public:
                                   const std::string &path = "/tmp") :
         StorageEngine<LevelDBStorageEngine<SYNC>, SYNC>(level, path),
         db_(nullptr), is_open_(false), db_path_(file_path) {
-
-        leveldb::Options options;
-        options.create_if_missing = true;
-
-        leveldb::DB *db = nullptr;
-        leveldb::Status status = leveldb::DB::Open(options, file_path, &db);
-        if (status.ok() && db) {
-            db_.reset(db);
-            is_open_ = true;
-        }
+        open(file_path, LevelDBTuning::options());
     }
 
     /**
      * @brief Destructor - closes the database
      */
-    ~LevelDBStorageEngine() {
-        if (is_open_ && db_) {
-            db_.reset();
-            is_open_ = false;
-        }
-    }
+    ~LevelDBStorageEngine() { close(); }
 
     // Disable copy
     LevelDBStorageEngine(const LevelDBStorageEngine &) = delete;
@@ -125,6 +218,8 @@ public:
     LevelDBStorageEngine(LevelDBStorageEngine &&other) noexcept :
         StorageEngine<LevelDBStorageEngine<SYNC>, SYNC>(other.level_,
                                                         other.path_),
+        block_cache_(std::move(other.block_cache_)),
+        filter_policy_(std::move(other.filter_policy_)),
         db_(std::move(other.db_)), is_open_(other.is_open_),
         db_path_(std::move(other.db_path_)) {
         other.is_open_ = false;
@@ -132,9 +227,9 @@ public:
 
     LevelDBStorageEngine &operator=(LevelDBStorageEngine &&other) noexcept {
         if (this != &other) {
-            if (is_open_ && db_) {
-                db_.reset();
-            }
+            close();
+            block_cache_ = std::move(other.block_cache_);
+            filter_policy_ = std::move(other.filter_policy_);
             db_ = std::move(other.db_);
             is_open_ = other.is_open_;
             db_path_ = std::move(other.db_path_);
@@ -236,17 +331,85 @@ public:
     }
 
     /**
-     * @brief Synchronize the database to storage
+     * @brief Synchronize the database to storage, even without SYNC
      */
     bool sync() {
         if (!is_open_ || !db_) {
             return false;
         }
-        if constexpr (SYNC) {
+        // A synced write, even empty, syncs the log of the earlier writes
+        leveldb::WriteOptions options;
+        options.sync = true;
+        leveldb::WriteBatch batch;
+        return db_->Write(options, &batch).ok();
+    }
+
+    /**
+     * @brief Compact the whole database through the CompactionScheduler
+     *
+     * Waits for compactions of other databases to finish first, so manual
+     * compactions of several partitions are staggered.
+     */
+    void compact() {
+        if (is_open_ && db_) {
+            CompactionScheduler::instance().compact(db_.get());
+        }
+    }
+
+    /**
+     * @brief Implementation: Write a database with the contents of a snapshot
+     *
+     * A snapshot fixes the image, then its records are written in batches
+     * of up to EngineCheckpoint::CHUNK_BYTES into a new database,
+     * <directory>/leveldb_<partition>, at the throttle's pace while this one
+     * keeps taking writes.
+     */
+    Status checkpoint_impl(const std::string &directory, size_t partition,
+                           TokenBucket &throttle,
+                           const std::function<void()> &captured) {
+        if (!is_open_ || !db_) {
+            captured();
+            return Status::ERROR;
+        }
+        const leveldb::Snapshot *snapshot = db_->GetSnapshot();
+        captured();
+
+        leveldb::Options options;
+        options.create_if_missing = true;
+        options.error_if_exists = true;
+        leveldb::DB *image = nullptr;
+        leveldb::Status status = leveldb::DB::Open(
+            options,
+            directory + "/" +
+                EnginePersistence::file_name("leveldb", partition),
+            &image);
+        if (status.ok()) {
+            std::unique_ptr<leveldb::DB> image_db(image);
+            leveldb::ReadOptions read_options;
+            read_options.snapshot = snapshot;
+            read_options.fill_cache = false;
+            std::unique_ptr<leveldb::Iterator> iter(
+                db_->NewIterator(read_options));
             leveldb::WriteBatch batch;
-            return db_->Write(durable_write_options(), &batch).ok();
+            size_t batch_bytes = 0;
+            for (iter->SeekToFirst(); iter->Valid() && status.ok();
+                 iter->Next()) {
+                batch.Put(iter->key(), iter->value());
+                batch_bytes += iter->key().size() + iter->value().size();
+                if (batch_bytes >= EngineCheckpoint::CHUNK_BYTES) {
+                    throttle.acquire(batch_bytes);
+                    status = image_db->Write(leveldb::WriteOptions(), &batch);
+                    batch.Clear();
+                    batch_bytes = 0;
+                }
+            }
+            if (status.ok()) {
+                throttle.acquire(batch_bytes);
+                status = image_db->Write(leveldb::WriteOptions(), &batch);
+            }
         }
-        return true;
+        db_->ReleaseSnapshot(snapshot);
+        return status.ok() ? Status::SUCCESS : Status::ERROR;
     }
 
     /**
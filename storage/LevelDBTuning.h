@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <optional>
+
+/**
+ * @brief LevelDB settings of one partition's database
+ *
+ * Zero keeps LevelDB's own default for a setting.
+ */
+struct LevelDBPartitionOptions {
+    size_t block_cache_size = 0;  // Bytes of a private block cache
+    int bloom_bits_per_key = 0;   // Bloom filter bits per key (0: no filter)
+    size_t write_buffer_size = 0; // Bytes of memtable before a flush
+
+    bool operator==(const LevelDBPartitionOptions &) const = default;
+};
+
+/**
+ * @brief Process-wide LevelDB settings, per partition
+ *
+ * LevelDBStorageEngine reads its options from here when it opens its
+ * database: partition-aware constructors use the partition's override if one
+ * was set, everything else uses the defaults. Set the options before creating
+ * the storage; databases already open keep the options they were opened with.
+ */
+class LevelDBTuning {
+private:
+    struct Registry {
+        std::mutex mutex;                                    // Guards below
+        LevelDBPartitionOptions defaults;                    // All partitions
+        std::map<size_t, LevelDBPartitionOptions> overrides; // By partition
+    };
+
+    static Registry &registry() {
+        static Registry instance;
+        return instance;
+    }
+
+public:
+    /**
+     * @brief Set the options of partitions without an override
+     * @param options The options
+     */
+    static void set_defaults(const LevelDBPartitionOptions &options) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.defaults = options;
+    }
+
+    /**
+     * @brief Set the options of one partition
+     * @param partition Partition index
+     * @param options The options (replacing the defaults entirely)
+     */
+    static void set_partition(size_t partition,
+                              const LevelDBPartitionOptions &options) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.overrides[partition] = options;
+    }
+
+    /**
+     * @brief Get the options a database opens with
+     * @param partition Partition index, if known
+     * @return The partition's override, or the defaults
+     */
+    static LevelDBPartitionOptions
+    options(std::optional<size_t> partition = std::nullopt) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (partition.has_value()) {
+            auto it = r.overrides.find(*partition);
+            if (it != r.overrides.end()) {
+                return it->second;
+            }
+        }
+        return r.defaults;
+    }
+
+    /**
+     * @brief Drop the overrides and restore LevelDB's defaults
+     */
+    static void reset() {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.defaults = LevelDBPartitionOptions();
+        r.overrides.clear();
+    }
+};
@@ -2,13 +2,20 @@
 
 #include "StorageEngineIterator.h"
 #include "StorageEngine.h"
+#include "LmdbTransactions.h"
+#include "EnginePersistence.h"
+#include "EngineTuning.h"
 #include <lmdb.h>
+#include <unistd.h>
 #include <string>
+#include <thread>
 #include <vector>
 #include <ctime>
 #include <filesystem>
 #include <atomic>
 #include <chrono>
+#include <memory>
+#include <optional>
 
 /**
  * @brief LMDB-based implementation of StorageEngine
@@ -32,6 +39,10 @@
  * Limitations:
  * - Empty keys may not be supported (LMDB restriction)
  *
+ * The environment is opened with the LmdbTuning settings: the map starts
+ * small and doubles when full, and MDB_WRITEMAP / MDB_MAPASYNC are optional.
+ * Reads reuse one read transaction per thread (see LmdbTransactions).
+ *
  * Note: This class is NOT thread-safe by default. Users must manually
  * call lock()/unlock() or lock_shared()/unlock_shared() when needed.
  *
@@ -46,49 +57,102 @@ private:
     MDB_dbi dbi_;
     bool is_open_;
     std::string db_path_;
+    bool persistent_; // Kept on disk when closed (EnginePersistence)
+    std::unique_ptr<LmdbTransactions> transactions_;
 
     static std::atomic_int db_counter_;
     static std::string id_;
 
-    static constexpr unsigned env_open_flags() {
-        if constexpr (SYNC) {
-            return 0;
+    /**
+     * @brief Close the environment, aborting its cached read transactions
+     */
+    void close_env() {
+        if (transactions_) {
+            transactions_->close();
+            transactions_.reset();
         }
-        return MDB_NOSYNC | MDB_NOMETASYNC;
+        mdb_dbi_close(env_, dbi_);
+        mdb_env_close(env_);
     }
 
 public:
+    using TuningType = LmdbOptions;
+
+    /**
+     * @brief Get this engine's settings in a profile
+     * @param profile The profile
+     * @param partition Partition index, if known (unused)
+     * @return The profile's LMDB settings
+     */
+    static LmdbOptions profile_tuning(const EngineProfile &profile,
+                                      std::optional<size_t> partition) {
+        (void)partition;
+        return profile.lmdb;
+    }
+
     /**
      * @brief Constructor - creates an in-memory database
      * @param level The hierarchy level for this storage engine (default: 0)
      * @param path Optional path for database files (default: /tmp)
+     * @param options Environment settings (default: the LmdbTuning ones)
      *
      * Creates a temporary LMDB database in the provided path for in-memory-like
      * behavior.
      */
-    explicit LmdbStorageEngine(size_t level = 0,
-                               const std::string &path = "/tmp") :
+    explicit LmdbStorageEngine(
+        size_t level = 0, const std::string &path = "/tmp",
+        const LmdbOptions &options = LmdbTuning::options()) :
         StorageEngine<LmdbStorageEngine<SYNC>, SYNC>(level, path),
-        env_(nullptr), dbi_(MDB_dbi{}), is_open_(false) {
+        env_(nullptr), dbi_(MDB_dbi{}), is_open_(false), persistent_(false) {
 
-        init();
+        init(options);
+    }
+
+    /**
+     * @brief Constructor - creates the database of a partition
+     *
+     * The database is temporary, or the partition's database in the
+     * EnginePersistence store if one is set (reopened with its contents and
+     * kept on disk when closed).
+     *
+     * @param level The hierarchy level for this storage engine
+     * @param path Path for database files
+     * @param partition Partition index
+     * @param options Environment settings (default: the LmdbTuning ones)
+     */
+    LmdbStorageEngine(size_t level, const std::string &path, size_t partition,
+                      const LmdbOptions &options = LmdbTuning::options()) :
+        StorageEngine<LmdbStorageEngine<SYNC>, SYNC>(level, path),
+        env_(nullptr), dbi_(MDB_dbi{}), is_open_(false), persistent_(false) {
+        if (!EnginePersistence::enabled()) {
+            init(options);
+            return;
+        }
+        db_path_ = EnginePersistence::partition_path(path, "lmdb", partition);
+        std::filesystem::create_directories(db_path_);
+        persistent_ = true;
+        init_with_path(db_path_, options);
     }
 
     /**
      * @brief Constructor with file path - creates a persistent database
      * @param file_path Path to the database directory
-     * @param map_size Maximum size of the memory map in bytes (default: 50GB)
+     * @param map_size Initial size of the memory map in bytes (default: 0,
+     *        the LmdbTuning setting); the map grows when full
      * @param level The hierarchy level for this storage engine (default: 0)
      * @param path Optional path for database files (default: /tmp)
      */
     explicit LmdbStorageEngine(const std::string &file_path,
-                               size_t map_size = 50ULL * 1024 * 1024 * 1024,
-                               size_t level = 0,
+                               size_t map_size = 0, size_t level = 0,
                                const std::string &path = "/tmp") :
         StorageEngine<LmdbStorageEngine<SYNC>, SYNC>(level, path),
-        env_(nullptr), dbi_(MDB_dbi{}), is_open_(false), db_path_(file_path) {
-
-        init_with_path(file_path, map_size);
+        env_(nullptr), dbi_(MDB_dbi{}), is_open_(false), db_path_(file_path),
+        persistent_(false) {
+        LmdbOptions options = LmdbTuning::options();
+        if (map_size != 0) {
+            options.map_size = map_size;
+        }
+        init_with_path(file_path, options);
     }
 
     /**
@@ -96,13 +160,12 @@ public:
      */
     ~LmdbStorageEngine() {
         if (is_open_ && env_) {
-            mdb_dbi_close(env_, dbi_);
-            mdb_env_close(env_);
+            close_env();
             is_open_ = false;
 
             // Clean up temporary directory if it was created
             std::string temp_prefix = this->path_ + "/repart_kv_storage/";
-            if (db_path_.find(temp_prefix) == 0) {
+            if (!persistent_ && db_path_.find(temp_prefix) == 0) {
                 std::filesystem::remove_all(db_path_);
             }
         }
@@ -116,7 +179,8 @@ public:
     LmdbStorageEngine(LmdbStorageEngine &&other) noexcept :
         StorageEngine<LmdbStorageEngine<SYNC>, SYNC>(other.level_, other.path_),
         env_(other.env_), dbi_(other.dbi_), is_open_(other.is_open_),
-        db_path_(std::move(other.db_path_)) {
+        db_path_(std::move(other.db_path_)), persistent_(other.persistent_),
+        transactions_(std::move(other.transactions_)) {
         other.env_ = nullptr;
         other.is_open_ = false;
     }
@@ -124,13 +188,14 @@ public:
     LmdbStorageEngine &operator=(LmdbStorageEngine &&other) noexcept {
         if (this != &other) {
             if (is_open_ && env_) {
-                mdb_dbi_close(env_, dbi_);
-                mdb_env_close(env_);
+                close_env();
             }
             env_ = other.env_;
             dbi_ = other.dbi_;
             is_open_ = other.is_open_;
             db_path_ = std::move(other.db_path_);
+            persistent_ = other.persistent_;
+            transactions_ = std::move(other.transactions_);
             other.env_ = nullptr;
             other.is_open_ = false;
         }
@@ -148,29 +213,24 @@ public:
             return Status::ERROR;
         }
 
-        MDB_txn *txn;
-        MDB_val mdb_key;
-        MDB_val mdb_value;
-
-        int rc = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
-        if (rc != 0) {
+        LmdbTransactions::Reader reader = transactions_->read();
+        if (reader.txn() == nullptr) {
             return Status::ERROR;
         }
 
+        MDB_val mdb_key;
+        MDB_val mdb_value;
         mdb_key.mv_size = key.size();
         mdb_key.mv_data =
             const_cast<void *>(static_cast<const void *>(key.c_str()));
 
-        rc = mdb_get(txn, dbi_, &mdb_key, &mdb_value);
+        int rc = mdb_get(reader.txn(), dbi_, &mdb_key, &mdb_value);
         if (rc == MDB_SUCCESS) {
-            value = std::string(reinterpret_cast<char *>(mdb_value.mv_data),
-                                mdb_value.mv_size);
-            mdb_txn_abort(txn);
+            value.assign(static_cast<const char *>(mdb_value.mv_data),
+                         mdb_value.mv_size);
             return Status::SUCCESS;
-        } else {
-            mdb_txn_abort(txn);
-            return Status::NOT_FOUND;
         }
+        return Status::NOT_FOUND;
     }
 
     /**
@@ -184,15 +244,8 @@ public:
             return Status::ERROR;
         }
 
-        MDB_txn *txn;
         MDB_val mdb_key;
         MDB_val mdb_value;
-
-        int rc = mdb_txn_begin(env_, nullptr, 0, &txn);
-        if (rc != 0) {
-            return Status::ERROR;
-        }
-
         mdb_key.mv_size = key.size();
         mdb_key.mv_data =
             const_cast<void *>(static_cast<const void *>(key.c_str()));
@@ -200,13 +253,9 @@ public:
         mdb_value.mv_data =
             const_cast<void *>(static_cast<const void *>(value.c_str()));
 
-        rc = mdb_put(txn, dbi_, &mdb_key, &mdb_value, 0);
-        if (rc != 0) {
-            mdb_txn_abort(txn);
-            return Status::ERROR;
-        }
-
-        rc = mdb_txn_commit(txn);
+        int rc = transactions_->write([&](MDB_txn *txn) {
+            return mdb_put(txn, dbi_, &mdb_key, &mdb_value, 0);
+        });
         if (rc != 0) {
             return Status::ERROR;
         }
@@ -234,22 +283,20 @@ public:
         results.clear();
         results.reserve(limit);
 
-        MDB_txn *txn;
+        LmdbTransactions::Reader reader = transactions_->read();
+        if (reader.txn() == nullptr) {
+            return Status::ERROR;
+        }
+
         MDB_cursor *cursor;
         MDB_val mdb_key;
         MDB_val mdb_value;
 
-        int rc = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
+        int rc = mdb_cursor_open(reader.txn(), dbi_, &cursor);
         if (rc != 0) {
             return Status::ERROR;
         }
 
-        rc = mdb_cursor_open(txn, dbi_, &cursor);
-        if (rc != 0) {
-            mdb_txn_abort(txn);
-            return Status::ERROR;
-        }
-
         // Set the cursor to the first key >= initial_key_prefix
         if (initial_key_prefix.empty()) {
             // If prefix is empty, start from the very beginning of the database
@@ -283,7 +330,6 @@ public:
         }
 
         mdb_cursor_close(cursor);
-        mdb_txn_abort(txn);
 
         if (results.empty()) {
             return Status::NOT_FOUND;
@@ -307,17 +353,13 @@ public:
             return 0;
         }
 
-        MDB_txn *txn;
-        MDB_stat stat;
-
-        int rc = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
-        if (rc != 0) {
+        LmdbTransactions::Reader reader = transactions_->read();
+        if (reader.txn() == nullptr) {
             return 0;
         }
 
-        rc = mdb_stat(txn, dbi_, &stat);
-        mdb_txn_abort(txn);
-
+        MDB_stat stat;
+        int rc = mdb_stat(reader.txn(), dbi_, &stat);
         if (rc != 0) {
             return 0;
         }
@@ -326,7 +368,7 @@ public:
     }
 
     /**
-     * @brief Synchronize the database to storage
+     * @brief Synchronize the database to storage, even without SYNC
      * @return true if successful, false otherwise
      */
     bool sync() {
@@ -334,7 +376,7 @@ public:
             return false;
         }
 
-        int rc = mdb_env_sync(env_, SYNC ? 1 : 0);
+        int rc = mdb_env_sync(env_, 1);
         return rc == 0;
     }
 
@@ -346,19 +388,10 @@ public:
             return;
         }
 
-        MDB_txn *txn;
-        int rc = mdb_txn_begin(env_, nullptr, 0, &txn);
-        if (rc != 0) {
-            return;
-        }
-
-        rc = mdb_drop(txn, dbi_,
-                      0); // 0 = don't delete the database, just clear it
-        if (rc == 0) {
-            mdb_txn_commit(txn);
-        } else {
-            mdb_txn_abort(txn);
-        }
+        transactions_->write([&](MDB_txn *txn) {
+            // 0 = don't delete the database, just clear it
+            return mdb_drop(txn, dbi_, 0);
+        });
     }
 
     /**
@@ -369,35 +402,27 @@ public:
             return Status::ERROR;
         }
 
-        MDB_txn *txn;
         MDB_val mdb_key;
-        MDB_val mdb_value;
-
-        int rc = mdb_txn_begin(env_, nullptr, 0, &txn);
-        if (rc != 0) {
-            return Status::ERROR;
-        }
-
         mdb_key.mv_size = key.size();
         mdb_key.mv_data =
             const_cast<void *>(static_cast<const void *>(key.c_str()));
 
-        rc = mdb_get(txn, dbi_, &mdb_key, &mdb_value);
-        if (rc != MDB_SUCCESS) {
-            mdb_txn_abort(txn);
-            return Status::NOT_FOUND;
-        }
-
-        removed_value.assign(static_cast<const char *>(mdb_value.mv_data),
-                             mdb_value.mv_size);
-
-        rc = mdb_del(txn, dbi_, &mdb_key, nullptr);
+        bool found = false;
+        int rc = transactions_->write([&](MDB_txn *txn) {
+            MDB_val mdb_value;
+            int get_rc = mdb_get(txn, dbi_, &mdb_key, &mdb_value);
+            found = get_rc == MDB_SUCCESS;
+            if (!found) {
+                return get_rc;
+            }
+            removed_value.assign(static_cast<const char *>(mdb_value.mv_data),
+                                 mdb_value.mv_size);
+            return mdb_del(txn, dbi_, &mdb_key, nullptr);
+        });
         if (rc == 0) {
-            mdb_txn_commit(txn);
             return Status::SUCCESS;
         }
-        mdb_txn_abort(txn);
-        return Status::ERROR;
+        return found ? Status::ERROR : Status::NOT_FOUND;
     }
 
     /**
@@ -406,6 +431,52 @@ public:
      */
     const std::string &get_path() const { return db_path_; }
 
+    /**
+     * @brief Get the current size of the memory map
+     * @return Bytes (0 if the database is not open)
+     */
+    size_t map_size() const {
+        return transactions_ ? transactions_->map_size() : 0;
+    }
+
+    /**
+     * @brief Implementation: Write a compacted copy of the environment
+     *
+     * mdb_env_copyfd2() with MDB_CP_COMPACT runs in its own read
+     * transaction and writes into a pipe, which is drained into
+     * <directory>/lmdb_<partition>/data.mdb at the throttle's pace. The
+     * image is fixed once the first bytes come out of the pipe, so writers
+     * only wait for the copy to start. The map cannot grow until the copy
+     * ends, so it is grown first until half of it is free; a write that
+     * still finds it full waits for the copy to end (see
+     * LmdbTransactions::pin_copy()).
+     */
+    Status checkpoint_impl(const std::string &directory, size_t partition,
+                           TokenBucket &throttle,
+                           const std::function<void()> &captured) {
+        const std::string image =
+            directory + "/" + EnginePersistence::file_name("lmdb", partition);
+        int fds[2];
+        if (!is_open_ || !env_ || !std::filesystem::create_directories(image) ||
+            ::pipe(fds) != 0) {
+            captured();
+            return Status::ERROR;
+        }
+
+        transactions_->reserve_headroom(); // Best effort (max_map_size)
+        auto pin = transactions_->pin_copy(); // Keeps the map in place
+        int rc = 0;
+        std::thread copier([&]() {
+            rc = mdb_env_copyfd2(env_, fds[1], MDB_CP_COMPACT);
+            ::close(fds[1]);
+        });
+        Status status = EngineCheckpoint::drain(fds[0], image + "/data.mdb",
+                                                throttle, captured);
+        copier.join();
+        ::close(fds[0]);
+        return rc == 0 ? status : Status::ERROR;
+    }
+
     /**
      * @brief LMDB scan iterator for locality-optimized key lookups
      *
@@ -416,6 +487,7 @@ public:
     class LmdbIterator
         : public StorageEngineIterator<LmdbIterator, LmdbStorageEngine<SYNC>> {
     private:
+        LmdbTransactions::Pin pin_; // Keeps the map in place
         MDB_txn *txn_;
         MDB_cursor *cursor_;
 
@@ -429,6 +501,7 @@ public:
                 engine),
             txn_(nullptr), cursor_(nullptr) {
             if (engine.is_open_ && engine.env_) {
+                pin_ = engine.transactions_->pin();
                 int rc = mdb_txn_begin(engine.env_, nullptr, MDB_RDONLY, &txn_);
                 if (rc == 0) {
                     rc = mdb_cursor_open(txn_, engine.dbi_, &cursor_);
@@ -446,7 +519,8 @@ public:
         LmdbIterator(LmdbIterator &&other) noexcept :
             StorageEngineIterator<LmdbIterator, LmdbStorageEngine<SYNC>>(
                 *other.engine_),
-            txn_(other.txn_), cursor_(other.cursor_) {
+            pin_(std::move(other.pin_)), txn_(other.txn_),
+            cursor_(other.cursor_) {
             other.txn_ = nullptr;
             other.cursor_ = nullptr;
         }
@@ -460,6 +534,7 @@ public:
                     mdb_txn_abort(txn_);
                 }
                 this->engine_ = other.engine_;
+                pin_ = std::move(other.pin_);
                 txn_ = other.txn_;
                 cursor_ = other.cursor_;
                 other.txn_ = nullptr;
@@ -523,36 +598,26 @@ public:
 private:
     /**
      * @brief Initialize the database with a temporary path
+     * @param options Environment settings
      */
-    void init() {
+    void init(const LmdbOptions &options) {
         db_path_ =
             this->path_ + std::string("/repart_kv_storage/") + id_ +
             std::string("/") +
             std::to_string(db_counter_.fetch_add(1, std::memory_order_relaxed));
         std::filesystem::create_directories(db_path_);
 
-        init_with_path(db_path_, 50ULL * 1024 * 1024 * 1024);
+        init_with_path(db_path_, options);
     }
 
     /**
      * @brief Initialize the database with a specific path
      * @param path The database path
-     * @param map_size The map size
+     * @param options Environment settings
      */
-    void init_with_path(const std::string &path, size_t map_size) {
-        int rc = mdb_env_create(&env_);
-        if (rc != 0) {
-            is_open_ = false;
-            return;
-        }
-
-        mdb_env_set_maxdbs(env_, 1);
-        mdb_env_set_mapsize(env_, map_size);
-
-        rc = mdb_env_open(env_, path.c_str(), env_open_flags(), 0664);
+    void init_with_path(const std::string &path, const LmdbOptions &options) {
+        int rc = LmdbTransactions::open_env(env_, path.c_str(), options, SYNC);
         if (rc != 0) {
-            mdb_env_close(env_);
-            env_ = nullptr;
             is_open_ = false;
             return;
         }
@@ -576,6 +641,7 @@ private:
         }
 
         mdb_txn_commit(txn);
+        transactions_ = std::make_unique<LmdbTransactions>(env_, options);
         is_open_ = true;
     }
 };
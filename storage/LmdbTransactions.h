@@ -0,0 +1,550 @@
+#pragma once
+
+#include "LmdbTuning.h"
+#include <lmdb.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Transactions of one LMDB environment
+ *
+ * Read transactions are reused instead of begun and aborted per call: the
+ * environment is opened with MDB_NOTLS, each thread keeps one reset
+ * transaction per environment and renews it for its next read. Threads that
+ * exit hand their transaction back to the environment for the next new
+ * thread, so short-lived threads do not use up reader slots.
+ *
+ * write() runs a write transaction and, when the map is full, doubles the map
+ * and retries. Growing remaps the file, which LMDB forbids while any
+ * transaction of the process is active, so readers, writers and open cursors
+ * hold a Pin. A pin is counted in one of PIN_SHARDS padded slots, picked
+ * once per thread, so reads do not bounce a shared lock's cache line.
+ * Growth raises a flag that makes new pins wait, then waits for the held
+ * ones to be released, so steady read traffic cannot starve it. A thread
+ * that pins the environment again while a growth waits for its first pin
+ * (e.g. a write or a read under an open iterator) stalls until the growth
+ * gives up after GROW_WAIT; the write then fails with MDB_MAP_FULL. A copy
+ * of the environment pins it through pin_copy() instead: growth then waits
+ * for the copy to end, however long the copy takes, without holding back
+ * other pins meanwhile.
+ */
+class LmdbTransactions {
+public:
+    // How long growth waits for the environment to be unpinned
+    static constexpr std::chrono::milliseconds GROW_WAIT{1000};
+    // Slots pins are counted in
+    static constexpr size_t PIN_SHARDS = 16;
+
+private:
+    /**
+     * @brief Count of the pins held by the threads that picked one slot
+     */
+    struct alignas(64) PinShard {
+        std::atomic_size_t count{0};
+    };
+
+    /**
+     * @brief Read transactions of the environment, shared with the threads
+     * caching them
+     */
+    struct Pool {
+        std::mutex mutex;            // Guards the fields below
+        MDB_env *env;                // Environment
+        bool closed = false;         // Transactions were aborted
+        std::vector<MDB_txn *> idle; // Reset, cached by no thread
+        std::vector<MDB_txn *> all;  // Every transaction begun
+
+        explicit Pool(MDB_env *environment) : env(environment) {}
+    };
+
+    /**
+     * @brief Read transaction a thread keeps for one environment
+     */
+    struct CachedReader {
+        std::shared_ptr<Pool> pool; // Pool the transaction belongs to
+        MDB_txn *txn;               // Reset when not in use
+        bool in_use;                // Renewed by the thread right now
+    };
+
+    /**
+     * @brief A thread's cached read transactions
+     */
+    struct ThreadReaders {
+        std::vector<CachedReader> readers;
+
+        ~ThreadReaders() {
+            for (CachedReader &reader : readers) {
+                std::lock_guard<std::mutex> lock(reader.pool->mutex);
+                if (!reader.pool->closed) {
+                    reader.pool->idle.push_back(reader.txn);
+                }
+            }
+        }
+    };
+
+    static ThreadReaders &thread_readers() {
+        thread_local ThreadReaders readers;
+        return readers;
+    }
+
+    std::shared_ptr<Pool> pool_; // This environment's transactions
+    mutable std::array<PinShard, PIN_SHARDS> pins_; // Pins held, per slot
+    std::atomic<bool> growing_;    // New pins wait while set
+    std::mutex grow_mutex_;        // One growth at a time
+    std::atomic<size_t> map_size_; // Current map size
+    size_t max_map_size_;          // Growth limit (0: none)
+    std::atomic<size_t> copies_;   // Copies pinning the map (pin_copy())
+
+    static size_t pin_shard() {
+        static std::atomic_size_t next_shard{0};
+        thread_local const size_t index =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % PIN_SHARDS;
+        return index;
+    }
+
+    /**
+     * @brief Count a pin, waiting for a pending growth first
+     * @return The slot counting the pin
+     */
+    std::atomic_size_t *acquire_pin() const {
+        std::atomic_size_t *count = &pins_[pin_shard()].count;
+        for (;;) {
+            count->fetch_add(1, std::memory_order_seq_cst);
+            if (!growing_.load(std::memory_order_seq_cst)) {
+                return count;
+            }
+            // Step back so the growth can drain the pins
+            count->fetch_sub(1, std::memory_order_release);
+            while (growing_.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /**
+     * @brief Hold back new pins and wait until the held ones are released
+     * @return false if they were not released within GROW_WAIT (new pins
+     * are let through again)
+     *
+     * While a copy holds its pin, new pins are let through and the wait is
+     * not limited.
+     */
+    bool drain_pins() {
+        auto deadline = std::chrono::steady_clock::now() + GROW_WAIT;
+        for (;;) {
+            if (copies_.load(std::memory_order_acquire) > 0) {
+                // Released once the copy is written out, at the throttle's
+                // pace
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                deadline = std::chrono::steady_clock::now() + GROW_WAIT;
+                continue;
+            }
+
+            growing_.store(true, std::memory_order_seq_cst);
+            bool drained = true;
+            for (size_t i = 0; i < PIN_SHARDS && drained; ++i) {
+                while (pins_[i].count.load(std::memory_order_seq_cst) > 0) {
+                    if (copies_.load(std::memory_order_acquire) > 0 ||
+                        std::chrono::steady_clock::now() > deadline) {
+                        drained = false;
+                        break;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+            if (drained) {
+                return true;
+            }
+            growing_.store(false, std::memory_order_release);
+            if (copies_.load(std::memory_order_acquire) == 0) {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * @brief Get a reset transaction from the pool, or begin a new one
+     * @return The transaction, active, or nullptr on failure
+     */
+    MDB_txn *take_from_pool() {
+        MDB_txn *txn = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(pool_->mutex);
+            if (!pool_->idle.empty()) {
+                txn = pool_->idle.back();
+                pool_->idle.pop_back();
+            }
+        }
+        if (txn != nullptr) {
+            if (mdb_txn_renew(txn) == MDB_SUCCESS) {
+                return txn;
+            }
+            std::lock_guard<std::mutex> lock(pool_->mutex);
+            pool_->idle.push_back(txn);
+            return nullptr;
+        }
+        if (mdb_txn_begin(pool_->env, nullptr, MDB_RDONLY, &txn) != 0) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(pool_->mutex);
+        pool_->all.push_back(txn);
+        return txn;
+    }
+
+    MDB_txn *begin_read() {
+        std::vector<CachedReader> &readers = thread_readers().readers;
+        for (CachedReader &reader : readers) {
+            if (reader.pool == pool_) {
+                if (reader.in_use) {
+                    // Nested read on this thread: use another transaction
+                    return take_from_pool();
+                }
+                if (mdb_txn_renew(reader.txn) != MDB_SUCCESS) {
+                    return nullptr;
+                }
+                reader.in_use = true;
+                return reader.txn;
+            }
+        }
+        // Forget transactions of environments closed since
+        readers.erase(std::remove_if(readers.begin(), readers.end(),
+                                     [](const CachedReader &reader) {
+                                         std::lock_guard<std::mutex> lock(
+                                             reader.pool->mutex);
+                                         return reader.pool->closed;
+                                     }),
+                      readers.end());
+        MDB_txn *txn = take_from_pool();
+        if (txn != nullptr) {
+            readers.push_back(CachedReader{pool_, txn, true});
+        }
+        return txn;
+    }
+
+    void end_read(MDB_txn *txn) {
+        mdb_txn_reset(txn);
+        for (CachedReader &reader : thread_readers().readers) {
+            if (reader.pool == pool_ && reader.txn == txn) {
+                reader.in_use = false;
+                return;
+            }
+        }
+        std::lock_guard<std::mutex> lock(pool_->mutex);
+        pool_->idle.push_back(txn);
+    }
+
+    /**
+     * @brief Double the map, unless another writer already grew it
+     * @param full_size Map size the failed write ran with
+     * @return true if the map is now larger than full_size
+     */
+    bool grow(size_t full_size) {
+        std::lock_guard<std::mutex> growth(grow_mutex_);
+        size_t current = map_size_.load(std::memory_order_relaxed);
+        if (current > full_size) {
+            return true;
+        }
+        if (max_map_size_ != 0 && current >= max_map_size_) {
+            return false;
+        }
+        if (!drain_pins()) {
+            return false;
+        }
+        size_t next = current * 2;
+        if (max_map_size_ != 0) {
+            next = std::min(next, max_map_size_);
+        }
+        bool grown = mdb_env_set_mapsize(pool_->env, next) == 0;
+        if (grown) {
+            map_size_.store(next, std::memory_order_relaxed);
+        }
+        growing_.store(false, std::memory_order_release);
+        return grown;
+    }
+
+public:
+    /**
+     * @brief Keeps the map from being resized while held (see pin())
+     */
+    class Pin {
+    private:
+        std::atomic_size_t *count_; // Slot counting the pin (nullptr: none)
+
+    public:
+        /**
+         * @brief Constructor - holds nothing
+         */
+        Pin() : count_(nullptr) {}
+
+        /**
+         * @brief Constructor - pins the map
+         * @param owner Transactions of the environment to pin
+         */
+        explicit Pin(const LmdbTransactions &owner) :
+            count_(owner.acquire_pin()) {}
+
+        Pin(Pin &&other) noexcept :
+            count_(std::exchange(other.count_, nullptr)) {}
+
+        Pin &operator=(Pin &&other) noexcept {
+            if (this != &other) {
+                release();
+                count_ = std::exchange(other.count_, nullptr);
+            }
+            return *this;
+        }
+
+        ~Pin() { release(); }
+
+        /**
+         * @brief Release the pin early
+         */
+        void release() {
+            if (count_ != nullptr) {
+                count_->fetch_sub(1, std::memory_order_release);
+                count_ = nullptr;
+            }
+        }
+    };
+
+    /**
+     * @brief Read transaction held for the lifetime of the object
+     */
+    class Reader {
+    private:
+        LmdbTransactions *owner_; // Transactions it came from
+        Pin pin_;                 // Keeps the map in place
+        MDB_txn *txn_;            // nullptr if begin failed
+
+    public:
+        explicit Reader(LmdbTransactions &owner) :
+            owner_(&owner), pin_(owner), txn_(owner.begin_read()) {}
+
+        ~Reader() {
+            if (txn_ != nullptr) {
+                owner_->end_read(txn_);
+            }
+        }
+
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        /**
+         * @brief Get the transaction
+         * @return The transaction, or nullptr if it could not begin
+         */
+        MDB_txn *txn() const { return txn_; }
+    };
+
+    /**
+     * @brief Pin held by a copy of the environment (see pin_copy())
+     */
+    class CopyPin {
+    private:
+        LmdbTransactions *owner_; // Transactions it pins
+        Pin pin_;                 // Keeps the map in place
+
+    public:
+        explicit CopyPin(LmdbTransactions &owner) : owner_(&owner) {
+            // Counted first, so a growth lets the pin through and waits
+            owner_->copies_.fetch_add(1, std::memory_order_release);
+            pin_ = Pin(owner);
+        }
+
+        ~CopyPin() {
+            pin_.release();
+            owner_->copies_.fetch_sub(1, std::memory_order_release);
+        }
+
+        CopyPin(const CopyPin &) = delete;
+        CopyPin &operator=(const CopyPin &) = delete;
+    };
+
+    /**
+     * @brief Constructor
+     * @param env Open environment (must use MDB_NOTLS; owned by the caller)
+     * @param options Settings the environment was opened with
+     */
+    LmdbTransactions(MDB_env *env, const LmdbOptions &options) :
+        pool_(std::make_shared<Pool>(env)), growing_(false),
+        map_size_(options.map_size), max_map_size_(options.max_map_size),
+        copies_(0) {}
+
+    /**
+     * @brief Destructor - aborts the read transactions
+     */
+    ~LmdbTransactions() { close(); }
+
+    LmdbTransactions(const LmdbTransactions &) = delete;
+    LmdbTransactions &operator=(const LmdbTransactions &) = delete;
+
+    /**
+     * @brief Get the mdb_env_open() flags for the given settings
+     * @param options The settings
+     * @param sync Durable commits (no MDB_NOSYNC / MDB_MAPASYNC)
+     * @return The flags
+     */
+    static unsigned int env_flags(const LmdbOptions &options, bool sync) {
+        unsigned int flags = MDB_NOTLS;
+        if (!sync) {
+            flags |= MDB_NOSYNC | MDB_NOMETASYNC;
+        }
+        if (options.write_map) {
+            flags |= MDB_WRITEMAP;
+            if (options.map_async && !sync) {
+                flags |= MDB_MAPASYNC;
+            }
+        }
+        return flags;
+    }
+
+    /**
+     * @brief Open an environment with the given settings
+     * @param env Output parameter for the environment
+     * @param path Directory of the environment
+     * @param options The settings
+     * @param sync Durable commits
+     * @return 0 on success, or the LMDB error (env is then nullptr)
+     */
+    static int open_env(MDB_env *&env, const char *path,
+                        const LmdbOptions &options, bool sync) {
+        int rc = mdb_env_create(&env);
+        if (rc != 0) {
+            env = nullptr;
+            return rc;
+        }
+        mdb_env_set_maxdbs(env, 1);
+        mdb_env_set_maxreaders(env, options.max_readers);
+        mdb_env_set_mapsize(env, options.map_size);
+        rc = mdb_env_open(env, path, env_flags(options, sync), 0664);
+        if (rc != 0) {
+            mdb_env_close(env);
+            env = nullptr;
+        }
+        return rc;
+    }
+
+    /**
+     * @brief Abort every read transaction; call before closing the
+     * environment
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(pool_->mutex);
+        if (pool_->closed) {
+            return;
+        }
+        pool_->closed = true;
+        for (MDB_txn *txn : pool_->all) {
+            mdb_txn_abort(txn);
+        }
+        pool_->all.clear();
+        pool_->idle.clear();
+    }
+
+    /**
+     * @brief Begin a read transaction
+     * @return The transaction, ended when the Reader is destroyed
+     */
+    Reader read() { return Reader(*this); }
+
+    /**
+     * @brief Keep the map from being resized (for long-lived cursors)
+     * @return A pin released when destroyed
+     */
+    Pin pin() const { return Pin(*this); }
+
+    /**
+     * @brief Keep the map from being resized while the environment is
+     * copied
+     * @return A pin released when destroyed; writers that find the map full
+     * meanwhile wait for it instead of failing
+     *
+     * The copying thread must not wait for writers while it holds the pin.
+     */
+    CopyPin pin_copy() { return CopyPin(*this); }
+
+    /**
+     * @brief Grow the map until at least half of it is free
+     * @return false if it could not grow that far (e.g. max_map_size)
+     *
+     * Called before a copy, so that writers rarely have to wait for it to
+     * end.
+     */
+    bool reserve_headroom() {
+        MDB_envinfo info;
+        MDB_stat stat;
+        if (mdb_env_info(pool_->env, &info) != 0 ||
+            mdb_env_stat(pool_->env, &stat) != 0) {
+            return false;
+        }
+        const size_t used = (info.me_last_pgno + 1) * size_t(stat.ms_psize);
+        for (;;) {
+            size_t current = map_size_.load(std::memory_order_relaxed);
+            if (current >= 2 * used) {
+                return true;
+            }
+            if (!grow(current)) {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * @brief Run a write transaction, growing the map when it is full
+     *
+     * The transaction commits if body returns MDB_SUCCESS and is aborted
+     * otherwise; body may run again after a growth.
+     *
+     * @param body Callable taking the MDB_txn * and returning an LMDB code
+     * @return body's code, or the error of begin or commit
+     */
+    template <typename Body> int write(Body &&body) {
+        for (;;) {
+            size_t size;
+            int rc;
+            {
+                Pin pin(*this);
+                size = map_size_.load(std::memory_order_relaxed);
+                MDB_txn *txn;
+                rc = mdb_txn_begin(pool_->env, nullptr, 0, &txn);
+                if (rc != 0) {
+                    return rc;
+                }
+                rc = body(txn);
+                if (rc == MDB_SUCCESS) {
+                    rc = mdb_txn_commit(txn);
+                } else {
+                    mdb_txn_abort(txn);
+                }
+            }
+            if (rc != MDB_MAP_FULL || !grow(size)) {
+                return rc;
+            }
+        }
+    }
+
+    /**
+     * @brief Get the current map size
+     * @return Bytes
+     */
+    size_t map_size() const {
+        return map_size_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of read transactions begun so far
+     * @return Transactions (threads that read, plus nested reads)
+     */
+    size_t reader_count() const {
+        std::lock_guard<std::mutex> lock(pool_->mutex);
+        return pool_->all.size();
+    }
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+
+/**
+ * @brief LMDB environment settings
+ *
+ * The map starts at map_size and doubles whenever a write finds it full, up
+ * to max_map_size (0: no limit), so small databases do not reserve a huge
+ * address range up front.
+ */
+struct LmdbOptions {
+    size_t map_size = 1ULL << 30;    // Initial map size in bytes
+    size_t max_map_size = 0;         // Largest map size (0: unlimited)
+    bool write_map = false;          // MDB_WRITEMAP: write through the map
+    bool map_async = false;          // MDB_MAPASYNC: async flushes
+    unsigned int max_readers = 1024; // Reader slots (one per reading thread)
+
+    bool operator==(const LmdbOptions &) const = default;
+};
+
+/**
+ * @brief Process-wide LMDB settings for LmdbStorageEngine and LmdbKeyStorage
+ *
+ * Set before creating the storage; environments already open keep the
+ * settings they were opened with.
+ */
+class LmdbTuning {
+private:
+    struct Registry {
+        std::mutex mutex;    // Guards options
+        LmdbOptions options; // Settings of new environments
+    };
+
+    static Registry &registry() {
+        static Registry instance;
+        return instance;
+    }
+
+public:
+    /**
+     * @brief Set the settings of environments opened from now on
+     * @param options The settings
+     */
+    static void set_options(const LmdbOptions &options) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.options = options;
+    }
+
+    /**
+     * @brief Get the settings new environments open with
+     * @return The settings
+     */
+    static LmdbOptions options() {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        return r.options;
+    }
+};
+
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Status.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <string>
+
+/**
+ * @brief One key of a StorageEngine::multi_read() batch
+ */
+struct ReadRequest {
+    const std::string *key;          // Key to read
+    std::string *value;              // Receives the value when found
+    Status status = Status::PENDING; // SUCCESS or NOT_FOUND once read
+};
+
+namespace multi_read {
+
+/** Keys looked up together by ordered_multi_read(). */
+constexpr size_t GROUP = 16;
+
+/**
+ * Successors of the previous key's entry tried before a new descent. Batches
+ * often hold co-accessed keys, which repartitioning keeps in one partition
+ * and which tend to be neighbours in key order.
+ */
+constexpr size_t FINGER_STEPS = 4;
+
+/**
+ * @brief Hint the CPU to load a cache line for reading
+ * @param address Any address in the line
+ */
+inline void prefetch(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 0, 3);
+#else
+    (void)address;
+#endif
+}
+
+/**
+ * @brief Look up a batch of keys in an ordered map (std::map,
+ * absl::btree_map), overlapping their cache misses
+ *
+ * Neither map exposes its nodes, so lookups cannot be interleaved node by
+ * node. Each group of GROUP keys is instead processed in three passes:
+ * 1. Locate: the keys are searched in sorted order, so consecutive descents
+ *    share the upper levels already in cache. Each key is first looked for
+ *    among the FINGER_STEPS successors of the previous key's entry.
+ * 2. Prefetch the value buffer of every entry found.
+ * 3. Copy the values, whose loads were issued together by pass 2.
+ *
+ * The caller holds whatever lock protects the map.
+ *
+ * @param map The map
+ * @param requests Keys to read; each receives its value and status
+ */
+template <typename OrderedMap>
+void ordered_multi_read(const OrderedMap &map,
+                        std::span<ReadRequest> requests) {
+    using Iterator = typename OrderedMap::const_iterator;
+    std::array<size_t, GROUP> order;
+    std::array<Iterator, GROUP> found;
+
+    for (size_t begin = 0; begin < requests.size(); begin += GROUP) {
+        const size_t count = std::min(GROUP, requests.size() - begin);
+        ReadRequest *group = requests.data() + begin;
+        std::iota(order.begin(), order.begin() + count, size_t{0});
+        std::sort(order.begin(), order.begin() + count,
+                  [group](size_t a, size_t b) {
+                      return *group[a].key < *group[b].key;
+                  });
+
+        // Pass 1: locate, sorted, starting from the previous entry
+        Iterator previous = map.end();
+        for (size_t i = 0; i < count; ++i) {
+            const std::string &key = *group[order[i]].key;
+            Iterator it = previous;
+            for (size_t steps = 0; it != map.end() && it->first < key &&
+                                   steps < FINGER_STEPS;
+                 ++steps) {
+                ++it;
+            }
+            if (previous == map.end() ||
+                (it != map.end() && it->first < key)) {
+                it = map.lower_bound(key);
+            }
+            previous = it;
+            found[order[i]] =
+                it != map.end() && it->first == key ? it : map.end();
+        }
+
+        // Pass 2: start loading every value at once
+        for (size_t i = 0; i < count; ++i) {
+            if (found[i] != map.end()) {
+                prefetch(found[i]->second.data());
+            }
+        }
+
+        // Pass 3: copy
+        for (size_t i = 0; i < count; ++i) {
+            if (found[i] != map.end()) {
+                *group[i].value = found[i]->second;
+                group[i].status = Status::SUCCESS;
+            } else {
+                group[i].status = Status::NOT_FOUND;
+            }
+        }
+    }
+}
+
+} // namespace multi_read
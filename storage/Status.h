@@ -9,6 +9,8 @@ enum class Status {
     SUCCESS,
     NOT_FOUND,
     ERROR,
+    BUSY,        // Rejected by admission control, the caller may retry later
+    STALE_ROUTE, // Routed with an outdated key map (re-routed internally)
 };
 
 /**
@@ -26,6 +28,10 @@ inline std::string to_string(Status status) {
             return "NOT_FOUND";
         case Status::ERROR:
             return "ERROR";
+        case Status::BUSY:
+            return "BUSY";
+        case Status::STALE_ROUTE:
+            return "STALE_ROUTE";
         default:
             return "UNKNOWN";
     }
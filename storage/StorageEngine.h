@@ -1,7 +1,12 @@
 #pragma once
 
 #include "StorageEngineConcepts.h"
+#include "EngineCheckpoint.h"
+#include "EngineThreading.h"
+#include "MultiRead.h"
 #include <atomic>
+#include <functional>
+#include <span>
 #include <string>
 #include <shared_mutex>
 #include <vector>
@@ -29,8 +34,12 @@
  * - remove_impl(const std::string& key, std::string& removed_value)
  * - scan_impl(const std::string& initial_key_prefix, size_t limit,
  *   std::vector<std::pair<std::string, std::string>>& results) const
+ * - multi_read_impl(std::span<ReadRequest>) (optional) - reads a batch of
+ *   keys with overlapped lookups (see MultiRead.h)
  * - iterator_impl() (optional) - returns a scan iterator for locality-optimized
  * lookups
+ * - checkpoint_impl(directory, partition, throttle, captured) (optional) -
+ *   writes a point-in-time image with the engine's own copy or snapshot
  */
 template <typename Derived, bool SYNC = false> class StorageEngine {
 public:
@@ -40,8 +49,7 @@ public:
 protected:
     mutable std::shared_mutex _lock; // Mutex for thread-safe operations
     size_t level_;                   // Hierarchy level of this storage engine
-    std::atomic_size_t operation_count_; // Number of operations performed on
-                                         // this storage engine
+    ShardedCounter operation_count_; // Operations performed on this engine
     std::string path_; // Path for embedded database files (default: /tmp)
 public:
     /**
@@ -50,7 +58,7 @@ public:
      * @param path Optional path for embedded database files (default: /tmp)
      */
     explicit StorageEngine(size_t level, const std::string &path = "/tmp") :
-        level_(level), operation_count_(0), path_(path) {}
+        level_(level), path_(path) {}
 
     /**
      * @brief Default destructor
@@ -65,7 +73,7 @@ public:
      */
     Status read(const std::string &key, std::string &value) {
         Derived *derived = static_cast<Derived *>(this);
-        derived->operation_count_.fetch_add(1, std::memory_order_relaxed);
+        derived->operation_count_.add();
         return derived->read_impl(key, value);
     }
 
@@ -77,10 +85,30 @@ public:
      */
     Status write(const std::string &key, const std::string &value) {
         Derived *derived = static_cast<Derived *>(this);
-        derived->operation_count_.fetch_add(1, std::memory_order_relaxed);
+        derived->operation_count_.add();
         return derived->write_impl(key, value);
     }
 
+    /**
+     * @brief Read a batch of keys
+     * @param requests Keys to read; each receives its value and status
+     *
+     * Engines with multi_read_impl() overlap the lookups' cache misses;
+     * the others read the keys one by one. Counts one operation per key.
+     */
+    void multi_read(std::span<ReadRequest> requests) {
+        Derived *derived = static_cast<Derived *>(this);
+        derived->operation_count_.add(requests.size());
+        if constexpr (requires { derived->multi_read_impl(requests); }) {
+            derived->multi_read_impl(requests);
+        } else {
+            for (ReadRequest &request : requests) {
+                request.status =
+                    derived->read_impl(*request.key, *request.value);
+            }
+        }
+    }
+
     /**
      * @brief Scan for key-value pairs from a starting point (lower_bound)
      * @param key_start The starting key (returns keys >= key_start)
@@ -91,7 +119,7 @@ public:
     Status scan(const std::string &key_start, size_t limit,
                 std::vector<std::pair<std::string, std::string>> &results) {
         Derived *derived = static_cast<Derived *>(this);
-        derived->operation_count_.fetch_add(1, std::memory_order_relaxed);
+        derived->operation_count_.add();
         return derived->scan_impl(key_start, limit, results);
     }
 
@@ -105,7 +133,7 @@ public:
      */
     Status remove(const std::string &key, std::string &removed_value) {
         Derived *derived = static_cast<Derived *>(this);
-        derived->operation_count_.fetch_add(1, std::memory_order_relaxed);
+        derived->operation_count_.add();
         return derived->remove_impl(key, removed_value);
     }
 
@@ -122,6 +150,55 @@ public:
         return derived->iterator_impl();
     }
 
+    /**
+     * @brief Write a point-in-time image of the engine (see EngineCheckpoint)
+     * @param directory Checkpoint directory (must exist)
+     * @param partition Partition index, part of the image's name
+     * @param throttle Budget the image bytes are taken from
+     * @param captured Called exactly once, when the image content is fixed;
+     *        the caller keeps writers away from the engine until then
+     * @return Status::SUCCESS, or Status::ERROR if the image could not be
+     * written
+     *
+     * Engines without checkpoint_impl() are read into memory with
+     * scan_impl() before captured() and written as a record file afterwards.
+     */
+    Status checkpoint(const std::string &directory, size_t partition,
+                      TokenBucket &throttle,
+                      const std::function<void()> &captured) {
+        Derived *derived = static_cast<Derived *>(this);
+        if constexpr (requires {
+                          derived->checkpoint_impl(directory, partition,
+                                                   throttle, captured);
+                      }) {
+            return derived->checkpoint_impl(directory, partition, throttle,
+                                            captured);
+        } else {
+            constexpr size_t batch_size = 1024;
+            std::vector<std::pair<std::string, std::string>> records;
+            std::vector<std::pair<std::string, std::string>> batch;
+            std::string next_key;
+            Status status = Status::SUCCESS;
+            do {
+                batch.clear();
+                status = derived->scan_impl(next_key, batch_size, batch);
+                if (!batch.empty()) {
+                    next_key = batch.back().first + '\0';
+                    records.insert(records.end(),
+                                   std::make_move_iterator(batch.begin()),
+                                   std::make_move_iterator(batch.end()));
+                }
+            } while (batch.size() == batch_size);
+            captured();
+            if (status == Status::ERROR) {
+                return Status::ERROR;
+            }
+            return EngineCheckpoint::write_records(
+                EngineCheckpoint::record_file(directory, partition), records,
+                throttle);
+        }
+    }
+
     /**
      * @brief Acquire a shared lock (for read operations)
      * User must manually call this when thread-safety is needed
@@ -158,7 +235,7 @@ public:
      */
     void level(size_t level) { level_ = level; }
 
-    size_t operation_count() const { return operation_count_; }
+    size_t operation_count() const { return operation_count_.load(); }
 
     /**
      * @brief Get the path for embedded database files
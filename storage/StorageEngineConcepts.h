@@ -1,10 +1,14 @@
 #pragma once
 
+#include <cstddef>
+#include <optional>
 #include <string>
 #include <vector>
 #include <concepts>
 #include "Status.h"
 
+struct EngineProfile; // EngineTuning.h
+
 /**
  * @brief Concept for types that implement the StorageEngine interface
  */
@@ -18,3 +22,79 @@ concept StorageEngineImpl =
         { engine.remove_impl(key, value) } -> std::same_as<Status>;
         { constEngine.scan_impl(key, limit, results) } -> std::same_as<Status>;
     };
+
+/**
+ * @brief Concept for engines with per-partition settings, which take the
+ * partition index as a third constructor argument (level, path, partition)
+ */
+template <typename T>
+concept PartitionAwareStorageEngine =
+    std::constructible_from<T, size_t, const std::string &, size_t>;
+
+/**
+ * @brief Concept for engines with tuning
+ *
+ * A tunable engine names its tuning struct TuningType, picks it out of an
+ * EngineProfile with T::profile_tuning(profile, partition), and takes it as
+ * the last argument of its (level, path) and (level, path, partition)
+ * constructors.
+ */
+template <typename T>
+concept TunableStorageEngine =
+    requires(const EngineProfile &profile, std::optional<size_t> partition) {
+        typename T::TuningType;
+        {
+            T::profile_tuning(profile, partition)
+        } -> std::convertible_to<typename T::TuningType>;
+    } &&
+    std::constructible_from<T, size_t, const std::string &,
+                            const typename T::TuningType &> &&
+    std::constructible_from<T, size_t, const std::string &, size_t,
+                            const typename T::TuningType &>;
+
+/**
+ * @brief Create a storage engine tuned by a profile
+ * @param level The hierarchy level for the engine
+ * @param path Path for embedded database files
+ * @param partition Partition index, passed on to partition-aware engines
+ * (nullopt: the engine does not belong to a partition)
+ * @param profile Tuning of every backend; tunable engines take theirs
+ * @return The new engine (owned by the caller)
+ */
+template <typename T>
+T *new_engine(size_t level, const std::string &path,
+              std::optional<size_t> partition, const EngineProfile &profile) {
+    if constexpr (TunableStorageEngine<T>) {
+        const auto &tuning = T::profile_tuning(profile, partition);
+        if (partition.has_value()) {
+            return new T(level, path, *partition, tuning);
+        }
+        return new T(level, path, tuning);
+    } else {
+        (void)profile;
+        if constexpr (PartitionAwareStorageEngine<T>) {
+            if (partition.has_value()) {
+                return new T(level, path, *partition);
+            }
+        }
+        return new T(level, path);
+    }
+}
+
+/**
+ * @brief Create a storage engine tuned by a profile, by value
+ * @param level The hierarchy level for the engine
+ * @param path Path for embedded database files
+ * @param profile Tuning of every backend; tunable engines take theirs
+ * @return The new engine
+ */
+template <typename T>
+T make_engine(size_t level, const std::string &path,
+              const EngineProfile &profile) {
+    if constexpr (TunableStorageEngine<T>) {
+        return T(level, path, T::profile_tuning(profile, std::nullopt));
+    } else {
+        (void)profile;
+        return T(level, path);
+    }
+}
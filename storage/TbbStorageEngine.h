@@ -25,6 +25,10 @@
  * Note: This class is thread-safe by design. The base class lock()/unlock()
  * methods are still available but not necessary for thread-safety.
  *
+ * multi_read() reads the keys one by one: concurrent_hash_map exposes no
+ * bucket or node to prefetch, and holding several accessors at once could
+ * deadlock against writers.
+ *
  * @tparam SYNC Durable sync flag (ignored; in-memory only).
  */
 template <bool SYNC = false> class TbbStorageEngine
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "StorageEngineIterator.h"
+#include "StorageEngine.h"
+#include "EngineTuning.h"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/**
+ * @brief Storage tier of a TieredStorageEngine
+ */
+enum class Tier {
+    HOT, // Served by the hot (e.g. in-memory) engine
+    COLD // Served by the cold (e.g. on-disk) engine
+};
+
+/**
+ * @brief Storage engine that runs on either a hot or a cold engine type
+ *
+ * Holds a std::variant handle to one engine of either type and forwards every
+ * operation to it, so a partitioned storage can keep hot partitions in a
+ * memory engine and cold ones in LMDB or LevelDB while all its partitions
+ * share one engine type. New engines start cold.
+ *
+ * migrate() moves the data to a new engine of the other type in batches of
+ * MIGRATION_BATCH pairs. Requests keep being served during the move: each
+ * batch is copied under a short exclusive lock, writes and removes issued
+ * meanwhile go to both engines, and the engines are swapped once the last
+ * batch is copied. migrate() is meant to run on a background thread.
+ *
+ * Like the other engines, operations do not take the StorageEngine lock();
+ * the internal tier lock only orders them against migration.
+ *
+ * @tparam HotEngineTemplate Engine template for hot data (e.g.
+ *         \c MapStorageEngine)
+ * @tparam ColdEngineTemplate Engine template for cold data (e.g.
+ *         \c LmdbStorageEngine)
+ * @tparam SYNC Durable sync flag, forwarded to both engines
+ */
+template <template <bool> class HotEngineTemplate,
+          template <bool> class ColdEngineTemplate, bool SYNC = false>
+class TieredStorageEngine
+    : public StorageEngine<
+          TieredStorageEngine<HotEngineTemplate, ColdEngineTemplate, SYNC>,
+          SYNC> {
+public:
+    using HotEngineType = HotEngineTemplate<SYNC>;
+    using ColdEngineType = ColdEngineTemplate<SYNC>;
+    using EngineHandle = std::variant<std::unique_ptr<HotEngineType>,
+                                      std::unique_ptr<ColdEngineType>>;
+
+    static constexpr size_t MIGRATION_BATCH = 1024; // Pairs copied per lock
+
+private:
+    using Base = StorageEngine<
+        TieredStorageEngine<HotEngineTemplate, ColdEngineTemplate, SYNC>, SYNC>;
+
+    std::optional<size_t> partition_;     // Partition index, if known
+    EngineProfile profile_;               // Tuning of the tiers' engines
+    EngineHandle engine_;                 // Engine serving requests
+    std::optional<EngineHandle> target_;  // Engine being filled by migrate()
+    mutable std::shared_mutex tier_lock_; // Exclusive to copy a batch or swap
+    std::mutex migration_mutex_;          // One migration at a time
+
+    template <typename Engine> std::unique_ptr<Engine> make_tier() const {
+        return std::unique_ptr<Engine>(new_engine<Engine>(
+            this->level_, this->path_, partition_, profile_));
+    }
+
+    // Indices select the alternative, so both tiers may use the same type
+    EngineHandle make_engine(Tier tier) const {
+        if (tier == Tier::HOT) {
+            return EngineHandle(std::in_place_index<0>,
+                                make_tier<HotEngineType>());
+        }
+        return EngineHandle(std::in_place_index<1>,
+                            make_tier<ColdEngineType>());
+    }
+
+    static Tier tier_of(const EngineHandle &handle) {
+        return handle.index() == 0 ? Tier::HOT : Tier::COLD;
+    }
+
+    /**
+     * @brief Apply a write or remove to the engine, and to the migration
+     * target if a migration is running
+     */
+    template <typename Operation> Status update(Operation &&operation) {
+        {
+            std::shared_lock<std::shared_mutex> lock(tier_lock_);
+            if (!target_.has_value()) {
+                return std::visit(operation, engine_);
+            }
+        }
+        // Exclusive so both engines see the updates in the same order
+        std::unique_lock<std::shared_mutex> lock(tier_lock_);
+        Status status = std::visit(operation, engine_);
+        if (target_.has_value()) {
+            std::visit(operation, *target_);
+        }
+        return status;
+    }
+
+public:
+    // Both tiers' engines take their parts of a whole profile
+    using TuningType = EngineProfile;
+
+    /**
+     * @brief Get this engine's tuning in a profile
+     * @param profile The profile
+     * @param partition Partition index, if known (unused)
+     * @return The whole profile
+     */
+    static const EngineProfile &
+    profile_tuning(const EngineProfile &profile,
+                   std::optional<size_t> partition) {
+        (void)partition;
+        return profile;
+    }
+
+    /**
+     * @brief Constructor - creates a cold engine
+     * @param level The hierarchy level for this storage engine (default: 0)
+     * @param path Optional path for embedded database files (default: /tmp)
+     * @param profile Tuning of the tiers' engines (default: the EngineTuning
+     * profile)
+     */
+    explicit TieredStorageEngine(
+        size_t level = 0, const std::string &path = "/tmp",
+        const EngineProfile &profile = EngineTuning::profile()) :
+        Base(level, path), profile_(profile),
+        engine_(make_engine(Tier::COLD)) {}
+
+    /**
+     * @brief Constructor - creates an engine of the given tier
+     * @param tier Initial tier
+     * @param level The hierarchy level for this storage engine
+     * @param path Optional path for embedded database files (default: /tmp)
+     */
+    TieredStorageEngine(Tier tier, size_t level,
+                        const std::string &path = "/tmp") :
+        Base(level, path), profile_(EngineTuning::profile()),
+        engine_(make_engine(tier)) {}
+
+    /**
+     * @brief Constructor - creates a cold engine for a partition
+     *
+     * Both tiers' engines are created with the partition index if they take
+     * one (e.g. LevelDB's per-partition options).
+     *
+     * @param level The hierarchy level for this storage engine
+     * @param path Path for embedded database files
+     * @param partition Partition index
+     * @param profile Tuning of the tiers' engines (default: the EngineTuning
+     * profile)
+     */
+    TieredStorageEngine(
+        size_t level, const std::string &path, size_t partition,
+        const EngineProfile &profile = EngineTuning::profile()) :
+        Base(level, path), partition_(partition), profile_(profile),
+        engine_(make_engine(Tier::COLD)) {}
+
+    // Copy constructor and assignment operator are deleted
+    TieredStorageEngine(const TieredStorageEngine &) = delete;
+    TieredStorageEngine &operator=(const TieredStorageEngine &) = delete;
+
+    /**
+     * @brief Get the tier currently serving requests
+     * @return Tier::HOT or Tier::COLD
+     */
+    Tier tier() const {
+        std::shared_lock<std::shared_mutex> lock(tier_lock_);
+        return tier_of(engine_);
+    }
+
+    /**
+     * @brief Move the data to an engine of another tier
+     *
+     * Blocks until the data has moved; requests are served meanwhile. A
+     * migration to the current tier returns immediately.
+     *
+     * @param tier The tier to move to
+     * @return Status::SUCCESS once the new engine serves requests, or the
+     * status of the failed copy (the old engine keeps serving)
+     */
+    Status migrate(Tier tier) {
+        std::lock_guard<std::mutex> migration(migration_mutex_);
+        {
+            std::unique_lock<std::shared_mutex> lock(tier_lock_);
+            if (tier_of(engine_) == tier) {
+                return Status::SUCCESS;
+            }
+            target_.emplace(make_engine(tier));
+        }
+
+        std::vector<std::pair<std::string, std::string>> batch;
+        std::string next_key;
+        for (;;) {
+            std::unique_lock<std::shared_mutex> lock(tier_lock_);
+            batch.clear();
+            Status status = std::visit(
+                [&](auto &engine) {
+                    return engine->scan(next_key, MIGRATION_BATCH, batch);
+                },
+                engine_);
+            if (status != Status::SUCCESS && status != Status::NOT_FOUND) {
+                EngineHandle abandoned = std::move(*target_);
+                target_.reset();
+                lock.unlock();
+                return status;
+            }
+            for (const auto &[key, value] : batch) {
+                status = std::visit(
+                    [&](auto &engine) { return engine->write(key, value); },
+                    *target_);
+                if (status != Status::SUCCESS) {
+                    EngineHandle abandoned = std::move(*target_);
+                    target_.reset();
+                    lock.unlock();
+                    return status;
+                }
+            }
+            if (batch.size() < MIGRATION_BATCH) {
+                // The old engine is destroyed once the lock is released
+                EngineHandle old = std::move(engine_);
+                engine_ = std::move(*target_);
+                target_.reset();
+                lock.unlock();
+                return Status::SUCCESS;
+            }
+            next_key = batch.back().first + '\0';
+        }
+    }
+
+    /**
+     * @brief Move the data to the hot engine
+     * @return See migrate()
+     */
+    Status promote() { return migrate(Tier::HOT); }
+
+    /**
+     * @brief Move the data to the cold engine
+     * @return See migrate()
+     */
+    Status demote() { return migrate(Tier::COLD); }
+
+    Status read_impl(const std::string &key, std::string &value) const {
+        std::shared_lock<std::shared_mutex> lock(tier_lock_);
+        return std::visit(
+            [&](const auto &engine) { return engine->read(key, value); },
+            engine_);
+    }
+
+    Status write_impl(const std::string &key, const std::string &value) {
+        return update(
+            [&](auto &engine) { return engine->write(key, value); });
+    }
+
+    Status remove_impl(const std::string &key, std::string &removed_value) {
+        return update([&](auto &engine) {
+            std::string target_value;
+            Status status = engine->remove(key, target_value);
+            if (status == Status::SUCCESS) {
+                removed_value = std::move(target_value);
+            }
+            return status;
+        });
+    }
+
+    Status
+    scan_impl(const std::string &initial_key_prefix, size_t limit,
+              std::vector<std::pair<std::string, std::string>> &results) const {
+        std::shared_lock<std::shared_mutex> lock(tier_lock_);
+        return std::visit(
+            [&](const auto &engine) {
+                return engine->scan(initial_key_prefix, limit, results);
+            },
+            engine_);
+    }
+
+    /**
+     * @brief Iterator over a TieredStorageEngine
+     *
+     * Looks keys up in whichever engine serves requests at the time of the
+     * lookup, so it stays valid across migrations.
+     */
+    class TieredIterator
+        : public StorageEngineIterator<TieredIterator, TieredStorageEngine> {
+    public:
+        explicit TieredIterator(TieredStorageEngine &engine) :
+            StorageEngineIterator<TieredIterator, TieredStorageEngine>(engine) {
+        }
+
+        Status find_impl(const std::string &key, std::string &value) const {
+            return this->engine_->read_impl(key, value);
+        }
+    };
+
+    TieredIterator iterator_impl() { return TieredIterator(*this); }
+
+    using IteratorType = TieredIterator;
+};
+
+/**
+ * @brief Whether an engine type is a TieredStorageEngine
+ */
+template <typename T> struct is_tiered_storage_engine : std::false_type {};
+
+template <template <bool> class Hot, template <bool> class Cold, bool SYNC>
+struct is_tiered_storage_engine<TieredStorageEngine<Hot, Cold, SYNC>>
+    : std::true_type {};
+
+template <typename T>
+inline constexpr bool is_tiered_storage_engine_v =
+    is_tiered_storage_engine<T>::value;
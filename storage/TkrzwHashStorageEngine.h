@@ -2,6 +2,8 @@
 
 #include "StorageEngineIterator.h"
 #include "StorageEngine.h"
+#include "EnginePersistence.h"
+#include "TkrzwTuning.h"
 #include <atomic>
 #include <tkrzw_dbm_hash.h>
 #include <string>
@@ -11,6 +13,7 @@
 #include <algorithm>
 #include <chrono>
 #include <filesystem>
+#include <optional>
 
 /**
  * @brief TKRZW HashDBM-based implementation of StorageEngine
@@ -42,37 +45,96 @@ private:
         return db_->Synchronize(true) == tkrzw::Status::SUCCESS;
     }
 
+    /**
+     * @brief Get a fresh path for a temporary database, creating its parent
+     */
+    std::string temp_path() const {
+        std::filesystem::create_directories(
+            this->path_ + std::string("/repart_kv_storage/") + id_);
+        return this->path_ + std::string("/repart_kv_storage/") + id_ +
+               std::string("/tkrzw_hash_temp_") +
+               std::to_string(
+                   db_counter_.fetch_add(1, std::memory_order_relaxed)) +
+               ".tkh";
+    }
+
+    /**
+     * @brief Open the database file
+     * @param file_path Path to the database file
+     * @param truncate Whether to empty the file (otherwise it is reopened)
+     * @param tuning HashDBM tuning
+     */
+    void open(const std::string &file_path, bool truncate,
+              const TkrzwHashTuning &tuning) {
+        tkrzw::Status status = db_->OpenAdvanced(
+            file_path,
+            true, // writable
+            truncate ? tkrzw::File::OPEN_TRUNCATE : tkrzw::File::OPEN_DEFAULT,
+            tkrzw_tuning_parameters(tuning));
+
+        if (status == tkrzw::Status::SUCCESS) {
+            is_open_ = true;
+        }
+    }
+
 public:
+    using TuningType = TkrzwHashTuning;
+
+    /**
+     * @brief Get this engine's tuning in a profile
+     * @param profile The profile
+     * @param partition Partition index, if known (unused)
+     * @return The profile's HashDBM tuning
+     */
+    static TkrzwHashTuning profile_tuning(const EngineProfile &profile,
+                                          std::optional<size_t> partition) {
+        (void)partition;
+        return profile.tkrzw_hash;
+    }
+
     /**
      * @brief Constructor - creates an in-memory database
      * @param level The hierarchy level for this storage engine (default: 0)
      * @param path Optional path for database files (default: /tmp)
+     * @param tuning HashDBM tuning (default: the EngineTuning profile's)
      *
      * Note: TKRZW HashDBM doesn't support true in-memory mode.
      * For in-memory storage, consider using tkrzw::BabyDBM or
      * a temporary file that gets deleted.
      */
-    explicit TkrzwHashStorageEngine(size_t level = 0,
-                                    const std::string &path = "/tmp") :
+    explicit TkrzwHashStorageEngine(
+        size_t level = 0, const std::string &path = "/tmp",
+        const TkrzwHashTuning &tuning = EngineTuning::profile().tkrzw_hash) :
         StorageEngine<TkrzwHashStorageEngine<SYNC>, SYNC>(level, path),
         db_(std::make_unique<tkrzw::HashDBM>()), is_open_(false) {
         // TKRZW HashDBM requires a file path, so we use the provided path
         // The file will be created but can be considered temporary
-        std::string temp_path =
-            this->path_ + std::string("/repart_kv_storage/") + id_ +
-            std::string("/tkrzw_hash_temp_") +
-            std::to_string(
-                db_counter_.fetch_add(1, std::memory_order_relaxed)) +
-            ".tkh";
-        std::filesystem::create_directories(
-            this->path_ + std::string("/repart_kv_storage/") + id_);
-
-        tkrzw::Status status = db_->OpenAdvanced(temp_path,
-                                                 true, // writable
-                                                 tkrzw::File::OPEN_TRUNCATE);
+        open(temp_path(), true, tuning);
+    }
 
-        if (status == tkrzw::Status::SUCCESS) {
-            is_open_ = true;
+    /**
+     * @brief Constructor - creates the database of a partition
+     *
+     * The database is temporary, or the partition's database in the
+     * EnginePersistence store if one is set (reopened with its contents).
+     *
+     * @param level The hierarchy level for this storage engine
+     * @param path Path for database files
+     * @param partition Partition index
+     * @param tuning HashDBM tuning (default: the EngineTuning profile's)
+     */
+    TkrzwHashStorageEngine(
+        size_t level, const std::string &path, size_t partition,
+        const TkrzwHashTuning &tuning = EngineTuning::profile().tkrzw_hash) :
+        StorageEngine<TkrzwHashStorageEngine<SYNC>, SYNC>(level, path),
+        db_(std::make_unique<tkrzw::HashDBM>()), is_open_(false) {
+        if (EnginePersistence::enabled()) {
+            open(EnginePersistence::partition_path(path, "tkrzw_hash",
+                                                   partition) +
+                     ".tkh",
+                 false, tuning);
+        } else {
+            open(temp_path(), true, tuning);
         }
     }
 
@@ -243,14 +305,39 @@ public:
     }
 
     /**
-     * @brief Synchronize the database to storage
+     * @brief Synchronize the database to storage, even without SYNC
      * @return true if successful, false otherwise
      */
     bool sync() {
         if (!is_open_) {
             return false;
         }
-        return db_->Synchronize(SYNC) == tkrzw::Status::SUCCESS;
+        return db_->Synchronize(true) == tkrzw::Status::SUCCESS;
+    }
+
+    /**
+     * @brief Implementation: Copy the database file
+     *
+     * HashDBM::CopyFileData() writes <directory>/tkrzw_hash_<partition>.tkh and
+     * holds the database's own lock meanwhile, so the image is fixed only
+     * once the copy is done. The copied bytes are taken from the throttle
+     * afterwards: they slow the other partitions' images down, not this
+     * copy.
+     */
+    Status checkpoint_impl(const std::string &directory, size_t partition,
+                           TokenBucket &throttle,
+                           const std::function<void()> &captured) {
+        const std::string image =
+            directory + "/" +
+            EnginePersistence::file_name("tkrzw_hash", partition) + ".tkh";
+        const bool copied =
+            is_open_ &&
+            db_->CopyFileData(image, SYNC) == tkrzw::Status::SUCCESS;
+        captured();
+        std::error_code error;
+        const auto bytes = std::filesystem::file_size(image, error);
+        throttle.acquire(error ? 0 : bytes);
+        return copied ? Status::SUCCESS : Status::ERROR;
     }
 
     /**
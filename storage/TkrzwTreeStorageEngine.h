@@ -2,6 +2,8 @@
 
 #include "StorageEngineIterator.h"
 #include "StorageEngine.h"
+#include "EnginePersistence.h"
+#include "TkrzwTuning.h"
 #include <tkrzw_dbm_tree.h>
 #include <string>
 #include <vector>
@@ -10,6 +12,7 @@
 #include <atomic>
 #include <chrono>
 #include <filesystem>
+#include <optional>
 
 /**
  * @brief TKRZW TreeDBM-based implementation of StorageEngine
@@ -26,7 +29,8 @@
  * - Efficient range queries and prefix scans
  * - Slightly slower writes than HashDBM
  * - Better for scan-heavy workloads
- * - Uses zlib compression for record values to reduce storage space
+ * - Uses zlib compression for record values to reduce storage space (by
+ *   default; see TkrzwTreeTuning)
  *
  * Note: This class is NOT thread-safe by default. Users must manually
  * call lock()/unlock() or lock_shared()/unlock_shared() when needed.
@@ -49,41 +53,95 @@ private:
         return db_->Synchronize(true) == tkrzw::Status::SUCCESS;
     }
 
+    /**
+     * @brief Get a fresh path for a temporary database, creating its parent
+     */
+    std::string temp_path() const {
+        std::filesystem::create_directories(
+            this->path_ + std::string("/repart_kv_storage/") + id_);
+        return this->path_ + std::string("/repart_kv_storage/") + id_ +
+               std::string("/tkrzw_tree_temp_") +
+               std::to_string(
+                   db_counter_.fetch_add(1, std::memory_order_relaxed)) +
+               ".tkt";
+    }
+
+    /**
+     * @brief Open the database file
+     * @param file_path Path to the database file
+     * @param truncate Whether to empty the file (otherwise it is reopened)
+     * @param tuning TreeDBM tuning
+     */
+    void open(const std::string &file_path, bool truncate,
+              const TkrzwTreeTuning &tuning) {
+        tkrzw::Status status = db_->OpenAdvanced(
+            file_path,
+            true, // writable
+            truncate ? tkrzw::File::OPEN_TRUNCATE : tkrzw::File::OPEN_DEFAULT,
+            tkrzw_tuning_parameters(tuning));
+
+        if (status == tkrzw::Status::SUCCESS) {
+            is_open_ = true;
+        }
+    }
+
 public:
+    using TuningType = TkrzwTreeTuning;
+
+    /**
+     * @brief Get this engine's tuning in a profile
+     * @param profile The profile
+     * @param partition Partition index, if known (unused)
+     * @return The profile's TreeDBM tuning
+     */
+    static TkrzwTreeTuning profile_tuning(const EngineProfile &profile,
+                                          std::optional<size_t> partition) {
+        (void)partition;
+        return profile.tkrzw_tree;
+    }
+
     /**
      * @brief Constructor - creates an in-memory database
      * @param level The hierarchy level for this storage engine (default: 0)
      * @param path Optional path for database files (default: /tmp)
+     * @param tuning TreeDBM tuning (default: the EngineTuning profile's)
      *
      * Note: TKRZW TreeDBM doesn't support true in-memory mode.
      * Uses a temporary file for in-memory-like behavior.
      */
-    explicit TkrzwTreeStorageEngine(size_t level = 0,
-                                    const std::string &path = "/tmp") :
+    explicit TkrzwTreeStorageEngine(
+        size_t level = 0, const std::string &path = "/tmp",
+        const TkrzwTreeTuning &tuning = EngineTuning::profile().tkrzw_tree) :
         StorageEngine<TkrzwTreeStorageEngine<SYNC>, SYNC>(level, path),
         db_(std::make_unique<tkrzw::TreeDBM>()), is_open_(false) {
         // TKRZW TreeDBM requires a file path, so we use the provided path
         // The file will be created but can be considered temporary
-        std::string temp_path =
-            this->path_ + std::string("/repart_kv_storage/") + id_ +
-            std::string("/tkrzw_tree_temp_") +
-            std::to_string(
-                db_counter_.fetch_add(1, std::memory_order_relaxed)) +
-            ".tkt";
-        std::filesystem::create_directories(
-            this->path_ + std::string("/repart_kv_storage/") + id_);
-
-        tkrzw::TreeDBM::TuningParameters tuning_params;
-        tuning_params.record_comp_mode = tkrzw::HashDBM::RECORD_COMP_ZLIB;
-
-        tkrzw::Status status =
-            db_->OpenAdvanced(temp_path,
-                              true,                       // writable
-                              tkrzw::File::OPEN_TRUNCATE, // Create new
-                              tuning_params);
+        open(temp_path(), true, tuning);
+    }
 
-        if (status == tkrzw::Status::SUCCESS) {
-            is_open_ = true;
+    /**
+     * @brief Constructor - creates the database of a partition
+     *
+     * The database is temporary, or the partition's database in the
+     * EnginePersistence store if one is set (reopened with its contents).
+     *
+     * @param level The hierarchy level for this storage engine
+     * @param path Path for database files
+     * @param partition Partition index
+     * @param tuning TreeDBM tuning (default: the EngineTuning profile's)
+     */
+    TkrzwTreeStorageEngine(
+        size_t level, const std::string &path, size_t partition,
+        const TkrzwTreeTuning &tuning = EngineTuning::profile().tkrzw_tree) :
+        StorageEngine<TkrzwTreeStorageEngine<SYNC>, SYNC>(level, path),
+        db_(std::make_unique<tkrzw::TreeDBM>()), is_open_(false) {
+        if (EnginePersistence::enabled()) {
+            open(EnginePersistence::partition_path(path, "tkrzw_tree",
+                                                   partition) +
+                     ".tkt",
+                 false, tuning);
+        } else {
+            open(temp_path(), true, tuning);
         }
     }
 
@@ -250,14 +308,39 @@ public:
     }
 
     /**
-     * @brief Synchronize the database to storage
+     * @brief Synchronize the database to storage, even without SYNC
      * @return true if successful, false otherwise
      */
     bool sync() {
         if (!is_open_) {
             return false;
         }
-        return db_->Synchronize(SYNC) == tkrzw::Status::SUCCESS;
+        return db_->Synchronize(true) == tkrzw::Status::SUCCESS;
+    }
+
+    /**
+     * @brief Implementation: Copy the database file
+     *
+     * TreeDBM::CopyFileData() writes <directory>/tkrzw_tree_<partition>.tkt and
+     * holds the database's own lock meanwhile, so the image is fixed only
+     * once the copy is done. The copied bytes are taken from the throttle
+     * afterwards: they slow the other partitions' images down, not this
+     * copy.
+     */
+    Status checkpoint_impl(const std::string &directory, size_t partition,
+                           TokenBucket &throttle,
+                           const std::function<void()> &captured) {
+        const std::string image =
+            directory + "/" +
+            EnginePersistence::file_name("tkrzw_tree", partition) + ".tkt";
+        const bool copied =
+            is_open_ &&
+            db_->CopyFileData(image, SYNC) == tkrzw::Status::SUCCESS;
+        captured();
+        std::error_code error;
+        const auto bytes = std::filesystem::file_size(image, error);
+        throttle.acquire(error ? 0 : bytes);
+        return copied ? Status::SUCCESS : Status::ERROR;
     }
 
     /**
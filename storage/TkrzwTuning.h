@@ -0,0 +1,62 @@
+#pragma once
+
+#include "EngineTuning.h"
+#include <tkrzw_dbm_hash.h>
+#include <tkrzw_dbm_tree.h>
+
+/**
+ * @brief Get the TKRZW record compression mode
+ * @param compression The compression
+ * @return The HashDBM / TreeDBM mode
+ */
+inline tkrzw::HashDBM::RecordCompressionMode
+tkrzw_compression_mode(TkrzwCompression compression) {
+    switch (compression) {
+    case TkrzwCompression::ZLIB:
+        return tkrzw::HashDBM::RECORD_COMP_ZLIB;
+    case TkrzwCompression::ZSTD:
+        return tkrzw::HashDBM::RECORD_COMP_ZSTD;
+    case TkrzwCompression::LZ4:
+        return tkrzw::HashDBM::RECORD_COMP_LZ4;
+    case TkrzwCompression::LZMA:
+        return tkrzw::HashDBM::RECORD_COMP_LZMA;
+    default:
+        return tkrzw::HashDBM::RECORD_COMP_NONE;
+    }
+}
+
+/**
+ * @brief Get the TreeDBM parameters of a tuning
+ * @param tuning The tuning (zero fields keep TKRZW's defaults)
+ * @return The parameters
+ */
+inline tkrzw::TreeDBM::TuningParameters
+tkrzw_tuning_parameters(const TkrzwTreeTuning &tuning) {
+    tkrzw::TreeDBM::TuningParameters params;
+    params.record_comp_mode = tkrzw_compression_mode(tuning.compression);
+    if (tuning.max_page_size > 0) {
+        params.max_page_size = tuning.max_page_size;
+    }
+    if (tuning.max_branches > 0) {
+        params.max_branches = tuning.max_branches;
+    }
+    if (tuning.max_cached_pages > 0) {
+        params.max_cached_pages = tuning.max_cached_pages;
+    }
+    return params;
+}
+
+/**
+ * @brief Get the HashDBM parameters of a tuning
+ * @param tuning The tuning (zero fields keep TKRZW's defaults)
+ * @return The parameters
+ */
+inline tkrzw::HashDBM::TuningParameters
+tkrzw_tuning_parameters(const TkrzwHashTuning &tuning) {
+    tkrzw::HashDBM::TuningParameters params;
+    params.record_comp_mode = tkrzw_compression_mode(tuning.compression);
+    if (tuning.num_buckets > 0) {
+        params.num_buckets = tuning.num_buckets;
+    }
+    return params;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Token bucket rate limiter shared by several threads
+ *
+ * Tokens (e.g. bytes) accumulate at rate() per second up to burst().
+ * acquire() takes tokens and, when the bucket runs dry, puts the caller in
+ * debt and sleeps until the debt is paid back, so concurrent callers are
+ * served in arrival order and the long-run throughput never exceeds rate().
+ * A rate of 0 disables the limit.
+ */
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    mutable std::mutex mutex_; // Guards the fields below
+    uint64_t rate_;            // Tokens per second (0: unlimited)
+    uint64_t burst_;           // Bucket capacity
+    double tokens_;            // Available tokens (negative: debt)
+    Clock::time_point refill_; // Time tokens_ was last refilled
+
+    void refill(Clock::time_point now) {
+        std::chrono::duration<double> elapsed = now - refill_;
+        tokens_ = std::min(static_cast<double>(burst_),
+                           tokens_ + elapsed.count() * rate_);
+        refill_ = now;
+    }
+
+public:
+    /**
+     * @brief Constructor - starts with a full bucket
+     * @param rate Tokens per second (0: unlimited)
+     * @param burst Bucket capacity (0: one second worth of tokens)
+     */
+    explicit TokenBucket(uint64_t rate = 0, uint64_t burst = 0) :
+        rate_(rate), burst_(burst == 0 ? rate : burst),
+        tokens_(static_cast<double>(burst_)), refill_(Clock::now()) {}
+
+    // Copy constructor and assignment operator are deleted
+    TokenBucket(const TokenBucket &) = delete;
+    TokenBucket &operator=(const TokenBucket &) = delete;
+
+    /**
+     * @brief Change the rate and capacity; the bucket starts full again
+     * @param rate Tokens per second (0: unlimited)
+     * @param burst Bucket capacity (0: one second worth of tokens)
+     */
+    void configure(uint64_t rate, uint64_t burst = 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rate_ = rate;
+        burst_ = burst == 0 ? rate : burst;
+        tokens_ = static_cast<double>(burst_);
+        refill_ = Clock::now();
+    }
+
+    /**
+     * @brief Get the refill rate
+     * @return Tokens per second (0: unlimited)
+     */
+    uint64_t rate() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return rate_;
+    }
+
+    /**
+     * @brief Get the bucket capacity
+     * @return Maximum tokens held
+     */
+    uint64_t burst() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return burst_;
+    }
+
+    /**
+     * @brief Compute how long a request for tokens has to wait, taking them
+     * @param count Tokens requested
+     * @param now Current time
+     * @return Time until the tokens are paid for (zero if available)
+     */
+    Clock::duration reserve(uint64_t count, Clock::time_point now) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (rate_ == 0) {
+            return Clock::duration::zero();
+        }
+        refill(now);
+        tokens_ -= static_cast<double>(count);
+        if (tokens_ >= 0) {
+            return Clock::duration::zero();
+        }
+        return std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(-tokens_ / rate_));
+    }
+
+    /**
+     * @brief Take tokens, sleeping until they are available
+     * @param count Tokens requested
+     */
+    void acquire(uint64_t count) {
+        Clock::duration wait = reserve(count, Clock::now());
+        if (wait > Clock::duration::zero()) {
+            std::this_thread::sleep_for(wait);
+        }
+    }
+};
@@ -5,14 +5,27 @@
 #include "../LmdbStorageEngine.h"
 #include "../LevelDBStorageEngine.h"
 #include "../TbbStorageEngine.h"
+#include "../TieredStorageEngine.h"
+#include "../CachedStorageEngine.h"
+#include "../TokenBucket.h"
+#include "../LevelDBTuning.h"
+#include "../CompactionScheduler.h"
+#include "../EngineTuning.h"
+#include "../EngineThreading.h"
 #include "../../utils/test_assertions.h"
 #include "../../utils/test_resources.h"
+#include <atomic>
 #include <iostream>
 #include <thread>
 #include <vector>
 #include <string>
 #include <memory>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <stdexcept>
 
 // Test result tracking
 int tests_passed = 0;
@@ -452,6 +465,45 @@ template <typename EngineType> void test_iterator_multiple_lookups() {
     END_TEST("iterator_multiple_lookups")
 }
 
+template <typename EngineType> void test_multi_read() {
+    TEST("multi_read")
+    EngineType engine(0, repart_kv_test::test_resources_dir());
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_STATUS_EQ(Status::SUCCESS,
+                         engine.write("key:" + std::to_string(i),
+                                      "value:" + std::to_string(i)));
+    }
+
+    // More keys than one lookup group, unsorted, with misses and repeats
+    std::vector<std::string> keys;
+    for (int i = 99; i >= 0; i -= 3) {
+        keys.push_back("key:" + std::to_string(i));
+    }
+    keys.push_back("key:");
+    keys.push_back("key:50");
+    keys.push_back("key:99");
+    keys.push_back("zzz");
+    std::vector<std::string> values(keys.size());
+    std::vector<ReadRequest> requests;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        requests.push_back({&keys[i], &values[i]});
+    }
+    ASSERT_GT(requests.size(), multi_read::GROUP);
+    size_t operations = engine.operation_count();
+
+    engine.multi_read(requests);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] == "key:" || keys[i] == "zzz") {
+            ASSERT_STATUS_EQ(Status::NOT_FOUND, requests[i].status);
+        } else {
+            ASSERT_STATUS_EQ(Status::SUCCESS, requests[i].status);
+            ASSERT_STR_EQ("value:" + keys[i].substr(4), values[i]);
+        }
+    }
+    ASSERT_EQ(operations + keys.size(), engine.operation_count());
+    END_TEST("multi_read")
+}
+
 template <typename EngineType> void test_operation_count() {
     TEST("operation_count")
     EngineType engine(0, repart_kv_test::test_resources_dir());
@@ -489,6 +541,791 @@ template <typename EngineType> void test_operation_count() {
     END_TEST("operation_count")
 }
 
+// Hot engine in memory, cold engine in LMDB
+template <bool SYNC>
+using MapLmdbTieredEngine =
+    TieredStorageEngine<MapStorageEngine, LmdbStorageEngine, SYNC>;
+
+void test_tiered_migration() {
+    TEST("tiered_migration")
+    MapLmdbTieredEngine<false> engine(0, repart_kv_test::test_resources_dir());
+    ASSERT_TRUE(engine.tier() == Tier::COLD);
+
+    // More pairs than one migration batch
+    const size_t count = 3 * MapLmdbTieredEngine<false>::MIGRATION_BATCH + 7;
+    for (size_t i = 0; i < count; ++i) {
+        engine.write("key:" + std::to_string(i), "value:" + std::to_string(i));
+    }
+
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.promote());
+    ASSERT_TRUE(engine.tier() == Tier::HOT);
+    std::vector<std::pair<std::string, std::string>> results;
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.scan("", count + 1, results));
+    ASSERT_EQ(count, results.size());
+
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.demote());
+    ASSERT_TRUE(engine.tier() == Tier::COLD);
+    for (size_t i = 0; i < count; ++i) {
+        std::string value;
+        ASSERT_STATUS_EQ(Status::SUCCESS,
+                         engine.read("key:" + std::to_string(i), value));
+        ASSERT_STR_EQ("value:" + std::to_string(i), value);
+    }
+
+    // Migrating to the current tier is a no-op
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.demote());
+    ASSERT_TRUE(engine.tier() == Tier::COLD);
+    END_TEST("tiered_migration")
+}
+
+void test_tiered_updates_during_migration() {
+    TEST("tiered_updates_during_migration")
+    MapLmdbTieredEngine<false> engine(0, repart_kv_test::test_resources_dir());
+    const size_t count = 8 * MapLmdbTieredEngine<false>::MIGRATION_BATCH;
+    for (size_t i = 0; i < count; ++i) {
+        engine.write("key:" + std::to_string(i), "old");
+    }
+
+    // Overwrite even keys and remove odd ones while the data moves
+    std::atomic<bool> done(false);
+    std::thread writer([&engine, &done, count]() {
+        for (size_t i = 0; i < count; ++i) {
+            std::string key = "key:" + std::to_string(i);
+            if (i % 2 == 0) {
+                engine.write(key, "new");
+            } else {
+                std::string removed;
+                engine.remove(key, removed);
+            }
+        }
+        done = true;
+    });
+    while (!done) {
+        engine.migrate(engine.tier() == Tier::HOT ? Tier::COLD : Tier::HOT);
+    }
+    writer.join();
+
+    for (size_t i = 0; i < count; ++i) {
+        std::string value;
+        Status status = engine.read("key:" + std::to_string(i), value);
+        if (i % 2 == 0) {
+            ASSERT_STATUS_EQ(Status::SUCCESS, status);
+            ASSERT_STR_EQ("new", value);
+        } else {
+            ASSERT_STATUS_EQ(Status::NOT_FOUND, status);
+        }
+    }
+    END_TEST("tiered_updates_during_migration")
+}
+
+// Read cache in front of LMDB
+template <bool SYNC>
+using CachedLmdbEngine = CachedStorageEngine<LmdbStorageEngine, SYNC>;
+
+void test_cache_clock_eviction() {
+    TEST("cache_clock_eviction")
+    CachedLmdbEngine<false> engine(0, repart_kv_test::test_resources_dir(),
+                                   PartitionCacheTuning{4, 16});
+    for (size_t i = 0; i < 8; ++i) {
+        engine.write("key:" + std::to_string(i), "value:" + std::to_string(i));
+    }
+
+    // Misses fill the cache; reads of cached keys are hits
+    std::string value;
+    for (size_t i = 0; i < 4; ++i) {
+        engine.read("key:" + std::to_string(i), value);
+    }
+    ASSERT_EQ(4, engine.cached_count());
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.read("key:0", value));
+    ASSERT_STR_EQ("value:0", value);
+    CacheStats stats = engine.cache_stats();
+    ASSERT_EQ(1, stats.hits);
+    ASSERT_EQ(4, stats.misses);
+
+    // Further misses evict, and the cache never exceeds its capacity
+    for (size_t i = 4; i < 8; ++i) {
+        engine.read("key:" + std::to_string(i), value);
+    }
+    ASSERT_EQ(4, engine.cached_count());
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.read("key:7", value));
+    ASSERT_STR_EQ("value:7", value);
+    ASSERT_EQ(2, engine.cache_stats().hits);
+
+    // Writes refresh cached values and removes drop them
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.write("key:7", "updated"));
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.read("key:7", value));
+    ASSERT_STR_EQ("updated", value);
+    std::string removed;
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.remove("key:7", removed));
+    ASSERT_STATUS_EQ(Status::NOT_FOUND, engine.read("key:7", value));
+    ASSERT_EQ(3, engine.cached_count());
+    END_TEST("cache_clock_eviction")
+}
+
+void test_cache_prefetch() {
+    TEST("cache_prefetch")
+    CachedLmdbEngine<false> engine(0, repart_kv_test::test_resources_dir(),
+                                   PartitionCacheTuning{2, 16});
+    for (size_t i = 0; i < 8; ++i) {
+        engine.write("key:" + std::to_string(i), "value:" + std::to_string(i));
+    }
+    engine.prefetch("key:1");
+    engine.prefetch("key:2");
+    engine.prefetch("missing");
+    for (int i = 0; i < 1000 && engine.cache_stats().prefetched < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(2, engine.cache_stats().prefetched);
+
+    // A prefetched key is a hit; the other one is wasted once evicted
+    std::string value;
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.read("key:1", value));
+    ASSERT_STR_EQ("value:1", value);
+    engine.read("key:5", value);
+    CacheStats stats = engine.cache_stats();
+    ASSERT_EQ(1, stats.hits);
+    ASSERT_EQ(1, stats.misses);
+    ASSERT_EQ(1, stats.wasted);
+    ASSERT_TRUE(stats.hit_rate() == 0.5);
+    ASSERT_TRUE(stats.wasted_prefetch_ratio() == 0.5);
+    END_TEST("cache_prefetch")
+}
+
+void test_cache_updates_during_prefetch() {
+    TEST("cache_updates_during_prefetch")
+    CachedLmdbEngine<false> engine(0, repart_kv_test::test_resources_dir(),
+                                   PartitionCacheTuning{64, 1024});
+    const size_t count = 256;
+    for (size_t i = 0; i < count; ++i) {
+        engine.write("key:" + std::to_string(i), "old");
+    }
+
+    // Overwrite even keys and remove odd ones while they are prefetched
+    std::atomic<bool> done(false);
+    std::thread writer([&engine, &done, count]() {
+        for (size_t i = 0; i < count; ++i) {
+            std::string key = "key:" + std::to_string(i);
+            if (i % 2 == 0) {
+                engine.write(key, "new");
+            } else {
+                std::string removed;
+                engine.remove(key, removed);
+            }
+        }
+        done = true;
+    });
+    while (!done) {
+        for (size_t i = 0; i < count; ++i) {
+            engine.prefetch("key:" + std::to_string(i));
+        }
+    }
+    writer.join();
+
+    for (size_t i = 0; i < count; ++i) {
+        std::string value;
+        Status status = engine.read("key:" + std::to_string(i), value);
+        if (i % 2 == 0) {
+            ASSERT_STATUS_EQ(Status::SUCCESS, status);
+            ASSERT_STR_EQ("new", value);
+        } else {
+            ASSERT_STATUS_EQ(Status::NOT_FOUND, status);
+        }
+    }
+    END_TEST("cache_updates_during_prefetch")
+}
+
+void test_cache_concurrent_hits() {
+    TEST("cache_concurrent_hits")
+    // Large enough to be sharded
+    CachedLmdbEngine<false> engine(0, repart_kv_test::test_resources_dir(),
+                                   PartitionCacheTuning{8192, 4096});
+    CachedLmdbEngine<false> other(0, repart_kv_test::test_resources_dir(),
+                                  PartitionCacheTuning{8192, 4096});
+    const size_t count = 2048;
+    for (size_t i = 0; i < count; ++i) {
+        engine.write("key:" + std::to_string(i), "value:" + std::to_string(i));
+        other.write("key:" + std::to_string(i), "other");
+    }
+
+    // Both engines prefetch on the shared pool
+    for (size_t i = 0; i < count; ++i) {
+        engine.prefetch("key:" + std::to_string(i));
+        other.prefetch("key:" + std::to_string(i));
+    }
+    for (int i = 0; i < 5000 && (engine.cached_count() < count ||
+                                 other.cached_count() < count);
+         ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(count, engine.cached_count());
+    ASSERT_EQ(count, other.cached_count());
+
+    // Concurrent readers of cached keys all hit
+    const size_t threads = 8;
+    std::atomic<size_t> wrong(0);
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < threads; ++t) {
+        readers.emplace_back([&engine, &wrong, count, t]() {
+            std::string value;
+            for (size_t i = 0; i < count; ++i) {
+                size_t k = (i + t * 97) % count;
+                if (engine.read("key:" + std::to_string(k), value) !=
+                        Status::SUCCESS ||
+                    value != "value:" + std::to_string(k)) {
+                    ++wrong;
+                }
+            }
+        });
+    }
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQ(0, wrong.load());
+    CacheStats stats = engine.cache_stats();
+    ASSERT_EQ(threads * count, stats.hits);
+    ASSERT_EQ(0, stats.misses);
+    ASSERT_EQ(count, stats.prefetched);
+    ASSERT_EQ(0, stats.wasted);
+    END_TEST("cache_concurrent_hits")
+}
+
+void test_sharded_counter() {
+    TEST("sharded_counter")
+    // No add is lost when threads share a sharded counter
+    ShardedCounter shared;
+    const size_t threads_count = 8;
+    const size_t adds = 10000;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&shared]() {
+            for (size_t i = 0; i < adds; ++i) {
+                shared.add();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(threads_count * adds, shared.load());
+    END_TEST("sharded_counter")
+}
+
+void test_token_bucket() {
+    TEST("token_bucket")
+    using Clock = TokenBucket::Clock;
+    TokenBucket unlimited;
+    ASSERT_TRUE(unlimited.reserve(1 << 30, Clock::now()) ==
+                Clock::duration::zero());
+
+    // 1 MiB/s with a 64 KiB burst: the burst is free, the rest is paid in time
+    TokenBucket bucket(1 << 20, 64 << 10);
+    Clock::time_point now = Clock::now();
+    ASSERT_TRUE(bucket.reserve(64 << 10, now) == Clock::duration::zero());
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        bucket.reserve(512 << 10, now));
+    ASSERT_GE(wait.count(), 490);
+    ASSERT_LE(wait.count(), 510);
+
+    // The debt is paid back at the configured rate
+    auto later = now + std::chrono::milliseconds(500);
+    ASSERT_TRUE(bucket.reserve(0, later) == Clock::duration::zero());
+    END_TEST("token_bucket")
+}
+
+void test_leveldb_partition_options() {
+    TEST("leveldb_partition_options")
+    LevelDBPartitionOptions defaults;
+    defaults.write_buffer_size = 1 << 20;
+    LevelDBPartitionOptions hot = defaults;
+    hot.block_cache_size = 16 << 20;
+    hot.bloom_bits_per_key = 10;
+    LevelDBTuning::set_defaults(defaults);
+    LevelDBTuning::set_partition(1, hot);
+    ASSERT_TRUE(LevelDBTuning::options() == defaults);
+    ASSERT_TRUE(LevelDBTuning::options(0) == defaults);
+    ASSERT_TRUE(LevelDBTuning::options(1) == hot);
+
+    // Partition-aware engines open with their partition's options
+    LevelDBStorageEngine<> plain(0, repart_kv_test::test_resources_dir(), 0);
+    LevelDBStorageEngine<> tuned(0, repart_kv_test::test_resources_dir(), 1);
+    ASSERT_TRUE(plain.is_open());
+    ASSERT_TRUE(tuned.is_open());
+    ASSERT_STATUS_EQ(Status::SUCCESS, tuned.write("key", "value"));
+    std::string value;
+    ASSERT_STATUS_EQ(Status::SUCCESS, tuned.read("key", value));
+    ASSERT_STR_EQ("value", value);
+
+    // Moving an engine keeps its cache and filter alive
+    LevelDBStorageEngine<> moved(std::move(tuned));
+    ASSERT_STATUS_EQ(Status::SUCCESS, moved.read("key", value));
+
+    LevelDBTuning::reset();
+    ASSERT_TRUE(LevelDBTuning::options(1) == LevelDBPartitionOptions());
+    END_TEST("leveldb_partition_options")
+}
+
+void test_compaction_staggering() {
+    TEST("compaction_staggering")
+    CompactionScheduler &scheduler = CompactionScheduler::instance();
+    CompactionScheduler::Settings settings;
+    settings.stagger = std::chrono::milliseconds(50);
+    scheduler.configure(settings);
+
+    const size_t registered = scheduler.database_count();
+    std::vector<std::unique_ptr<LevelDBStorageEngine<>>> engines;
+    for (size_t i = 0; i < 3; ++i) {
+        engines.push_back(std::make_unique<LevelDBStorageEngine<>>(
+            0, repart_kv_test::test_resources_dir(), i));
+        for (size_t k = 0; k < 1000; ++k) {
+            engines.back()->write("key:" + std::to_string(k),
+                                  "value:" + std::to_string(k));
+        }
+    }
+    ASSERT_EQ(registered + 3, scheduler.database_count());
+
+    // Concurrent requests run one at a time, at least stagger apart
+    const size_t compactions = scheduler.compactions();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (auto &engine : engines) {
+        threads.emplace_back([&engine]() { engine->compact(); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    ASSERT_EQ(compactions + 3, scheduler.compactions());
+    ASSERT_GE(elapsed.count(), 100);
+
+    std::string value;
+    ASSERT_STATUS_EQ(Status::SUCCESS, engines[2]->read("key:999", value));
+    ASSERT_STR_EQ("value:999", value);
+
+    engines.clear();
+    ASSERT_EQ(registered, scheduler.database_count());
+    scheduler.configure(CompactionScheduler::Settings());
+    END_TEST("compaction_staggering")
+}
+
+void test_compaction_throttling() {
+    TEST("compaction_throttling")
+    CompactionScheduler &scheduler = CompactionScheduler::instance();
+    CompactionScheduler::Settings settings;
+    settings.bytes_per_second = 1 << 20;
+    settings.burst_bytes = 64 << 10;
+    scheduler.configure(settings);
+
+    // About 512 KiB of incompressible values
+    LevelDBStorageEngine<> engine(0, repart_kv_test::test_resources_dir());
+    uint64_t state = 88172645463325252ULL;
+    for (size_t k = 0; k < 512; ++k) {
+        std::string value(1024, '\0');
+        for (char &c : value) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            c = static_cast<char>(state);
+        }
+        engine.write("key:" + std::to_string(k), value);
+    }
+
+    // The compaction writes its tables through the 1 MiB/s bucket
+    auto start = std::chrono::steady_clock::now();
+    engine.compact();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    ASSERT_GE(elapsed.count(), 250);
+
+    scheduler.configure(CompactionScheduler::Settings());
+    END_TEST("compaction_throttling")
+}
+
+void test_lmdb_map_growth() {
+    TEST("lmdb_map_growth")
+    LmdbOptions options;
+    options.map_size = 1 << 16;
+    options.max_map_size = 1 << 20;
+    LmdbTuning::set_options(options);
+    LmdbStorageEngine<> engine(0, repart_kv_test::test_resources_dir());
+    LmdbTuning::set_options(LmdbOptions());
+    ASSERT_EQ(size_t(1) << 16, engine.map_size());
+
+    // Far more than the initial map: writes grow it instead of failing
+    const std::string value(256, 'v');
+    for (size_t i = 0; i < 1000; ++i) {
+        ASSERT_STATUS_EQ(Status::SUCCESS,
+                         engine.write("key:" + std::to_string(i), value));
+    }
+    ASSERT_GT(engine.map_size(), size_t(1) << 16);
+    ASSERT_LE(engine.map_size(), size_t(1) << 20);
+    std::string read_value;
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.read("key:0", read_value));
+    ASSERT_STR_EQ(value, read_value);
+
+    // Past max_map_size, writes fail and the data stays readable
+    Status status = Status::SUCCESS;
+    for (size_t i = 1000; i < 10000 && status == Status::SUCCESS; ++i) {
+        status = engine.write("key:" + std::to_string(i), value);
+    }
+    ASSERT_STATUS_EQ(Status::ERROR, status);
+    ASSERT_EQ(size_t(1) << 20, engine.map_size());
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.read("key:999", read_value));
+    END_TEST("lmdb_map_growth")
+}
+
+void test_lmdb_growth_under_reads() {
+    TEST("lmdb_growth_under_reads")
+    LmdbOptions options;
+    options.map_size = 1 << 16;
+    options.max_map_size = 1 << 24;
+    LmdbTuning::set_options(options);
+    LmdbStorageEngine<> engine(0, repart_kv_test::test_resources_dir());
+    LmdbTuning::set_options(LmdbOptions());
+    const std::string value(256, 'v');
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.write("key:0", value));
+
+    // Readers always pin the map: growth still gets its turn
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < 4; ++t) {
+        readers.emplace_back([&engine, &done]() {
+            std::string read_value;
+            while (!done) {
+                engine.read("key:0", read_value);
+            }
+        });
+    }
+    size_t failed = 0;
+    for (size_t i = 1; i < 2000; ++i) {
+        if (engine.write("key:" + std::to_string(i), value) !=
+            Status::SUCCESS) {
+            ++failed;
+        }
+    }
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQ(size_t(0), failed);
+    ASSERT_GT(engine.map_size(), size_t(1) << 16);
+    END_TEST("lmdb_growth_under_reads")
+}
+
+void test_lmdb_growth_during_checkpoint() {
+    TEST("lmdb_growth_during_checkpoint")
+    LmdbOptions options;
+    options.map_size = 1 << 16;
+    options.max_map_size = 1 << 24;
+    LmdbTuning::set_options(options);
+    LmdbStorageEngine<> engine(0, repart_kv_test::test_resources_dir());
+    LmdbTuning::set_options(LmdbOptions());
+    const std::string value(256, 'v');
+    for (size_t i = 0; i < 100; ++i) {
+        ASSERT_STATUS_EQ(Status::SUCCESS,
+                         engine.write("key:" + std::to_string(i), value));
+    }
+    const std::string directory = repart_kv_test::test_resources_dir() +
+                                  "/lmdb_growth_during_checkpoint";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    // The slow image keeps the map pinned while the writes below outgrow
+    // it: growth waits for the copy instead of failing
+    TokenBucket throttle(64 << 10, 4 << 10);
+    std::atomic<bool> captured(false);
+    Status checkpoint_status = Status::ERROR;
+    std::thread checkpointer([&]() {
+        checkpoint_status = engine.checkpoint(directory, 0, throttle,
+                                              [&captured]() {
+                                                  captured = true;
+                                              });
+    });
+    while (!captured) {
+        std::this_thread::yield();
+    }
+    size_t failed = 0;
+    for (size_t i = 100; i < 3000; ++i) {
+        if (engine.write("key:" + std::to_string(i), value) !=
+            Status::SUCCESS) {
+            ++failed;
+        }
+    }
+    checkpointer.join();
+    ASSERT_EQ(size_t(0), failed);
+    ASSERT_STATUS_EQ(Status::SUCCESS, checkpoint_status);
+    ASSERT_GT(engine.map_size(), size_t(1) << 18);
+    std::filesystem::remove_all(directory);
+    END_TEST("lmdb_growth_during_checkpoint")
+}
+
+void test_lmdb_read_transaction_reuse() {
+    TEST("lmdb_read_transaction_reuse")
+    std::string path = repart_kv_test::test_resources_dir() +
+                       "/lmdb_read_transaction_reuse";
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    LmdbOptions options;
+    options.write_map = true;
+    MDB_env *env = nullptr;
+    ASSERT_INT_EQ(0, LmdbTransactions::open_env(env, path.c_str(), options,
+                                                false));
+    {
+        LmdbTransactions transactions(env, options);
+        {
+            LmdbTransactions::Reader reader = transactions.read();
+            ASSERT_TRUE(reader.txn() != nullptr);
+        }
+        {
+            LmdbTransactions::Reader reader = transactions.read();
+            ASSERT_TRUE(reader.txn() != nullptr);
+        }
+        ASSERT_EQ(1u, transactions.reader_count());
+
+        // A nested read needs a second transaction
+        {
+            LmdbTransactions::Reader outer = transactions.read();
+            LmdbTransactions::Reader inner = transactions.read();
+            ASSERT_TRUE(inner.txn() != nullptr);
+            ASSERT_TRUE(inner.txn() != outer.txn());
+        }
+        ASSERT_EQ(2u, transactions.reader_count());
+
+        // Threads that exit hand their transaction over to later threads
+        for (size_t i = 0; i < 16; ++i) {
+            std::thread([&transactions]() {
+                LmdbTransactions::Reader reader = transactions.read();
+            }).join();
+        }
+        ASSERT_LE(transactions.reader_count(), 3u);
+    }
+    mdb_env_close(env);
+    std::filesystem::remove_all(path);
+    END_TEST("lmdb_read_transaction_reuse")
+}
+
+void test_engine_profile_load() {
+    TEST("engine_profile_load")
+    std::string path =
+        repart_kv_test::test_resources_dir() + "/engine_profile.toml";
+    {
+        std::ofstream file(path);
+        file << "workload.n_records = 1000\n"
+                "# [engine.lmdb] in a comment is ignored\n"
+                "[engine]\n"
+                "name = \"nvme\" # trailing comment\n"
+                "\n"
+                "[engine.tkrzw_tree]\n"
+                "compression = \"none\"\n"
+                "max_page_size = 4096\n"
+                "[engine.tkrzw_hash_keys]\n"
+                "num_buckets = 1_000_000\n"
+                "[engine.leveldb]\n"
+                "bloom_bits_per_key = 10\n"
+                "[engine.cache]\n"
+                "capacity = 100\n"
+                "[output]\n"
+                "engine.lmdb.write_map = true\n"
+                "[other]\n"
+                "map_size = 1\n";
+    }
+    EngineProfile profile = EngineTuning::load(path);
+    ASSERT_STR_EQ("nvme", profile.name);
+    ASSERT_TRUE(profile.tkrzw_tree.compression == TkrzwCompression::NONE);
+    ASSERT_EQ(4096, profile.tkrzw_tree.max_page_size);
+    ASSERT_EQ(1000000, profile.tkrzw_hash_keys.num_buckets);
+    ASSERT_EQ(10, profile.leveldb.bloom_bits_per_key);
+    ASSERT_EQ(100, profile.cache.capacity);
+    // Dotted keys under another table are not engine settings
+    ASSERT_FALSE(profile.lmdb.write_map);
+
+    // Untouched backends keep their defaults
+    EngineProfile defaults;
+    ASSERT_TRUE(profile.tkrzw_tree_keys == defaults.tkrzw_tree_keys);
+    ASSERT_TRUE(profile.tkrzw_hash == defaults.tkrzw_hash);
+    ASSERT_TRUE(profile.lmdb == defaults.lmdb);
+    ASSERT_EQ(8192, defaults.tkrzw_tree_keys.max_page_size);
+    ASSERT_TRUE(defaults.tkrzw_tree.compression == TkrzwCompression::ZLIB);
+
+    ASSERT_STR_EQ("lmdb.map_size=1073741824;lmdb.max_map_size=0;"
+                  "lmdb.write_map=0;lmdb.map_async=0;lmdb.max_readers=1024",
+                  EngineTuning::describe(profile, "tiered_lmdb"));
+    ASSERT_STR_EQ("", EngineTuning::describe(profile, "map"));
+    ASSERT_STR_EQ("lmdb.map_size=1073741824;lmdb.max_map_size=0;"
+                  "lmdb.write_map=0;lmdb.map_async=0;lmdb.max_readers=1024;"
+                  "cache.capacity=100;cache.prefetch_queue=1024",
+                  EngineTuning::describe(profile, "cached_lmdb"));
+
+    // The profile sets the LevelDB and LMDB registries as well
+    EngineTuning::set_profile(profile);
+    ASSERT_EQ(10, LevelDBTuning::options().bloom_bits_per_key);
+    ASSERT_EQ(4096, EngineTuning::profile().tkrzw_tree.max_page_size);
+    EngineTuning::set_profile(EngineProfile());
+    LevelDBTuning::reset();
+    std::filesystem::remove(path);
+    END_TEST("engine_profile_load")
+}
+
+void test_engine_profile_errors() {
+    TEST("engine_profile_errors")
+    EngineProfile profile;
+    EngineTuning::set(profile, "lmdb", "write_map", "true");
+    ASSERT_TRUE(profile.lmdb.write_map);
+
+    auto rejected = [&](const std::string &section, const std::string &key,
+                        const std::string &value) {
+        try {
+            EngineTuning::set(profile, section, key, value);
+        } catch (const std::invalid_argument &) {
+            return true;
+        }
+        return false;
+    };
+    ASSERT_TRUE(rejected("lmdb", "unknown", "1"));
+    ASSERT_TRUE(rejected("unknown", "map_size", "1"));
+    ASSERT_TRUE(rejected("lmdb", "map_size", "0"));
+    ASSERT_TRUE(rejected("lmdb", "write_map", "1"));
+    ASSERT_TRUE(rejected("tkrzw_tree", "compression", "\"snappy\""));
+    ASSERT_TRUE(rejected("tkrzw_tree", "max_page_size", "-1"));
+    ASSERT_TRUE(rejected("tkrzw_hash", "num_buckets", "12abc"));
+    ASSERT_TRUE(profile.lmdb.write_map);
+
+    bool thrown = false;
+    try {
+        EngineTuning::load(repart_kv_test::test_resources_dir() +
+                           "/missing.toml");
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+    END_TEST("engine_profile_errors")
+}
+
+void test_tkrzw_tuned_engines() {
+    TEST("tkrzw_tuned_engines")
+    TkrzwTreeStorageEngine<> tree(0, repart_kv_test::test_resources_dir(),
+                                  {TkrzwCompression::NONE, 1024, 16, 64});
+    TkrzwHashStorageEngine<> hash(0, repart_kv_test::test_resources_dir(),
+                                  {TkrzwCompression::NONE, 1024});
+    for (size_t i = 0; i < 2000; ++i) {
+        const std::string key = "key:" + std::to_string(i);
+        ASSERT_STATUS_EQ(Status::SUCCESS, tree.write(key, key));
+        ASSERT_STATUS_EQ(Status::SUCCESS, hash.write(key, key));
+    }
+    std::string value;
+    ASSERT_STATUS_EQ(Status::SUCCESS, tree.read("key:1999", value));
+    ASSERT_STR_EQ("key:1999", value);
+    ASSERT_STATUS_EQ(Status::SUCCESS, hash.read("key:0", value));
+    ASSERT_STR_EQ("key:0", value);
+    END_TEST("tkrzw_tuned_engines")
+}
+
+void test_engine_profile_forwarding() {
+    TEST("engine_profile_forwarding")
+    EngineProfile profile;
+    profile.lmdb.map_size = 1 << 20;
+    profile.cache.capacity = 8;
+    profile.leveldb.write_buffer_size = 1 << 20;
+    profile.leveldb_partitions[1].bloom_bits_per_key = 10;
+
+    // LevelDB partitions take their override, the others the defaults
+    ASSERT_EQ(10, EngineTuning::leveldb_options(profile, 1).bloom_bits_per_key);
+    ASSERT_TRUE(EngineTuning::leveldb_options(profile, 0) == profile.leveldb);
+    ASSERT_TRUE(EngineTuning::leveldb_options(profile, std::nullopt) ==
+                profile.leveldb);
+
+    // Engines get their part of the profile without touching the default
+    std::unique_ptr<LmdbStorageEngine<>> lmdb(new_engine<LmdbStorageEngine<>>(
+        0, repart_kv_test::test_resources_dir(), 0, profile));
+    ASSERT_EQ(size_t(1) << 20, lmdb->map_size());
+    std::unique_ptr<CachedStorageEngine<LmdbStorageEngine>> cached(
+        new_engine<CachedStorageEngine<LmdbStorageEngine>>(
+            0, repart_kv_test::test_resources_dir(), std::nullopt, profile));
+    ASSERT_EQ(size_t(8), cached->cache_tuning().capacity);
+    LmdbStorageEngine<> plain = make_engine<LmdbStorageEngine<>>(
+        0, repart_kv_test::test_resources_dir(), EngineProfile());
+    ASSERT_EQ(LmdbOptions().map_size, plain.map_size());
+    ASSERT_TRUE(EngineTuning::profile() == EngineProfile());
+    END_TEST("engine_profile_forwarding")
+}
+
+void test_record_checkpoint_image() {
+    TEST("record_checkpoint_image")
+    MapStorageEngine<> engine(0, repart_kv_test::test_resources_dir());
+    const size_t count = 3000; // Several scan batches
+    for (size_t i = 0; i < count; ++i) {
+        engine.write("key:" + std::to_string(i), "value:" + std::to_string(i));
+    }
+    const std::string directory =
+        repart_kv_test::test_resources_dir() + "/record_checkpoint_image";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    TokenBucket throttle;
+    size_t captured = 0;
+    ASSERT_STATUS_EQ(Status::SUCCESS,
+                     engine.checkpoint(directory, 2, throttle,
+                                       [&captured]() { ++captured; }));
+    ASSERT_EQ(size_t(1), captured);
+
+    const std::string file = EngineCheckpoint::record_file(directory, 2);
+    std::map<std::string, std::string> image;
+    auto collect = [&image](const std::string &key, const std::string &value) {
+        image[key] = value;
+    };
+    ASSERT_STATUS_EQ(Status::SUCCESS,
+                     EngineCheckpoint::read_records(file, collect));
+    ASSERT_EQ(count, image.size());
+    ASSERT_STR_EQ("value:1234", image["key:1234"]);
+
+    // A truncated image is detected
+    std::filesystem::resize_file(file, std::filesystem::file_size(file) - 1);
+    ASSERT_STATUS_EQ(Status::ERROR,
+                     EngineCheckpoint::read_records(file, collect));
+    ASSERT_STATUS_EQ(Status::NOT_FOUND,
+                     EngineCheckpoint::read_records(directory + "/none",
+                                                    collect));
+    END_TEST("record_checkpoint_image")
+}
+
+// Engines with a native image, reopened through their file path constructor
+template <typename EngineType>
+void test_native_checkpoint_image(const std::string &engine_name) {
+    TEST("native_checkpoint_image")
+    EngineType engine(0, repart_kv_test::test_resources_dir());
+    const size_t count = 3000;
+    for (size_t i = 0; i < count; ++i) {
+        engine.write("key:" + std::to_string(i), "value:" + std::to_string(i));
+    }
+    const std::string directory = repart_kv_test::test_resources_dir() +
+                                  "/" + engine_name + "_checkpoint_image";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    // A write right after the image is fixed stays out of it
+    TokenBucket throttle;
+    size_t captured = 0;
+    ASSERT_STATUS_EQ(Status::SUCCESS,
+                     engine.checkpoint(directory, 3, throttle, [&]() {
+                         ++captured;
+                         std::thread([&engine]() {
+                             engine.write("late", "value");
+                         }).join();
+                     }));
+    ASSERT_EQ(size_t(1), captured);
+
+    EngineType image(directory + "/" + engine_name + "_3");
+    std::vector<std::pair<std::string, std::string>> results;
+    image.scan("", count + 1, results);
+    ASSERT_EQ(count, results.size());
+    std::string value;
+    ASSERT_STATUS_EQ(Status::SUCCESS, image.read("key:1234", value));
+    ASSERT_STR_EQ("value:1234", value);
+    ASSERT_STATUS_EQ(Status::NOT_FOUND, image.read("late", value));
+    ASSERT_STATUS_EQ(Status::SUCCESS, engine.read("late", value));
+    END_TEST("native_checkpoint_image")
+}
+
 // Helper function to run all tests for a given engine type
 template <typename EngineType>
 void run_storage_engine_test_suite(const std::string &engine_name) {
@@ -512,6 +1349,7 @@ void run_storage_engine_test_suite(const std::string &engine_name) {
         {"concurrent_writes", []() { test_concurrent_writes<EngineType>(); }},
         {"concurrent_reads_writes",
          []() { test_concurrent_reads_writes<EngineType>(); }},
+        {"multi_read", []() { test_multi_read<EngineType>(); }},
         {"operation_count", []() { test_operation_count<EngineType>(); }}};
 
     run_test_suite(engine_name, tests);
@@ -548,6 +1386,10 @@ int main() {
     run_storage_engine_test_suite<LevelDBStorageEngine<>>(
         "LevelDBStorageEngine");
     run_storage_engine_test_suite<TbbStorageEngine<>>("TbbStorageEngine");
+    run_storage_engine_test_suite<MapLmdbTieredEngine<false>>(
+        "TieredStorageEngine<Map, Lmdb>");
+    run_storage_engine_test_suite<CachedLmdbEngine<false>>(
+        "CachedStorageEngine<Lmdb>");
 
     // Iterator tests (only for engines that implement iterator_impl)
     run_iterator_tests<MapStorageEngine<>>("MapStorageEngine");
@@ -557,6 +1399,50 @@ int main() {
     run_iterator_tests<LevelDBStorageEngine<>>("LevelDBStorageEngine");
     run_iterator_tests<TkrzwTreeStorageEngine<>>("TkrzwTreeStorageEngine");
     run_iterator_tests<TbbStorageEngine<>>("TbbStorageEngine");
+    run_iterator_tests<MapLmdbTieredEngine<false>>(
+        "TieredStorageEngine<Map, Lmdb>");
+    run_iterator_tests<CachedLmdbEngine<false>>("CachedStorageEngine<Lmdb>");
+    run_test_suite("TieredStorageEngine<Map, Lmdb> (migration)",
+                   {{"tiered_migration", test_tiered_migration},
+                    {"tiered_updates_during_migration",
+                     test_tiered_updates_during_migration}});
+    run_test_suite("CachedStorageEngine<Lmdb> (read cache)",
+                   {{"cache_clock_eviction", test_cache_clock_eviction},
+                    {"cache_prefetch", test_cache_prefetch},
+                    {"cache_updates_during_prefetch",
+                     test_cache_updates_during_prefetch},
+                    {"cache_concurrent_hits", test_cache_concurrent_hits}});
+
+    run_test_suite("Sharded counter",
+                   {{"sharded_counter", test_sharded_counter}});
+
+    run_test_suite("LMDB transactions",
+                   {{"lmdb_map_growth", test_lmdb_map_growth},
+                    {"lmdb_growth_under_reads", test_lmdb_growth_under_reads},
+                    {"lmdb_growth_during_checkpoint",
+                     test_lmdb_growth_during_checkpoint},
+                    {"lmdb_read_transaction_reuse",
+                     test_lmdb_read_transaction_reuse}});
+    run_test_suite("LevelDB tuning",
+                   {{"token_bucket", test_token_bucket},
+                    {"leveldb_partition_options",
+                     test_leveldb_partition_options},
+                    {"compaction_staggering", test_compaction_staggering},
+                    {"compaction_throttling", test_compaction_throttling}});
+    run_test_suite(
+        "Engine checkpoints",
+        {{"record_checkpoint_image", test_record_checkpoint_image},
+         {"lmdb_checkpoint_image",
+          []() { test_native_checkpoint_image<LmdbStorageEngine<>>("lmdb"); }},
+         {"leveldb_checkpoint_image", []() {
+              test_native_checkpoint_image<LevelDBStorageEngine<>>("leveldb");
+          }}});
+    run_test_suite("Engine tuning",
+                   {{"engine_profile_load", test_engine_profile_load},
+                    {"engine_profile_errors", test_engine_profile_errors},
+                    {"engine_profile_forwarding",
+                     test_engine_profile_forwarding},
+                    {"tkrzw_tuned_engines", test_tkrzw_tuned_engines}});
 
     // Same suites with SYNC=true (durable persistence where the backend
     // supports it; in-memory engines are unchanged but must still pass).
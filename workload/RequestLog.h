@@ -0,0 +1,241 @@
+#pragma once
+
+#include "Workload.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace workload {
+
+/**
+ * @brief A request read back from a request log
+ */
+struct RecordedRequest {
+    uint64_t issue_ns;   // Issue time, relative to the start of the recording
+    Operation operation; // The request
+};
+
+namespace detail {
+
+inline void append_varint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline bool consume_varint(std::string_view &in, uint64_t &value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && !in.empty(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(in.front());
+        in.remove_prefix(1);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool consume_string(std::string_view &in, std::string &value) {
+    uint64_t size;
+    if (!consume_varint(in, size) || size > in.size()) {
+        return false;
+    }
+    value.assign(in.data(), size);
+    in.remove_prefix(size);
+    return true;
+}
+
+inline constexpr std::string_view REQUEST_LOG_MAGIC("RPKVREQ1", 8);
+
+} // namespace detail
+
+/**
+ * @brief Binary log of the requests issued by a set of client threads
+ *
+ * Every client thread appends to its own buffer, so recording takes no lock
+ * and makes no system call on the request path. A buffer is written to the
+ * file, under a lock, once it holds FLUSH_BYTES.
+ *
+ * File format: the 8-byte magic "RPKVREQ1" and the thread count, then one
+ * record per request. A record holds the thread, the issue time in
+ * nanoseconds since start(), the operation type, the key, the value (empty
+ * for the default write value) and the scan limit. Integers are LEB128
+ * varints and strings are a length followed by the raw bytes. Records of
+ * different threads are interleaved in flush order. Each thread's records
+ * stay in issue order.
+ */
+class RequestRecorder {
+public:
+    static constexpr size_t FLUSH_BYTES = 64 * 1024; // Per-thread buffer size
+
+private:
+    /**
+     * @brief Records of one client thread not yet written to the file
+     */
+    struct alignas(64) ThreadBuffer {
+        std::string bytes; // Encoded records
+        size_t count = 0;  // Requests recorded by the thread
+    };
+
+    std::ofstream file_;                 // Log file
+    std::mutex file_lock_;               // Serializes buffer writes
+    std::vector<ThreadBuffer> buffers_;  // One buffer per client thread
+    std::chrono::steady_clock::time_point
+        start_; // Time origin of the recording
+
+    void write(ThreadBuffer &buffer) {
+        std::lock_guard<std::mutex> lock(file_lock_);
+        file_.write(buffer.bytes.data(),
+                    static_cast<std::streamsize>(buffer.bytes.size()));
+        buffer.bytes.clear();
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param path Log file to create (replaced if it exists)
+     * @param thread_count Number of client threads that will record
+     * @throws std::runtime_error if the file cannot be created
+     */
+    RequestRecorder(const std::string &path, size_t thread_count) :
+        file_(path, std::ios::binary | std::ios::trunc),
+        buffers_(thread_count), start_(std::chrono::steady_clock::now()) {
+        if (!file_.is_open()) {
+            throw std::runtime_error("Failed to create request log: " + path);
+        }
+        std::string header(detail::REQUEST_LOG_MAGIC);
+        detail::append_varint(header, thread_count);
+        file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+        for (auto &buffer : buffers_) {
+            buffer.bytes.reserve(FLUSH_BYTES + 1024);
+        }
+    }
+
+    /**
+     * @brief Destructor - writes the records still buffered
+     *
+     * Must only run once the client threads have stopped recording.
+     */
+    ~RequestRecorder() {
+        for (auto &buffer : buffers_) {
+            write(buffer);
+        }
+    }
+
+    // Copy constructor and assignment operator are deleted
+    RequestRecorder(const RequestRecorder &) = delete;
+    RequestRecorder &operator=(const RequestRecorder &) = delete;
+
+    /**
+     * @brief Set the time origin of the recording
+     *
+     * Call before the client threads start.
+     */
+    void start() { start_ = std::chrono::steady_clock::now(); }
+
+    /**
+     * @brief Record a request about to be issued
+     * @param thread The client thread issuing it (each thread must use its own
+     * index)
+     * @param operation The request
+     */
+    void record(size_t thread, const Operation &operation) {
+        uint64_t issue_ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_)
+                .count());
+        ThreadBuffer &buffer = buffers_[thread];
+        detail::append_varint(buffer.bytes, thread);
+        detail::append_varint(buffer.bytes, issue_ns);
+        buffer.bytes.push_back(static_cast<char>(operation.type));
+        detail::append_varint(buffer.bytes, operation.key.size());
+        buffer.bytes.append(operation.key);
+        detail::append_varint(buffer.bytes, operation.value.size());
+        buffer.bytes.append(operation.value);
+        detail::append_varint(buffer.bytes, operation.limit);
+        ++buffer.count;
+        if (buffer.bytes.size() >= FLUSH_BYTES) {
+            write(buffer);
+        }
+    }
+
+    /**
+     * @brief Get the number of recorded requests
+     * @return Request count (exact once the client threads have stopped)
+     */
+    size_t recorded_count() const {
+        size_t count = 0;
+        for (const auto &buffer : buffers_) {
+            count += buffer.count;
+        }
+        return count;
+    }
+};
+
+/**
+ * @brief Read a log written by RequestRecorder
+ * @param path Path to the log file
+ * @return The requests of each recorded client thread, in issue order
+ * @throws std::runtime_error if the file cannot be read or is malformed
+ */
+inline std::vector<std::vector<RecordedRequest>>
+read_request_log(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open request log: " + path);
+    }
+    const std::string contents((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+    std::string_view in(contents);
+
+    uint64_t thread_count;
+    if (in.substr(0, detail::REQUEST_LOG_MAGIC.size()) !=
+        detail::REQUEST_LOG_MAGIC) {
+        throw std::runtime_error("Not a request log: " + path);
+    }
+    in.remove_prefix(detail::REQUEST_LOG_MAGIC.size());
+    if (!detail::consume_varint(in, thread_count) || thread_count == 0) {
+        throw std::runtime_error("Malformed request log header: " + path);
+    }
+
+    std::vector<std::vector<RecordedRequest>> requests(thread_count);
+    while (!in.empty()) {
+        uint64_t thread;
+        uint64_t issue_ns;
+        uint64_t limit;
+        RecordedRequest request{0, Operation(OperationType::READ, "")};
+        Operation &operation = request.operation;
+        bool valid = detail::consume_varint(in, thread) &&
+                     thread < thread_count &&
+                     detail::consume_varint(in, issue_ns) && !in.empty();
+        if (valid) {
+            uint8_t type = static_cast<uint8_t>(in.front());
+            in.remove_prefix(1);
+            valid = type <= static_cast<uint8_t>(OperationType::SCAN);
+            operation.type = static_cast<OperationType>(type);
+        }
+        valid = valid && detail::consume_string(in, operation.key) &&
+                detail::consume_string(in, operation.value) &&
+                detail::consume_varint(in, limit);
+        if (!valid) {
+            throw std::runtime_error("Truncated or malformed request log: " +
+                                     path);
+        }
+        request.issue_ns = issue_ns;
+        operation.limit = static_cast<size_t>(limit);
+        requests[thread].push_back(std::move(request));
+    }
+    return requests;
+}
+
+} // namespace workload
@@ -0,0 +1,155 @@
+#include "../RequestLog.h"
+#include "../../utils/test_assertions.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Test result tracking
+int tests_passed = 0;
+int tests_failed = 0;
+
+const std::string LOG_PATH = "/tmp/repart_kv_test_request_log.bin";
+
+void testRoundTrip() {
+    TEST("round_trip")
+    {
+        workload::RequestRecorder recorder(LOG_PATH, 2);
+        recorder.start();
+        workload::Operation write(workload::OperationType::WRITE, "key:1");
+        write.value = "value:1";
+        recorder.record(0, write);
+        recorder.record(1, workload::Operation(workload::OperationType::SCAN,
+                                               "key:0", 25));
+        recorder.record(0, workload::Operation(workload::OperationType::READ,
+                                               "key:1"));
+        ASSERT_EQ(3, recorder.recorded_count());
+    }
+
+    auto requests = workload::read_request_log(LOG_PATH);
+    ASSERT_EQ(2, requests.size());
+    ASSERT_EQ(2, requests[0].size());
+    ASSERT_EQ(1, requests[1].size());
+
+    const auto &write = requests[0][0].operation;
+    ASSERT_TRUE(write.type == workload::OperationType::WRITE);
+    ASSERT_STR_EQ("key:1", write.key);
+    ASSERT_STR_EQ("value:1", write.value);
+
+    const auto &read = requests[0][1].operation;
+    ASSERT_TRUE(read.type == workload::OperationType::READ);
+    ASSERT_STR_EQ("key:1", read.key);
+    ASSERT_TRUE(read.value.empty());
+    ASSERT_LE(requests[0][0].issue_ns, requests[0][1].issue_ns);
+
+    const auto &scan = requests[1][0].operation;
+    ASSERT_TRUE(scan.type == workload::OperationType::SCAN);
+    ASSERT_STR_EQ("key:0", scan.key);
+    ASSERT_EQ(25, scan.limit);
+
+    std::remove(LOG_PATH.c_str());
+    END_TEST("round_trip")
+}
+
+void testConcurrentRecording() {
+    TEST("concurrent_recording")
+    const size_t thread_count = 4;
+    // Enough requests per thread to flush each buffer several times
+    const size_t request_count = 20000;
+    {
+        workload::RequestRecorder recorder(LOG_PATH, thread_count);
+        recorder.start();
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&recorder, t, request_count]() {
+                for (size_t i = 0; i < request_count; ++i) {
+                    recorder.record(
+                        t, workload::Operation(
+                               workload::OperationType::READ,
+                               std::to_string(t) + ":" + std::to_string(i)));
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(thread_count * request_count, recorder.recorded_count());
+    }
+
+    auto requests = workload::read_request_log(LOG_PATH);
+    ASSERT_EQ(thread_count, requests.size());
+    for (size_t t = 0; t < thread_count; ++t) {
+        ASSERT_EQ(request_count, requests[t].size());
+        for (size_t i = 0; i < request_count; ++i) {
+            ASSERT_STR_EQ(std::to_string(t) + ":" + std::to_string(i),
+                          requests[t][i].operation.key);
+            if (i > 0) {
+                ASSERT_LE(requests[t][i - 1].issue_ns,
+                          requests[t][i].issue_ns);
+            }
+        }
+    }
+
+    std::remove(LOG_PATH.c_str());
+    END_TEST("concurrent_recording")
+}
+
+void testMalformedLog() {
+    TEST("malformed_log")
+    {
+        workload::RequestRecorder recorder(LOG_PATH, 1);
+        recorder.record(0, workload::Operation(workload::OperationType::READ,
+                                               "a_key_long_enough"));
+    }
+
+    // Cut the last record short
+    std::ifstream in(LOG_PATH, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(LOG_PATH, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(),
+              static_cast<std::streamsize>(contents.size() - 4));
+    out.close();
+
+    bool thrown = false;
+    try {
+        workload::read_request_log(LOG_PATH);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+
+    thrown = false;
+    try {
+        workload::read_request_log("/tmp/repart_kv_test_no_request_log.bin");
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+
+    std::remove(LOG_PATH.c_str());
+    END_TEST("malformed_log")
+}
+
+int main() {
+    std::vector<std::pair<std::string, TestFunction>> tests = {
+        {"round_trip", testRoundTrip},
+        {"concurrent_recording", testConcurrentRecording},
+        {"malformed_log", testMalformedLog}};
+
+    run_test_suite("Request Log", tests);
+
+    std::cout << "Tests passed: " << tests_passed << std::endl;
+    std::cout << "Tests failed: " << tests_failed << std::endl;
+
+    if (tests_failed == 0) {
+        std::cout << "✓ All request log tests passed!" << std::endl;
+        return 0;
+    } else {
+        std::cout << "✗ Some request log tests failed!" << std::endl;
+        return 1;
+    }
+}